@@ -0,0 +1,17 @@
+#ifndef CASECONVERSION_H
+#define CASECONVERSION_H
+
+#include <QString>
+
+namespace CaseConversion {
+
+enum class Mode { Upper, Lower };
+
+bool convert(QString &text, Mode mode);
+// Index of the first code unit at or after from whose conversion is not a
+// single code unit (a length-changing mapping or a surrogate), or the size.
+qsizetype findFullMapping(QStringView text, qsizetype from, Mode mode);
+
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef COMPAREVIEW_H
+#define COMPAREVIEW_H
+
+#include <QDialog>
+#include <QVector>
+#include <QFutureWatcher>
+
+class QPlainTextEdit;
+class QLabel;
+
+// A hunk in rows of the padded view: the old lines fill the left side from
+// row, the new lines the right side, and the shorter side is padded with
+// blank rows up to rows().
+struct CompareHunk
+{
+    int row = 0;
+    int oldCount = 0;
+    int newCount = 0;
+
+    int rows() const { return qMax(oldCount, newCount); }
+};
+
+struct CompareWord
+{
+    int row = 0;
+    int start = 0;
+    int length = 0;
+};
+
+struct CompareResult
+{
+    QString leftText;
+    QString rightText;
+    QVector<CompareHunk> hunks;
+    QVector<CompareWord> leftWords;
+    QVector<CompareWord> rightWords;
+    int removedLines = 0;
+    int addedLines = 0;
+    qint64 milliseconds = 0;
+    QString error;
+};
+
+// Side-by-side comparison of a file with the editor text. Reading, diffing
+// and padding run on a worker thread; both sides have the same rows, so the
+// scroll bars are simply tied together. Only the visible rows are coloured.
+class CompareDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit CompareDialog(QWidget *parent = nullptr);
+    ~CompareDialog() override;
+
+    void compare(const QString &leftPath, const QString &rightTitle, const QString &rightText);
+
+protected:
+    void resizeEvent(QResizeEvent *event) override;
+
+private slots:
+    void onCompared();
+    void render();
+    void nextChange();
+    void previousChange();
+
+private:
+    void goToHunk(int index);
+
+    QPlainTextEdit *left_ = nullptr;
+    QPlainTextEdit *right_ = nullptr;
+    QLabel *leftTitle_ = nullptr;
+    QLabel *rightTitle_ = nullptr;
+    QLabel *statusLabel_ = nullptr;
+    QFutureWatcher<CompareResult> watcher_;
+    QVector<CompareHunk> hunks_;
+    QVector<CompareWord> leftWords_;
+    QVector<CompareWord> rightWords_;
+    int currentHunk_ = -1;
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef COMPLETIONPOPUP_H
+#define COMPLETIONPOPUP_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+class QTextEdit;
+class QListWidget;
+class QListWidgetItem;
+
+// Completion list drawn over the editor. It never takes focus: navigation
+// keys are intercepted with an event filter and everything else is typed
+// into the editor, which narrows the list to the word being completed.
+class CompletionPopup : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Entry
+    {
+        QString text;
+        QString detail;
+    };
+
+    explicit CompletionPopup(QTextEdit *textEdit, QObject *parent = nullptr);
+
+    void show(int replaceFrom, const QVector<Entry> &entries);
+    void hide();
+    bool isVisible() const;
+
+signals:
+    void accepted(const QString &text);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void refilter();
+    void acceptItem(QListWidgetItem *item);
+
+private:
+    QString typedPrefix() const;
+    void moveSelection(int delta);
+
+    QTextEdit *textEdit_ = nullptr;
+    QListWidget *list_ = nullptr;
+    QVector<Entry> entries_;
+    int replaceFrom_ = -1;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#ifndef CPPHIGHLIGHTER_H
+#define CPPHIGHLIGHTER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QTextCharFormat>
+#include <QTextBlock>
+#include <QVector>
+
+class QTextEdit;
+
+// C/C++ highlighting through QTextLayout additional formats. The lexer state
+// at the end of every block is kept in QTextBlock::userState(), so an edit
+// re-lexes from the edited block only until the state matches what was
+// there before. The visible blocks are lexed first and the rest of the file
+// in short slices from the event loop.
+class CppHighlighter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CppHighlighter(QTextEdit *textEdit, QObject *parent = nullptr);
+
+    static bool handlesFile(const QString &fileName);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_; }
+    void setDarkPalette(bool dark);
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void processSlice();
+
+private:
+    void restart();
+    void clearFormats();
+    void advance(qint64 budgetMs);
+    void highlightViewport();
+    int lexBlock(QTextBlock &block, int state);
+
+    QTextEdit *textEdit_ = nullptr;
+    QTimer sliceTimer_;
+    QVector<QTextCharFormat> formats_;
+    bool enabled_ = false;
+    bool dark_ = false;
+
+    // Blocks before frontier_ have final formats. Blocks before lexedUntil_
+    // were final before the pending edits, which ended at dirtyUntil_.
+    int frontier_ = 0;
+    int lexedUntil_ = 0;
+    int dirtyUntil_ = -1;
+    int blockCount_ = 0;
+};
+
+#endif
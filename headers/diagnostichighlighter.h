@@ -0,0 +1,50 @@
+#ifndef DIAGNOSTICHIGHLIGHTER_H
+#define DIAGNOSTICHIGHLIGHTER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QPoint>
+#include <QVector>
+#include "lspclient.h"
+
+class QTextEdit;
+
+// Underlines language server diagnostics. Only the diagnostics on visible
+// lines become extra selections; scrolling re-selects from the sorted list.
+// Tooltips show the diagnostic under the mouse or ask for a hover.
+class DiagnosticHighlighter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DiagnosticHighlighter(QTextEdit *textEdit, QObject *parent = nullptr);
+
+    void setDiagnostics(const QVector<LspDiagnostic> &diagnostics);
+    void showHover(int position, const QString &text);
+
+    int errorCount() const { return errors_; }
+    int warningCount() const { return warnings_; }
+
+signals:
+    void hoverRequested(int position);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void schedule();
+    void render();
+
+private:
+    int positionOf(int line, int character) const;
+
+    QTextEdit *textEdit_ = nullptr;
+    QTimer renderTimer_;
+    QVector<LspDiagnostic> diagnostics_;
+    int errors_ = 0;
+    int warnings_ = 0;
+    int hoverPosition_ = -1;
+    QPoint hoverPoint_;
+};
+
+#endif
@@ -6,8 +6,11 @@
 #include <QFileInfo>
 #include <QDateTime>
 #include <QTextDocument>
+#include <QTextCursor>
 #include "idocument.h"
 
+class QTextEdit;
+
 class Document : public QObject, public IDocument
 {
     Q_OBJECT
@@ -17,6 +20,7 @@ public:
     explicit Document(const QString &text, QObject *parent = nullptr);
 
     QTextDocument *qtDocument() const;
+    void attachEditor(QTextEdit *editor);
 
     bool loadFromFile(const QString &fileName);
     bool saveToFile(const QString &fileName);
@@ -35,6 +39,13 @@ public:
     QString getAllText() const override;
     void insertTextAtCursor(const QString &text) override;
 
+    bool hasSelection() const override;
+    TextRange selectionRange() const override;
+    int characterCount() const override;
+    int blockCount() const override;
+    DocumentBlocks blocks(TextRange range) const override;
+    DocumentBlocks blocks() const override;
+
 public slots:
     void setModified(bool modified = true);
     void clear();
@@ -47,7 +58,9 @@ private:
     bool m_isNew = true;
 
     QTextDocument *m_doc;
+    QTextEdit *m_editor = nullptr;
 
+    QTextCursor editorCursor() const;
     void updateFileInfo();
 };
 
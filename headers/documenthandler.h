@@ -14,6 +14,9 @@ struct DocumentContext
     QString workingFile;
     QString originalExtension;
     bool isReadOnly = false;
+    // Bytes of the file the buffer was read from or written to; -1 when
+    // the handler cannot tell.
+    qint64 syncedBytes = -1;
 };
 
 class DocumentHandler
@@ -33,6 +36,10 @@ public:
                       QTextDocument *document,
                       DocumentContext &context,
                       QString &error) = 0;
+
+    virtual bool extractText(const QString &filePath,
+                             QString &text,
+                             QString &error) const = 0;
 };
 
 using DocumentHandlerPtr = std::unique_ptr<DocumentHandler>;
@@ -19,6 +19,8 @@ public:
 
     bool loadDocument(const QString &filePath, QTextDocument *document, QString &errorMessage);
     bool saveDocument(const QString &filePath, QTextDocument *document, QString &errorMessage);
+    bool extractText(const QString &filePath, QString &text, QString &errorMessage) const;
+    bool isPlainText(const QString &filePath) const;
 
     QString filterForOpenDialog() const;
     QString filterForSaveDialog() const;
@@ -0,0 +1,55 @@
+#ifndef EDITTOOLEXECUTOR_H
+#define EDITTOOLEXECUTOR_H
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QThreadPool>
+#include <QVector>
+#include "edittools.h"
+
+class QTextEdit;
+
+class EditToolExecutor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EditToolExecutor(QObject *parent = nullptr);
+    ~EditToolExecutor() override;
+
+    bool start(const IEditTool *tool, IDocument *document, QTextEdit *textEdit);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void started(const QString &toolName);
+    void progress(int percent);
+    void finished(const QString &message);
+
+private slots:
+    void onFinished();
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    struct Change
+    {
+        int position = 0;
+        int removed = 0;
+        int added = 0;
+    };
+
+    bool rebase(EditToolResult &result) const;
+    void apply(const EditToolResult &result);
+    void detach();
+
+    QThreadPool pool_;
+    QFutureWatcher<EditToolResult> watcher_;
+    QPointer<QTextEdit> textEdit_;
+    QMetaObject::Connection changeConnection_;
+    QVector<Change> changes_;
+    QString toolName_;
+    bool applying_ = false;
+};
+
+#endif
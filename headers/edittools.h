@@ -3,52 +3,104 @@
 
 #include <QTextEdit>
 #include <QString>
+#include <QVector>
 #include <memory>
 #include <vector>
 #include "idocument.h"
 
+class QThreadPool;
+
+struct EditToolInput {
+    QString text;
+    TextRange range;
+    bool selection = false;
+};
+
+struct EditToolEdit {
+    int position = 0;
+    int length = 0;
+    QString text;
+    // Written fragment by fragment so every changed fragment keeps its own
+    // format; only worth it for edits confined to a few characters.
+    bool keepFormats = false;
+};
+
+struct EditToolResult {
+    QVector<EditToolEdit> edits;
+    TextRange selection;
+    bool placeCursor = false;
+    QString message;
+};
+
+class EditToolControl {
+public:
+    virtual ~EditToolControl() = default;
+    virtual bool isCanceled() const = 0;
+    virtual void setProgress(int percent) = 0;
+    virtual QThreadPool* pool() const = 0;
+};
+
+// Plain text outside a live document, e.g. the buffer of a macro replay.
+class ITextSource {
+public:
+    virtual ~ITextSource() = default;
+    virtual int length() const = 0;
+    virtual QString text(TextRange range) const = 0;
+    virtual TextRange lineRange(int position) const = 0;
+};
+
+// snapshot() runs on the GUI thread; compute() runs on a worker against the
+// snapshot and must not touch the document or the editor. snapshotSource()
+// builds the same input from plain text and may run on any thread.
 class IEditTool {
 public:
     virtual ~IEditTool() = default;
     virtual QString getName() const = 0;
-    virtual void execute(IDocument* document, QTextEdit* textEdit) = 0;
     virtual bool canExecute(IDocument* document, QTextEdit* textEdit) const = 0;
+    virtual EditToolInput snapshot(IDocument* document) const = 0;
+    virtual EditToolInput snapshotSource(const ITextSource& source, TextRange selection) const;
+    virtual EditToolResult compute(const EditToolInput& input, EditToolControl& control) const = 0;
 };
 
 class UpperCaseTool : public IEditTool {
 public:
     QString getName() const override { return "To Upper Case"; }
-    void execute(IDocument* document, QTextEdit* textEdit) override;
     bool canExecute(IDocument* document, QTextEdit* textEdit) const override;
+    EditToolInput snapshot(IDocument* document) const override;
+    EditToolInput snapshotSource(const ITextSource& source, TextRange selection) const override;
+    EditToolResult compute(const EditToolInput& input, EditToolControl& control) const override;
 };
 
 class LowerCaseTool : public IEditTool {
 public:
     QString getName() const override { return "To Lower Case"; }
-    void execute(IDocument* document, QTextEdit* textEdit) override;
     bool canExecute(IDocument* document, QTextEdit* textEdit) const override;
+    EditToolInput snapshot(IDocument* document) const override;
+    EditToolInput snapshotSource(const ITextSource& source, TextRange selection) const override;
+    EditToolResult compute(const EditToolInput& input, EditToolControl& control) const override;
 };
 
 class WordCountTool : public IEditTool {
 public:
     QString getName() const override { return "Word Count"; }
-    void execute(IDocument* document, QTextEdit* textEdit) override;
     bool canExecute(IDocument* document, QTextEdit* textEdit) const override {
-        (void)document;
         (void)textEdit;
-        return true;
+        return document != nullptr;
     }
+    EditToolInput snapshot(IDocument* document) const override;
+    EditToolResult compute(const EditToolInput& input, EditToolControl& control) const override;
 };
 
 class DuplicateLineTool : public IEditTool {
 public:
     QString getName() const override { return "Duplicate Line"; }
-    void execute(IDocument* document, QTextEdit* textEdit) override;
     bool canExecute(IDocument* document, QTextEdit* textEdit) const override {
-        (void)document;
         (void)textEdit;
-        return true;
+        return document != nullptr;
     }
+    EditToolInput snapshot(IDocument* document) const override;
+    EditToolInput snapshotSource(const ITextSource& source, TextRange selection) const override;
+    EditToolResult compute(const EditToolInput& input, EditToolControl& control) const override;
 };
 
 class EditToolManager {
@@ -57,7 +109,7 @@ public:
 
     void registerTool(std::unique_ptr<IEditTool> tool);
     std::vector<IEditTool*> getAvailableTools() const;
-    void executeTool(const QString& name, IDocument* document, QTextEdit* textEdit) const;
+    IEditTool* findTool(const QString& name, IDocument* document, QTextEdit* textEdit) const;
 
 private:
     std::vector<std::unique_ptr<IEditTool>> tools_;
@@ -0,0 +1,61 @@
+#ifndef EXTERNALFILTER_H
+#define EXTERNALFILTER_H
+
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QStringDecoder>
+#include "idocument.h"
+
+class QTextEdit;
+
+// Pipes a selection (or the whole document) through a shell command and
+// replaces it with the command's output, like vim's "!". Input is encoded
+// straight from document views a chunk at a time and written only while
+// the pipe has room, so the input is never materialised as one string.
+class ExternalFilterRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ExternalFilterRunner(QObject *parent = nullptr);
+    ~ExternalFilterRunner() override;
+
+    bool start(const QString &command, IDocument *document, QTextEdit *textEdit);
+    bool isRunning() const;
+
+public slots:
+    void cancel();
+
+signals:
+    void started(const QString &command);
+    void progress(int percent);
+    void finished(const QString &message);
+
+private slots:
+    void feed();
+    void readOutput();
+    void readErrors();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onProcessError(QProcess::ProcessError error);
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    void apply();
+    void finish(const QString &message);
+
+    QProcess *process_ = nullptr;
+    IDocument *document_ = nullptr;
+    QPointer<QTextEdit> textEdit_;
+    QMetaObject::Connection changeConnection_;
+    QStringDecoder decoder_;
+    QString command_;
+    QString output_;
+    QByteArray errors_;
+    TextRange range_;
+    int fed_ = 0;
+    bool inputClosed_ = false;
+    bool applying_ = false;
+};
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef FILECHANGEMONITOR_H
+#define FILECHANGEMONITOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QDateTime>
+#include <QVector>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+
+class QTextEdit;
+
+// Replaces [start, end) of the buffer with text. Positions are in the
+// buffer with a line break appended, so every line has a terminator.
+struct ReloadEdit
+{
+    int start = 0;
+    int end = 0;
+    QString text;
+};
+
+struct ReloadPlan
+{
+    quint64 generation = 0;
+    int revision = 0;
+    QVector<ReloadEdit> edits;
+    qint64 milliseconds = 0;
+    // Bytes of the file the new text was decoded from.
+    qint64 bytes = -1;
+    QString error;
+};
+
+// Watches the open plain-text file. A change on disk is diffed against the
+// buffer on a worker thread and only the changed lines are replaced, in one
+// undo step, so the cursor, the scroll position and the undo history
+// survive. The editor's own saves are recognised by size and time stamp.
+class FileChangeMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FileChangeMonitor(QTextEdit *textEdit, QObject *parent = nullptr);
+    ~FileChangeMonitor() override;
+
+    // An empty path stops watching. syncedBytes is how much of the file the
+    // buffer holds; by default the current size.
+    void watch(const QString &filePath, qint64 syncedBytes = -1);
+    void noteSaved();
+    qint64 syncedBytes() const { return syncedBytes_; }
+    // Waits for a reload being planned and applies it.
+    void finishReload();
+    // The file no longer has the size and time stamp last seen; true before
+    // the settle delay has passed, too.
+    bool isChangedOnDisk() const;
+    bool isReloading() const { return planWatcher_.isRunning(); }
+
+public slots:
+    void reload();
+    // Checks at once instead of after the settle delay.
+    void checkNow();
+
+signals:
+    void changedOnDisk(const QString &filePath);
+    void removedOnDisk(const QString &filePath);
+    void reloaded(int hunks, qint64 milliseconds);
+    void failed(const QString &message);
+
+private slots:
+    void scheduleCheck();
+    void check();
+    void onPlanned();
+
+private:
+    void rememberState();
+    void handlePlan(const QFuture<ReloadPlan> &future);
+    void apply(const ReloadPlan &plan);
+
+    QTextEdit *textEdit_ = nullptr;
+    QFileSystemWatcher watcher_;
+    QTimer checkTimer_;
+    QFutureWatcher<ReloadPlan> planWatcher_;
+    QString filePath_;
+    QDateTime knownModified_;
+    qint64 knownSize_ = -1;
+    qint64 syncedBytes_ = -1;
+    quint64 generation_ = 0;
+    bool missing_ = false;
+};
+
+#endif
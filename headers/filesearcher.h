@@ -0,0 +1,97 @@
+#ifndef FILESEARCHER_H
+#define FILESEARCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QThreadPool>
+#include <memory>
+#include "searchengine.h"
+
+struct FileSearchHit
+{
+    QString filePath;
+    int line = 0;
+    int column = 0;
+    int length = 0;
+    QString preview;
+};
+
+struct FileSearchRequest
+{
+    QString rootPath;
+    QStringList nameFilters;
+    QStringList files;
+    QHash<QString, QString> textSources;
+    SearchQuery query;
+    int maxHitsPerFile = 1000;
+    int maxTotalHits = 100000;
+};
+
+struct FileSearchStats
+{
+    qint64 filesScanned = 0;
+    qint64 filesSkipped = 0;
+    qint64 bytesScanned = 0;
+    qint64 hits = 0;
+    qint64 elapsedMs = 0;
+    bool canceled = false;
+};
+
+class FileScanner
+{
+public:
+    explicit FileScanner(const SearchQuery &query);
+
+    bool isValid() const { return searcher_.isValid(); }
+
+    QVector<FileSearchHit> scanFile(const QString &filePath, int maxHits,
+                                    qint64 *bytesScanned = nullptr, bool *skipped = nullptr) const;
+    QVector<FileSearchHit> scanText(const QString &filePath, QStringView text, int maxHits) const;
+
+    static bool isBinaryContent(const char *data, qint64 size);
+
+private:
+    QVector<FileSearchHit> scanBytes(const QString &filePath, const char *data, qint64 size, int maxHits) const;
+    const char *findBytes(const char *from, const char *end) const;
+    bool isWordBoundary(const char *begin, const char *end, const char *hit) const;
+
+    TextSearcher searcher_;
+    QByteArray needle_;
+    QByteArray foldedNeedle_;
+    bool byteSearch_ = false;
+    bool asciiFold_ = false;
+};
+
+class ParallelFileSearcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ParallelFileSearcher(QObject *parent = nullptr);
+    ~ParallelFileSearcher() override;
+
+    void start(const FileSearchRequest &request);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void hitsFound(const QVector<FileSearchHit> &hits);
+    void progress(qint64 filesScanned);
+    void finished(const FileSearchStats &stats);
+
+private:
+    struct Run;
+
+    void walk(const std::shared_ptr<Run> &run);
+    void work(const std::shared_ptr<Run> &run, int workerIndex);
+    void finishWorker(const std::shared_ptr<Run> &run);
+
+    QThreadPool pool_;
+    std::shared_ptr<Run> current_;
+};
+
+#endif
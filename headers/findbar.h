@@ -0,0 +1,103 @@
+#ifndef FINDBAR_H
+#define FINDBAR_H
+
+#include <QWidget>
+#include <QFutureWatcher>
+#include <QVector>
+#include <array>
+#include <memory>
+#include "searchengine.h"
+#include "foldedshadow.h"
+
+class QTextEdit;
+class QLineEdit;
+class QCheckBox;
+class QLabel;
+class QTimer;
+class QToolButton;
+
+struct SearchBatch
+{
+    int region = 0;
+    QVector<SearchMatch> matches;
+};
+
+class FindBar : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit FindBar(QTextEdit *textEdit, QWidget *parent = nullptr);
+    ~FindBar() override;
+
+    void activate();
+    void activateReplace();
+    SearchQuery currentQuery() const;
+    bool isFolded() const;
+
+public slots:
+    void findNext();
+    void findPrevious();
+    void closeBar();
+    void replaceCurrent();
+    void replaceAll();
+
+signals:
+    void statusMessage(const QString &message);
+    void navigated(const SearchQuery &query, bool backward);
+
+private slots:
+    void scheduleSearch();
+    void startSearch();
+    void onBatchReady(int resultIndex);
+    void onSearchFinished();
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void updateHighlights();
+    void onReplacePlanReady();
+
+private:
+    enum Region { VisibleRegion = 0, BeforeRegion = 1, AfterRegion = 2 };
+
+    const QString &snapshot();
+    QPair<qsizetype, qsizetype> visibleRange(qsizetype margin = 0) const;
+    const QVector<SearchMatch> &sortedMatches();
+    void cancelSearch();
+    void selectMatch(const SearchMatch &match);
+    void updateCountLabel();
+
+    QTextEdit *textEdit_ = nullptr;
+    QLineEdit *findEdit_ = nullptr;
+    QCheckBox *caseCheck_ = nullptr;
+    QCheckBox *wordCheck_ = nullptr;
+    QCheckBox *regexCheck_ = nullptr;
+    QCheckBox *foldCheck_ = nullptr;
+    QLabel *countLabel_ = nullptr;
+    QToolButton *prevButton_ = nullptr;
+    QToolButton *nextButton_ = nullptr;
+    QToolButton *closeButton_ = nullptr;
+    QWidget *replaceRow_ = nullptr;
+    QLineEdit *replaceEdit_ = nullptr;
+    QToolButton *replaceButton_ = nullptr;
+    QToolButton *replaceAllButton_ = nullptr;
+    QTimer *searchTimer_ = nullptr;
+    FoldedShadow *shadow_ = nullptr;
+
+    QFutureWatcher<SearchBatch> watcher_;
+    QFutureWatcher<ReplacePlan> replaceWatcher_;
+    std::array<QVector<SearchMatch>, 3> regionMatches_;
+    QVector<SearchMatch> merged_;
+    bool mergedDirty_ = false;
+
+    SearchQuery lastQuery_;
+    bool lastFolded_ = false;
+    quint64 lastQueryRevision_ = 0;
+    bool lastSearchComplete_ = false;
+    qsizetype currentMatch_ = -1;
+    int pendingJump_ = 0;
+
+    QString snapshot_;
+    quint64 snapshotRevision_ = 0;
+    quint64 contentsRevision_ = 1;
+};
+
+#endif
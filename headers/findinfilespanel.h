@@ -0,0 +1,71 @@
+#ifndef FINDINFILESPANEL_H
+#define FINDINFILESPANEL_H
+
+#include <QWidget>
+#include <QHash>
+#include "filesearcher.h"
+#include "workspaceindex.h"
+#include "workspacereplace.h"
+
+class QLineEdit;
+class QCheckBox;
+class QPushButton;
+class QLabel;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+class FindInFilesPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit FindInFilesPanel(QWidget *parent = nullptr);
+
+    void setRootPath(const QString &path);
+    void activate(const QString &initialPattern = QString());
+
+signals:
+    void openRequested(const QString &filePath, int line, int column);
+    void filesRewritten(const QStringList &files);
+
+private slots:
+    void browse();
+    void startSearch();
+    void stopSearch();
+    void onHitsFound(const QVector<FileSearchHit> &hits);
+    void onProgress(qint64 filesScanned);
+    void onFinished(const FileSearchStats &stats);
+    void onItemActivated(QTreeWidgetItem *item, int column);
+    void onIndexToggled(bool enabled);
+    void startReplace();
+    void onReplacePlanReady(const QVector<FileReplacePlan> &plans);
+    void onReplaceCommitted(const ReplaceCommitResult &result);
+    void onIndexProgress(qint64 done, qint64 total);
+
+private:
+    FileSearchRequest buildRequest() const;
+
+    bool applyIndex(FileSearchRequest &request);
+
+    ParallelFileSearcher searcher_;
+    WorkspaceIndex index_;
+    WorkspaceReplacer replacer_;
+    QLineEdit *rootEdit_ = nullptr;
+    QLineEdit *patternEdit_ = nullptr;
+    QLineEdit *filterEdit_ = nullptr;
+    QLineEdit *replaceEdit_ = nullptr;
+    QCheckBox *caseCheck_ = nullptr;
+    QCheckBox *wordCheck_ = nullptr;
+    QCheckBox *regexCheck_ = nullptr;
+    QCheckBox *indexCheck_ = nullptr;
+    QPushButton *searchButton_ = nullptr;
+    QPushButton *stopButton_ = nullptr;
+    QPushButton *replaceButton_ = nullptr;
+    QLabel *statusLabel_ = nullptr;
+    QTreeWidget *resultsTree_ = nullptr;
+    QHash<QString, QTreeWidgetItem *> fileItems_;
+    qint64 hitCount_ = 0;
+    QString indexNote_;
+};
+
+#endif
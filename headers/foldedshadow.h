@@ -0,0 +1,61 @@
+#ifndef FOLDEDSHADOW_H
+#define FOLDEDSHADOW_H
+
+#include <QObject>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include <QHash>
+#include <memory>
+#include <vector>
+
+class QTextDocument;
+class QTextBlock;
+
+struct FoldedSnapshot
+{
+    QString text;
+    std::vector<qsizetype> foldedStarts;
+    std::vector<qsizetype> originalStarts;
+    QHash<qsizetype, QVector<int>> maps;
+
+    qsizetype toOriginal(qsizetype folded) const;
+    qsizetype toFolded(qsizetype original) const;
+};
+
+class FoldedShadow : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FoldedShadow(QTextDocument *document, QObject *parent = nullptr);
+
+    std::shared_ptr<const FoldedSnapshot> snapshot();
+
+    static QString fold(QStringView text, QVector<int> *map = nullptr);
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    struct BlockShadow
+    {
+        QString folded;
+        QVector<int> map;
+        bool valid = false;
+    };
+
+    const BlockShadow &blockShadow(const QTextBlock &block, size_t index);
+    void rebuild();
+    void patch();
+
+    QTextDocument *document_ = nullptr;
+    std::vector<BlockShadow> blocks_;
+    bool attached_ = false;
+    std::shared_ptr<FoldedSnapshot> snapshot_;
+    // Blocks changed since the last snapshot, in current block numbers.
+    int dirtyFirst_ = -1;
+    int dirtyLast_ = -1;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef GITGUTTER_H
+#define GITGUTTER_H
+
+#include <QWidget>
+#include <QTimer>
+#include <QVector>
+#include <QFutureWatcher>
+
+class QTextEdit;
+
+struct GitLineChange
+{
+    enum Kind { Added, Modified, Deleted };
+
+    int first = 0;   // block number; a deletion sits above this block
+    int count = 0;
+    Kind kind = Added;
+};
+
+struct GitGutterDiff
+{
+    quint64 generation = 0;
+    QVector<size_t> base;
+    QVector<GitLineChange> changes;
+};
+
+// Added, modified and deleted line markers beside the editor. The HEAD
+// version of the file is read with `git show` once per open; after that the
+// block hashes are patched on every edit and diffed against HEAD on a
+// worker thread.
+class GitGutter : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit GitGutter(QTextEdit *textEdit, QWidget *parent = nullptr);
+    ~GitGutter() override;
+
+    void setFile(const QString &filePath);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void startDiff();
+    void onDiffed();
+
+private:
+    void rebuildHashes();
+    int blockTop(int blockNumber) const;
+
+    QTextEdit *textEdit_ = nullptr;
+    QFutureWatcher<GitGutterDiff> diffWatcher_;
+    QTimer diffTimer_;
+    QString baseText_;
+    QVector<size_t> base_;
+    QVector<size_t> current_;
+    QVector<GitLineChange> changes_;
+    quint64 generation_ = 0;
+    bool tracked_ = false;
+    bool diffPending_ = false;
+};
+
+#endif
@@ -2,7 +2,92 @@
 #define IDOCUMENT_H
 
 #include <QString>
+#include <QStringView>
 #include <QColor>
+#include <QTextBlock>
+
+struct TextRange
+{
+    int start = 0;
+    int end = 0;
+
+    bool isEmpty() const { return end <= start; }
+    int length() const { return end - start; }
+};
+
+struct TextChunk
+{
+    QStringView text;
+    QStringView blockText;
+    int position = 0;
+    int blockPosition = 0;
+    int blockNumber = 0;
+};
+
+class DocumentBlocks
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator() = default;
+        Iterator(const QTextBlock &block, TextRange range)
+            : block_(block), range_(range)
+        {
+            load();
+        }
+
+        const TextChunk &operator*() const { return chunk_; }
+        const TextChunk *operator->() const { return &chunk_; }
+
+        Iterator &operator++()
+        {
+            block_ = block_.next();
+            load();
+            return *this;
+        }
+
+        bool operator==(const Iterator &other) const { return block_ == other.block_; }
+        bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+    private:
+        void load()
+        {
+            if (!block_.isValid() || block_.position() > range_.end) {
+                block_ = QTextBlock();
+                text_.clear();
+                chunk_ = TextChunk{};
+                return;
+            }
+            text_ = block_.text();
+            const int blockPosition = block_.position();
+            const int from = qBound(0, range_.start - blockPosition, static_cast<int>(text_.size()));
+            const int to = qBound(from, range_.end - blockPosition, static_cast<int>(text_.size()));
+            chunk_.blockText = text_;
+            chunk_.text = QStringView(text_).sliced(from, to - from);
+            chunk_.position = blockPosition + from;
+            chunk_.blockPosition = blockPosition;
+            chunk_.blockNumber = block_.blockNumber();
+        }
+
+        QTextBlock block_;
+        TextRange range_;
+        QString text_;
+        TextChunk chunk_;
+    };
+
+    DocumentBlocks(const QTextBlock &first, TextRange range)
+        : first_(first), range_(range)
+    {
+    }
+
+    Iterator begin() const { return Iterator(first_, range_); }
+    Iterator end() const { return Iterator(); }
+
+private:
+    QTextBlock first_;
+    TextRange range_;
+};
 
 class IDocument {
 public:
@@ -12,6 +97,13 @@ public:
     virtual QString getAllText() const = 0;
     virtual QString getPlainText() const = 0;
 
+    virtual bool hasSelection() const = 0;
+    virtual TextRange selectionRange() const = 0;
+    virtual int characterCount() const = 0;
+    virtual int blockCount() const = 0;
+    virtual DocumentBlocks blocks(TextRange range) const = 0;
+    virtual DocumentBlocks blocks() const = 0;
+
     virtual void setPlainText(const QString &text) = 0;
     virtual void insertTextAtCursor(const QString &text) = 0;
 
@@ -22,6 +22,10 @@ public:
               DocumentContext &context,
               QString &error) override;
 
+    bool extractText(const QString &filePath,
+                     QString &text,
+                     QString &error) const override;
+
 private:
     bool ensureLibreOfficeAvailable(QString &error) const;
     QString findLibreOfficeExecutable() const;
@@ -29,6 +33,10 @@ private:
                        const QString &outputDir,
                        QString &htmlFilePath,
                        QString &error) const;
+    bool convertToPlainText(const QString &filePath,
+                            const QString &outputDir,
+                            QString &textFilePath,
+                            QString &error) const;
     bool convertFromHtml(const QString &htmlPath,
                          const QString &targetFormat,
                          const QString &destinationPath,
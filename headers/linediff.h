@@ -0,0 +1,55 @@
+#ifndef LINEDIFF_H
+#define LINEDIFF_H
+
+#include <QList>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+// A replaced range: oldCount lines at oldStart became newCount lines at
+// newStart. Pure insertions have oldCount == 0, deletions newCount == 0.
+struct DiffHunk
+{
+    int oldStart = 0;
+    int oldCount = 0;
+    int newStart = 0;
+    int newCount = 0;
+};
+
+// Changed characters of one line of a hunk; line counts from the hunk start.
+struct WordRange
+{
+    int line = 0;
+    int start = 0;
+    int length = 0;
+};
+
+struct WordDiff
+{
+    QVector<WordRange> oldRanges;
+    QVector<WordRange> newRanges;
+};
+
+namespace LineDiff {
+
+size_t hashLine(QStringView line);
+// Lines are split on '\n' with the SIMD scan of SearchEngine; a trailing
+// '\r' is dropped. A text ending in '\n' has an empty last line, as a
+// QTextDocument has an empty last block.
+QList<QStringView> splitLines(QStringView text);
+QVector<size_t> hashLines(QStringView text);
+QVector<size_t> hashLines(const QList<QStringView> &lines);
+
+// Histogram diff: the rarest line common to both sides anchors the longest
+// matching run, and the ranges around it are diffed recursively. Ranges
+// without a rare common line fall back to Myers' O(ND) diff in linear space,
+// which past a cost limit picks its split point greedily.
+QVector<DiffHunk> diff(const QVector<size_t> &oldLines, const QVector<size_t> &newLines);
+
+// Word-level diff of a changed hunk: words, runs of spaces and single
+// punctuation characters are compared as tokens.
+WordDiff refineWords(const QList<QStringView> &oldLines, const QList<QStringView> &newLines);
+
+}
+
+#endif
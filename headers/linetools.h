@@ -0,0 +1,44 @@
+#ifndef LINETOOLS_H
+#define LINETOOLS_H
+
+#include <QString>
+#include <QStringView>
+#include <QThreadPool>
+#include "edittools.h"
+
+namespace LineTransform {
+
+enum class Operation {
+    SortLexical,
+    SortNumeric,
+    SortNatural,
+    SortLocale,
+    Unique,
+    Reverse,
+    Shuffle,
+    TrimTrailing,
+    RemoveBlank
+};
+
+// Checks control for cancel during long passes; the result of a canceled
+// run is meaningless.
+QString apply(QStringView text, Operation operation, EditToolControl& control);
+
+}
+
+class LineTransformTool : public IEditTool {
+public:
+    LineTransformTool(const QString& name, LineTransform::Operation operation);
+
+    QString getName() const override { return name_; }
+    bool canExecute(IDocument* document, QTextEdit* textEdit) const override;
+    EditToolInput snapshot(IDocument* document) const override;
+    EditToolInput snapshotSource(const ITextSource& source, TextRange selection) const override;
+    EditToolResult compute(const EditToolInput& input, EditToolControl& control) const override;
+
+private:
+    QString name_;
+    LineTransform::Operation operation_;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef LOGFOLLOWER_H
+#define LOGFOLLOWER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFile>
+#include <QByteArray>
+#include <QStringDecoder>
+#include <QFileSystemWatcher>
+
+class QTextEdit;
+
+// Follows a growing log like tail -F. Only the bytes appended after the last
+// read offset are read, and they are added to the end of the buffer at most
+// linesPerFrame() lines per frame. The frame timer runs only while there is
+// something to append, so an idle file costs nothing but the watcher.
+// A truncated file is read again from the start; after a rotation the old
+// file is drained and the new one followed from its beginning.
+class LogFollower : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LogFollower(QTextEdit *textEdit, QObject *parent = nullptr);
+
+    // offset is how much of the file the buffer already holds; a negative
+    // one starts at the current end.
+    bool start(const QString &filePath, qint64 offset, QString &error);
+    void stop();
+    bool isFollowing() const { return file_.isOpen(); }
+    qint64 offset() const { return offset_; }
+
+    void setLinesPerFrame(int lines);
+    int linesPerFrame() const { return linesPerFrame_; }
+
+signals:
+    void followingChanged(bool following);
+    void statusMessage(const QString &message);
+
+private slots:
+    void wake();
+    void onFrame();
+    void onScrolled(int value);
+    void onRangeChanged(int minimum, int maximum);
+
+private:
+    void checkFile();
+    void reopen();
+    void readAvailable();
+    void append(QStringView text);
+
+    QTextEdit *textEdit_ = nullptr;
+    QFile file_;
+    QFileSystemWatcher watcher_;
+    QTimer frameTimer_;
+    QStringDecoder decoder_;
+    QByteArray identity_;
+    QString pending_;
+    qsizetype pendingPos_ = 0;
+    qint64 offset_ = 0;
+    int linesPerFrame_ = 0;
+    bool autoScroll_ = true;
+    bool wasReadOnly_ = false;
+    bool hadUndo_ = true;
+};
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef LSPCLIENT_H
+#define LSPCLIENT_H
+
+#include <QObject>
+#include <QPointer>
+#include <QProcess>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QVector>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonValue>
+
+class QTextDocument;
+
+// Positions are LSP line/character pairs in UTF-16 code units, which is what
+// QString and QTextBlock columns already are.
+struct LspDiagnostic
+{
+    enum Severity { Error = 1, Warning = 2, Information = 3, Hint = 4 };
+
+    int startLine = 0;
+    int startCharacter = 0;
+    int endLine = 0;
+    int endCharacter = 0;
+    int severity = Error;
+    QString message;
+    QString source;
+};
+
+struct LspCompletionItem
+{
+    QString label;
+    QString insertText;
+    QString detail;
+};
+
+// Language server client over stdio (clangd by default). One document is
+// synchronised at a time: edits are sent as incremental ranges, coalesced
+// and flushed on a short timer, and completion/hover requests that were
+// overtaken by newer ones or by edits are cancelled on the server.
+class LspClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LspClient(QObject *parent = nullptr);
+    ~LspClient() override;
+
+    static bool isAvailable(const QString &program = "clangd");
+
+    bool start(const QString &rootPath, const QString &program = "clangd");
+    void stop();
+    bool isRunning() const;
+    QString rootPath() const { return rootPath_; }
+    bool hasDocument() const { return !uri_.isEmpty(); }
+
+    void openDocument(const QString &filePath, QTextDocument *document);
+    void closeDocument();
+
+    void requestCompletion(int position);
+    void requestHover(int position);
+
+signals:
+    void diagnosticsChanged(const QVector<LspDiagnostic> &diagnostics);
+    void completionReady(int position, const QVector<LspCompletionItem> &items);
+    void hoverReady(int position, const QString &text);
+    void requestTraced(const QString &method, qint64 milliseconds);
+    void statusMessage(const QString &message);
+
+private slots:
+    void readOutput();
+    void onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void flushChanges();
+    void sendHover();
+
+private:
+    struct PendingRequest
+    {
+        QString method;
+        QElapsedTimer timer;
+        int position = -1;
+        int version = 0;
+    };
+
+    qint64 sendRequest(const QString &method, const QJsonObject &params, int position = -1);
+    void sendNotification(const QString &method, const QJsonValue &params);
+    void sendMessage(const QJsonObject &message);
+    void cancelRequest(qint64 &id);
+    void handleMessage(const QJsonObject &message);
+    void handleResponse(qint64 id, const QJsonObject &message);
+    void handleNotification(const QString &method, const QJsonObject &params);
+    void resyncAll();
+    QJsonObject positionAt(int position) const;
+    QJsonObject documentPosition(int position) const;
+
+    QProcess *process_ = nullptr;
+    QString rootPath_;
+    QByteArray buffer_;
+    qint64 nextId_ = 1;
+    bool initialized_ = false;
+    QVector<QJsonObject> queued_;
+    QHash<qint64, PendingRequest> pending_;
+    qint64 completionId_ = -1;
+    qint64 hoverId_ = -1;
+
+    QPointer<QTextDocument> document_;
+    QMetaObject::Connection changeConnection_;
+    QString uri_;
+    // Text as the server last saw it; old ranges of an edit are computed
+    // from here because the document already holds the new text.
+    QString mirror_;
+    int version_ = 0;
+    QJsonArray pendingChanges_;
+    int insertEnd_ = -1;
+    QTimer changeTimer_;
+    QTimer hoverTimer_;
+    int hoverPosition_ = -1;
+};
+
+#endif
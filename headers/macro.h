@@ -0,0 +1,93 @@
+#ifndef MACRO_H
+#define MACRO_H
+
+#include <QObject>
+#include <QString>
+#include <QTextCursor>
+#include <QVector>
+#include <memory>
+#include "edittools.h"
+#include "searchengine.h"
+
+class QTextEdit;
+class QKeyEvent;
+
+// A macro is recorded as semantic operations rather than raw key events, so
+// replay does not depend on widget state such as the viewport or the font.
+struct MacroStep
+{
+    enum class Kind { Insert, DeleteBackward, DeleteForward, Move, Find, Tool };
+
+    Kind kind = Kind::Insert;
+    QString text;
+    int count = 1;
+    QTextCursor::MoveOperation operation = QTextCursor::NoMove;
+    QTextCursor::MoveMode mode = QTextCursor::MoveAnchor;
+    SearchQuery query;
+    bool backward = false;
+};
+
+class MacroRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MacroRecorder(QTextEdit *textEdit, QObject *parent = nullptr);
+
+    bool isRecording() const { return recording_; }
+    const QVector<MacroStep> &macro() const { return steps_; }
+
+public slots:
+    void start();
+    void stop();
+    void recordTool(const QString &toolName);
+    void recordFind(const SearchQuery &query, bool backward);
+
+signals:
+    void recordingChanged(bool recording);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    void recordKey(const QKeyEvent *event);
+    void recordMove(QTextCursor::MoveOperation operation, QTextCursor::MoveMode mode);
+    void append(const MacroStep &step);
+
+    QTextEdit *textEdit_ = nullptr;
+    QVector<MacroStep> steps_;
+    bool recording_ = false;
+};
+
+// Replays a macro N times (or until the cursor stops advancing towards the
+// end of the document) against a private copy of the text. All iterations
+// are folded into one list of edits that the executor applies in a single
+// edit block, so the editor is neither repainted nor relaid out in between.
+class MacroReplayTool : public IEditTool
+{
+public:
+    MacroReplayTool(const QVector<MacroStep> &macro, const EditToolManager &tools, int iterations);
+    ~MacroReplayTool() override;
+
+    QString getName() const override { return "Macro Replay"; }
+    bool canExecute(IDocument *document, QTextEdit *textEdit) const override;
+    EditToolInput snapshot(IDocument *document) const override;
+    EditToolResult compute(const EditToolInput &input, EditToolControl &control) const override;
+
+    bool isValid() const { return error_.isEmpty(); }
+    QString errorString() const { return error_; }
+
+private:
+    struct CompiledStep
+    {
+        MacroStep step;
+        const IEditTool *tool = nullptr;
+        std::shared_ptr<const TextSearcher> searcher;
+    };
+
+    QVector<CompiledStep> steps_;
+    int iterations_ = 1;
+    QString error_;
+};
+
+#endif
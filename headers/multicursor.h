@@ -0,0 +1,81 @@
+#ifndef MULTICURSOR_H
+#define MULTICURSOR_H
+
+#include <QObject>
+#include <QPoint>
+#include <QTextCursor>
+#include <QVector>
+
+class QTextEdit;
+class QWidget;
+class QKeyEvent;
+class QMouseEvent;
+class QPainter;
+
+// Extra carets are kept as plain offsets rather than QTextCursor objects:
+// the document updates every live QTextCursor on each change, which makes
+// N cursors times N edits quadratic.
+class MultiCursorController : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit MultiCursorController(QTextEdit *textEdit, QObject *parent = nullptr);
+    ~MultiCursorController() override;
+
+    int cursorCount() const;
+    bool isActive() const { return carets_.size() > 1; }
+
+public slots:
+    void addCaretAbove();
+    void addCaretBelow();
+    void clear();
+
+signals:
+    void cursorCountChanged(int count);
+    void editApplied(int cursors, qint64 nanoseconds);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    struct Caret
+    {
+        int anchor = 0;
+        int position = 0;
+        bool primary = false;
+
+        int start() const { return qMin(anchor, position); }
+        int end() const { return qMax(anchor, position); }
+        bool hasSelection() const { return anchor != position; }
+    };
+
+    enum class EditKind { Insert, Backspace, Delete };
+
+    bool isHandledKey(const QKeyEvent *event) const;
+    bool handleKey(QKeyEvent *event);
+    bool handleMouse(QEvent *event);
+    void edit(EditKind kind, const QString &text);
+    void move(QTextCursor::MoveOperation operation, QTextCursor::MoveMode mode);
+    void addCaret(int anchor, int position);
+    void addCaretVertically(QTextCursor::MoveOperation operation);
+    void setColumnSelection(const QPoint &from, const QPoint &to);
+    void adoptEditorCursor();
+    void normalize();
+    void syncPrimary();
+    void refresh();
+    void paintCarets(QPainter &painter) const;
+
+    QTextEdit *textEdit_ = nullptr;
+    QWidget *overlay_ = nullptr;
+    QVector<Caret> carets_;
+    bool applying_ = false;
+    bool columnDrag_ = false;
+    bool dragMoved_ = false;
+    QPoint dragOrigin_;
+};
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef OCCURRENCEHIGHLIGHTER_H
+#define OCCURRENCEHIGHLIGHTER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFutureWatcher>
+#include <QVector>
+#include "searchengine.h"
+
+class QTextEdit;
+
+struct OccurrenceBatch
+{
+    quint64 generation = 0;
+    QVector<SearchMatch> matches;
+};
+
+struct OccurrenceCount
+{
+    qsizetype count = 0;
+    qsizetype scanned = 0;
+    qsizetype total = 0;
+};
+
+class OccurrenceHighlighter : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OccurrenceHighlighter(QTextEdit *textEdit, QObject *parent = nullptr);
+    ~OccurrenceHighlighter() override;
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_; }
+
+signals:
+    void countChanged(const QString &message);
+
+private slots:
+    void schedule();
+    void startVisibleJob();
+    void startCountJob();
+    void onVisibleReady();
+    void onCountProgress(int resultIndex);
+    void onCountFinished();
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+
+private:
+    SearchQuery termUnderCursor() const;
+    void clear();
+
+    QTextEdit *textEdit_ = nullptr;
+    QTimer visibleTimer_;
+    QTimer countTimer_;
+    QFutureWatcher<OccurrenceBatch> visibleWatcher_;
+    QFutureWatcher<OccurrenceCount> countWatcher_;
+
+    bool enabled_ = true;
+    quint64 generation_ = 0;
+    SearchQuery term_;
+    SearchQuery countedTerm_;
+    quint64 countedRevision_ = 0;
+    quint64 contentsRevision_ = 1;
+};
+
+#endif
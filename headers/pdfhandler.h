@@ -19,6 +19,10 @@ public:
               DocumentContext &context,
               QString &error) override;
 
+    bool extractText(const QString &filePath,
+                     QString &text,
+                     QString &error) const override;
+
 private:
     bool ensurePdfToolsAvailable(QString &error) const;
     bool convertPdfToHtmlStdout(const QString &pdfPath, QString &htmlOut, QString &error) const;
@@ -0,0 +1,119 @@
+#ifndef PDFSEARCH_H
+#define PDFSEARCH_H
+
+#include <QObject>
+#include <QWidget>
+#include <QString>
+#include <QVector>
+#include <QHash>
+#include <QPolygonF>
+#include <QFutureWatcher>
+#include <QtPdfWidgets/QPdfView>
+
+class QPdfDocument;
+class QLineEdit;
+class QListWidget;
+class QListWidgetItem;
+class QLabel;
+class QTimer;
+
+struct PdfSearchHit
+{
+    int page = -1;
+    int offset = 0;
+    int length = 0;
+    QString context;
+};
+
+struct PdfPageText
+{
+    int page = -1;
+    QString text;
+};
+
+class PdfTextIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PdfTextIndex(QObject *parent = nullptr);
+    ~PdfTextIndex() override;
+
+    void build(const QString &filePath);
+    void cancel();
+
+    int pageCount() const { return pageCount_; }
+    int indexedPageCount() const { return static_cast<int>(foldedPages_.size()); }
+    bool isComplete() const { return pageCount_ >= 0 && indexedPageCount() >= pageCount_; }
+
+    QVector<PdfSearchHit> search(const QString &query);
+
+signals:
+    void pageIndexed(int page);
+    void indexingFinished();
+
+private:
+    struct CachedResult {
+        int coveredPages = 0;
+        QVector<PdfSearchHit> hits;
+    };
+
+    void onPageReady(int resultIndex);
+    void searchPages(const QString &foldedQuery, int fromPage, int toPage, QVector<PdfSearchHit> &hits) const;
+
+    QFutureWatcher<PdfPageText> watcher_;
+    QVector<QString> pages_;
+    QVector<QString> foldedPages_;
+    QHash<QString, CachedResult> cache_;
+    int pageCount_ = -1;
+};
+
+class PdfSearchView : public QPdfView
+{
+    Q_OBJECT
+
+public:
+    explicit PdfSearchView(QWidget *parent = nullptr);
+
+    void showHit(const PdfSearchHit &hit);
+    void clearHighlight();
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QRect pageGeometry(int page) const;
+
+    int highlightPage_ = -1;
+    QList<QPolygonF> highlightBounds_;
+};
+
+class PdfSearchPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit PdfSearchPanel(PdfSearchView *view, QWidget *parent = nullptr);
+
+    void setDocumentFile(const QString &filePath);
+    void activate();
+
+private slots:
+    void scheduleSearch();
+    void runSearch();
+    void onPageIndexed(int page);
+    void onItemActivated(QListWidgetItem *item);
+
+private:
+    void updateStatus();
+
+    PdfSearchView *view_ = nullptr;
+    PdfTextIndex index_;
+    QLineEdit *queryEdit_ = nullptr;
+    QListWidget *resultsList_ = nullptr;
+    QLabel *statusLabel_ = nullptr;
+    QTimer *searchTimer_ = nullptr;
+    QVector<PdfSearchHit> hits_;
+};
+
+#endif
@@ -18,6 +18,17 @@ public:
               QTextDocument *document,
               DocumentContext &context,
               QString &error) override;
+
+    bool extractText(const QString &filePath,
+                     QString &text,
+                     QString &error) const override;
+
+    // Reads the file as UTF-8; bytesRead is the number of bytes the text
+    // was decoded from, which may differ from the size seen before reading.
+    static bool readText(const QString &filePath,
+                         QString &text,
+                         qint64 &bytesRead,
+                         QString &error);
 };
 
 #endif
@@ -0,0 +1,29 @@
+#ifndef REPLACEPREVIEWDIALOG_H
+#define REPLACEPREVIEWDIALOG_H
+
+#include <QDialog>
+#include <QVector>
+#include "workspacereplace.h"
+
+class QTreeWidget;
+class QLabel;
+
+class ReplacePreviewDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    ReplacePreviewDialog(const QVector<FileReplacePlan> &plans, QWidget *parent = nullptr);
+
+    QVector<FileReplacePlan> selectedPlans() const;
+
+private slots:
+    void updateSummary();
+
+private:
+    QVector<FileReplacePlan> plans_;
+    QTreeWidget *tree_ = nullptr;
+    QLabel *summaryLabel_ = nullptr;
+};
+
+#endif
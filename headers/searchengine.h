@@ -0,0 +1,118 @@
+#ifndef SEARCHENGINE_H
+#define SEARCHENGINE_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QRegularExpression>
+#include <array>
+#include <functional>
+
+struct SearchOptions
+{
+    bool caseSensitive = false;
+    bool wholeWords = false;
+    bool regex = false;
+
+    bool operator==(const SearchOptions &other) const = default;
+};
+
+struct SearchQuery
+{
+    QString pattern;
+    SearchOptions options;
+
+    bool isEmpty() const { return pattern.isEmpty(); }
+};
+
+struct SearchMatch
+{
+    qsizetype start = 0;
+    qsizetype length = 0;
+
+    qsizetype end() const { return start + length; }
+    bool operator<(const SearchMatch &other) const { return start < other.start; }
+};
+
+// One replaced match; the text between matches is never part of an edit,
+// so its formatting and embedded objects stay untouched.
+struct ReplaceEdit
+{
+    qsizetype start = 0;
+    qsizetype length = 0;
+    QString text;
+};
+
+struct ReplacePlan
+{
+    QVector<ReplaceEdit> edits;
+    quint64 revision = 0;
+};
+
+class RegexCache
+{
+public:
+    static RegexCache &instance();
+
+    QRegularExpression get(const QString &pattern, QRegularExpression::PatternOptions options);
+
+private:
+    RegexCache() = default;
+
+    static constexpr qsizetype kCapacity = 32;
+
+    QMutex mutex_;
+    QHash<QString, QRegularExpression> entries_;
+    QList<QString> order_;
+};
+
+namespace SearchEngine {
+
+qsizetype findChar(QStringView text, char16_t ch, qsizetype from, qsizetype to);
+qsizetype findEitherChar(QStringView text, char16_t first, char16_t second, qsizetype from, qsizetype to);
+// Letters, digits and '_' make up words for whole-word matching.
+bool isWordChar(char32_t ch);
+
+}
+
+class TextSearcher
+{
+public:
+    explicit TextSearcher(const SearchQuery &query);
+
+    bool isValid() const { return valid_; }
+    QString errorString() const { return error_; }
+    const SearchQuery &query() const { return query_; }
+
+    bool findNext(QStringView text, qsizetype from, qsizetype to, SearchMatch &match) const;
+    qsizetype findAll(QStringView text, qsizetype from, qsizetype to,
+                      QVector<SearchMatch> &matches, qsizetype limit = -1) const;
+    bool matchesAt(QStringView text, qsizetype position, qsizetype length) const;
+
+    QString replacementAt(QStringView text, const SearchMatch &match, const QString &replacement) const;
+    bool buildReplacePlan(QStringView text, const QString &replacement, ReplacePlan &plan,
+                          const std::function<bool()> &isCanceled = {}) const;
+
+    static QString expandReplacement(QStringView replacement, const QRegularExpressionMatch &match);
+
+private:
+    bool findLiteral(QStringView text, qsizetype from, qsizetype to, SearchMatch &match) const;
+    bool findRegex(QStringView text, qsizetype from, qsizetype to, SearchMatch &match) const;
+    qsizetype horspool(QStringView text, qsizetype from, qsizetype to) const;
+    qsizetype firstCharScan(QStringView text, qsizetype from, qsizetype to) const;
+    bool isWordBoundaryMatch(QStringView text, qsizetype start, qsizetype length) const;
+
+    SearchQuery query_;
+    QRegularExpression regex_;
+    std::array<qsizetype, 256> shift_{};
+    char16_t firstLower_ = 0;
+    char16_t firstUpper_ = 0;
+    bool useHorspool_ = false;
+    bool valid_ = true;
+    QString error_;
+};
+
+#endif
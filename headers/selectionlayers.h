@@ -0,0 +1,36 @@
+#ifndef SELECTIONLAYERS_H
+#define SELECTIONLAYERS_H
+
+#include <QObject>
+#include <QTextEdit>
+#include <QList>
+#include <QMap>
+
+class SelectionLayers : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Layer {
+        DiagnosticLayer = 5,
+        SpellLayer = 7,
+        OccurrenceLayer = 10,
+        SearchLayer = 20,
+        MultiCursorLayer = 30
+    };
+
+    static SelectionLayers *of(QTextEdit *textEdit);
+
+    void setLayer(int layer, const QList<QTextEdit::ExtraSelection> &selections);
+    void clearLayer(int layer);
+
+private:
+    explicit SelectionLayers(QTextEdit *textEdit);
+
+    void apply();
+
+    QTextEdit *textEdit_ = nullptr;
+    QMap<int, QList<QTextEdit::ExtraSelection>> layers_;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef SPELLCHECKER_H
+#define SPELLCHECKER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QStringList>
+#include <QFutureWatcher>
+#include <memory>
+#include "spelldictionary.h"
+
+class QTextEdit;
+
+struct SpellRange
+{
+    int start = 0;
+    int length = 0;
+};
+
+struct SpellBatch
+{
+    QStringList texts;
+    QVector<QVector<SpellRange>> misspellings;
+};
+
+// Underlines misspelled words of the visible and recently edited blocks.
+// Blocks are checked on a worker thread and the result is cached by block
+// text, so scrolling back or undoing an edit needs no new check.
+class SpellChecker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SpellChecker(QTextEdit *textEdit, QObject *parent = nullptr);
+    ~SpellChecker() override;
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_; }
+
+signals:
+    void statusMessage(const QString &message);
+
+private slots:
+    void onDictionariesLoaded();
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void scheduleRender();
+    void startCheck();
+    void onChecked();
+    void render();
+
+private:
+    QVector<int> visibleBlocks() const;
+
+    QTextEdit *textEdit_ = nullptr;
+    std::shared_ptr<const SpellDictionaries> dictionaries_;
+    QFutureWatcher<std::shared_ptr<const SpellDictionaries>> loadWatcher_;
+    QFutureWatcher<SpellBatch> checkWatcher_;
+    QTimer checkTimer_;
+    QTimer renderTimer_;
+    QHash<QString, QVector<SpellRange>> cache_;
+    QSet<int> editedBlocks_;
+    bool enabled_ = false;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef SPELLDICTIONARY_H
+#define SPELLDICTIONARY_H
+
+#include <QString>
+#include <QStringView>
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QVector>
+#include <memory>
+
+class QFile;
+struct DawgEdge;
+
+// Word forms as one arena of NUL-terminated UTF-8 strings; millions of
+// expanded Hunspell forms fit without a QByteArray per word.
+class WordList
+{
+public:
+    void append(QByteArrayView word);
+    void sortUnique();
+
+    qsizetype size() const { return offsets_.size(); }
+    QByteArrayView at(qsizetype i) const;
+
+private:
+    QByteArray data_;
+    QVector<quint32> offsets_;
+};
+
+// Lower-cased words stored as a minimal acyclic automaton (DAWG) over UTF-8
+// bytes. The compiled file is mapped read-only, so opening is instant and
+// the pages are shared between windows and processes.
+class SpellDictionary
+{
+public:
+    ~SpellDictionary();
+
+    static std::shared_ptr<const SpellDictionary> map(const QString &path, QString &error);
+    static bool compile(WordList &words, const QString &path, QString &error);
+
+    // Lower case, "ё" folded to "е", typographic apostrophe to ASCII and
+    // combining stress marks dropped.
+    static QString normalize(QStringView word);
+
+    bool contains(QStringView normalizedWord) const;
+    quint32 wordCount() const { return wordCount_; }
+
+private:
+    SpellDictionary() = default;
+
+    std::unique_ptr<QFile> file_;
+    const DawgEdge *edges_ = nullptr;
+    quint32 edgeCount_ = 0;
+    quint32 root_ = 0;
+    quint32 wordCount_ = 0;
+};
+
+namespace HunspellReader {
+
+// Expands a Hunspell .dic/.aff pair (prefix and suffix rules, cross
+// products) into normalized word forms.
+bool readWords(const QString &dicPath, WordList &words, QString &error);
+
+}
+
+// The Russian and English dictionaries of the process. Compiled files live
+// in AppDataLocation/dictionaries and are rebuilt when the source word list
+// is newer. Loading may compile, so call shared() off the GUI thread.
+class SpellDictionaries
+{
+public:
+    static std::shared_ptr<const SpellDictionaries> shared();
+
+    const SpellDictionary *forWord(QStringView word) const;
+    bool isEmpty() const { return !russian_ && !english_; }
+    QString description() const;
+
+private:
+    std::shared_ptr<const SpellDictionary> russian_;
+    std::shared_ptr<const SpellDictionary> english_;
+    QString errors_;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef SYMBOLINDEX_H
+#define SYMBOLINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QHash>
+#include <QVector>
+#include <QThreadPool>
+#include <QFutureWatcher>
+
+struct SymbolInfo
+{
+    enum class Kind : quint8 { Class, Struct, Union, Enum, Function, Method, Macro };
+
+    QString name;
+    QString scope;
+    Kind kind = Kind::Function;
+    int line = 0;
+    int column = 0;
+    bool definition = false;
+
+    QString qualifiedName() const { return scope.isEmpty() ? name : scope + "::" + name; }
+};
+
+struct SymbolLocation
+{
+    QString path;
+    SymbolInfo symbol;
+};
+
+struct FileSymbols
+{
+    qint64 modified = 0;
+    qint64 size = 0;
+    QVector<SymbolInfo> symbols;
+};
+
+// Immutable view of the index; a new one is built on the worker after every
+// update and swapped in on the GUI thread.
+struct SymbolSnapshot
+{
+    QHash<QString, FileSymbols> files;
+    QVector<SymbolLocation> all;
+    QHash<QString, QVector<qsizetype>> byName;
+    qsizetype changed = 0;
+    qsizetype removed = 0;
+    bool saved = true;
+};
+
+namespace SymbolParser {
+
+// Tolerant single-pass scan: comments, strings and preprocessor lines are
+// blanked out, then braces are tracked to tell namespaces and classes from
+// function bodies. It never fails; unrecognised constructs are skipped.
+QVector<SymbolInfo> parse(QStringView text);
+
+bool isSourceFile(const QString &path);
+QString kindName(SymbolInfo::Kind kind);
+
+}
+
+class SymbolIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit SymbolIndex(QObject *parent = nullptr);
+    ~SymbolIndex() override;
+
+    void openForFile(const QString &filePath);
+    void refresh();
+    void close();
+
+    QString rootPath() const { return rootPath_; }
+    bool isBusy() const { return watcher_.isRunning(); }
+    qsizetype symbolCount() const { return snapshot_.all.size(); }
+
+    QVector<SymbolLocation> definitions(const QString &name) const;
+    QVector<SymbolLocation> match(const QString &query, int limit) const;
+
+    static QString projectRoot(const QString &filePath);
+
+signals:
+    void updated(qsizetype files, qsizetype symbols);
+    void failed(const QString &message);
+
+private slots:
+    void onUpdateFinished();
+
+private:
+    QString rootPath_;
+    QString indexPath_;
+    SymbolSnapshot snapshot_;
+    bool pending_ = false;
+    QThreadPool pool_;
+    QFutureWatcher<SymbolSnapshot> watcher_;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef SYMBOLPANEL_H
+#define SYMBOLPANEL_H
+
+#include <QWidget>
+#include <QDialog>
+#include <QTimer>
+#include <QPointer>
+#include <QFutureWatcher>
+#include "symbolindex.h"
+
+class QLineEdit;
+class QLabel;
+class QListWidget;
+class QListWidgetItem;
+class QTreeWidget;
+class QTreeWidgetItem;
+class QTextDocument;
+
+// Outline of the current file. The document is re-parsed on a worker a
+// moment after typing stops, so it does not depend on the project index.
+class OutlinePanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit OutlinePanel(QWidget *parent = nullptr);
+    ~OutlinePanel() override;
+
+    void setDocument(QTextDocument *document);
+    void setActive(bool active);
+
+signals:
+    void activated(int line, int column);
+
+private slots:
+    void reparse();
+    void onParsed();
+    void applyFilter();
+    void onItemActivated(QTreeWidgetItem *item, int column);
+
+private:
+    QPointer<QTextDocument> document_;
+    QMetaObject::Connection changeConnection_;
+    QFutureWatcher<QVector<SymbolInfo>> watcher_;
+    QTimer reparseTimer_;
+    QLineEdit *filterEdit_ = nullptr;
+    QTreeWidget *tree_ = nullptr;
+    bool active_ = false;
+    bool stale_ = false;
+};
+
+// "Go to symbol" dialog answered straight from the in-memory index.
+class SymbolQuickOpen : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit SymbolQuickOpen(const SymbolIndex *index, QWidget *parent = nullptr);
+
+    void activate(const QString &initialQuery = QString());
+
+signals:
+    void openRequested(const QString &filePath, int line, int column);
+
+private slots:
+    void search();
+    void openCurrent();
+    void onItemActivated(QListWidgetItem *item);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    const SymbolIndex *index_ = nullptr;
+    QLineEdit *queryEdit_ = nullptr;
+    QListWidget *list_ = nullptr;
+    QLabel *statusLabel_ = nullptr;
+};
+
+#endif
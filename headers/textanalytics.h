@@ -0,0 +1,52 @@
+#ifndef TEXTANALYTICS_H
+#define TEXTANALYTICS_H
+
+#include <QString>
+#include <QVector>
+#include <QPromise>
+#include <array>
+
+class QThreadPool;
+
+namespace TextAnalytics {
+
+enum CharClass { Letter, Digit, Space, Punctuation, Symbol, Other, CharClassCount };
+
+constexpr int kLineLengthBuckets = 18;
+
+}
+
+struct FrequencyEntry
+{
+    QString text;
+    qint64 count = 0;
+};
+
+struct TextAnalyticsReport
+{
+    QVector<FrequencyEntry> words;
+    QVector<FrequencyEntry> bigrams;
+    QVector<FrequencyEntry> trigrams;
+    std::array<qint64, TextAnalytics::kLineLengthBuckets> lineLengths{};
+    std::array<qint64, TextAnalytics::CharClassCount> charClasses{};
+    qint64 totalWords = 0;
+    qint64 totalBigrams = 0;
+    qint64 totalTrigrams = 0;
+    qint64 uniqueWords = 0;
+    qint64 lines = 0;
+    qint64 characters = 0;
+    qint64 elapsedMs = 0;
+};
+
+namespace TextAnalytics {
+
+// Bucket 0 holds empty lines, bucket i holds lengths in [2^(i-1), 2^i),
+// the last bucket is open-ended.
+QString bucketLabel(int bucket);
+QString charClassName(CharClass charClass);
+
+void analyze(QPromise<TextAnalyticsReport> &promise, QThreadPool *pool, const QString &text, int topN);
+
+}
+
+#endif
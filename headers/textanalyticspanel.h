@@ -0,0 +1,53 @@
+#ifndef TEXTANALYTICSPANEL_H
+#define TEXTANALYTICSPANEL_H
+
+#include <QWidget>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include "textanalytics.h"
+
+class IDocument;
+class QSpinBox;
+class QPushButton;
+class QLabel;
+class QProgressBar;
+class QTreeWidget;
+
+class TextAnalyticsPanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit TextAnalyticsPanel(QWidget *parent = nullptr);
+    ~TextAnalyticsPanel() override;
+
+    void setDocument(const IDocument *document);
+
+public slots:
+    void analyze();
+    void stop();
+
+private slots:
+    void onFinished();
+
+private:
+    void showReport(const TextAnalyticsReport &report);
+    static void fillFrequencies(QTreeWidget *tree, const QVector<FrequencyEntry> &entries, qint64 total);
+
+    QThreadPool pool_;
+    QFutureWatcher<TextAnalyticsReport> watcher_;
+    const IDocument *document_ = nullptr;
+    bool selectionOnly_ = false;
+    QSpinBox *topSpin_ = nullptr;
+    QPushButton *analyzeButton_ = nullptr;
+    QPushButton *stopButton_ = nullptr;
+    QProgressBar *progressBar_ = nullptr;
+    QLabel *summaryLabel_ = nullptr;
+    QTreeWidget *wordsTree_ = nullptr;
+    QTreeWidget *bigramsTree_ = nullptr;
+    QTreeWidget *trigramsTree_ = nullptr;
+    QTreeWidget *linesTree_ = nullptr;
+    QTreeWidget *classesTree_ = nullptr;
+};
+
+#endif
@@ -29,11 +29,34 @@
 #include "textfilecontroller.h"
 #include "texteditorui.h"
 
-class QPdfView;
 class QPdfDocument;
+class QDockWidget;
+class PdfSearchView;
+class PdfSearchPanel;
+class FindBar;
+class FindInFilesPanel;
+class TextAnalyticsPanel;
+class OccurrenceHighlighter;
+class MultiCursorController;
+class MacroRecorder;
+class MacroReplayTool;
+class ExternalFilterRunner;
+class CppHighlighter;
+class SymbolIndex;
+class OutlinePanel;
+class SymbolQuickOpen;
+class LspClient;
+class DiagnosticHighlighter;
+class CompletionPopup;
+class SpellChecker;
+class WordCompleter;
+class GitGutter;
+class FileChangeMonitor;
+class LogFollower;
 class Document;
 class TextFormatController;
 class TextEditorUi;
+class EditToolExecutor;
 
 class TextEditor : public QMainWindow
 {
@@ -56,7 +79,29 @@ private slots:
     void speakSelectedText();
     void stopSpeaking();
     void onSpeechError(const QString &error);
-    
+    void find();
+    void findNext();
+    void findPrevious();
+    void replace();
+    void findInFiles();
+    void setHighlightOccurrences(bool enabled);
+    void textAnalytics();
+    void setMacroRecording(bool recording);
+    void replayMacro();
+    void replayMacroTimes();
+    void filterThroughCommand();
+    void onToolStarted(const QString &toolName);
+    void onToolFinished(const QString &message);
+    void goToDefinition();
+    void findSymbol();
+    void showOutline();
+    void triggerCompletion();
+    void setSpellChecking(bool enabled);
+    void setWordAutoComplete(bool enabled);
+    void compareWithSaved();
+    void compareWithFile();
+    void setLogFollowing(bool enabled);
+    void setLogFollowRate();
 
 private:
     void applyTheme();
@@ -64,6 +109,10 @@ private:
     void setupFormatActions();
     void mergeFormatOnWordOrSelection(const QTextCharFormat &format);
     void updateAlignmentButtons();
+    void startMacroReplay(int iterations);
+    void updateSourceFeatures();
+    void onChangedOnDisk(const QString &filePath);
+    void watchCurrentFile(qint64 syncedBytes = -1);
 
     template<typename Operation>
     void handleFileOperation(Operation operation, const QString& errorMessage)
@@ -82,13 +131,39 @@ private:
     friend class TextEditorUi;
 
     QStackedWidget *centralStack = nullptr;
+    QWidget *editorPage = nullptr;
     QTextEdit *textEdit;
+    FindBar *findBar = nullptr;
+    QDockWidget *findInFilesDock = nullptr;
+    FindInFilesPanel *findInFilesPanel = nullptr;
+    QDockWidget *analyticsDock = nullptr;
+    TextAnalyticsPanel *analyticsPanel = nullptr;
+    OccurrenceHighlighter *occurrenceHighlighter = nullptr;
+    MultiCursorController *multiCursor = nullptr;
+    MacroRecorder *macroRecorder = nullptr;
+    ExternalFilterRunner *filterRunner = nullptr;
+    CppHighlighter *cppHighlighter = nullptr;
+    SymbolIndex *symbolIndex = nullptr;
+    QDockWidget *outlineDock = nullptr;
+    OutlinePanel *outlinePanel = nullptr;
+    SymbolQuickOpen *symbolQuickOpen = nullptr;
+    DiagnosticHighlighter *diagnosticHighlighter = nullptr;
+    CompletionPopup *completionPopup = nullptr;
+    SpellChecker *spellChecker = nullptr;
+    WordCompleter *wordCompleter = nullptr;
+    GitGutter *gitGutter = nullptr;
+    FileChangeMonitor *fileMonitor = nullptr;
+    LogFollower *logFollower = nullptr;
     Document *document_ = nullptr;
-    QPdfView *pdfView = nullptr;
+    PdfSearchView *pdfView = nullptr;
     QPdfDocument *pdfDocument = nullptr;
+    QDockWidget *pdfSearchDock = nullptr;
+    PdfSearchPanel *pdfSearchPanel = nullptr;
 
     ThemeManager* themeManager_ = &ThemeManager::getInstance();
     std::unique_ptr<EditToolManager> editToolManager_ = std::make_unique<EditToolManager>();
+    std::unique_ptr<EditToolExecutor> editToolExecutor_;
+    std::unique_ptr<MacroReplayTool> macroReplay_;
     SpeechManager *speechManager;
 
     std::unique_ptr<TextFormatController> formatController_;
@@ -96,11 +171,16 @@ private:
     std::unique_ptr<TextEditorUi> ui_;
 
     QString currentFile;
+    QString lastFilterCommand;
+    bool spellCheckEnabled = true;
+    bool wordAutoCompleteEnabled = true;
+    bool reloadPromptOpen = false;
 
     QTimer *autoSaveTimer;
     bool autoSaveEnabled = false;
 
     DocumentManager documentManager_;
+    LspClient *lspClient_ = nullptr;
 };
 
 #endif
@@ -8,6 +8,8 @@
 #include <QComboBox>
 #include <QFontComboBox>
 #include <QAction>
+#include <QProgressBar>
+#include <QToolButton>
 
 class TextEditor;
 
@@ -23,8 +25,11 @@ public:
 
     QLabel *statusLabel() const { return statusBar_.statusLabel; }
     QLabel *themeLabel() const  { return statusBar_.themeLabel; }
+    QLabel *occurrenceLabel() const { return statusBar_.occurrenceLabel; }
     QComboBox *themeComboBox() const { return statusBar_.themeComboBox; }
     QComboBox *toolsComboBox() const { return statusBar_.toolsComboBox; }
+    QProgressBar *toolProgress() const { return statusBar_.toolProgress; }
+    QToolButton *toolCancelButton() const { return statusBar_.toolCancelButton; }
     QFontComboBox *fontCombo() const { return format_.fontCombo; }
     QComboBox *fontSizeCombo() const { return format_.fontSizeCombo; }
 
@@ -44,6 +49,20 @@ private:
     QMenu *toolsMenu = nullptr;
     QMenu *helpMenu = nullptr;
 
+    QAction *textAnalyticsAct = nullptr;
+    QAction *recordMacroAct = nullptr;
+    QAction *replayMacroAct = nullptr;
+    QAction *replayMacroTimesAct = nullptr;
+    QAction *filterCommandAct = nullptr;
+    QAction *compareWithSavedAct = nullptr;
+    QAction *compareWithFileAct = nullptr;
+    QAction *followLogAct = nullptr;
+    QAction *followRateAct = nullptr;
+    QAction *goToDefinitionAct = nullptr;
+    QAction *findSymbolAct = nullptr;
+    QAction *outlineAct = nullptr;
+    QAction *spellCheckAct = nullptr;
+
     struct FileUi {
         QMenu *fileMenu = nullptr;
 
@@ -65,6 +84,17 @@ private:
         QAction *pasteAct = nullptr;
         QAction *undoAct = nullptr;
         QAction *redoAct = nullptr;
+        QAction *findAct = nullptr;
+        QAction *findNextAct = nullptr;
+        QAction *findPreviousAct = nullptr;
+        QAction *replaceAct = nullptr;
+        QAction *findInFilesAct = nullptr;
+        QAction *highlightOccurrencesAct = nullptr;
+        QAction *addCaretAboveAct = nullptr;
+        QAction *addCaretBelowAct = nullptr;
+        QAction *completeAct = nullptr;
+        QAction *wordAutoCompleteAct = nullptr;
+        QAction *wordsFromAllDocumentsAct = nullptr;
 
         QToolBar *editToolBar = nullptr;
     };
@@ -103,9 +133,12 @@ private:
 
     struct StatusBarUi {
         QLabel *statusLabel = nullptr;
+        QLabel *occurrenceLabel = nullptr;
         QLabel *themeLabel = nullptr;
         QComboBox *themeComboBox = nullptr;
         QComboBox *toolsComboBox = nullptr;
+        QProgressBar *toolProgress = nullptr;
+        QToolButton *toolCancelButton = nullptr;
     };
 
     StatusBarUi statusBar_;
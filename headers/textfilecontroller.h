@@ -15,6 +15,8 @@ public:
 public slots:
     void newFile();
     void openFile();
+    bool openPath(const QString &fileName);
+    void openFileAt(const QString &fileName, int line, int column);
     void saveFile();
     void saveAsFile();
 
@@ -25,7 +27,7 @@ public slots:
 private:
     TextEditor *editor_ = nullptr;
 
-    void openFileImpl();
+    void openFileImpl(const QString &fileName);
 };
 
 class DocumentOperationException : public std::runtime_error {
@@ -0,0 +1,87 @@
+#ifndef WORDINDEX_H
+#define WORDINDEX_H
+
+#include <QObject>
+#include <QTimer>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+
+class QTextEdit;
+class QTextBlock;
+class CompletionPopup;
+
+struct WordCandidate
+{
+    QString word;
+    int count = 0;
+};
+
+// Reference-counted words kept in case-insensitive sorted order, so every
+// word with a given prefix is one contiguous range found by a binary search.
+class WordIndex
+{
+public:
+    struct Store;
+
+    WordIndex();
+    ~WordIndex();
+    WordIndex(const WordIndex &) = delete;
+    WordIndex &operator=(const WordIndex &) = delete;
+
+    void add(const QStringList &words);
+    void remove(const QStringList &words);
+    qsizetype size() const;
+
+    QVector<WordCandidate> complete(QStringView prefix, int limit, const QString &exclude = QString()) const;
+    // Same lookup over the indexes of every open document in the process.
+    static QVector<WordCandidate> completeEverywhere(QStringView prefix, int limit, const QString &exclude = QString());
+
+    std::weak_ptr<Store> store() const { return store_; }
+
+private:
+    std::shared_ptr<Store> store_;
+};
+
+// Keeps a WordIndex in step with a QTextEdit. Each block remembers the words
+// it contributed (QTextBlockUserData), so an edit only re-counts the changed
+// blocks and a deleted block takes its words with it.
+class WordCompleter : public QObject
+{
+    Q_OBJECT
+
+public:
+    WordCompleter(QTextEdit *textEdit, CompletionPopup *popup, QObject *parent = nullptr);
+
+    void setAutoComplete(bool enabled) { autoComplete_ = enabled; }
+    void setAllDocuments(bool enabled) { allDocuments_ = enabled; }
+    bool allDocuments() const { return allDocuments_; }
+    qsizetype wordCount() const { return index_.size(); }
+
+public slots:
+    void complete();
+
+signals:
+    void completed(int candidates, qint64 microseconds);
+
+private slots:
+    void onContentsChange(int position, int charsRemoved, int charsAdded);
+    void sweep();
+    void autoComplete();
+
+private:
+    void indexBlock(QTextBlock &block, bool force);
+    void scheduleSweep(int fromBlock);
+    bool showCandidates(bool explicitRequest);
+
+    QTextEdit *textEdit_ = nullptr;
+    CompletionPopup *popup_ = nullptr;
+    WordIndex index_;
+    QTimer sweepTimer_;
+    QTimer autoTimer_;
+    int sweepFrom_ = -1;
+    bool autoComplete_ = true;
+    bool allDocuments_ = false;
+};
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef WORKSPACEINDEX_H
+#define WORKSPACEINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QFile>
+#include <QTimer>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
+#include <QFileSystemWatcher>
+#include <vector>
+#include "searchengine.h"
+
+enum IndexedFileFlag : quint32 {
+    IndexedDocument = 0x1,
+    IndexedBinary = 0x2,
+    IndexedUnindexed = 0x4
+};
+
+struct IndexedFile
+{
+    QString path;
+    qint64 modified = 0;
+    qint64 size = 0;
+    quint32 flags = 0;
+};
+
+struct IndexEntry
+{
+    IndexedFile file;
+    std::vector<quint32> trigrams;
+};
+
+struct IndexUpdate
+{
+    QVector<IndexEntry> entries;
+    QStringList removed;
+    QStringList directories;
+    bool full = false;
+};
+
+struct IndexBuildResult
+{
+    bool ok = false;
+    QString error;
+};
+
+struct IndexCandidates
+{
+    QStringList files;
+    QHash<QString, QString> textSources;
+    qint64 totalFiles = 0;
+    bool narrowed = false;
+};
+
+class TrigramIndexFile
+{
+public:
+    using PostingMap = QHash<quint32, std::vector<quint32>>;
+
+    TrigramIndexFile() = default;
+    TrigramIndexFile(const TrigramIndexFile &) = delete;
+    TrigramIndexFile &operator=(const TrigramIndexFile &) = delete;
+    ~TrigramIndexFile();
+
+    bool open(const QString &path);
+    void close();
+    bool isOpen() const { return data_ != nullptr; }
+
+    quint32 fileCount() const { return fileCount_; }
+    IndexedFile file(quint32 id) const;
+    std::vector<quint32> intersect(const std::vector<quint32> &trigrams) const;
+
+    static bool write(const QString &path,
+                      const QVector<IndexedFile> &files,
+                      const PostingMap &postings,
+                      QString &error);
+
+private:
+    const void *findTrigram(quint32 trigram) const;
+    std::vector<quint32> decodePostings(const void *record) const;
+
+    QFile file_;
+    const uchar *data_ = nullptr;
+    qint64 size_ = 0;
+    quint32 fileCount_ = 0;
+    quint32 trigramCount_ = 0;
+    quint64 filesOffset_ = 0;
+    quint64 trigramsOffset_ = 0;
+    quint64 postingsOffset_ = 0;
+    quint64 stringsOffset_ = 0;
+};
+
+class WorkspaceIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WorkspaceIndex(QObject *parent = nullptr);
+    ~WorkspaceIndex() override;
+
+    void open(const QString &rootPath);
+    void rebuild();
+    void close();
+    void refreshIfStale();
+
+    QString rootPath() const { return rootPath_; }
+    bool isReady() const { return base_.isOpen(); }
+    bool isBusy() const;
+    qint64 fileCount() const { return stamps_.size(); }
+
+    IndexCandidates candidates(const SearchQuery &query, const QStringList &nameFilters) const;
+
+    static std::vector<quint32> queryTrigrams(const SearchQuery &query, bool *narrowable);
+
+signals:
+    void progress(qint64 done, qint64 total);
+    void ready();
+    void failed(const QString &message);
+
+private slots:
+    void onBuildFinished();
+    void onUpdateFinished();
+    void onPathChanged(const QString &path);
+    void flushPendingChanges();
+
+private:
+    struct FileStamp
+    {
+        qint64 modified = 0;
+        qint64 size = 0;
+    };
+
+    bool loadBase();
+    void startUpdate(const QStringList &directories, const QStringList &files, bool full);
+    void applyUpdate(const IndexUpdate &update);
+    void markBaseStale(const QString &path);
+    void watchPaths(const QStringList &directories, const QStringList &files);
+    QString textSourcePath(const QString &filePath) const;
+
+    QString rootPath_;
+    QString indexPath_;
+    QString textCacheDir_;
+    TrigramIndexFile base_;
+    QHash<QString, quint32> baseIds_;
+    std::vector<bool> staleBase_;
+    std::vector<quint32> unindexedBase_;
+    QHash<QString, IndexEntry> overlay_;
+    QHash<QString, FileStamp> stamps_;
+    QSet<QString> directories_;
+    QSet<QString> pendingDirectories_;
+    QSet<QString> pendingFiles_;
+    bool pendingFull_ = false;
+    QFileSystemWatcher watcher_;
+    QTimer changeTimer_;
+    QElapsedTimer sinceRefresh_;
+    QThreadPool pool_;
+    QFutureWatcher<IndexBuildResult> buildWatcher_;
+    QFutureWatcher<IndexUpdate> updateWatcher_;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef WORKSPACEREPLACE_H
+#define WORKSPACEREPLACE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QThreadPool>
+#include <QFutureWatcher>
+#include "filesearcher.h"
+
+class QIODevice;
+
+struct ReplacePreviewLine
+{
+    int line = 0;
+    QString before;
+    QString after;
+};
+
+struct FileReplacePlan
+{
+    QString filePath;
+    qint64 modified = 0;
+    qint64 size = 0;
+    qsizetype matchCount = 0;
+    QVector<ReplacePreviewLine> preview;
+};
+
+struct ReplaceCommitResult
+{
+    bool ok = false;
+    QString error;
+    QStringList files;
+    qint64 bytesWritten = 0;
+    qint64 elapsedMs = 0;
+};
+
+class StreamingReplacer
+{
+public:
+    StreamingReplacer(const SearchQuery &query, const QString &replacement);
+
+    bool isValid() const { return searcher_.isValid(); }
+    QString errorString() const { return searcher_.errorString(); }
+
+    FileReplacePlan plan(const QString &filePath, int previewLimit) const;
+    bool rewrite(QIODevice &input, QIODevice &output, qint64 *bytesWritten, QString &error) const;
+
+private:
+    qsizetype process(QIODevice &input, QIODevice *output, QVector<ReplacePreviewLine> *preview,
+                      int previewLimit, qint64 *bytesWritten, QString &error) const;
+    void collectPreview(QStringView block, int firstLine, QVector<ReplacePreviewLine> &preview, int previewLimit) const;
+
+    TextSearcher searcher_;
+    QString replacement_;
+};
+
+class WorkspaceReplacer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit WorkspaceReplacer(QObject *parent = nullptr);
+    ~WorkspaceReplacer() override;
+
+    void plan(const FileSearchRequest &request, const QString &replacement);
+    void commit(const QVector<FileReplacePlan> &plans);
+    void cancel();
+    bool isRunning() const;
+
+signals:
+    void planProgress(int done, int total);
+    void planReady(const QVector<FileReplacePlan> &plans);
+    void committed(const ReplaceCommitResult &result);
+
+private:
+    QThreadPool pool_;
+    QFutureWatcher<FileReplacePlan> planWatcher_;
+    QFutureWatcher<ReplaceCommitResult> commitWatcher_;
+    SearchQuery query_;
+    QString replacement_;
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "../headers/caseconversion.h"
+
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TEXTEDITOR_CASE_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TEXTEDITOR_CASE_NEON 1
+#endif
+
+namespace {
+
+constexpr char16_t kNeedsFullMapping = 0;
+
+// Simple 1:1 mappings for the whole BMP; 0 marks characters whose full
+// mapping changes the length (e.g. "ß" -> "SS") or that are surrogates.
+const std::vector<char16_t> &caseTable(CaseConversion::Mode mode)
+{
+    auto build = [](CaseConversion::Mode tableMode) {
+        std::vector<char16_t> table(0x10000);
+        for (char32_t c = 0; c < 0x10000; ++c) {
+            if (QChar::isSurrogate(c)) {
+                table[c] = kNeedsFullMapping;
+                continue;
+            }
+            const QString single(QChar(static_cast<char16_t>(c)));
+            const QString mapped = tableMode == CaseConversion::Mode::Upper ? single.toUpper() : single.toLower();
+            table[c] = mapped.size() == 1 ? mapped.at(0).unicode() : kNeedsFullMapping;
+        }
+        return table;
+    };
+    static const std::vector<char16_t> upper = build(CaseConversion::Mode::Upper); // NOSONAR - Meyers singleton pattern
+    static const std::vector<char16_t> lower = build(CaseConversion::Mode::Lower); // NOSONAR - Meyers singleton pattern
+    return mode == CaseConversion::Mode::Upper ? upper : lower;
+}
+
+char16_t asciiCase(char16_t c, CaseConversion::Mode mode)
+{
+    if (mode == CaseConversion::Mode::Upper) {
+        return (c >= u'a' && c <= u'z') ? static_cast<char16_t>(c - 0x20) : c;
+    }
+    return (c >= u'A' && c <= u'Z') ? static_cast<char16_t>(c + 0x20) : c;
+}
+
+// Converts ASCII runs eight code units at a time. Returns the index of the
+// first non-ASCII code unit at or after |from|, or |size| when none is left.
+qsizetype convertAsciiRun(char16_t *data, qsizetype from, qsizetype size, CaseConversion::Mode mode, bool &changed)
+{
+    qsizetype i = from;
+    const char16_t first = mode == CaseConversion::Mode::Upper ? u'a' : u'A';
+
+#if defined(TEXTEDITOR_CASE_SSE2)
+    const __m128i nonAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i low = _mm_set1_epi16(static_cast<short>(first - 1));
+    const __m128i high = _mm_set1_epi16(static_cast<short>(first + 26));
+    const __m128i flip = _mm_set1_epi16(0x20);
+    for (; i + 8 <= size; i += 8) {
+        auto *p = reinterpret_cast<__m128i *>(data + i);
+        const __m128i v = _mm_loadu_si128(p);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, nonAscii), _mm_setzero_si128())) != 0xFFFF) {
+            break;
+        }
+        const __m128i letters = _mm_and_si128(_mm_cmpgt_epi16(v, low), _mm_cmplt_epi16(v, high));
+        if (_mm_movemask_epi8(letters) != 0) {
+            _mm_storeu_si128(p, _mm_xor_si128(v, _mm_and_si128(letters, flip)));
+            changed = true;
+        }
+    }
+#elif defined(TEXTEDITOR_CASE_NEON)
+    const uint16x8_t low = vdupq_n_u16(first);
+    const uint16x8_t high = vdupq_n_u16(static_cast<uint16_t>(first + 25));
+    const uint16x8_t flip = vdupq_n_u16(0x20);
+    for (; i + 8 <= size; i += 8) {
+        auto *p = reinterpret_cast<uint16_t *>(data + i);
+        const uint16x8_t v = vld1q_u16(p);
+        if (vmaxvq_u16(v) >= 0x80) {
+            break;
+        }
+        const uint16x8_t letters = vandq_u16(vcgeq_u16(v, low), vcleq_u16(v, high));
+        if (vmaxvq_u16(letters) != 0) {
+            vst1q_u16(p, veorq_u16(v, vandq_u16(letters, flip)));
+            changed = true;
+        }
+    }
+#endif
+
+    for (; i < size && data[i] < 0x80; ++i) {
+        const char16_t mapped = asciiCase(data[i], mode);
+        if (mapped != data[i]) {
+            data[i] = mapped;
+            changed = true;
+        }
+    }
+    return i;
+}
+
+}
+
+namespace CaseConversion {
+
+bool convert(QString &text, Mode mode)
+{
+    const std::vector<char16_t> &table = caseTable(mode);
+    char16_t *data = reinterpret_cast<char16_t *>(text.data());
+    const qsizetype size = text.size();
+    bool changed = false;
+
+    qsizetype i = 0;
+    while (i < size) {
+        i = convertAsciiRun(data, i, size, mode, changed);
+        for (; i < size && data[i] >= 0x80; ++i) {
+            const char16_t mapped = table[data[i]];
+            if (mapped == kNeedsFullMapping) {
+                const QString tail = QStringView(text).sliced(i).toString();
+                text.truncate(i);
+                text += mode == Mode::Upper ? tail.toUpper() : tail.toLower();
+                return true;
+            }
+            if (mapped != data[i]) {
+                data[i] = mapped;
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+qsizetype findFullMapping(QStringView text, qsizetype from, Mode mode)
+{
+    const std::vector<char16_t> &table = caseTable(mode);
+    for (qsizetype i = from; i < text.size(); ++i) {
+        const char16_t c = text[i].unicode();
+        if (c >= 0x80 && table[c] == kNeedsFullMapping) {
+            return i;
+        }
+    }
+    return text.size();
+}
+
+}
@@ -0,0 +1,278 @@
+#include "../headers/compareview.h"
+#include "../headers/linediff.h"
+#include "../headers/documentmanager.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QPromise>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QPlainTextEdit>
+#include <QTextBlock>
+#include <QScrollBar>
+#include <QLabel>
+#include <QToolButton>
+#include <QFontDatabase>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <algorithm>
+
+namespace {
+
+constexpr int kMaxRefinedLines = 200;
+
+void appendLines(QString &out, const QList<QStringView> &lines, int from, int count)
+{
+    for (int i = from; i < from + count; ++i) {
+        out += lines.at(i);
+        out += u'\n';
+    }
+}
+
+void compareWithFile(QPromise<CompareResult> &promise, const QString &leftPath, const QString &rightText)
+{
+    QElapsedTimer timer;
+    timer.start();
+    CompareResult result;
+    QString leftText;
+    {
+        const DocumentManager documents;
+        if (!documents.extractText(leftPath, leftText, result.error)) {
+            promise.addResult(std::move(result));
+            return;
+        }
+    }
+
+    const QList<QStringView> oldLines = LineDiff::splitLines(leftText);
+    const QList<QStringView> newLines = LineDiff::splitLines(rightText);
+    const QVector<DiffHunk> hunks = LineDiff::diff(LineDiff::hashLines(oldLines), LineDiff::hashLines(newLines));
+    if (promise.isCanceled()) {
+        return;
+    }
+
+    result.leftText.reserve(leftText.size() + rightText.size() / 4);
+    result.rightText.reserve(rightText.size() + leftText.size() / 4);
+    int oldPos = 0;
+    int newPos = 0;
+    int row = 0;
+    for (const DiffHunk &hunk : hunks) {
+        const int equal = hunk.oldStart - oldPos;
+        appendLines(result.leftText, oldLines, oldPos, equal);
+        appendLines(result.rightText, newLines, newPos, equal);
+        row += equal;
+
+        const CompareHunk compareHunk{row, hunk.oldCount, hunk.newCount};
+        appendLines(result.leftText, oldLines, hunk.oldStart, hunk.oldCount);
+        appendLines(result.rightText, newLines, hunk.newStart, hunk.newCount);
+        result.leftText += QString(compareHunk.rows() - hunk.oldCount, u'\n');
+        result.rightText += QString(compareHunk.rows() - hunk.newCount, u'\n');
+        if (hunk.oldCount > 0 && hunk.newCount > 0 && compareHunk.rows() <= kMaxRefinedLines) {
+            const WordDiff words = LineDiff::refineWords(oldLines.mid(hunk.oldStart, hunk.oldCount),
+                                                         newLines.mid(hunk.newStart, hunk.newCount));
+            for (const WordRange &range : words.oldRanges) {
+                result.leftWords.append({row + range.line, range.start, range.length});
+            }
+            for (const WordRange &range : words.newRanges) {
+                result.rightWords.append({row + range.line, range.start, range.length});
+            }
+        }
+        result.hunks.append(compareHunk);
+        result.removedLines += hunk.oldCount;
+        result.addedLines += hunk.newCount;
+        row += compareHunk.rows();
+        oldPos = hunk.oldStart + hunk.oldCount;
+        newPos = hunk.newStart + hunk.newCount;
+    }
+    appendLines(result.leftText, oldLines, oldPos, static_cast<int>(oldLines.size()) - oldPos);
+    appendLines(result.rightText, newLines, newPos, static_cast<int>(newLines.size()) - newPos);
+    result.leftText.chop(1);
+    result.rightText.chop(1);
+    result.milliseconds = timer.elapsed();
+    promise.addResult(std::move(result));
+}
+
+int visibleRow(const QPlainTextEdit *edit, int y)
+{
+    return edit->cursorForPosition(QPoint(0, y)).blockNumber();
+}
+
+// One full-width selection per row: a single selection across blocks would
+// leave empty padding rows unpainted. Only visible rows get here.
+void addRows(QList<QTextEdit::ExtraSelection> &selections, QPlainTextEdit *edit, int from, int to, const QColor &color)
+{
+    QTextBlock block = edit->document()->findBlockByNumber(from);
+    for (int row = from; row < to && block.isValid(); ++row, block = block.next()) {
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(block);
+        selection.format.setBackground(color);
+        selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+        selections.append(selection);
+    }
+}
+
+void addWords(QList<QTextEdit::ExtraSelection> &selections, QPlainTextEdit *edit,
+              const QVector<CompareWord> &words, int first, int last, const QColor &color)
+{
+    auto it = std::partition_point(words.cbegin(), words.cend(), [first](const CompareWord &word) {
+        return word.row < first;
+    });
+    for (; it != words.cend() && it->row <= last; ++it) {
+        const int start = edit->document()->findBlockByNumber(it->row).position() + it->start;
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(edit->document());
+        selection.cursor.setPosition(start);
+        selection.cursor.setPosition(start + it->length, QTextCursor::KeepAnchor);
+        selection.format.setBackground(color);
+        selections.append(selection);
+    }
+}
+
+}
+
+CompareDialog::CompareDialog(QWidget *parent)
+    : QDialog(parent)
+{
+    setAttribute(Qt::WA_DeleteOnClose);
+    setWindowTitle("Сравнение");
+    resize(1100, 700);
+
+    const QFont font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+    for (QPlainTextEdit **edit : {&left_, &right_}) {
+        *edit = new QPlainTextEdit(this);
+        (*edit)->setReadOnly(true);
+        (*edit)->setLineWrapMode(QPlainTextEdit::NoWrap);
+        (*edit)->setFont(font);
+        connect((*edit)->verticalScrollBar(), &QScrollBar::valueChanged, this, &CompareDialog::render);
+    }
+    connect(left_->verticalScrollBar(), &QScrollBar::valueChanged, right_->verticalScrollBar(), &QScrollBar::setValue);
+    connect(right_->verticalScrollBar(), &QScrollBar::valueChanged, left_->verticalScrollBar(), &QScrollBar::setValue);
+    connect(left_->horizontalScrollBar(), &QScrollBar::valueChanged, right_->horizontalScrollBar(), &QScrollBar::setValue);
+    connect(right_->horizontalScrollBar(), &QScrollBar::valueChanged, left_->horizontalScrollBar(), &QScrollBar::setValue);
+
+    leftTitle_ = new QLabel(this);
+    rightTitle_ = new QLabel(this);
+    statusLabel_ = new QLabel("Сравнение…", this);
+
+    auto *previousButton = new QToolButton(this);
+    previousButton->setText("▲");
+    previousButton->setToolTip("Предыдущее изменение (Shift+F8)");
+    previousButton->setShortcut(QKeySequence("Shift+F8"));
+    auto *nextButton = new QToolButton(this);
+    nextButton->setText("▼");
+    nextButton->setToolTip("Следующее изменение (F8)");
+    nextButton->setShortcut(QKeySequence(Qt::Key_F8));
+    connect(previousButton, &QToolButton::clicked, this, &CompareDialog::previousChange);
+    connect(nextButton, &QToolButton::clicked, this, &CompareDialog::nextChange);
+
+    auto *titles = new QHBoxLayout();
+    titles->addWidget(leftTitle_, 1);
+    titles->addWidget(previousButton);
+    titles->addWidget(nextButton);
+    titles->addWidget(rightTitle_, 1);
+
+    auto *sides = new QHBoxLayout();
+    sides->addWidget(left_);
+    sides->addWidget(right_);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addLayout(titles);
+    layout->addLayout(sides, 1);
+    layout->addWidget(statusLabel_);
+
+    connect(&watcher_, &QFutureWatcher<CompareResult>::finished, this, &CompareDialog::onCompared);
+}
+
+CompareDialog::~CompareDialog()
+{
+    watcher_.cancel();
+    watcher_.waitForFinished();
+}
+
+void CompareDialog::compare(const QString &leftPath, const QString &rightTitle, const QString &rightText)
+{
+    leftTitle_->setText(QFileInfo(leftPath).fileName());
+    leftTitle_->setToolTip(leftPath);
+    rightTitle_->setText(rightTitle);
+    watcher_.setFuture(QtConcurrent::run(compareWithFile, leftPath, rightText));
+}
+
+// A larger window shows rows that no scroll has coloured yet.
+void CompareDialog::resizeEvent(QResizeEvent *event)
+{
+    QDialog::resizeEvent(event);
+    render();
+}
+
+void CompareDialog::onCompared()
+{
+    if (watcher_.isCanceled() || watcher_.future().resultCount() == 0) {
+        return;
+    }
+    CompareResult result = watcher_.result();
+    if (!result.error.isEmpty()) {
+        statusLabel_->setText(result.error);
+        return;
+    }
+    hunks_ = std::move(result.hunks);
+    leftWords_ = std::move(result.leftWords);
+    rightWords_ = std::move(result.rightWords);
+    left_->setPlainText(result.leftText);
+    right_->setPlainText(result.rightText);
+    statusLabel_->setText(hunks_.isEmpty()
+                              ? QString("Различий нет | сравнение за %1 мс").arg(result.milliseconds)
+                              : QString("Изменений: %1 | удалено строк: %2, добавлено: %3 | сравнение за %4 мс")
+                                    .arg(hunks_.size()).arg(result.removedLines).arg(result.addedLines)
+                                    .arg(result.milliseconds));
+    render();
+    if (!hunks_.isEmpty()) {
+        goToHunk(0);
+    }
+}
+
+// Removed lines are red on the left, added lines green on the right and
+// padding rows grey; changed words inside a hunk are marked darker.
+void CompareDialog::render()
+{
+    const int first = visibleRow(left_, 0);
+    const int last = visibleRow(left_, left_->viewport()->height());
+    QList<QTextEdit::ExtraSelection> leftSelections;
+    QList<QTextEdit::ExtraSelection> rightSelections;
+
+    auto it = std::partition_point(hunks_.cbegin(), hunks_.cend(), [first](const CompareHunk &hunk) {
+        return hunk.row + hunk.rows() <= first;
+    });
+    const QColor padding(236, 236, 236);
+    for (; it != hunks_.cend() && it->row <= last; ++it) {
+        const int from = qMax(it->row, first);
+        const int end = qMin(it->row + it->rows(), last + 1);
+        addRows(leftSelections, left_, from, qMin(it->row + it->oldCount, end), QColor(255, 225, 225));
+        addRows(leftSelections, left_, qMax(from, it->row + it->oldCount), end, padding);
+        addRows(rightSelections, right_, from, qMin(it->row + it->newCount, end), QColor(220, 250, 220));
+        addRows(rightSelections, right_, qMax(from, it->row + it->newCount), end, padding);
+    }
+    addWords(leftSelections, left_, leftWords_, first, last, QColor(250, 170, 170));
+    addWords(rightSelections, right_, rightWords_, first, last, QColor(160, 225, 160));
+    left_->setExtraSelections(leftSelections);
+    right_->setExtraSelections(rightSelections);
+}
+
+void CompareDialog::goToHunk(int index)
+{
+    if (index < 0 || index >= hunks_.size()) {
+        return;
+    }
+    currentHunk_ = index;
+    const QTextBlock block = left_->document()->findBlockByNumber(hunks_.at(index).row);
+    left_->setTextCursor(QTextCursor(block));
+    left_->centerCursor();
+    right_->setTextCursor(QTextCursor(right_->document()->findBlockByNumber(block.blockNumber())));
+}
+
+void CompareDialog::nextChange()
+{
+    goToHunk(qMin(currentHunk_ + 1, static_cast<int>(hunks_.size()) - 1));
+}
+
+void CompareDialog::previousChange()
+{
+    goToHunk(qMax(currentHunk_ - 1, 0));
+}
@@ -0,0 +1,188 @@
+#include "../headers/completionpopup.h"
+
+#include <QTextEdit>
+#include <QTextCursor>
+#include <QTextBlock>
+#include <QListWidget>
+#include <QKeyEvent>
+#include <algorithm>
+
+namespace {
+
+constexpr int kMaxVisibleRows = 10;
+constexpr int kMaxEntries = 500;
+constexpr int kPopupWidth = 360;
+
+bool isWordChar(QChar ch)
+{
+    return ch.isLetterOrNumber() || ch == u'_';
+}
+
+}
+
+CompletionPopup::CompletionPopup(QTextEdit *textEdit, QObject *parent)
+    : QObject(parent)
+    , textEdit_(textEdit)
+{
+    list_ = new QListWidget(textEdit_->viewport());
+    list_->setFocusPolicy(Qt::NoFocus);
+    list_->setUniformItemSizes(true);
+    list_->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    list_->hide();
+
+    connect(list_, &QListWidget::itemClicked, this, &CompletionPopup::acceptItem);
+    connect(textEdit_, &QTextEdit::cursorPositionChanged, this, &CompletionPopup::refilter);
+    textEdit_->installEventFilter(this);
+}
+
+bool CompletionPopup::isVisible() const
+{
+    return list_->isVisible();
+}
+
+void CompletionPopup::show(int replaceFrom, const QVector<Entry> &entries)
+{
+    replaceFrom_ = replaceFrom;
+    entries_ = entries;
+    if (entries_.isEmpty()) {
+        hide();
+        return;
+    }
+    refilter();
+}
+
+void CompletionPopup::hide()
+{
+    list_->hide();
+    list_->clear();
+    entries_.clear();
+    replaceFrom_ = -1;
+}
+
+QString CompletionPopup::typedPrefix() const
+{
+    const QTextCursor cursor = textEdit_->textCursor();
+    if (replaceFrom_ < 0 || cursor.hasSelection() || cursor.position() < replaceFrom_) {
+        return QString();
+    }
+    const QTextBlock block = cursor.block();
+    if (replaceFrom_ < block.position()) {
+        return QString();
+    }
+    return block.text().mid(replaceFrom_ - block.position(), cursor.position() - replaceFrom_);
+}
+
+// Prefix matches are listed first, then the remaining substring matches,
+// each group in the order the provider gave.
+void CompletionPopup::refilter()
+{
+    if (replaceFrom_ < 0) {
+        return;
+    }
+    const QTextCursor cursor = textEdit_->textCursor();
+    const QString prefix = typedPrefix();
+    if (cursor.position() < replaceFrom_ || cursor.hasSelection()
+        || std::any_of(prefix.cbegin(), prefix.cend(), [](QChar ch) { return !isWordChar(ch); })) {
+        hide();
+        return;
+    }
+
+    QStringList starts;
+    QStringList contains;
+    QStringList startDetails;
+    QStringList containDetails;
+    for (const Entry &entry : std::as_const(entries_)) {
+        if (starts.size() >= kMaxEntries) {
+            break;
+        }
+        if (entry.text.startsWith(prefix, Qt::CaseInsensitive)) {
+            starts << entry.text;
+            startDetails << entry.detail;
+        } else if (entry.text.contains(prefix, Qt::CaseInsensitive)) {
+            contains << entry.text;
+            containDetails << entry.detail;
+        }
+    }
+    starts += contains.mid(0, kMaxEntries - starts.size());
+    startDetails += containDetails.mid(0, kMaxEntries - startDetails.size());
+    if (starts.isEmpty() || (starts.size() == 1 && starts.first() == prefix)) {
+        list_->hide();
+        return;
+    }
+
+    list_->setUpdatesEnabled(false);
+    list_->clear();
+    list_->addItems(starts);
+    for (int i = 0; i < startDetails.size(); ++i) {
+        if (!startDetails.at(i).isEmpty()) {
+            list_->item(i)->setToolTip(startDetails.at(i));
+        }
+    }
+    list_->setCurrentRow(0);
+    list_->setUpdatesEnabled(true);
+
+    const int rows = qMin(kMaxVisibleRows, list_->count());
+    const int height = rows * list_->sizeHintForRow(0) + 2 * list_->frameWidth();
+    const QRect caret = textEdit_->cursorRect(cursor);
+    const QRect viewport = textEdit_->viewport()->rect();
+    const int width = qMin(kPopupWidth, viewport.width());
+    int x = qMin(caret.left(), viewport.right() - width);
+    int y = caret.bottom() + 1;
+    if (y + height > viewport.bottom() && caret.top() - height >= 0) {
+        y = caret.top() - height;
+    }
+    list_->setGeometry(qMax(0, x), y, width, height);
+    list_->show();
+    list_->raise();
+}
+
+void CompletionPopup::moveSelection(int delta)
+{
+    const int row = qBound(0, list_->currentRow() + delta, list_->count() - 1);
+    list_->setCurrentRow(row);
+}
+
+void CompletionPopup::acceptItem(QListWidgetItem *item)
+{
+    if (!item || replaceFrom_ < 0) {
+        return;
+    }
+    const QString text = item->text();
+    QTextCursor cursor = textEdit_->textCursor();
+    cursor.beginEditBlock();
+    cursor.setPosition(replaceFrom_);
+    cursor.setPosition(textEdit_->textCursor().position(), QTextCursor::KeepAnchor);
+    cursor.insertText(text);
+    cursor.endEditBlock();
+    hide();
+    textEdit_->setTextCursor(cursor);
+    emit accepted(text);
+}
+
+bool CompletionPopup::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == textEdit_ && list_->isVisible()) {
+        if (event->type() == QEvent::FocusOut) {
+            hide();
+        } else if (event->type() == QEvent::KeyPress) {
+            const int page = kMaxVisibleRows - 1;
+            switch (static_cast<QKeyEvent *>(event)->key()) {
+            case Qt::Key_Up: moveSelection(-1); return true;
+            case Qt::Key_Down: moveSelection(1); return true;
+            case Qt::Key_PageUp: moveSelection(-page); return true;
+            case Qt::Key_PageDown: moveSelection(page); return true;
+            case Qt::Key_Return:
+            case Qt::Key_Enter:
+            case Qt::Key_Tab:
+                acceptItem(list_->currentItem());
+                return true;
+            case Qt::Key_Escape:
+                hide();
+                return true;
+            default:
+                break;
+            }
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
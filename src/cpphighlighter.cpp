@@ -0,0 +1,527 @@
+#include "../headers/cpphighlighter.h"
+
+#include <QTextEdit>
+#include <QTextDocument>
+#include <QTextLayout>
+#include <QScrollBar>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+constexpr qint64 kSliceMs = 8;
+constexpr qint64 kEditBudgetMs = 2;
+constexpr int kClockStride = 16;
+constexpr int kMaxRawDelimiter = 16;
+
+enum State {
+    Normal = 0,
+    BlockComment = 1,
+    LineCommentContinued = 2,
+    StringContinued = 3,
+    RawString = 4
+};
+constexpr int kStateMask = 0xff;
+
+enum Token {
+    KeywordToken,
+    TypeToken,
+    NumberToken,
+    StringToken,
+    CommentToken,
+    PreprocessorToken,
+    FunctionToken,
+    TokenCount
+};
+
+constexpr QStringView kKeywords[] = {
+    u"alignas", u"alignof", u"asm", u"auto", u"break", u"case", u"catch", u"class", u"co_await", u"co_return",
+    u"co_yield", u"concept", u"const", u"const_cast", u"consteval", u"constexpr", u"constinit", u"continue",
+    u"decltype", u"default", u"delete", u"do", u"dynamic_cast", u"else", u"enum", u"explicit", u"export",
+    u"extern", u"false", u"final", u"for", u"friend", u"goto", u"if", u"inline", u"mutable", u"namespace",
+    u"new", u"noexcept", u"nullptr", u"operator", u"override", u"private", u"protected", u"public",
+    u"register", u"reinterpret_cast", u"requires", u"return", u"sizeof", u"static", u"static_assert",
+    u"static_cast", u"struct", u"switch", u"template", u"this", u"thread_local", u"throw", u"true", u"try",
+    u"typedef", u"typeid", u"typename", u"union", u"using", u"virtual", u"volatile", u"while"
+};
+
+constexpr QStringView kTypes[] = {
+    u"bool", u"char", u"char16_t", u"char32_t", u"char8_t", u"double", u"float", u"int", u"int16_t",
+    u"int32_t", u"int64_t", u"int8_t", u"intptr_t", u"long", u"ptrdiff_t", u"qint16", u"qint32", u"qint64",
+    u"qint8", u"qreal", u"qsizetype", u"quint16", u"quint32", u"quint64", u"quint8", u"short", u"signed",
+    u"size_t", u"ssize_t", u"uint16_t", u"uint32_t", u"uint64_t", u"uint8_t", u"uintptr_t", u"unsigned",
+    u"void", u"wchar_t"
+};
+
+const QStringList kCppExtensions = {
+    "c", "cc", "cpp", "cxx", "c++", "h", "hh", "hpp", "hxx", "h++", "inl", "ipp", "tpp"
+};
+
+template<size_t N>
+bool contains(const QStringView (&words)[N], QStringView word)
+{
+    return std::binary_search(std::begin(words), std::end(words), word);
+}
+
+bool isIdentifierStart(QChar ch)
+{
+    return ch.isLetter() || ch == u'_';
+}
+
+bool isIdentifierChar(QChar ch)
+{
+    return ch.isLetterOrNumber() || ch == u'_';
+}
+
+int rawStringState(QStringView delimiter)
+{
+    return RawString | static_cast<int>((qHash(delimiter) & 0xffff) << 8);
+}
+
+// Index just past the closing quote, or -1 if the literal runs to the end.
+qsizetype scanQuoted(QStringView text, qsizetype from, QChar quote)
+{
+    for (qsizetype i = from; i < text.size(); ++i) {
+        if (text[i] == u'\\') {
+            ++i;
+        } else if (text[i] == quote) {
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+// Index just past ')delimiter"' for the delimiter hashed into the state.
+qsizetype scanRawEnd(QStringView text, qsizetype from, int state)
+{
+    for (qsizetype i = text.indexOf(u')', from); i >= 0; i = text.indexOf(u')', i + 1)) {
+        const qsizetype quote = text.indexOf(u'"', i + 1);
+        if (quote < 0) {
+            return -1;
+        }
+        if (quote - i - 1 <= kMaxRawDelimiter && rawStringState(text.sliced(i + 1, quote - i - 1)) == state) {
+            return quote + 1;
+        }
+    }
+    return -1;
+}
+
+bool endsWithBackslash(QStringView text)
+{
+    return !text.isEmpty() && text.back() == u'\\';
+}
+
+class Lexer
+{
+public:
+    Lexer(QStringView text, const QVector<QTextCharFormat> &formats, QVector<QTextLayout::FormatRange> &ranges)
+        : text_(text), formats_(formats), ranges_(ranges)
+    {
+    }
+
+    int run(int state)
+    {
+        const qsizetype size = text_.size();
+        qsizetype i = 0;
+
+        switch (state & kStateMask) {
+        case BlockComment: {
+            const qsizetype end = text_.indexOf(u"*/");
+            if (end < 0) {
+                add(0, size, CommentToken);
+                return BlockComment;
+            }
+            add(0, end + 2, CommentToken);
+            i = end + 2;
+            break;
+        }
+        case LineCommentContinued:
+            add(0, size, CommentToken);
+            return endsWithBackslash(text_) ? LineCommentContinued : Normal;
+        case StringContinued: {
+            const qsizetype end = scanQuoted(text_, 0, u'"');
+            if (end < 0) {
+                add(0, size, StringToken);
+                return endsWithBackslash(text_) ? StringContinued : Normal;
+            }
+            add(0, end, StringToken);
+            i = end;
+            break;
+        }
+        case RawString: {
+            const qsizetype end = scanRawEnd(text_, 0, state);
+            if (end < 0) {
+                add(0, size, StringToken);
+                return state;
+            }
+            add(0, end, StringToken);
+            i = end;
+            break;
+        }
+        default:
+            break;
+        }
+
+        bool lineStart = true;
+        while (i < size) {
+            const QChar ch = text_[i];
+            const QChar next = i + 1 < size ? text_[i + 1] : QChar();
+
+            if (ch.isSpace()) {
+                ++i;
+                continue;
+            }
+            if (ch == u'/' && next == u'/') {
+                add(i, size, CommentToken);
+                return endsWithBackslash(text_) ? LineCommentContinued : Normal;
+            }
+            if (ch == u'/' && next == u'*') {
+                const qsizetype end = text_.indexOf(u"*/", i + 2);
+                if (end < 0) {
+                    add(i, size, CommentToken);
+                    return BlockComment;
+                }
+                add(i, end + 2, CommentToken);
+                i = end + 2;
+                lineStart = false;
+                continue;
+            }
+            if (ch == u'#' && lineStart) {
+                i = directive(i);
+                lineStart = false;
+                continue;
+            }
+            lineStart = false;
+
+            if (ch == u'"' || ch == u'\'') {
+                const int result = quoted(i, i);
+                if (result >= 0) {
+                    return result;
+                }
+                continue;
+            }
+            if (ch.isDigit() || (ch == u'.' && next.isDigit())) {
+                const qsizetype start = i;
+                while (i < size) {
+                    const QChar c = text_[i];
+                    if ((c == u'+' || c == u'-') && (text_[i - 1] == u'e' || text_[i - 1] == u'E'
+                                                     || text_[i - 1] == u'p' || text_[i - 1] == u'P')) {
+                        ++i;
+                    } else if (isIdentifierChar(c) || c == u'.' || c == u'\'') {
+                        ++i;
+                    } else {
+                        break;
+                    }
+                }
+                add(start, i, NumberToken);
+                continue;
+            }
+            if (isIdentifierStart(ch)) {
+                const qsizetype start = i;
+                while (i < size && isIdentifierChar(text_[i])) {
+                    ++i;
+                }
+                const QStringView word = text_.sliced(start, i - start);
+                if (i < size && (text_[i] == u'"' || text_[i] == u'\'') && isLiteralPrefix(word, text_[i])) {
+                    const int result = quoted(start, i);
+                    if (result >= 0) {
+                        return result;
+                    }
+                    continue;
+                }
+                if (contains(kKeywords, word)) {
+                    add(start, i, KeywordToken);
+                } else if (contains(kTypes, word)) {
+                    add(start, i, TypeToken);
+                } else {
+                    qsizetype j = i;
+                    while (j < size && text_[j].isSpace()) {
+                        ++j;
+                    }
+                    if (j < size && text_[j] == u'(') {
+                        add(start, i, FunctionToken);
+                    }
+                }
+                continue;
+            }
+            ++i;
+        }
+        return Normal;
+    }
+
+private:
+    static bool isLiteralPrefix(QStringView word, QChar quote)
+    {
+        if (word == u"u8" || word == u"u" || word == u"U" || word == u"L") {
+            return true;
+        }
+        return quote == u'"' && (word == u"R" || word == u"u8R" || word == u"uR" || word == u"UR" || word == u"LR");
+    }
+
+    // Lexes a string or character literal whose opening quote is at quote.
+    // Returns the end state when the literal runs past the line, -1 otherwise.
+    int quoted(qsizetype start, qsizetype &quote)
+    {
+        const qsizetype size = text_.size();
+        const bool raw = quote > start && text_[quote - 1] == u'R';
+        if (raw) {
+            const qsizetype paren = text_.indexOf(u'(', quote + 1);
+            if (paren >= 0 && paren - quote - 1 <= kMaxRawDelimiter) {
+                const int state = rawStringState(text_.sliced(quote + 1, paren - quote - 1));
+                const qsizetype end = scanRawEnd(text_, paren + 1, state);
+                if (end < 0) {
+                    add(start, size, StringToken);
+                    return state;
+                }
+                add(start, end, StringToken);
+                quote = end;
+                return -1;
+            }
+        }
+
+        const QChar q = text_[quote];
+        const qsizetype end = scanQuoted(text_, quote + 1, q);
+        if (end < 0) {
+            add(start, size, StringToken);
+            return q == u'"' && endsWithBackslash(text_) ? StringContinued : Normal;
+        }
+        add(start, end, StringToken);
+        quote = end;
+        return -1;
+    }
+
+    qsizetype directive(qsizetype hash)
+    {
+        const qsizetype size = text_.size();
+        qsizetype i = hash + 1;
+        while (i < size && text_[i].isSpace()) {
+            ++i;
+        }
+        const qsizetype nameStart = i;
+        while (i < size && isIdentifierChar(text_[i])) {
+            ++i;
+        }
+        add(hash, i, PreprocessorToken);
+
+        const QStringView name = text_.sliced(nameStart, i - nameStart);
+        if (name == u"include" || name == u"include_next" || name == u"import") {
+            while (i < size && text_[i].isSpace()) {
+                ++i;
+            }
+            if (i < size && text_[i] == u'<') {
+                const qsizetype end = text_.indexOf(u'>', i + 1);
+                const qsizetype stop = end < 0 ? size : end + 1;
+                add(i, stop, StringToken);
+                i = stop;
+            }
+        }
+        return i;
+    }
+
+    void add(qsizetype start, qsizetype end, Token token)
+    {
+        if (end > start) {
+            ranges_.append({static_cast<int>(start), static_cast<int>(end - start), formats_.at(token)});
+        }
+    }
+
+    QStringView text_;
+    const QVector<QTextCharFormat> &formats_;
+    QVector<QTextLayout::FormatRange> &ranges_;
+};
+
+QTextCharFormat tokenFormat(const QColor &color, bool italic = false)
+{
+    QTextCharFormat format;
+    format.setForeground(color);
+    if (italic) {
+        format.setFontItalic(true);
+    }
+    return format;
+}
+
+}
+
+CppHighlighter::CppHighlighter(QTextEdit *textEdit, QObject *parent)
+    : QObject(parent), textEdit_(textEdit)
+{
+    sliceTimer_.setSingleShot(true);
+    sliceTimer_.setInterval(0);
+    connect(&sliceTimer_, &QTimer::timeout, this, &CppHighlighter::processSlice);
+    connect(textEdit_->document(), &QTextDocument::contentsChange, this, &CppHighlighter::onContentsChange);
+    connect(textEdit_->verticalScrollBar(), &QScrollBar::valueChanged, this, [this]() {
+        if (enabled_ && frontier_ < blockCount_) {
+            sliceTimer_.start();
+        }
+    });
+    setDarkPalette(false);
+}
+
+bool CppHighlighter::handlesFile(const QString &fileName)
+{
+    return kCppExtensions.contains(QFileInfo(fileName).suffix().toLower());
+}
+
+void CppHighlighter::setEnabled(bool enabled)
+{
+    if (enabled_ == enabled) {
+        return;
+    }
+    enabled_ = enabled;
+    if (enabled_) {
+        restart();
+    } else {
+        sliceTimer_.stop();
+        clearFormats();
+    }
+}
+
+void CppHighlighter::setDarkPalette(bool dark)
+{
+    if (!formats_.isEmpty() && dark_ == dark) {
+        return;
+    }
+    dark_ = dark;
+    formats_.resize(TokenCount);
+    formats_[KeywordToken] = tokenFormat(dark ? QColor("#cc7832") : QColor("#0033b3"));
+    formats_[TypeToken] = tokenFormat(dark ? QColor("#b589d6") : QColor("#7a3e9d"));
+    formats_[NumberToken] = tokenFormat(dark ? QColor("#6897bb") : QColor("#1750eb"));
+    formats_[StringToken] = tokenFormat(dark ? QColor("#6a8759") : QColor("#067d17"));
+    formats_[CommentToken] = tokenFormat(dark ? QColor("#808080") : QColor("#8c8c8c"), true);
+    formats_[PreprocessorToken] = tokenFormat(dark ? QColor("#bbb529") : QColor("#9e880d"));
+    formats_[FunctionToken] = tokenFormat(dark ? QColor("#ffc66d") : QColor("#00627a"));
+    if (enabled_) {
+        restart();
+    }
+}
+
+void CppHighlighter::restart()
+{
+    frontier_ = 0;
+    lexedUntil_ = 0;
+    dirtyUntil_ = -1;
+    blockCount_ = textEdit_->document()->blockCount();
+    processSlice();
+}
+
+void CppHighlighter::clearFormats()
+{
+    QTextDocument *document = textEdit_->document();
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+        block.setUserState(-1);
+        if (!block.layout()->formats().isEmpty()) {
+            block.layout()->clearFormats();
+            document->markContentsDirty(block.position(), block.length());
+        }
+    }
+}
+
+// Line-count changes shift the bookkeeping after the edit; the edited blocks
+// themselves are re-lexed right away within a small budget.
+void CppHighlighter::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (!enabled_ || (charsRemoved == 0 && charsAdded == 0)) {
+        return;
+    }
+    QTextDocument *document = textEdit_->document();
+    const int count = document->blockCount();
+    const int lineDelta = count - blockCount_;
+    blockCount_ = count;
+
+    const int first = document->findBlock(position).blockNumber();
+    const int last = qMax(first, document->findBlock(position + charsAdded).blockNumber());
+    if (lexedUntil_ > first) {
+        lexedUntil_ = qMax(first, lexedUntil_ + lineDelta);
+    }
+    if (dirtyUntil_ > first) {
+        dirtyUntil_ = qMax(first, dirtyUntil_ + lineDelta);
+    }
+    dirtyUntil_ = qMax(dirtyUntil_, last);
+    frontier_ = qMin(frontier_, first);
+
+    advance(kEditBudgetMs);
+    if (frontier_ < blockCount_) {
+        sliceTimer_.start();
+    }
+}
+
+void CppHighlighter::processSlice()
+{
+    if (!enabled_) {
+        return;
+    }
+    highlightViewport();
+    advance(kSliceMs);
+    if (frontier_ < blockCount_) {
+        sliceTimer_.start();
+    }
+}
+
+void CppHighlighter::advance(qint64 budgetMs)
+{
+    QElapsedTimer clock;
+    clock.start();
+
+    QTextBlock block = textEdit_->document()->findBlockByNumber(frontier_);
+    int state = block.isValid() && block.previous().isValid() ? block.previous().userState() : Normal;
+    int processed = 0;
+    while (block.isValid()) {
+        const int number = frontier_;
+        const int previous = block.userState();
+        state = lexBlock(block, state);
+        ++frontier_;
+
+        if (state == previous && number >= dirtyUntil_ && frontier_ < lexedUntil_) {
+            frontier_ = lexedUntil_;
+            block = textEdit_->document()->findBlockByNumber(frontier_);
+            state = block.isValid() ? block.previous().userState() : Normal;
+        } else {
+            block = block.next();
+        }
+        if (++processed % kClockStride == 0 && clock.elapsed() >= budgetMs) {
+            break;
+        }
+    }
+
+    lexedUntil_ = qMax(lexedUntil_, frontier_);
+    if (frontier_ > dirtyUntil_) {
+        dirtyUntil_ = -1;
+    }
+}
+
+// Visible blocks beyond the frontier are lexed ahead of time, starting from
+// the best state known for the block above them; the sequential pass fixes
+// them up if that guess was wrong.
+void CppHighlighter::highlightViewport()
+{
+    const QRect viewport = textEdit_->viewport()->rect();
+    QTextBlock block = textEdit_->cursorForPosition(viewport.topLeft()).block();
+    const int last = textEdit_->cursorForPosition(viewport.bottomRight()).block().blockNumber();
+    if (!block.isValid() || last < frontier_) {
+        return;
+    }
+    if (block.blockNumber() < frontier_) {
+        block = textEdit_->document()->findBlockByNumber(frontier_);
+    }
+    int state = block.previous().isValid() ? qMax(static_cast<int>(Normal), block.previous().userState()) : Normal;
+    for (; block.isValid() && block.blockNumber() <= last; block = block.next()) {
+        state = lexBlock(block, state);
+    }
+}
+
+int CppHighlighter::lexBlock(QTextBlock &block, int state)
+{
+    QVector<QTextLayout::FormatRange> ranges;
+    const QString text = block.text();
+    const int endState = Lexer(text, formats_, ranges).run(state);
+    block.setUserState(endState);
+
+    QTextLayout *layout = block.layout();
+    if (layout->formats() != ranges) {
+        layout->setFormats(ranges);
+        textEdit_->document()->markContentsDirty(block.position(), block.length());
+    }
+    return endState;
+}
@@ -0,0 +1,164 @@
+#include "../headers/diagnostichighlighter.h"
+#include "../headers/selectionlayers.h"
+
+#include <QTextEdit>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QScrollBar>
+#include <QHelpEvent>
+#include <QToolTip>
+#include <algorithm>
+
+namespace {
+
+constexpr int kRenderDelayMs = 30;
+constexpr int kMaxSpanLines = 50;
+constexpr qsizetype kMaxHoverLength = 2000;
+
+QColor severityColor(int severity)
+{
+    switch (severity) {
+    case LspDiagnostic::Error: return QColor(220, 40, 40);
+    case LspDiagnostic::Warning: return QColor(230, 150, 0);
+    default: return QColor(60, 120, 220);
+    }
+}
+
+bool covers(const LspDiagnostic &diagnostic, int line, int character)
+{
+    const bool afterStart = line > diagnostic.startLine
+                            || (line == diagnostic.startLine && character >= diagnostic.startCharacter);
+    const bool beforeEnd = line < diagnostic.endLine
+                           || (line == diagnostic.endLine && character <= diagnostic.endCharacter);
+    return afterStart && beforeEnd;
+}
+
+}
+
+DiagnosticHighlighter::DiagnosticHighlighter(QTextEdit *textEdit, QObject *parent)
+    : QObject(parent)
+    , textEdit_(textEdit)
+{
+    renderTimer_.setSingleShot(true);
+    renderTimer_.setInterval(kRenderDelayMs);
+    connect(&renderTimer_, &QTimer::timeout, this, &DiagnosticHighlighter::render);
+    connect(textEdit_->verticalScrollBar(), &QScrollBar::valueChanged, this, &DiagnosticHighlighter::schedule);
+    textEdit_->viewport()->installEventFilter(this);
+}
+
+void DiagnosticHighlighter::setDiagnostics(const QVector<LspDiagnostic> &diagnostics)
+{
+    diagnostics_ = diagnostics;
+    std::stable_sort(diagnostics_.begin(), diagnostics_.end(), [](const LspDiagnostic &a, const LspDiagnostic &b) {
+        return a.startLine < b.startLine;
+    });
+    errors_ = static_cast<int>(std::count_if(diagnostics_.cbegin(), diagnostics_.cend(), [](const LspDiagnostic &d) {
+        return d.severity == LspDiagnostic::Error;
+    }));
+    warnings_ = static_cast<int>(std::count_if(diagnostics_.cbegin(), diagnostics_.cend(), [](const LspDiagnostic &d) {
+        return d.severity == LspDiagnostic::Warning;
+    }));
+    render();
+}
+
+void DiagnosticHighlighter::schedule()
+{
+    if (!diagnostics_.isEmpty()) {
+        renderTimer_.start();
+    }
+}
+
+int DiagnosticHighlighter::positionOf(int line, int character) const
+{
+    const QTextBlock block = textEdit_->document()->findBlockByNumber(line);
+    if (!block.isValid()) {
+        return textEdit_->document()->characterCount() - 1;
+    }
+    return block.position() + qBound(0, character, block.length() - 1);
+}
+
+void DiagnosticHighlighter::render()
+{
+    if (diagnostics_.isEmpty()) {
+        SelectionLayers::of(textEdit_)->clearLayer(SelectionLayers::DiagnosticLayer);
+        return;
+    }
+
+    const QRect viewport = textEdit_->viewport()->rect();
+    const int firstLine = textEdit_->cursorForPosition(viewport.topLeft()).blockNumber();
+    const int lastLine = textEdit_->cursorForPosition(viewport.bottomRight()).blockNumber();
+    auto it = std::lower_bound(diagnostics_.cbegin(), diagnostics_.cend(), firstLine - kMaxSpanLines,
+                               [](const LspDiagnostic &d, int line) { return d.startLine < line; });
+
+    QList<QTextEdit::ExtraSelection> selections;
+    for (; it != diagnostics_.cend() && it->startLine <= lastLine; ++it) {
+        if (it->endLine < firstLine) {
+            continue;
+        }
+        int start = positionOf(it->startLine, it->startCharacter);
+        int end = positionOf(it->endLine, it->endCharacter);
+        if (end <= start) {
+            const QTextBlock block = textEdit_->document()->findBlock(start);
+            const int blockEnd = block.position() + block.length() - 1;
+            if (start < blockEnd) {
+                end = start + 1;
+            } else {
+                end = start;
+                start = qMax(block.position(), start - 1);
+            }
+        }
+
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(textEdit_->document());
+        selection.cursor.setPosition(start);
+        selection.cursor.setPosition(end, QTextCursor::KeepAnchor);
+        selection.format.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
+        selection.format.setUnderlineColor(severityColor(it->severity));
+        selections.append(selection);
+    }
+    SelectionLayers::of(textEdit_)->setLayer(SelectionLayers::DiagnosticLayer, selections);
+}
+
+void DiagnosticHighlighter::showHover(int position, const QString &text)
+{
+    if (position != hoverPosition_ || !textEdit_->viewport()->underMouse()) {
+        return;
+    }
+    QToolTip::showText(hoverPoint_, text.left(kMaxHoverLength), textEdit_->viewport());
+}
+
+bool DiagnosticHighlighter::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched != textEdit_->viewport()) {
+        return QObject::eventFilter(watched, event);
+    }
+    if (event->type() == QEvent::Resize) {
+        schedule();
+    } else if (event->type() == QEvent::ToolTip) {
+        const auto *help = static_cast<QHelpEvent *>(event);
+        const QTextCursor cursor = textEdit_->cursorForPosition(help->pos());
+        const int line = cursor.blockNumber();
+        const int character = cursor.positionInBlock();
+
+        QStringList messages;
+        for (const LspDiagnostic &diagnostic : std::as_const(diagnostics_)) {
+            if (diagnostic.startLine > line) {
+                break;
+            }
+            if (covers(diagnostic, line, character)) {
+                messages << (diagnostic.source.isEmpty() ? diagnostic.message
+                                                         : diagnostic.source + ": " + diagnostic.message);
+            }
+        }
+        if (!messages.isEmpty()) {
+            QToolTip::showText(help->globalPos(), messages.join('\n'), textEdit_->viewport());
+        } else {
+            QToolTip::hideText();
+            hoverPosition_ = cursor.position();
+            hoverPoint_ = help->globalPos();
+            emit hoverRequested(hoverPosition_);
+        }
+        return true;
+    }
+    return QObject::eventFilter(watched, event);
+}
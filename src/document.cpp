@@ -2,6 +2,7 @@
 #include <QTextStream>
 #include <QFile>
 #include <QTextCursor>
+#include <QTextEdit>
 #include <QStringConverter>
 
 Document::Document(QObject *parent)
@@ -26,6 +27,19 @@ QTextDocument *Document::qtDocument() const
     return m_doc;
 }
 
+void Document::attachEditor(QTextEdit *editor)
+{
+    m_editor = editor;
+}
+
+QTextCursor Document::editorCursor() const
+{
+    if (m_editor && m_editor->document() == m_doc) {
+        return m_editor->textCursor();
+    }
+    return QTextCursor(m_doc);
+}
+
 bool Document::loadFromFile(const QString &fileName)
 {
     QFile file(fileName);
@@ -118,8 +132,7 @@ void Document::clear()
 
 QString Document::getSelectedText() const
 {
-    QTextCursor cursor(m_doc);
-    return cursor.selectedText();
+    return editorCursor().selectedText();
 }
 
 QString Document::getAllText() const
@@ -129,6 +142,40 @@ QString Document::getAllText() const
 
 void Document::insertTextAtCursor(const QString &text)
 {
-    QTextCursor cursor(m_doc);
+    QTextCursor cursor = editorCursor();
     cursor.insertText(text);
+    if (m_editor && m_editor->document() == m_doc) {
+        m_editor->setTextCursor(cursor);
+    }
+}
+
+bool Document::hasSelection() const
+{
+    return editorCursor().hasSelection();
+}
+
+TextRange Document::selectionRange() const
+{
+    const QTextCursor cursor = editorCursor();
+    return TextRange{cursor.selectionStart(), cursor.selectionEnd()};
+}
+
+int Document::characterCount() const
+{
+    return m_doc->characterCount();
+}
+
+int Document::blockCount() const
+{
+    return m_doc->blockCount();
+}
+
+DocumentBlocks Document::blocks(TextRange range) const
+{
+    return DocumentBlocks(m_doc->findBlock(range.start), range);
+}
+
+DocumentBlocks Document::blocks() const
+{
+    return DocumentBlocks(m_doc->begin(), TextRange{0, m_doc->characterCount()});
 }
@@ -78,6 +78,7 @@ bool DocumentManager::saveDocument(const QString &filePath, QTextDocument *docum
         return false;
     }
 
+    context_.syncedBytes = -1;
     if (!handler->save(filePath, document, context_, errorMessage)) {
         return false;
     }
@@ -88,6 +89,22 @@ bool DocumentManager::saveDocument(const QString &filePath, QTextDocument *docum
     return true;
 }
 
+bool DocumentManager::extractText(const QString &filePath, QString &text, QString &errorMessage) const
+{
+    const QString extension = normalizeExtension(filePath);
+    const DocumentHandler *handler = selectHandlerForExtension(extension, false);
+    if (!handler) {
+        errorMessage = QObject::tr("Формат '%1' не поддерживается").arg(extension);
+        return false;
+    }
+    return handler->extractText(filePath, text, errorMessage);
+}
+
+bool DocumentManager::isPlainText(const QString &filePath) const
+{
+    return dynamic_cast<const PlainTextHandler *>(selectHandlerForExtension(normalizeExtension(filePath), false)) != nullptr;
+}
+
 QString DocumentManager::filterForOpenDialog() const
 {
     QStringList parts;
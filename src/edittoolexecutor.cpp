@@ -0,0 +1,240 @@
+#include "../headers/edittoolexecutor.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QPromise>
+#include <QTextEdit>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QTextBlock>
+#include <QTextFragment>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+
+class PromiseControl : public EditToolControl
+{
+public:
+    PromiseControl(QPromise<EditToolResult> &promise, QThreadPool *pool)
+        : promise_(promise), pool_(pool)
+    {
+    }
+
+    bool isCanceled() const override { return promise_.isCanceled(); }
+    void setProgress(int percent) override { promise_.setProgressValue(percent); }
+    QThreadPool *pool() const override { return pool_; }
+
+private:
+    QPromise<EditToolResult> &promise_;
+    QThreadPool *pool_;
+};
+
+struct FormatSlice
+{
+    int position = 0;
+    int length = 0;
+    QTextCharFormat format;
+};
+
+void runTool(QPromise<EditToolResult> &promise, const IEditTool *tool, const EditToolInput &input, QThreadPool *pool)
+{
+    promise.setProgressRange(0, 100);
+    PromiseControl control(promise, pool);
+    EditToolResult result = tool->compute(input, control);
+    if (!promise.isCanceled()) {
+        promise.addResult(std::move(result));
+    }
+}
+
+// Shifts a position past changes that happened entirely before it.
+void shift(int &position, int changeEnd, int delta)
+{
+    if (changeEnd <= position) {
+        position += delta;
+    }
+}
+
+// Same-length replacements that ask for it are written fragment by
+// fragment with the fragment's own format, so case conversion keeps
+// bold/italic runs and leaves embedded objects alone. Other replacements,
+// such as a sorted range of lines, are one insertion with the format of
+// the fragment they start in.
+void applyEdit(QTextCursor &cursor, const EditToolEdit &edit)
+{
+    QTextDocument *document = cursor.document();
+    if (!edit.keepFormats || edit.length == 0 || edit.length != edit.text.size()) {
+        cursor.setPosition(edit.position);
+        cursor.setPosition(edit.position + edit.length, QTextCursor::KeepAnchor);
+        if (edit.length == 0) {
+            cursor.insertText(edit.text);
+            return;
+        }
+        const QTextBlock block = document->findBlock(edit.position);
+        for (auto it = block.begin(); !it.atEnd(); ++it) {
+            const QTextFragment fragment = it.fragment();
+            if (fragment.contains(edit.position)) {
+                cursor.insertText(edit.text, fragment.charFormat());
+                return;
+            }
+        }
+        cursor.insertText(edit.text);
+        return;
+    }
+
+    const int end = edit.position + edit.length;
+    QVector<FormatSlice> slices;
+    for (QTextBlock block = document->findBlock(edit.position); block.isValid() && block.position() < end;
+         block = block.next()) {
+        for (auto it = block.begin(); !it.atEnd(); ++it) {
+            const QTextFragment fragment = it.fragment();
+            const int from = qMax(fragment.position(), edit.position);
+            const int to = qMin(fragment.position() + fragment.length(), end);
+            if (from >= to) {
+                continue;
+            }
+            const QStringView replacement = QStringView(edit.text).sliced(from - edit.position, to - from);
+            if (QStringView(fragment.text()).sliced(from - fragment.position(), to - from) != replacement) {
+                slices.append({from, to - from, fragment.charFormat()});
+            }
+        }
+    }
+
+    for (const FormatSlice &slice : slices) {
+        cursor.setPosition(slice.position);
+        cursor.setPosition(slice.position + slice.length, QTextCursor::KeepAnchor);
+        cursor.insertText(edit.text.mid(slice.position - edit.position, slice.length), slice.format);
+    }
+}
+
+}
+
+EditToolExecutor::EditToolExecutor(QObject *parent)
+    : QObject(parent)
+{
+    pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    connect(&watcher_, &QFutureWatcher<EditToolResult>::progressValueChanged, this, &EditToolExecutor::progress);
+    connect(&watcher_, &QFutureWatcher<EditToolResult>::finished, this, &EditToolExecutor::onFinished);
+}
+
+EditToolExecutor::~EditToolExecutor()
+{
+    cancel();
+    watcher_.waitForFinished();
+}
+
+bool EditToolExecutor::start(const IEditTool *tool, IDocument *document, QTextEdit *textEdit)
+{
+    if (!tool || !document || !textEdit) {
+        return false;
+    }
+    if (isRunning()) {
+        cancel();
+        watcher_.waitForFinished();
+    }
+    detach();
+
+    textEdit_ = textEdit;
+    toolName_ = tool->getName();
+    changes_.clear();
+    changeConnection_ = connect(textEdit->document(), &QTextDocument::contentsChange,
+                                this, &EditToolExecutor::onContentsChange);
+
+    emit started(toolName_);
+    watcher_.setFuture(QtConcurrent::run(runTool, tool, tool->snapshot(document), &pool_));
+    return true;
+}
+
+void EditToolExecutor::cancel()
+{
+    watcher_.cancel();
+}
+
+bool EditToolExecutor::isRunning() const
+{
+    return watcher_.isRunning();
+}
+
+void EditToolExecutor::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (!applying_) {
+        changes_.append({position, charsRemoved, charsAdded});
+    }
+}
+
+void EditToolExecutor::onFinished()
+{
+    const QFuture<EditToolResult> future = watcher_.future();
+    if (future.isCanceled() || future.resultCount() == 0 || !textEdit_) {
+        detach();
+        emit finished(QString("%1: операция отменена").arg(toolName_));
+        return;
+    }
+
+    EditToolResult result = future.result();
+    if (!rebase(result)) {
+        detach();
+        emit finished(QString("%1: документ изменился во время выполнения, результат отброшен").arg(toolName_));
+        return;
+    }
+    apply(result);
+    detach();
+    emit finished(result.message.isEmpty() ? QString("%1: готово").arg(toolName_) : result.message);
+}
+
+// Edits are moved past changes made after the snapshot; a change that
+// touches an edited range makes the whole result stale.
+bool EditToolExecutor::rebase(EditToolResult &result) const
+{
+    for (const Change &change : changes_) {
+        const int changeEnd = change.position + change.removed;
+        const int delta = change.added - change.removed;
+        for (EditToolEdit &edit : result.edits) {
+            const int editEnd = edit.position + edit.length;
+            if (changeEnd <= edit.position) {
+                edit.position += delta;
+            } else if (change.position < editEnd) {
+                return false;
+            }
+        }
+        if (result.placeCursor || !result.selection.isEmpty()) {
+            shift(result.selection.end, changeEnd, delta);
+            shift(result.selection.start, changeEnd, delta);
+        }
+    }
+
+    const int limit = textEdit_->document()->characterCount() - 1;
+    return std::all_of(result.edits.cbegin(), result.edits.cend(), [limit](const EditToolEdit &edit) {
+        return edit.position >= 0 && edit.position + edit.length <= limit;
+    });
+}
+
+void EditToolExecutor::apply(const EditToolResult &result)
+{
+    QTextCursor cursor(textEdit_->document());
+    if (!result.edits.isEmpty()) {
+        QVector<EditToolEdit> edits = result.edits;
+        std::sort(edits.begin(), edits.end(), [](const EditToolEdit &a, const EditToolEdit &b) {
+            return a.position > b.position;
+        });
+
+        applying_ = true;
+        cursor.beginEditBlock();
+        for (const EditToolEdit &edit : edits) {
+            applyEdit(cursor, edit);
+        }
+        cursor.endEditBlock();
+        applying_ = false;
+    }
+
+    if (result.placeCursor || !result.selection.isEmpty()) {
+        cursor.setPosition(result.selection.start);
+        cursor.setPosition(result.selection.end, QTextCursor::KeepAnchor);
+        textEdit_->setTextCursor(cursor);
+    }
+}
+
+void EditToolExecutor::detach()
+{
+    disconnect(changeConnection_);
+    changes_.clear();
+}
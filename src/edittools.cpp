@@ -1,68 +1,259 @@
 #include "../headers/edittools.h"
-#include <QTextCursor>
-#include <QMessageBox>
-#include <QRegularExpression>
+#include "../headers/caseconversion.h"
+#include "../headers/linetools.h"
 
-void UpperCaseTool::execute(IDocument* document, QTextEdit* textEdit) {
-    (void)textEdit;
-    if (!document) {
-        return;
+namespace {
+
+constexpr qsizetype kProgressStride = qsizetype(1) << 20;
+constexpr qsizetype kMergeGap = 32;
+
+QString textOf(const IDocument* document, TextRange range) {
+    QString text;
+    text.reserve(range.length());
+    bool first = true;
+    for (const TextChunk& chunk : document->blocks(range)) {
+        if (!first) {
+            text += QLatin1Char('\n');
+        }
+        text += chunk.text;
+        first = false;
+    }
+    return text;
+}
+
+EditToolInput selectionSnapshot(const IDocument* document) {
+    EditToolInput input;
+    input.range = document->selectionRange();
+    input.selection = true;
+    input.text = textOf(document, input.range);
+    return input;
+}
+
+// Polls for cancellation and reports progress every kProgressStride units.
+class ProgressTicker {
+public:
+    ProgressTicker(EditToolControl& control, qsizetype total) : control_(control), total_(qMax<qsizetype>(1, total)) {}
+
+    bool canceled(qsizetype done) {
+        if (done < nextCheck_) {
+            return false;
+        }
+        nextCheck_ = done + kProgressStride;
+        if (control_.isCanceled()) {
+            return true;
+        }
+        control_.setProgress(static_cast<int>(done * 100 / total_));
+        return false;
+    }
+
+private:
+    EditToolControl& control_;
+    qsizetype total_;
+    qsizetype nextCheck_ = 0;
+};
+
+// Emits one edit per run of changed characters, merging runs separated by
+// short unchanged gaps, so formatting outside the changed runs is untouched.
+// converted has the length of original; offset is where original starts in
+// the input text.
+bool appendCaseRuns(EditToolResult& result, QStringView original, QStringView converted, int position,
+                    qsizetype offset, ProgressTicker& ticker) {
+    const qsizetype size = converted.size();
+    qsizetype i = 0;
+    while (i < size) {
+        if (ticker.canceled(offset + i)) {
+            return false;
+        }
+        if (original.at(i) == converted.at(i)) {
+            ++i;
+            continue;
+        }
+        qsizetype runEnd = i + 1;
+        qsizetype scan = runEnd;
+        while (scan < size && scan - runEnd < kMergeGap) {
+            if (original.at(scan) != converted.at(scan)) {
+                runEnd = scan + 1;
+            }
+            ++scan;
+        }
+        result.edits.append({position + static_cast<int>(i), static_cast<int>(runEnd - i),
+                             converted.sliced(i, runEnd - i).toString(), true});
+        i = runEnd;
     }
-    const QString selectedText = document->getSelectedText();
-    if (!selectedText.isEmpty()) {
-        document->insertTextAtCursor(selectedText.toUpper());
+    return true;
+}
+
+// Conversions that change the length (ß → SS, ﬁ → FI) get one edit per such
+// code point, so each lies inside a single fragment and keeps its format.
+// The text between them is converted in bulk and split into runs as usual.
+EditToolResult lengthChangingCaseResult(const EditToolInput& input, CaseConversion::Mode mode,
+                                        EditToolControl& control) {
+    EditToolResult result;
+    const QString& text = input.text;
+    const int start = input.range.start;
+    ProgressTicker ticker(control, text.size());
+    int delta = 0;
+
+    for (qsizetype i = 0; i < text.size();) {
+        const qsizetype split = CaseConversion::findFullMapping(text, i, mode);
+        QString segment = text.mid(i, split - i);
+        CaseConversion::convert(segment, mode);
+        if (!appendCaseRuns(result, QStringView(text).sliced(i, split - i), segment, start + static_cast<int>(i), i,
+                            ticker)) {
+            return {};
+        }
+        if (split == text.size()) {
+            break;
+        }
+
+        const qsizetype width =
+            text.at(split).isHighSurrogate() && split + 1 < text.size() && text.at(split + 1).isLowSurrogate() ? 2 : 1;
+        QString unit = text.mid(split, width);
+        CaseConversion::convert(unit, mode);
+        if (unit != QStringView(text).sliced(split, width)) {
+            delta += static_cast<int>(unit.size() - width);
+            result.edits.append({start + static_cast<int>(split), static_cast<int>(width), unit, true});
+        }
+        i = split + width;
     }
+    if (!result.edits.isEmpty()) {
+        result.selection = TextRange{start, start + static_cast<int>(text.size()) + delta};
+    }
+    return result;
+}
+
+EditToolResult caseResult(const EditToolInput& input, CaseConversion::Mode mode, EditToolControl& control) {
+    EditToolResult result;
+    QString converted = input.text;
+    if (!CaseConversion::convert(converted, mode) || control.isCanceled()) {
+        return result;
+    }
+    if (converted.size() != input.text.size()) {
+        return lengthChangingCaseResult(input, mode, control);
+    }
+
+    const int start = input.range.start;
+    result.selection = TextRange{start, start + static_cast<int>(converted.size())};
+    ProgressTicker ticker(control, converted.size());
+    if (!appendCaseRuns(result, input.text, converted, start, 0, ticker)) {
+        return {};
+    }
+    return result;
+}
+
+}
+
+EditToolInput IEditTool::snapshotSource(const ITextSource& source, TextRange selection) const {
+    EditToolInput input;
+    input.selection = !selection.isEmpty();
+    input.range = input.selection ? selection : TextRange{0, source.length()};
+    input.text = source.text(input.range);
+    return input;
 }
 
 bool UpperCaseTool::canExecute(IDocument* document, QTextEdit* textEdit) const {
     (void)textEdit;
-    return document && !document->getSelectedText().isEmpty();
+    return document && document->hasSelection();
 }
 
-void LowerCaseTool::execute(IDocument* document, QTextEdit* textEdit) {
-    (void)textEdit;
-    if (!document) {
-        return;
-    }
-    const QString selectedText = document->getSelectedText();
-    if (!selectedText.isEmpty()) {
-        document->insertTextAtCursor(selectedText.toLower());
+EditToolInput UpperCaseTool::snapshot(IDocument* document) const {
+    return selectionSnapshot(document);
+}
+
+EditToolInput UpperCaseTool::snapshotSource(const ITextSource& source, TextRange selection) const {
+    if (selection.isEmpty()) {
+        return {};
     }
+    return IEditTool::snapshotSource(source, selection);
+}
+
+EditToolResult UpperCaseTool::compute(const EditToolInput& input, EditToolControl& control) const {
+    return caseResult(input, CaseConversion::Mode::Upper, control);
 }
 
 bool LowerCaseTool::canExecute(IDocument* document, QTextEdit* textEdit) const {
     (void)textEdit;
-    return document && !document->getSelectedText().isEmpty();
+    return document && document->hasSelection();
 }
 
-void WordCountTool::execute(IDocument* document, QTextEdit* textEdit) {
-    (void)textEdit;
-    if (!document) {
-        return;
+EditToolInput LowerCaseTool::snapshot(IDocument* document) const {
+    return selectionSnapshot(document);
+}
+
+EditToolInput LowerCaseTool::snapshotSource(const ITextSource& source, TextRange selection) const {
+    if (selection.isEmpty()) {
+        return {};
     }
-    const QString text = document->getPlainText();
+    return IEditTool::snapshotSource(source, selection);
+}
+
+EditToolResult LowerCaseTool::compute(const EditToolInput& input, EditToolControl& control) const {
+    return caseResult(input, CaseConversion::Mode::Lower, control);
+}
+
+EditToolInput WordCountTool::snapshot(IDocument* document) const {
+    EditToolInput input;
+    input.selection = document->hasSelection();
+    input.range = input.selection ? document->selectionRange() : TextRange{0, qMax(0, document->characterCount() - 1)};
+    input.text = textOf(document, input.range);
+    return input;
+}
+
+EditToolResult WordCountTool::compute(const EditToolInput& input, EditToolControl& control) const {
+    EditToolResult result;
+    const QStringView text = input.text;
     qsizetype wordCount = 0;
-    qsizetype charCount = text.length();
-    qsizetype lineCount = text.count('\n') + 1;
+    qsizetype lineCount = 1;
+    bool inWord = false;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        if (i % kProgressStride == 0) {
+            if (control.isCanceled()) {
+                return result;
+            }
+            control.setProgress(static_cast<int>(i * 100 / text.size()));
+        }
+        const QChar ch = text.at(i);
+        if (ch == u'\n') {
+            ++lineCount;
+        }
+        const bool space = ch.isSpace();
+        if (!space && !inWord) {
+            ++wordCount;
+        }
+        inWord = !space;
+    }
 
-    QStringList words = text.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-    wordCount = words.size();
+    result.message = QString("%1Слов: %2 | Символов: %3 | Строк: %4")
+                         .arg(input.selection ? QString("Выделение — ") : QString())
+                         .arg(wordCount)
+                         .arg(text.size())
+                         .arg(lineCount);
+    return result;
+}
 
-    QMessageBox::information(nullptr, "Word Count",
-                             QString("Words: %1\nCharacters: %2\nLines: %3")
-                                 .arg(wordCount)
-                                 .arg(charCount)
-                                 .arg(lineCount));
+EditToolInput DuplicateLineTool::snapshot(IDocument* document) const {
+    EditToolInput input;
+    const int position = document->selectionRange().end;
+    for (const TextChunk& chunk : document->blocks(TextRange{position, position})) {
+        input.text = chunk.blockText.toString();
+        input.range = TextRange{chunk.blockPosition, chunk.blockPosition + static_cast<int>(chunk.blockText.size())};
+        break;
+    }
+    return input;
 }
 
-void DuplicateLineTool::execute(IDocument* document, QTextEdit* textEdit) {
-    (void)document;
-    QTextCursor cursor = textEdit->textCursor();
-    cursor.select(QTextCursor::LineUnderCursor);
-    QString lineText = cursor.selectedText();
+EditToolInput DuplicateLineTool::snapshotSource(const ITextSource& source, TextRange selection) const {
+    EditToolInput input;
+    input.range = source.lineRange(selection.end);
+    input.text = source.text(input.range);
+    return input;
+}
 
-    cursor.movePosition(QTextCursor::EndOfLine);
-    cursor.insertText("\n" + lineText);
+EditToolResult DuplicateLineTool::compute(const EditToolInput& input, EditToolControl& control) const {
+    (void)control;
+    EditToolResult result;
+    result.edits.append({input.range.end, 0, QChar('\n') + input.text});
+    return result;
 }
 
 EditToolManager::EditToolManager() {
@@ -70,6 +261,17 @@ EditToolManager::EditToolManager() {
     registerTool(std::make_unique<LowerCaseTool>());
     registerTool(std::make_unique<WordCountTool>());
     registerTool(std::make_unique<DuplicateLineTool>());
+
+    using LineTransform::Operation;
+    registerTool(std::make_unique<LineTransformTool>("Sort Lines", Operation::SortLexical));
+    registerTool(std::make_unique<LineTransformTool>("Sort Lines (Numeric)", Operation::SortNumeric));
+    registerTool(std::make_unique<LineTransformTool>("Sort Lines (Natural)", Operation::SortNatural));
+    registerTool(std::make_unique<LineTransformTool>("Sort Lines (Locale)", Operation::SortLocale));
+    registerTool(std::make_unique<LineTransformTool>("Unique Lines", Operation::Unique));
+    registerTool(std::make_unique<LineTransformTool>("Reverse Lines", Operation::Reverse));
+    registerTool(std::make_unique<LineTransformTool>("Shuffle Lines", Operation::Shuffle));
+    registerTool(std::make_unique<LineTransformTool>("Trim Trailing Whitespace", Operation::TrimTrailing));
+    registerTool(std::make_unique<LineTransformTool>("Remove Blank Lines", Operation::RemoveBlank));
 }
 
 void EditToolManager::registerTool(std::unique_ptr<IEditTool> tool) {
@@ -84,11 +286,11 @@ std::vector<IEditTool*> EditToolManager::getAvailableTools() const {
     return availableTools;
 }
 
-void EditToolManager::executeTool(const QString& name, IDocument* document, QTextEdit* textEdit) const {
+IEditTool* EditToolManager::findTool(const QString& name, IDocument* document, QTextEdit* textEdit) const {
     for (const auto& tool : tools_) {
         if (tool->getName() == name && tool->canExecute(document, textEdit)) {
-            tool->execute(document, textEdit);
-            return;
+            return tool.get();
         }
     }
+    return nullptr;
 }
@@ -0,0 +1,219 @@
+#include "../headers/externalfilter.h"
+
+#include <QTextEdit>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QTextBlock>
+
+namespace {
+
+constexpr qsizetype kChunkChars = 16 * 1024;
+constexpr qint64 kHighWaterBytes = 256 * 1024;
+constexpr qsizetype kMaxErrorBytes = 4096;
+
+}
+
+ExternalFilterRunner::ExternalFilterRunner(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ExternalFilterRunner::~ExternalFilterRunner()
+{
+    if (process_) {
+        process_->disconnect(this);
+        process_->kill();
+        process_->waitForFinished();
+    }
+}
+
+bool ExternalFilterRunner::start(const QString &command, IDocument *document, QTextEdit *textEdit)
+{
+    if (isRunning() || command.trimmed().isEmpty() || !document || !textEdit) {
+        return false;
+    }
+
+    document_ = document;
+    textEdit_ = textEdit;
+    command_ = command;
+    range_ = document->hasSelection() ? document->selectionRange()
+                                      : TextRange{0, qMax(0, document->characterCount() - 1)};
+    fed_ = range_.start;
+    inputClosed_ = false;
+    output_.clear();
+    errors_.clear();
+    decoder_ = QStringDecoder(QStringDecoder::Utf8);
+
+    changeConnection_ = connect(textEdit->document(), &QTextDocument::contentsChange,
+                                this, &ExternalFilterRunner::onContentsChange);
+
+    process_ = new QProcess(this);
+    connect(process_, &QProcess::started, this, &ExternalFilterRunner::feed);
+    connect(process_, &QProcess::bytesWritten, this, &ExternalFilterRunner::feed);
+    connect(process_, &QProcess::readyReadStandardOutput, this, &ExternalFilterRunner::readOutput);
+    connect(process_, &QProcess::readyReadStandardError, this, &ExternalFilterRunner::readErrors);
+    connect(process_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &ExternalFilterRunner::onProcessFinished);
+    connect(process_, &QProcess::errorOccurred, this, &ExternalFilterRunner::onProcessError);
+
+    emit started(command_);
+    process_->start("/bin/sh", QStringList() << "-c" << command_);
+    return true;
+}
+
+bool ExternalFilterRunner::isRunning() const
+{
+    return process_ != nullptr;
+}
+
+void ExternalFilterRunner::cancel()
+{
+    if (process_) {
+        finish(QString("Фильтр «%1»: отменено").arg(command_));
+    }
+}
+
+// Writes the next slices of the range while the pipe is below the high-water
+// mark; bytesWritten() calls back in as the command drains its stdin.
+void ExternalFilterRunner::feed()
+{
+    if (!process_ || inputClosed_) {
+        return;
+    }
+
+    while (fed_ < range_.end && process_->bytesToWrite() < kHighWaterBytes) {
+        QByteArray bytes;
+        qsizetype budget = kChunkChars;
+        for (const TextChunk &chunk : document_->blocks(TextRange{fed_, range_.end})) {
+            if (chunk.position > fed_) {
+                bytes += '\n';
+                fed_ = chunk.position;
+            }
+            QStringView text = chunk.text;
+            const bool partial = text.size() > budget;
+            if (partial) {
+                text = text.first(budget);
+                if (!text.isEmpty() && text.back().isHighSurrogate()) {
+                    text.chop(1);
+                }
+            }
+            bytes += text.toUtf8();
+            fed_ = chunk.position + static_cast<int>(text.size());
+            budget -= text.size();
+            if (partial || budget <= 0) {
+                break;
+            }
+        }
+        if (bytes.isEmpty()) {
+            break;
+        }
+        process_->write(bytes);
+    }
+
+    if (fed_ >= range_.end) {
+        inputClosed_ = true;
+        process_->closeWriteChannel();
+    }
+    const int total = qMax(1, range_.length());
+    emit progress(static_cast<int>(qint64(fed_ - range_.start) * 100 / total));
+}
+
+void ExternalFilterRunner::readOutput()
+{
+    if (process_) {
+        output_ += decoder_(process_->readAllStandardOutput());
+    }
+}
+
+void ExternalFilterRunner::readErrors()
+{
+    if (!process_) {
+        return;
+    }
+    const QByteArray chunk = process_->readAllStandardError();
+    if (errors_.size() < kMaxErrorBytes) {
+        errors_ += chunk.left(kMaxErrorBytes - errors_.size());
+    }
+}
+
+void ExternalFilterRunner::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    readOutput();
+    readErrors();
+    if (exitStatus != QProcess::NormalExit || exitCode != 0) {
+        const QString details = QString::fromUtf8(errors_).trimmed();
+        finish(QString("Фильтр «%1»: код завершения %2%3")
+                   .arg(command_)
+                   .arg(exitCode)
+                   .arg(details.isEmpty() ? QString() : ": " + details.section('\n', 0, 0)));
+        return;
+    }
+    if (!textEdit_) {
+        finish(QString("Фильтр «%1»: редактор закрыт, результат отброшен").arg(command_));
+        return;
+    }
+    const qsizetype produced = output_.size();
+    apply();
+    finish(QString("Фильтр «%1»: готово, %2 → %3 символов").arg(command_).arg(range_.length()).arg(produced));
+}
+
+void ExternalFilterRunner::onProcessError(QProcess::ProcessError error)
+{
+    if (error == QProcess::FailedToStart) {
+        finish(QString("Фильтр «%1»: не удалось запустить команду").arg(command_));
+    }
+}
+
+// Changes before the range shift it; a change inside the range makes the
+// command's output meaningless, so the run is abandoned.
+void ExternalFilterRunner::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (applying_ || !process_) {
+        return;
+    }
+    if (position + charsRemoved <= range_.start) {
+        const int delta = charsAdded - charsRemoved;
+        range_.start += delta;
+        range_.end += delta;
+        fed_ += delta;
+        return;
+    }
+    if (position <= range_.end) {
+        finish(QString("Фильтр «%1»: документ изменился, выполнение прервано").arg(command_));
+    }
+}
+
+void ExternalFilterRunner::apply()
+{
+    QTextDocument *document = textEdit_->document();
+    const bool inputEndsWithNewline = range_.end > range_.start && document->findBlock(range_.end).position() == range_.end;
+    if (!inputEndsWithNewline && output_.endsWith(QLatin1Char('\n'))) {
+        output_.chop(1);
+    }
+
+    applying_ = true;
+    QTextCursor cursor(document);
+    cursor.beginEditBlock();
+    cursor.setPosition(range_.start);
+    cursor.setPosition(range_.end, QTextCursor::KeepAnchor);
+    cursor.insertText(output_);
+    cursor.endEditBlock();
+    applying_ = false;
+
+    cursor.setPosition(range_.start, QTextCursor::KeepAnchor);
+    textEdit_->setTextCursor(cursor);
+}
+
+void ExternalFilterRunner::finish(const QString &message)
+{
+    disconnect(changeConnection_);
+    if (process_) {
+        process_->disconnect(this);
+        process_->kill();
+        process_->deleteLater();
+        process_ = nullptr;
+    }
+    output_ = QString();
+    errors_.clear();
+    emit finished(message);
+}
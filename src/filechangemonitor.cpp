@@ -0,0 +1,267 @@
+#include "../headers/filechangemonitor.h"
+#include "../headers/linediff.h"
+#include "../headers/plaintexthandler.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QPromise>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QTextEdit>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QAbstractTextDocumentLayout>
+#include <QScrollBar>
+
+namespace {
+
+// Editors and tools often write a file in several steps.
+constexpr int kSettleDelayMs = 200;
+
+int lineOffset(const QString &text, const QList<QStringView> &lines, int line)
+{
+    return line < lines.size() ? static_cast<int>(lines.at(line).data() - text.constData())
+                               : static_cast<int>(text.size()) + 1;
+}
+
+// Line hashes can collide, so the edits are replayed once and checked
+// against the disk text; on a mismatch the whole buffer is replaced.
+bool replaysTo(const QString &bufferWithBreak, const QVector<ReloadEdit> &edits, const QString &expected)
+{
+    QString result;
+    result.reserve(expected.size());
+    int position = 0;
+    for (const ReloadEdit &edit : edits) {
+        result += QStringView(bufferWithBreak).sliced(position, edit.start - position);
+        result += edit.text;
+        position = edit.end;
+    }
+    result += QStringView(bufferWithBreak).sliced(position);
+    return result == expected;
+}
+
+void planReload(QPromise<ReloadPlan> &promise, quint64 generation, int revision, const QString &filePath,
+                const QString &bufferText)
+{
+    QElapsedTimer timer;
+    timer.start();
+    ReloadPlan plan;
+    plan.generation = generation;
+    plan.revision = revision;
+    QString diskText;
+    if (!PlainTextHandler::readText(filePath, diskText, plan.bytes, plan.error)) {
+        promise.addResult(std::move(plan));
+        return;
+    }
+
+    const QList<QStringView> oldLines = LineDiff::splitLines(bufferText);
+    const QList<QStringView> newLines = LineDiff::splitLines(diskText);
+    const QVector<DiffHunk> hunks = LineDiff::diff(LineDiff::hashLines(oldLines), LineDiff::hashLines(newLines));
+    if (promise.isCanceled()) {
+        return;
+    }
+
+    const QString diskWithBreak = diskText + u'\n';
+    for (const DiffHunk &hunk : hunks) {
+        ReloadEdit edit;
+        edit.start = lineOffset(bufferText, oldLines, hunk.oldStart);
+        edit.end = lineOffset(bufferText, oldLines, hunk.oldStart + hunk.oldCount);
+        const int from = lineOffset(diskText, newLines, hunk.newStart);
+        edit.text = diskWithBreak.mid(from, lineOffset(diskText, newLines, hunk.newStart + hunk.newCount) - from);
+        plan.edits.append(edit);
+    }
+    if (!plan.edits.isEmpty() && !replaysTo(bufferText + u'\n', plan.edits, diskWithBreak)) {
+        plan.edits = {ReloadEdit{0, static_cast<int>(bufferText.size()) + 1, diskWithBreak}};
+    }
+    plan.milliseconds = timer.elapsed();
+    promise.addResult(std::move(plan));
+}
+
+}
+
+FileChangeMonitor::FileChangeMonitor(QTextEdit *textEdit, QObject *parent)
+    : QObject(parent)
+    , textEdit_(textEdit)
+{
+    checkTimer_.setSingleShot(true);
+    checkTimer_.setInterval(kSettleDelayMs);
+    connect(&checkTimer_, &QTimer::timeout, this, &FileChangeMonitor::check);
+    connect(&watcher_, &QFileSystemWatcher::fileChanged, this, &FileChangeMonitor::scheduleCheck);
+    connect(&watcher_, &QFileSystemWatcher::directoryChanged, this, &FileChangeMonitor::scheduleCheck);
+    connect(&planWatcher_, &QFutureWatcher<ReloadPlan>::finished, this, &FileChangeMonitor::onPlanned);
+}
+
+FileChangeMonitor::~FileChangeMonitor()
+{
+    planWatcher_.cancel();
+    planWatcher_.waitForFinished();
+}
+
+// The directory is watched too: a save by rename drops the file from the
+// watcher, and a deleted file may come back.
+void FileChangeMonitor::watch(const QString &filePath, qint64 syncedBytes)
+{
+    if (!watcher_.files().isEmpty()) {
+        watcher_.removePaths(watcher_.files());
+    }
+    if (!watcher_.directories().isEmpty()) {
+        watcher_.removePaths(watcher_.directories());
+    }
+    ++generation_;
+    planWatcher_.cancel();
+    checkTimer_.stop();
+    missing_ = false;
+    filePath_.clear();
+    syncedBytes_ = -1;
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    const QFileInfo info(filePath);
+    filePath_ = info.absoluteFilePath();
+    watcher_.addPath(filePath_);
+    watcher_.addPath(info.absolutePath());
+    rememberState();
+    syncedBytes_ = syncedBytes >= 0 ? syncedBytes : knownSize_;
+}
+
+void FileChangeMonitor::noteSaved()
+{
+    rememberState();
+    syncedBytes_ = knownSize_;
+}
+
+// The finished signal of a plan handled here is still queued; replacing
+// the future drops it, so the plan is not applied twice.
+void FileChangeMonitor::finishReload()
+{
+    while (planWatcher_.isRunning()) {
+        planWatcher_.waitForFinished();
+        const QFuture<ReloadPlan> future = planWatcher_.future();
+        planWatcher_.setFuture(QFuture<ReloadPlan>());
+        handlePlan(future);
+    }
+}
+
+bool FileChangeMonitor::isChangedOnDisk() const
+{
+    if (filePath_.isEmpty()) {
+        return false;
+    }
+    const QFileInfo info(filePath_);
+    return info.exists() && (info.size() != knownSize_ || info.lastModified() != knownModified_);
+}
+
+void FileChangeMonitor::rememberState()
+{
+    const QFileInfo info(filePath_);
+    knownSize_ = info.exists() ? info.size() : -1;
+    knownModified_ = info.exists() ? info.lastModified() : QDateTime();
+}
+
+void FileChangeMonitor::scheduleCheck()
+{
+    if (!filePath_.isEmpty()) {
+        checkTimer_.start();
+    }
+}
+
+void FileChangeMonitor::checkNow()
+{
+    if (!filePath_.isEmpty()) {
+        checkTimer_.stop();
+        check();
+    }
+}
+
+void FileChangeMonitor::check()
+{
+    const QFileInfo info(filePath_);
+    if (!info.exists()) {
+        if (!missing_) {
+            missing_ = true;
+            emit removedOnDisk(filePath_);
+        }
+        return;
+    }
+    missing_ = false;
+    if (!watcher_.files().contains(filePath_)) {
+        watcher_.addPath(filePath_);
+    }
+    if (info.size() == knownSize_ && info.lastModified() == knownModified_) {
+        return;
+    }
+    rememberState();
+    emit changedOnDisk(filePath_);
+}
+
+void FileChangeMonitor::reload()
+{
+    if (filePath_.isEmpty()) {
+        return;
+    }
+    if (planWatcher_.isRunning()) {
+        planWatcher_.cancel();
+        planWatcher_.waitForFinished();
+    }
+    const QTextDocument *document = textEdit_->document();
+    planWatcher_.setFuture(QtConcurrent::run(planReload, generation_, document->revision(), filePath_,
+                                             document->toPlainText()));
+}
+
+void FileChangeMonitor::onPlanned()
+{
+    handlePlan(planWatcher_.future());
+}
+
+// A buffer edited while the plan was made gets a fresh plan.
+void FileChangeMonitor::handlePlan(const QFuture<ReloadPlan> &future)
+{
+    if (future.isCanceled() || future.resultCount() == 0) {
+        return;
+    }
+    const ReloadPlan plan = future.result();
+    if (plan.generation != generation_) {
+        return;
+    }
+    if (!plan.error.isEmpty()) {
+        emit failed(plan.error);
+        return;
+    }
+    if (plan.revision != textEdit_->document()->revision()) {
+        reload();
+        return;
+    }
+    apply(plan);
+}
+
+// The edits assume a line break after the last line; it is added and
+// removed again inside the same edit block. The first visible block keeps
+// its place on screen.
+void FileChangeMonitor::apply(const ReloadPlan &plan)
+{
+    QTextDocument *document = textEdit_->document();
+    if (!plan.edits.isEmpty()) {
+        QScrollBar *scrollBar = textEdit_->verticalScrollBar();
+        const QTextCursor anchor = textEdit_->cursorForPosition(QPoint(0, 0));
+        const qreal offset = scrollBar->value() - document->documentLayout()->blockBoundingRect(anchor.block()).top();
+
+        QTextCursor cursor(document);
+        cursor.beginEditBlock();
+        cursor.movePosition(QTextCursor::End);
+        cursor.insertText(QString(u'\n'));
+        for (auto it = plan.edits.crbegin(); it != plan.edits.crend(); ++it) {
+            cursor.setPosition(it->start);
+            cursor.setPosition(it->end, QTextCursor::KeepAnchor);
+            cursor.insertText(it->text);
+        }
+        cursor.movePosition(QTextCursor::End);
+        cursor.deletePreviousChar();
+        cursor.endEditBlock();
+
+        scrollBar->setValue(qRound(document->documentLayout()->blockBoundingRect(anchor.block()).top() + offset));
+    }
+    document->setModified(false);
+    syncedBytes_ = plan.bytes;
+    emit reloaded(static_cast<int>(plan.edits.size()), plan.milliseconds);
+}
@@ -0,0 +1,569 @@
+#include "../headers/filesearcher.h"
+
+#include <QFile>
+#include <QDir>
+#include <QDirIterator>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QThread>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+namespace {
+
+constexpr qint64 kSniffBytes = 8000;
+constexpr int kPreviewBytes = 240;
+constexpr int kProgressEvery = 256;
+
+// Malformed sequences decode to U+FFFD, which is not a word character.
+char32_t decodeUtf8(const char *p, const char *end)
+{
+    const auto lead = static_cast<unsigned char>(*p);
+    const int length = lead < 0x80 ? 1 : (lead >= 0xF0 ? 4 : (lead >= 0xE0 ? 3 : (lead >= 0xC0 ? 2 : 0)));
+    if (length == 0 || end - p < length) {
+        return QChar::ReplacementCharacter;
+    }
+    char32_t code = length == 1 ? lead : (lead & (0x7F >> length));
+    for (int i = 1; i < length; ++i) {
+        code = (code << 6) | (static_cast<unsigned char>(p[i]) & 0x3F);
+    }
+    return code;
+}
+
+bool isContinuationByte(char c)
+{
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+// UTF-16 units the UTF-8 bytes decode to: one per lead byte, two for the
+// four-byte sequences outside the BMP.
+qsizetype utf16Length(const char *from, const char *to)
+{
+    qsizetype units = 0;
+    for (const char *p = from; p < to; ++p) {
+        const auto c = static_cast<unsigned char>(*p);
+        units += isContinuationByte(*p) ? 0 : (c >= 0xF0 ? 2 : 1);
+    }
+    return units;
+}
+
+char asciiLower(char c)
+{
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : c;
+}
+
+char asciiUpper(char c)
+{
+    return (c >= 'a' && c <= 'z') ? static_cast<char>(c - ('a' - 'A')) : c;
+}
+
+bool isAscii(const QString &text)
+{
+    return std::all_of(text.cbegin(), text.cend(), [](QChar ch) { return ch.unicode() < 0x80; });
+}
+
+QString makePreview(const char *lineStart, const char *end)
+{
+    const qint64 available = end - lineStart;
+    const qint64 limit = qMin<qint64>(available, kPreviewBytes);
+    const void *newline = std::memchr(lineStart, '\n', static_cast<size_t>(limit));
+    const qint64 length = newline ? static_cast<const char *>(newline) - lineStart : limit;
+    return QString::fromUtf8(lineStart, length).trimmed();
+}
+
+class WorkQueue
+{
+public:
+    void push(QString item)
+    {
+        QMutexLocker locker(&mutex_);
+        items_.push_back(std::move(item));
+    }
+
+    bool popFront(QString &item)
+    {
+        QMutexLocker locker(&mutex_);
+        if (items_.empty()) {
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        return true;
+    }
+
+    bool stealBack(QString &item)
+    {
+        QMutexLocker locker(&mutex_);
+        if (items_.empty()) {
+            return false;
+        }
+        item = std::move(items_.back());
+        items_.pop_back();
+        return true;
+    }
+
+private:
+    QMutex mutex_;
+    std::deque<QString> items_;
+};
+
+}
+
+FileScanner::FileScanner(const SearchQuery &query)
+    : searcher_(query)
+{
+    const bool asciiPattern = isAscii(query.pattern);
+    byteSearch_ = searcher_.isValid() && !query.options.regex
+                  && (query.options.caseSensitive || asciiPattern);
+    if (byteSearch_) {
+        needle_ = query.pattern.toUtf8();
+        asciiFold_ = !query.options.caseSensitive;
+        if (asciiFold_) {
+            foldedNeedle_ = needle_.toLower();
+        }
+    }
+}
+
+bool FileScanner::isBinaryContent(const char *data, qint64 size)
+{
+    const qint64 sniff = qMin(size, kSniffBytes);
+    return std::memchr(data, '\0', static_cast<size_t>(sniff)) != nullptr;
+}
+
+const char *FileScanner::findBytes(const char *from, const char *end) const
+{
+    const qsizetype m = needle_.size();
+    if (end - from < m) {
+        return nullptr;
+    }
+    const char *last = end - m + 1;
+
+    if (!asciiFold_) {
+        const char first = needle_.front();
+        while (from < last) {
+            const auto *p = static_cast<const char *>(std::memchr(from, first, static_cast<size_t>(last - from)));
+            if (!p) {
+                return nullptr;
+            }
+            if (std::memcmp(p + 1, needle_.constData() + 1, static_cast<size_t>(m - 1)) == 0) {
+                return p;
+            }
+            from = p + 1;
+        }
+        return nullptr;
+    }
+
+    const char lower = foldedNeedle_.front();
+    const char upper = asciiUpper(lower);
+    const char *nextLower = nullptr;
+    const char *nextUpper = lower == upper ? last : nullptr;
+    auto advance = [last](const char *&next, const char *start, char c) {
+        if (!next || (next < start && next != last)) {
+            const auto *p = static_cast<const char *>(std::memchr(start, c, static_cast<size_t>(last - start)));
+            next = p ? p : last;
+        }
+    };
+
+    while (from < last) {
+        advance(nextLower, from, lower);
+        if (lower != upper) {
+            advance(nextUpper, from, upper);
+        }
+        const char *p = qMin(nextLower, nextUpper);
+        if (p >= last) {
+            return nullptr;
+        }
+        bool equal = true;
+        for (qsizetype i = 1; i < m; ++i) {
+            if (asciiLower(p[i]) != foldedNeedle_.at(i)) {
+                equal = false;
+                break;
+            }
+        }
+        if (equal) {
+            return p;
+        }
+        from = p + 1;
+    }
+    return nullptr;
+}
+
+// Decodes the code points around the hit, so the workspace search agrees
+// with the find bar on non-ASCII words.
+bool FileScanner::isWordBoundary(const char *begin, const char *end, const char *hit) const
+{
+    if (hit > begin) {
+        const char *before = hit - 1;
+        while (before > begin && hit - before < 4 && isContinuationByte(*before)) {
+            --before;
+        }
+        if (SearchEngine::isWordChar(decodeUtf8(before, hit))) {
+            return false;
+        }
+    }
+    const char *after = hit + needle_.size();
+    return after >= end || !SearchEngine::isWordChar(decodeUtf8(after, end));
+}
+
+QVector<FileSearchHit> FileScanner::scanBytes(const QString &filePath, const char *data, qint64 size, int maxHits) const
+{
+    QVector<FileSearchHit> hits;
+    const char *end = data + size;
+    const char *lineStart = data;
+    const char *counted = data;
+    const char *columnAt = data;
+    qsizetype column = 0;
+    int line = 1;
+    const auto patternLength = static_cast<int>(searcher_.query().pattern.size());
+    const bool wholeWords = searcher_.query().options.wholeWords;
+
+    const char *from = data;
+    while (hits.size() < maxHits) {
+        const char *hit = findBytes(from, end);
+        if (!hit) {
+            break;
+        }
+        from = hit + 1;
+        if (wholeWords && !isWordBoundary(data, end, hit)) {
+            continue;
+        }
+
+        while (counted < hit) {
+            const auto *newline = static_cast<const char *>(std::memchr(counted, '\n', static_cast<size_t>(hit - counted)));
+            if (!newline) {
+                break;
+            }
+            ++line;
+            lineStart = newline + 1;
+            counted = newline + 1;
+        }
+        counted = hit;
+        if (columnAt < lineStart) {
+            columnAt = lineStart;
+            column = 0;
+        }
+        column += utf16Length(columnAt, hit);
+        columnAt = hit;
+
+        FileSearchHit result;
+        result.filePath = filePath;
+        result.line = line;
+        result.column = static_cast<int>(column);
+        result.length = patternLength;
+        result.preview = makePreview(lineStart, end);
+        hits.push_back(std::move(result));
+        from = hit + needle_.size();
+    }
+    return hits;
+}
+
+QVector<FileSearchHit> FileScanner::scanText(const QString &filePath, QStringView text, int maxHits) const
+{
+    QVector<FileSearchHit> hits;
+    QVector<SearchMatch> matches;
+    searcher_.findAll(text, 0, text.size(), matches, maxHits);
+
+    int line = 1;
+    qsizetype lineStart = 0;
+    qsizetype counted = 0;
+    for (const SearchMatch &match : matches) {
+        while (counted < match.start) {
+            const qsizetype newline = SearchEngine::findChar(text, u'\n', counted, match.start);
+            if (newline < 0) {
+                break;
+            }
+            ++line;
+            lineStart = newline + 1;
+            counted = newline + 1;
+        }
+        counted = match.start;
+
+        qsizetype lineEnd = SearchEngine::findChar(text, u'\n', lineStart, lineStart + kPreviewBytes);
+        if (lineEnd < 0) {
+            lineEnd = qMin(text.size(), lineStart + kPreviewBytes);
+        }
+
+        FileSearchHit result;
+        result.filePath = filePath;
+        result.line = line;
+        result.column = static_cast<int>(match.start - lineStart);
+        result.length = static_cast<int>(match.length);
+        result.preview = text.sliced(lineStart, lineEnd - lineStart).trimmed().toString();
+        hits.push_back(std::move(result));
+    }
+    return hits;
+}
+
+QVector<FileSearchHit> FileScanner::scanFile(const QString &filePath, int maxHits,
+                                             qint64 *bytesScanned, bool *skipped) const
+{
+    if (skipped) {
+        *skipped = true;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    const qint64 size = file.size();
+    if (size == 0) {
+        if (skipped) {
+            *skipped = false;
+        }
+        return {};
+    }
+
+    const uchar *mapped = file.map(0, size);
+    QByteArray fallback;
+    const char *data = reinterpret_cast<const char *>(mapped);
+    if (!data) {
+        fallback = file.readAll();
+        data = fallback.constData();
+    }
+
+    if (isBinaryContent(data, size)) {
+        return {};
+    }
+    if (skipped) {
+        *skipped = false;
+    }
+    if (bytesScanned) {
+        *bytesScanned += size;
+    }
+
+    if (byteSearch_) {
+        return scanBytes(filePath, data, size, maxHits);
+    }
+    const QString text = QString::fromUtf8(data, size);
+    return scanText(filePath, text, maxHits);
+}
+
+struct ParallelFileSearcher::Run
+{
+    explicit Run(const FileSearchRequest &req)
+        : request(req)
+        , scanner(req.query)
+    {
+    }
+
+    FileSearchRequest request;
+    FileScanner scanner;
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    // The walker bumps pushed under wakeMutex, so a worker that saw no new
+    // pushes before its pass cannot miss the wake-up.
+    void notifyPushed()
+    {
+        {
+            QMutexLocker locker(&wakeMutex);
+            ++pushed;
+        }
+        workAvailable.wakeOne();
+    }
+
+    void wakeAll(bool finished)
+    {
+        QMutexLocker locker(&wakeMutex);
+        if (finished) {
+            walkDone = true;
+        }
+        workAvailable.wakeAll();
+    }
+
+    quint64 pushCount()
+    {
+        QMutexLocker locker(&wakeMutex);
+        return pushed;
+    }
+
+    void waitForWork(quint64 seen)
+    {
+        QMutexLocker locker(&wakeMutex);
+        while (pushed == seen && !walkDone && !canceled) {
+            workAvailable.wait(&wakeMutex);
+        }
+    }
+
+    std::atomic_bool walkDone{false};
+    std::atomic_bool canceled{false};
+    QMutex wakeMutex;
+    QWaitCondition workAvailable;
+    quint64 pushed = 0;
+    std::atomic<int> activeWorkers{0};
+    std::atomic<qint64> filesScanned{0};
+    std::atomic<qint64> filesSkipped{0};
+    std::atomic<qint64> bytesScanned{0};
+    std::atomic<qint64> hits{0};
+    QElapsedTimer timer;
+};
+
+ParallelFileSearcher::ParallelFileSearcher(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ParallelFileSearcher::~ParallelFileSearcher()
+{
+    cancel();
+    pool_.waitForDone();
+}
+
+bool ParallelFileSearcher::isRunning() const
+{
+    return current_ != nullptr;
+}
+
+void ParallelFileSearcher::cancel()
+{
+    if (current_) {
+        current_->canceled = true;
+        current_->wakeAll(false);
+        current_.reset();
+    }
+}
+
+void ParallelFileSearcher::start(const FileSearchRequest &request)
+{
+    cancel();
+
+    auto run = std::make_shared<Run>(request);
+    if (!run->scanner.isValid()) {
+        emit finished(FileSearchStats{});
+        return;
+    }
+    current_ = run;
+    run->timer.start();
+
+    const int workers = qMax(1, QThread::idealThreadCount());
+    pool_.setMaxThreadCount(workers + 1);
+    for (int i = 0; i < workers; ++i) {
+        run->queues.push_back(std::make_unique<WorkQueue>());
+    }
+    run->activeWorkers = workers;
+
+    if (!request.files.isEmpty()) {
+        for (qsizetype i = 0; i < request.files.size(); ++i) {
+            run->queues[static_cast<size_t>(i % workers)]->push(request.files.at(i));
+        }
+        run->walkDone = true;
+    } else {
+        pool_.start([this, run]() { walk(run); });
+    }
+
+    for (int i = 0; i < workers; ++i) {
+        pool_.start([this, run, i]() { work(run, i); });
+    }
+}
+
+void ParallelFileSearcher::walk(const std::shared_ptr<Run> &run)
+{
+    QDirIterator it(run->request.rootPath,
+                    run->request.nameFilters,
+                    QDir::Files | QDir::Readable | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories);
+    const size_t workers = run->queues.size();
+    size_t next = 0;
+    while (it.hasNext() && !run->canceled) {
+        run->queues[next]->push(it.next());
+        run->notifyPushed();
+        next = (next + 1) % workers;
+    }
+    run->wakeAll(true);
+}
+
+void ParallelFileSearcher::work(const std::shared_ptr<Run> &run, int workerIndex)
+{
+    const auto workers = static_cast<int>(run->queues.size());
+    WorkQueue &own = *run->queues[static_cast<size_t>(workerIndex)];
+    QVector<FileSearchHit> pending;
+
+    auto flush = [this, run, &pending]() {
+        if (pending.isEmpty()) {
+            return;
+        }
+        QMetaObject::invokeMethod(this, [this, run, hits = std::move(pending)]() {
+            if (run == current_) {
+                emit hitsFound(hits);
+            }
+        }, Qt::QueuedConnection);
+        pending = {};
+    };
+
+    QString filePath;
+    while (!run->canceled) {
+        // Both are read before the pass: once the walk was done, every file
+        // was already queued when the pass found nothing.
+        const quint64 seen = run->pushCount();
+        const bool walkDone = run->walkDone;
+        bool found = own.popFront(filePath);
+        for (int i = 1; !found && i < workers; ++i) {
+            found = run->queues[static_cast<size_t>((workerIndex + i) % workers)]->stealBack(filePath);
+        }
+        if (!found) {
+            if (walkDone) {
+                break;
+            }
+            run->waitForWork(seen);
+            continue;
+        }
+
+        if (run->hits >= run->request.maxTotalHits) {
+            break;
+        }
+
+        qint64 bytes = 0;
+        bool skipped = false;
+        const QString source = run->request.textSources.value(filePath, filePath);
+        QVector<FileSearchHit> hits = run->scanner.scanFile(source, run->request.maxHitsPerFile, &bytes, &skipped);
+        if (source != filePath) {
+            for (FileSearchHit &hit : hits) {
+                hit.filePath = filePath;
+            }
+        }
+        run->bytesScanned += bytes;
+        run->hits += hits.size();
+        skipped ? ++run->filesSkipped : ++run->filesScanned;
+
+        pending += hits;
+        if (pending.size() >= 256) {
+            flush();
+        }
+
+        if (const qint64 scanned = run->filesScanned + run->filesSkipped; scanned % kProgressEvery == 0) {
+            QMetaObject::invokeMethod(this, [this, run, scanned]() {
+                if (run == current_) {
+                    emit progress(scanned);
+                }
+            }, Qt::QueuedConnection);
+        }
+    }
+
+    flush();
+    finishWorker(run);
+}
+
+void ParallelFileSearcher::finishWorker(const std::shared_ptr<Run> &run)
+{
+    if (--run->activeWorkers != 0) {
+        return;
+    }
+
+    FileSearchStats stats;
+    stats.filesScanned = run->filesScanned;
+    stats.filesSkipped = run->filesSkipped;
+    stats.bytesScanned = run->bytesScanned;
+    stats.hits = run->hits;
+    stats.elapsedMs = run->timer.elapsed();
+    stats.canceled = run->canceled;
+
+    QMetaObject::invokeMethod(this, [this, run, stats]() {
+        if (run == current_) {
+            current_.reset();
+            emit finished(stats);
+        }
+    }, Qt::QueuedConnection);
+}
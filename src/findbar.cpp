@@ -0,0 +1,656 @@
+#include "../headers/findbar.h"
+#include "../headers/selectionlayers.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QPromise>
+#include <QTextEdit>
+#include <QTextCursor>
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QScrollBar>
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QLabel>
+#include <QTimer>
+#include <QToolButton>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QMessageBox>
+#include <QShortcut>
+#include <algorithm>
+
+namespace {
+
+constexpr qsizetype kSearchChunk = qsizetype(1) << 20;
+constexpr qsizetype kMaxMatches = 5'000'000;
+constexpr qsizetype kMaxHighlights = 2000;
+
+SearchQuery foldedQuery(const SearchQuery &query)
+{
+    SearchQuery folded = query;
+    folded.pattern = FoldedShadow::fold(query.pattern);
+    folded.options.caseSensitive = true;
+    return folded;
+}
+
+void mapToOriginal(QVector<SearchMatch> &matches, const FoldedSnapshot &shadow)
+{
+    for (SearchMatch &match : matches) {
+        const qsizetype start = shadow.toOriginal(match.start);
+        match.length = shadow.toOriginal(match.end()) - start;
+        match.start = start;
+    }
+}
+
+void searchRange(QPromise<SearchBatch> &promise, const TextSearcher &searcher, QStringView text,
+                 int region, qsizetype from, qsizetype to, qsizetype &total,
+                 const FoldedSnapshot *shadow = nullptr)
+{
+    qsizetype pos = from;
+    while (pos < to && total < kMaxMatches) {
+        if (promise.isCanceled()) {
+            return;
+        }
+        const qsizetype chunkEnd = qMin(to, pos + kSearchChunk);
+        SearchBatch batch{region, {}};
+        total += searcher.findAll(text, pos, chunkEnd, batch.matches, kMaxMatches - total);
+        pos = batch.matches.isEmpty() ? chunkEnd : qMax(chunkEnd, batch.matches.last().end());
+        if (!batch.matches.isEmpty()) {
+            if (shadow) {
+                mapToOriginal(batch.matches, *shadow);
+            }
+            promise.addResult(std::move(batch));
+        }
+    }
+}
+
+void refineCandidates(QPromise<SearchBatch> &promise, const TextSearcher &searcher, QStringView text,
+                      const QVector<SearchMatch> &candidates, qsizetype visibleFrom, qsizetype visibleTo)
+{
+    const qsizetype length = searcher.query().pattern.size();
+    std::array<SearchBatch, 3> batches{SearchBatch{0, {}}, SearchBatch{1, {}}, SearchBatch{2, {}}};
+    for (qsizetype i = 0; i < candidates.size(); ++i) {
+        if ((i & 0xFFF) == 0 && promise.isCanceled()) {
+            return;
+        }
+        const qsizetype start = candidates.at(i).start;
+        if (!searcher.matchesAt(text, start, length)) {
+            continue;
+        }
+        const int region = start < visibleFrom ? 1 : (start < visibleTo ? 0 : 2);
+        batches[region].matches.push_back(SearchMatch{start, length});
+    }
+    for (SearchBatch &batch : batches) {
+        if (!batch.matches.isEmpty()) {
+            promise.addResult(std::move(batch));
+        }
+    }
+}
+
+void runSearch(QPromise<SearchBatch> &promise, const QString &text, const SearchQuery &query,
+               qsizetype visibleFrom, qsizetype visibleTo, const QVector<SearchMatch> &candidates, bool refine)
+{
+    const TextSearcher searcher(query);
+    if (!searcher.isValid()) {
+        return;
+    }
+
+    if (refine) {
+        refineCandidates(promise, searcher, text, candidates, visibleFrom, visibleTo);
+        return;
+    }
+
+    qsizetype total = 0;
+    searchRange(promise, searcher, text, 0, visibleFrom, visibleTo, total);
+    searchRange(promise, searcher, text, 1, 0, visibleFrom, total);
+    searchRange(promise, searcher, text, 2, visibleTo, text.size(), total);
+}
+
+void runFoldedSearch(QPromise<SearchBatch> &promise, const std::shared_ptr<const FoldedSnapshot> &shadow,
+                     const SearchQuery &query, qsizetype visibleFrom, qsizetype visibleTo)
+{
+    const TextSearcher searcher(query);
+    if (!searcher.isValid()) {
+        return;
+    }
+
+    const QString &text = shadow->text;
+    qsizetype total = 0;
+    searchRange(promise, searcher, text, 0, visibleFrom, visibleTo, total, shadow.get());
+    searchRange(promise, searcher, text, 1, 0, visibleFrom, total, shadow.get());
+    searchRange(promise, searcher, text, 2, visibleTo, text.size(), total, shadow.get());
+}
+
+// Matches are mapped back through the shadow offsets, one edit each.
+bool buildFoldedReplacePlan(const FoldedSnapshot &shadow, const SearchQuery &query,
+                            const QString &replacement, ReplacePlan &plan, const std::function<bool()> &isCanceled)
+{
+    const TextSearcher searcher(query);
+    QVector<SearchMatch> matches;
+    for (qsizetype pos = 0; pos < shadow.text.size();) {
+        if (isCanceled()) {
+            return false;
+        }
+        const qsizetype chunkEnd = qMin(shadow.text.size(), pos + kSearchChunk);
+        const qsizetype before = matches.size();
+        searcher.findAll(shadow.text, pos, chunkEnd, matches);
+        pos = matches.size() == before ? chunkEnd : qMax(chunkEnd, matches.last().end());
+    }
+    mapToOriginal(matches, shadow);
+
+    plan.edits.clear();
+    plan.edits.reserve(matches.size());
+    for (const SearchMatch &match : matches) {
+        plan.edits.append(ReplaceEdit{match.start, match.length, replacement});
+    }
+    return true;
+}
+
+}
+
+FindBar::FindBar(QTextEdit *textEdit, QWidget *parent)
+    : QWidget(parent)
+    , textEdit_(textEdit)
+{
+    findEdit_ = new QLineEdit(this);
+    findEdit_->setPlaceholderText("Найти...");
+    findEdit_->setClearButtonEnabled(true);
+    findEdit_->setMinimumWidth(220);
+
+    prevButton_ = new QToolButton(this);
+    prevButton_->setText("▲");
+    prevButton_->setToolTip("Предыдущее совпадение (Shift+Enter)");
+
+    nextButton_ = new QToolButton(this);
+    nextButton_->setText("▼");
+    nextButton_->setToolTip("Следующее совпадение (Enter)");
+
+    caseCheck_ = new QCheckBox("Аа", this);
+    caseCheck_->setToolTip("Учитывать регистр");
+    wordCheck_ = new QCheckBox("Слово", this);
+    wordCheck_->setToolTip("Только слово целиком");
+    regexCheck_ = new QCheckBox(".*", this);
+    regexCheck_->setToolTip("Регулярное выражение");
+    foldCheck_ = new QCheckBox("ё=е", this);
+    foldCheck_->setToolTip("Без учета регистра и диакритики (ё = е, é = e)");
+
+    countLabel_ = new QLabel(this);
+
+    closeButton_ = new QToolButton(this);
+    closeButton_->setText("✕");
+    closeButton_->setAutoRaise(true);
+
+    replaceRow_ = new QWidget(this);
+    replaceEdit_ = new QLineEdit(replaceRow_);
+    replaceEdit_->setPlaceholderText("Заменить на... ($1, \\1 — группы)");
+    replaceEdit_->setMinimumWidth(220);
+    replaceButton_ = new QToolButton(replaceRow_);
+    replaceButton_->setText("Заменить");
+    replaceAllButton_ = new QToolButton(replaceRow_);
+    replaceAllButton_->setText("Заменить все");
+
+    auto *findRow = new QHBoxLayout();
+    findRow->addWidget(new QLabel("Найти:", this));
+    findRow->addWidget(findEdit_);
+    findRow->addWidget(prevButton_);
+    findRow->addWidget(nextButton_);
+    findRow->addWidget(caseCheck_);
+    findRow->addWidget(wordCheck_);
+    findRow->addWidget(regexCheck_);
+    findRow->addWidget(foldCheck_);
+    findRow->addWidget(countLabel_);
+    findRow->addStretch(1);
+    findRow->addWidget(closeButton_);
+
+    auto *replaceLayout = new QHBoxLayout(replaceRow_);
+    replaceLayout->setContentsMargins(0, 0, 0, 0);
+    replaceLayout->addWidget(new QLabel("Заменить:", replaceRow_));
+    replaceLayout->addWidget(replaceEdit_);
+    replaceLayout->addWidget(replaceButton_);
+    replaceLayout->addWidget(replaceAllButton_);
+    replaceLayout->addStretch(1);
+    replaceRow_->hide();
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 2, 4, 2);
+    layout->setSpacing(2);
+    layout->addLayout(findRow);
+    layout->addWidget(replaceRow_);
+
+    searchTimer_ = new QTimer(this);
+    searchTimer_->setSingleShot(true);
+    shadow_ = new FoldedShadow(textEdit_->document(), this);
+
+    connect(findEdit_, &QLineEdit::textChanged, this, &FindBar::scheduleSearch);
+    connect(findEdit_, &QLineEdit::returnPressed, this, &FindBar::findNext);
+    connect(caseCheck_, &QCheckBox::toggled, this, &FindBar::scheduleSearch);
+    connect(wordCheck_, &QCheckBox::toggled, this, &FindBar::scheduleSearch);
+    connect(regexCheck_, &QCheckBox::toggled, this, &FindBar::scheduleSearch);
+    connect(regexCheck_, &QCheckBox::toggled, foldCheck_, &QCheckBox::setDisabled);
+    connect(foldCheck_, &QCheckBox::toggled, caseCheck_, &QCheckBox::setDisabled);
+    connect(foldCheck_, &QCheckBox::toggled, this, &FindBar::scheduleSearch);
+    connect(prevButton_, &QToolButton::clicked, this, &FindBar::findPrevious);
+    connect(nextButton_, &QToolButton::clicked, this, &FindBar::findNext);
+    connect(closeButton_, &QToolButton::clicked, this, &FindBar::closeBar);
+    connect(replaceButton_, &QToolButton::clicked, this, &FindBar::replaceCurrent);
+    connect(replaceAllButton_, &QToolButton::clicked, this, &FindBar::replaceAll);
+    connect(replaceEdit_, &QLineEdit::returnPressed, this, &FindBar::replaceCurrent);
+    connect(searchTimer_, &QTimer::timeout, this, &FindBar::startSearch);
+
+    auto *previousShortcut = new QShortcut(QKeySequence(Qt::SHIFT | Qt::Key_Return), findEdit_);
+    previousShortcut->setContext(Qt::WidgetShortcut);
+    connect(previousShortcut, &QShortcut::activated, this, &FindBar::findPrevious);
+
+    auto *escapeShortcut = new QShortcut(QKeySequence(Qt::Key_Escape), this);
+    escapeShortcut->setContext(Qt::WidgetWithChildrenShortcut);
+    connect(escapeShortcut, &QShortcut::activated, this, &FindBar::closeBar);
+
+    connect(&watcher_, &QFutureWatcher<SearchBatch>::resultReadyAt, this, &FindBar::onBatchReady);
+    connect(&watcher_, &QFutureWatcher<SearchBatch>::finished, this, &FindBar::onSearchFinished);
+    connect(&replaceWatcher_, &QFutureWatcher<ReplacePlan>::finished, this, &FindBar::onReplacePlanReady);
+
+    connect(textEdit_->document(), &QTextDocument::contentsChange, this, &FindBar::onContentsChange);
+    connect(textEdit_->verticalScrollBar(), &QScrollBar::valueChanged, this, &FindBar::updateHighlights);
+}
+
+FindBar::~FindBar()
+{
+    cancelSearch();
+    if (replaceWatcher_.isRunning()) {
+        replaceWatcher_.cancel();
+        replaceWatcher_.waitForFinished();
+    }
+}
+
+void FindBar::activateReplace()
+{
+    replaceRow_->show();
+    activate();
+}
+
+void FindBar::activate()
+{
+    const QTextCursor cursor = textEdit_->textCursor();
+    if (cursor.hasSelection()) {
+        const QString selected = cursor.selectedText();
+        if (!selected.contains(QChar::ParagraphSeparator)) {
+            findEdit_->setText(selected);
+        }
+    }
+    show();
+    findEdit_->setFocus();
+    findEdit_->selectAll();
+    startSearch();
+}
+
+SearchQuery FindBar::currentQuery() const
+{
+    SearchQuery query;
+    query.pattern = findEdit_->text();
+    query.options.caseSensitive = caseCheck_->isChecked();
+    query.options.wholeWords = wordCheck_->isChecked();
+    query.options.regex = regexCheck_->isChecked();
+    return query;
+}
+
+bool FindBar::isFolded() const
+{
+    return foldCheck_->isChecked() && !regexCheck_->isChecked();
+}
+
+void FindBar::closeBar()
+{
+    cancelSearch();
+    SelectionLayers::of(textEdit_)->clearLayer(SelectionLayers::SearchLayer);
+    replaceRow_->hide();
+    hide();
+    textEdit_->setFocus();
+}
+
+void FindBar::scheduleSearch()
+{
+    searchTimer_->start(120);
+}
+
+const QString &FindBar::snapshot()
+{
+    if (snapshotRevision_ != contentsRevision_) {
+        snapshot_ = textEdit_->document()->toPlainText();
+        snapshotRevision_ = contentsRevision_;
+    }
+    return snapshot_;
+}
+
+QPair<qsizetype, qsizetype> FindBar::visibleRange(qsizetype margin) const
+{
+    const QRect rect = textEdit_->viewport()->rect();
+    const qsizetype first = textEdit_->cursorForPosition(rect.topLeft()).block().position();
+    const QTextBlock lastBlock = textEdit_->cursorForPosition(rect.bottomRight()).block();
+    const qsizetype last = lastBlock.position() + lastBlock.length();
+    const qsizetype size = textEdit_->document()->characterCount();
+    return {qMax<qsizetype>(0, first - margin), qMin(size, last + margin)};
+}
+
+void FindBar::cancelSearch()
+{
+    if (watcher_.isRunning()) {
+        watcher_.cancel();
+        watcher_.waitForFinished();
+    }
+}
+
+void FindBar::startSearch()
+{
+    searchTimer_->stop();
+    const SearchQuery query = currentQuery();
+    const bool folded = isFolded();
+
+    // A longer pattern only matches where the shorter one did, except with
+    // whole words: a hit for "foob" is never a whole-word hit for "foo".
+    const bool canRefine = lastSearchComplete_
+                           && !folded && !lastFolded_
+                           && !query.options.wholeWords
+                           && lastQueryRevision_ == contentsRevision_
+                           && !query.options.regex && !lastQuery_.options.regex
+                           && query.options == lastQuery_.options
+                           && !lastQuery_.pattern.isEmpty()
+                           && query.pattern.size() > lastQuery_.pattern.size()
+                           && query.pattern.startsWith(lastQuery_.pattern,
+                                                       query.options.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive);
+    const QVector<SearchMatch> candidates = canRefine ? sortedMatches() : QVector<SearchMatch>();
+
+    cancelSearch();
+    for (auto &matches : regionMatches_) {
+        matches.clear();
+    }
+    merged_.clear();
+    mergedDirty_ = false;
+    currentMatch_ = -1;
+    pendingJump_ = 0;
+    lastQuery_ = query;
+    lastFolded_ = folded;
+    lastQueryRevision_ = contentsRevision_;
+    lastSearchComplete_ = false;
+
+    if (query.isEmpty()) {
+        countLabel_->clear();
+        SelectionLayers::of(textEdit_)->clearLayer(SelectionLayers::SearchLayer);
+        return;
+    }
+
+    if (const TextSearcher probe(query); !probe.isValid()) {
+        countLabel_->setText("Ошибка: " + probe.errorString());
+        SelectionLayers::of(textEdit_)->clearLayer(SelectionLayers::SearchLayer);
+        return;
+    }
+
+    const auto [visibleFrom, visibleTo] = visibleRange();
+    if (folded) {
+        const std::shared_ptr<const FoldedSnapshot> shadow = shadow_->snapshot();
+        watcher_.setFuture(QtConcurrent::run(runFoldedSearch, shadow, foldedQuery(query),
+                                             shadow->toFolded(visibleFrom), shadow->toFolded(visibleTo)));
+    } else {
+        watcher_.setFuture(QtConcurrent::run(runSearch, snapshot(), query, visibleFrom, visibleTo, candidates, canRefine));
+    }
+    updateCountLabel();
+}
+
+void FindBar::onBatchReady(int resultIndex)
+{
+    const SearchBatch batch = watcher_.resultAt(resultIndex);
+    regionMatches_[batch.region] += batch.matches;
+    mergedDirty_ = true;
+    if (batch.region == VisibleRegion) {
+        updateHighlights();
+    }
+    updateCountLabel();
+}
+
+void FindBar::onSearchFinished()
+{
+    if (watcher_.isCanceled()) {
+        return;
+    }
+    lastSearchComplete_ = true;
+    updateHighlights();
+    updateCountLabel();
+    emit statusMessage(QString("Найдено совпадений: %1").arg(sortedMatches().size()));
+
+    if (const int direction = pendingJump_; direction != 0) {
+        pendingJump_ = 0;
+        direction > 0 ? findNext() : findPrevious();
+    }
+}
+
+void FindBar::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(position)
+    if (charsRemoved == 0 && charsAdded == 0) {
+        return;
+    }
+    ++contentsRevision_;
+    if (isVisible() && !findEdit_->text().isEmpty()) {
+        searchTimer_->start(300);
+    }
+}
+
+const QVector<SearchMatch> &FindBar::sortedMatches()
+{
+    if (mergedDirty_) {
+        merged_.clear();
+        merged_.reserve(regionMatches_[BeforeRegion].size() + regionMatches_[VisibleRegion].size()
+                        + regionMatches_[AfterRegion].size());
+        merged_ += regionMatches_[BeforeRegion];
+        merged_ += regionMatches_[VisibleRegion];
+        merged_ += regionMatches_[AfterRegion];
+        mergedDirty_ = false;
+    }
+    return merged_;
+}
+
+void FindBar::updateHighlights()
+{
+    if (!isVisible() || lastQueryRevision_ != contentsRevision_) {
+        return;
+    }
+
+    const QVector<SearchMatch> &matches = sortedMatches();
+    const auto [from, to] = visibleRange(2000);
+    auto it = std::lower_bound(matches.cbegin(), matches.cend(), SearchMatch{from, 0});
+
+    QTextCharFormat matchFormat;
+    matchFormat.setBackground(QColor(255, 230, 120));
+    QTextCharFormat currentFormat;
+    currentFormat.setBackground(QColor(255, 150, 50));
+
+    QList<QTextEdit::ExtraSelection> selections;
+    for (; it != matches.cend() && it->start < to && selections.size() < kMaxHighlights; ++it) {
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(textEdit_->document());
+        selection.cursor.setPosition(it->start);
+        selection.cursor.setPosition(it->end(), QTextCursor::KeepAnchor);
+        const bool isCurrent = currentMatch_ >= 0 && currentMatch_ < matches.size()
+                               && matches.at(currentMatch_).start == it->start;
+        selection.format = isCurrent ? currentFormat : matchFormat;
+        selections.append(selection);
+    }
+    SelectionLayers::of(textEdit_)->setLayer(SelectionLayers::SearchLayer, selections);
+}
+
+void FindBar::selectMatch(const SearchMatch &match)
+{
+    QTextCursor cursor = textEdit_->textCursor();
+    cursor.setPosition(match.start);
+    cursor.setPosition(match.end(), QTextCursor::KeepAnchor);
+    textEdit_->setTextCursor(cursor);
+    textEdit_->ensureCursorVisible();
+    updateHighlights();
+    updateCountLabel();
+}
+
+void FindBar::findNext()
+{
+    emit navigated(currentQuery(), false);
+    if (searchTimer_->isActive() || lastQueryRevision_ != contentsRevision_) {
+        startSearch();
+    }
+    const QVector<SearchMatch> &matches = sortedMatches();
+    if (matches.isEmpty()) {
+        pendingJump_ = watcher_.isRunning() ? 1 : 0;
+        return;
+    }
+
+    const qsizetype cursorPos = textEdit_->textCursor().selectionEnd();
+    auto it = std::lower_bound(matches.cbegin(), matches.cend(), SearchMatch{cursorPos, 0});
+    if (it == matches.cend()) {
+        it = matches.cbegin();
+    }
+    currentMatch_ = it - matches.cbegin();
+    selectMatch(*it);
+}
+
+void FindBar::findPrevious()
+{
+    emit navigated(currentQuery(), true);
+    if (searchTimer_->isActive() || lastQueryRevision_ != contentsRevision_) {
+        startSearch();
+    }
+    const QVector<SearchMatch> &matches = sortedMatches();
+    if (matches.isEmpty()) {
+        pendingJump_ = watcher_.isRunning() ? -1 : 0;
+        return;
+    }
+
+    const qsizetype cursorPos = textEdit_->textCursor().selectionStart();
+    auto it = std::lower_bound(matches.cbegin(), matches.cend(), SearchMatch{cursorPos, 0});
+    it = it == matches.cbegin() ? matches.cend() - 1 : it - 1;
+    currentMatch_ = it - matches.cbegin();
+    selectMatch(*it);
+}
+
+void FindBar::updateCountLabel()
+{
+    const qsizetype total = sortedMatches().size();
+    QString text;
+    if (currentMatch_ >= 0 && currentMatch_ < total) {
+        text = QString("%1 из %2").arg(currentMatch_ + 1).arg(total);
+    } else {
+        text = QString("Совпадений: %1").arg(total);
+    }
+    if (watcher_.isRunning()) {
+        text += " …";
+    }
+    countLabel_->setText(text);
+}
+
+void FindBar::replaceCurrent()
+{
+    const SearchQuery query = currentQuery();
+    const TextSearcher searcher(query);
+    if (!searcher.isValid()) {
+        return;
+    }
+
+    QTextCursor cursor = textEdit_->textCursor();
+    if (cursor.hasSelection()) {
+        const QString &text = snapshot();
+        const SearchMatch selected{cursor.selectionStart(), cursor.selectionEnd() - cursor.selectionStart()};
+        bool matches = false;
+        if (isFolded()) {
+            const QString foldedSelection = FoldedShadow::fold(cursor.selectedText());
+            matches = TextSearcher(foldedQuery(query)).matchesAt(foldedSelection, 0, foldedSelection.size());
+        } else {
+            matches = searcher.matchesAt(text, selected.start, selected.length);
+        }
+        if (matches) {
+            const QString replacement = searcher.replacementAt(text, selected, replaceEdit_->text());
+            cursor.beginEditBlock();
+            cursor.insertText(replacement);
+            cursor.endEditBlock();
+            textEdit_->setTextCursor(cursor);
+        }
+    }
+    startSearch();
+    findNext();
+}
+
+void FindBar::replaceAll()
+{
+    const SearchQuery query = currentQuery();
+    if (query.isEmpty() || replaceWatcher_.isRunning()) {
+        return;
+    }
+
+    const quint64 revision = contentsRevision_;
+    const QString replacement = replaceEdit_->text();
+    replaceAllButton_->setEnabled(false);
+    countLabel_->setText("Подготовка замены…");
+
+    if (isFolded()) {
+        replaceWatcher_.setFuture(QtConcurrent::run([](QPromise<ReplacePlan> &promise,
+                                                       const std::shared_ptr<const FoldedSnapshot> &shadow,
+                                                       const SearchQuery &query, const QString &replacement,
+                                                       quint64 revision) {
+            ReplacePlan plan;
+            plan.revision = revision;
+            if (buildFoldedReplacePlan(*shadow, query, replacement, plan,
+                                       [&promise]() { return promise.isCanceled(); })) {
+                promise.addResult(std::move(plan));
+            }
+        }, shadow_->snapshot(), foldedQuery(query), replacement, revision));
+        return;
+    }
+
+    replaceWatcher_.setFuture(QtConcurrent::run([](QPromise<ReplacePlan> &promise, const QString &text,
+                                                   const SearchQuery &query, const QString &replacement,
+                                                   quint64 revision) {
+        const TextSearcher searcher(query);
+        ReplacePlan plan;
+        plan.revision = revision;
+        if (searcher.buildReplacePlan(text, replacement, plan, [&promise]() { return promise.isCanceled(); })) {
+            promise.addResult(std::move(plan));
+        }
+    }, snapshot(), query, replacement, revision));
+}
+
+void FindBar::onReplacePlanReady()
+{
+    replaceAllButton_->setEnabled(true);
+    if (replaceWatcher_.isCanceled() || replaceWatcher_.future().resultCount() == 0) {
+        updateCountLabel();
+        return;
+    }
+
+    const ReplacePlan plan = replaceWatcher_.result();
+    if (plan.edits.isEmpty()) {
+        emit statusMessage("Совпадений для замены не найдено");
+        updateCountLabel();
+        return;
+    }
+
+    const auto reply = QMessageBox::question(this, "Заменить все",
+                                             QString("Будет заменено совпадений: %1. Продолжить?").arg(plan.edits.size()));
+    if (reply != QMessageBox::Yes) {
+        updateCountLabel();
+        return;
+    }
+    if (plan.revision != contentsRevision_) {
+        emit statusMessage("Документ изменился во время подготовки замены — повторите операцию");
+        updateCountLabel();
+        return;
+    }
+
+    // Back to front, so earlier positions stay valid; each replacement
+    // takes the format of the match it replaces.
+    QTextCursor cursor(textEdit_->document());
+    cursor.beginEditBlock();
+    for (auto it = plan.edits.crbegin(); it != plan.edits.crend(); ++it) {
+        cursor.setPosition(static_cast<int>(it->start));
+        cursor.setPosition(static_cast<int>(it->start + it->length), QTextCursor::KeepAnchor);
+        cursor.insertText(it->text);
+    }
+    cursor.endEditBlock();
+
+    emit statusMessage(QString("Заменено совпадений: %1").arg(plan.edits.size()));
+    startSearch();
+}
@@ -0,0 +1,357 @@
+#include "../headers/findinfilespanel.h"
+#include "../headers/replacepreviewdialog.h"
+
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QToolButton>
+#include <QLabel>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QDir>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QFormLayout>
+#include <QElapsedTimer>
+
+namespace {
+
+enum ItemRole {
+    PathRole = Qt::UserRole,
+    LineRole,
+    ColumnRole
+};
+
+}
+
+FindInFilesPanel::FindInFilesPanel(QWidget *parent)
+    : QWidget(parent)
+{
+    rootEdit_ = new QLineEdit(this);
+    auto *browseButton = new QToolButton(this);
+    browseButton->setText("…");
+
+    patternEdit_ = new QLineEdit(this);
+    patternEdit_->setPlaceholderText("Искомый текст");
+    patternEdit_->setClearButtonEnabled(true);
+
+    replaceEdit_ = new QLineEdit(this);
+    replaceEdit_->setPlaceholderText("Заменить на");
+    replaceButton_ = new QPushButton("Заменить…", this);
+
+    filterEdit_ = new QLineEdit(this);
+    filterEdit_->setPlaceholderText("*.cpp; *.h; *.txt (пусто — все файлы)");
+
+    caseCheck_ = new QCheckBox("Аа", this);
+    caseCheck_->setToolTip("Учитывать регистр");
+    wordCheck_ = new QCheckBox("Слово", this);
+    wordCheck_->setToolTip("Только слово целиком");
+    regexCheck_ = new QCheckBox(".*", this);
+    regexCheck_->setToolTip("Регулярное выражение");
+    indexCheck_ = new QCheckBox("Индекс", this);
+    indexCheck_->setToolTip("Использовать индекс папки (включая текст .docx, .odt и .pdf)");
+
+    searchButton_ = new QPushButton("Найти", this);
+    stopButton_ = new QPushButton("Стоп", this);
+    stopButton_->setEnabled(false);
+
+    statusLabel_ = new QLabel(this);
+    statusLabel_->setWordWrap(true);
+
+    resultsTree_ = new QTreeWidget(this);
+    resultsTree_->setHeaderHidden(true);
+    resultsTree_->setUniformRowHeights(true);
+
+    auto *rootRow = new QHBoxLayout();
+    rootRow->addWidget(rootEdit_, 1);
+    rootRow->addWidget(browseButton);
+
+    auto *form = new QFormLayout();
+    form->addRow("Папка:", rootRow);
+    form->addRow("Найти:", patternEdit_);
+    auto *replaceRow = new QHBoxLayout();
+    replaceRow->addWidget(replaceEdit_, 1);
+    replaceRow->addWidget(replaceButton_);
+    form->addRow("Заменить:", replaceRow);
+    form->addRow("Файлы:", filterEdit_);
+
+    auto *optionsRow = new QHBoxLayout();
+    optionsRow->addWidget(caseCheck_);
+    optionsRow->addWidget(wordCheck_);
+    optionsRow->addWidget(regexCheck_);
+    optionsRow->addWidget(indexCheck_);
+    optionsRow->addStretch(1);
+    optionsRow->addWidget(searchButton_);
+    optionsRow->addWidget(stopButton_);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->addLayout(form);
+    layout->addLayout(optionsRow);
+    layout->addWidget(statusLabel_);
+    layout->addWidget(resultsTree_, 1);
+
+    connect(browseButton, &QToolButton::clicked, this, &FindInFilesPanel::browse);
+    connect(patternEdit_, &QLineEdit::returnPressed, this, &FindInFilesPanel::startSearch);
+    connect(searchButton_, &QPushButton::clicked, this, &FindInFilesPanel::startSearch);
+    connect(stopButton_, &QPushButton::clicked, this, &FindInFilesPanel::stopSearch);
+    connect(resultsTree_, &QTreeWidget::itemActivated, this, &FindInFilesPanel::onItemActivated);
+    connect(&searcher_, &ParallelFileSearcher::hitsFound, this, &FindInFilesPanel::onHitsFound);
+    connect(&searcher_, &ParallelFileSearcher::progress, this, &FindInFilesPanel::onProgress);
+    connect(&searcher_, &ParallelFileSearcher::finished, this, &FindInFilesPanel::onFinished);
+    connect(replaceButton_, &QPushButton::clicked, this, &FindInFilesPanel::startReplace);
+    connect(&replacer_, &WorkspaceReplacer::planProgress, this, [this](int done, int total) {
+        statusLabel_->setText(QString("Подготовка замены: %1 из %2 файлов").arg(done).arg(total));
+    });
+    connect(&replacer_, &WorkspaceReplacer::planReady, this, &FindInFilesPanel::onReplacePlanReady);
+    connect(&replacer_, &WorkspaceReplacer::committed, this, &FindInFilesPanel::onReplaceCommitted);
+    connect(indexCheck_, &QCheckBox::toggled, this, &FindInFilesPanel::onIndexToggled);
+    connect(&index_, &WorkspaceIndex::progress, this, &FindInFilesPanel::onIndexProgress);
+    connect(&index_, &WorkspaceIndex::ready, this, [this]() {
+        statusLabel_->setText(QString("Индекс готов: %1 файлов").arg(index_.fileCount()));
+    });
+    connect(&index_, &WorkspaceIndex::failed, this, [this](const QString &message) {
+        statusLabel_->setText("Ошибка индекса: " + message);
+    });
+}
+
+void FindInFilesPanel::setRootPath(const QString &path)
+{
+    if (!path.isEmpty()) {
+        rootEdit_->setText(QDir::toNativeSeparators(path));
+    }
+}
+
+void FindInFilesPanel::activate(const QString &initialPattern)
+{
+    if (!initialPattern.isEmpty()) {
+        patternEdit_->setText(initialPattern);
+    }
+    patternEdit_->setFocus();
+    patternEdit_->selectAll();
+}
+
+void FindInFilesPanel::browse()
+{
+    const QString dir = QFileDialog::getExistingDirectory(this, "Папка для поиска", rootEdit_->text());
+    setRootPath(dir);
+}
+
+FileSearchRequest FindInFilesPanel::buildRequest() const
+{
+    FileSearchRequest request;
+    request.rootPath = QDir::fromNativeSeparators(rootEdit_->text().trimmed());
+    request.query.pattern = patternEdit_->text();
+    request.query.options.caseSensitive = caseCheck_->isChecked();
+    request.query.options.wholeWords = wordCheck_->isChecked();
+    request.query.options.regex = regexCheck_->isChecked();
+
+    const QStringList filters = filterEdit_->text().split(QRegularExpression("[;,\\s]+"), Qt::SkipEmptyParts);
+    request.nameFilters = filters;
+    return request;
+}
+
+void FindInFilesPanel::startSearch()
+{
+    const FileSearchRequest request = buildRequest();
+    if (request.query.isEmpty()) {
+        return;
+    }
+    if (!QFileInfo(request.rootPath).isDir()) {
+        statusLabel_->setText("Папка не найдена: " + request.rootPath);
+        return;
+    }
+    if (const TextSearcher probe(request.query); !probe.isValid()) {
+        statusLabel_->setText("Ошибка: " + probe.errorString());
+        return;
+    }
+
+    resultsTree_->clear();
+    fileItems_.clear();
+    hitCount_ = 0;
+    indexNote_.clear();
+
+    FileSearchRequest indexed = request;
+    if (!applyIndex(indexed)) {
+        statusLabel_->setText("Совпадений: 0 | " + indexNote_);
+        return;
+    }
+
+    statusLabel_->setText("Поиск...");
+    searchButton_->setEnabled(false);
+    stopButton_->setEnabled(true);
+    searcher_.start(indexed);
+}
+
+bool FindInFilesPanel::applyIndex(FileSearchRequest &request)
+{
+    if (!indexCheck_->isChecked()) {
+        return true;
+    }
+    if (QDir(request.rootPath).canonicalPath() != index_.rootPath()) {
+        index_.open(request.rootPath);
+    }
+    if (!index_.isReady()) {
+        indexNote_ = "индекс строится, полный просмотр";
+        return true;
+    }
+
+    index_.refreshIfStale();
+    QElapsedTimer timer;
+    timer.start();
+    const IndexCandidates candidates = index_.candidates(request.query, request.nameFilters);
+    indexNote_ = QString("индекс: кандидатов %1 из %2 за %3 мс")
+                     .arg(candidates.files.size())
+                     .arg(candidates.totalFiles)
+                     .arg(timer.elapsed());
+    request.files = candidates.files;
+    request.textSources = candidates.textSources;
+    return !request.files.isEmpty();
+}
+
+void FindInFilesPanel::startReplace()
+{
+    FileSearchRequest request = buildRequest();
+    if (request.query.isEmpty() || replacer_.isRunning()) {
+        return;
+    }
+    if (!QFileInfo(request.rootPath).isDir()) {
+        statusLabel_->setText("Папка не найдена: " + request.rootPath);
+        return;
+    }
+    if (const TextSearcher probe(request.query); !probe.isValid()) {
+        statusLabel_->setText("Ошибка: " + probe.errorString());
+        return;
+    }
+    if (!applyIndex(request)) {
+        statusLabel_->setText("Совпадений для замены нет");
+        return;
+    }
+
+    replaceButton_->setEnabled(false);
+    statusLabel_->setText("Подготовка замены...");
+    replacer_.plan(request, replaceEdit_->text());
+}
+
+void FindInFilesPanel::onReplacePlanReady(const QVector<FileReplacePlan> &plans)
+{
+    if (plans.isEmpty()) {
+        replaceButton_->setEnabled(true);
+        statusLabel_->setText("Совпадений для замены нет");
+        return;
+    }
+
+    ReplacePreviewDialog dialog(plans, this);
+    const QVector<FileReplacePlan> selected = dialog.exec() == QDialog::Accepted ? dialog.selectedPlans()
+                                                                                  : QVector<FileReplacePlan>();
+    if (selected.isEmpty()) {
+        replaceButton_->setEnabled(true);
+        statusLabel_->setText("Замена отменена");
+        return;
+    }
+    statusLabel_->setText(QString("Запись %1 файлов...").arg(selected.size()));
+    replacer_.commit(selected);
+}
+
+void FindInFilesPanel::onReplaceCommitted(const ReplaceCommitResult &result)
+{
+    replaceButton_->setEnabled(true);
+    if (!result.ok) {
+        statusLabel_->setText("Замена не выполнена, файлы не изменены: " + result.error);
+        return;
+    }
+
+    const double megabytes = result.bytesWritten / (1024.0 * 1024.0);
+    const double seconds = qMax<qint64>(1, result.elapsedMs) / 1000.0;
+    statusLabel_->setText(QString("Заменено в %1 файлах (%2 МБ) за %3 мс | %4 файлов/с, %5 МБ/с")
+                              .arg(result.files.size())
+                              .arg(megabytes, 0, 'f', 1)
+                              .arg(result.elapsedMs)
+                              .arg(result.files.size() / seconds, 0, 'f', 0)
+                              .arg(megabytes / seconds, 0, 'f', 1));
+    emit filesRewritten(result.files);
+}
+
+void FindInFilesPanel::onIndexToggled(bool enabled)
+{
+    if (!enabled) {
+        index_.close();
+        return;
+    }
+    const QString root = QDir::fromNativeSeparators(rootEdit_->text().trimmed());
+    if (QFileInfo(root).isDir()) {
+        index_.open(root);
+    }
+}
+
+void FindInFilesPanel::onIndexProgress(qint64 done, qint64 total)
+{
+    statusLabel_->setText(QString("Индексация: %1 из %2 файлов").arg(done).arg(total));
+}
+
+void FindInFilesPanel::stopSearch()
+{
+    searcher_.cancel();
+    searchButton_->setEnabled(true);
+    stopButton_->setEnabled(false);
+    statusLabel_->setText(QString("Остановлено. Совпадений: %1").arg(hitCount_));
+}
+
+void FindInFilesPanel::onHitsFound(const QVector<FileSearchHit> &hits)
+{
+    resultsTree_->setUpdatesEnabled(false);
+    for (const FileSearchHit &hit : hits) {
+        QTreeWidgetItem *fileItem = fileItems_.value(hit.filePath);
+        if (!fileItem) {
+            fileItem = new QTreeWidgetItem(resultsTree_);
+            fileItem->setText(0, QDir::toNativeSeparators(hit.filePath));
+            fileItem->setData(0, PathRole, hit.filePath);
+            fileItem->setData(0, LineRole, hit.line);
+            fileItem->setData(0, ColumnRole, hit.column);
+            fileItems_.insert(hit.filePath, fileItem);
+        }
+        auto *hitItem = new QTreeWidgetItem(fileItem);
+        hitItem->setText(0, QString("%1: %2").arg(hit.line).arg(hit.preview));
+        hitItem->setData(0, PathRole, hit.filePath);
+        hitItem->setData(0, LineRole, hit.line);
+        hitItem->setData(0, ColumnRole, hit.column);
+    }
+    hitCount_ += hits.size();
+    resultsTree_->setUpdatesEnabled(true);
+}
+
+void FindInFilesPanel::onProgress(qint64 filesScanned)
+{
+    statusLabel_->setText(QString("Поиск... файлов: %1, совпадений: %2").arg(filesScanned).arg(hitCount_));
+}
+
+void FindInFilesPanel::onFinished(const FileSearchStats &stats)
+{
+    searchButton_->setEnabled(true);
+    stopButton_->setEnabled(false);
+    const double megabytes = stats.bytesScanned / (1024.0 * 1024.0);
+    QString status = QString("Совпадений: %1 в %2 файлах | просмотрено %3 файлов (%4 МБ), пропущено %5 | %6 мс")
+                         .arg(stats.hits)
+                         .arg(fileItems_.size())
+                         .arg(stats.filesScanned)
+                         .arg(megabytes, 0, 'f', 1)
+                         .arg(stats.filesSkipped)
+                         .arg(stats.elapsedMs);
+    if (!indexNote_.isEmpty()) {
+        status += " | " + indexNote_;
+    }
+    statusLabel_->setText(status);
+}
+
+void FindInFilesPanel::onItemActivated(QTreeWidgetItem *item, int column)
+{
+    Q_UNUSED(column)
+    if (!item) {
+        return;
+    }
+    emit openRequested(item->data(0, PathRole).toString(),
+                       item->data(0, LineRole).toInt(),
+                       item->data(0, ColumnRole).toInt());
+}
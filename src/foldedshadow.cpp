@@ -0,0 +1,280 @@
+#include "../headers/foldedshadow.h"
+
+#include <QTextDocument>
+#include <QTextBlock>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+constexpr char16_t kShortI = 0x0439;
+constexpr char16_t kCapitalShortI = 0x0419;
+
+bool decomposesToBaseAndMarks(const QString &decomposition)
+{
+    return decomposition.size() > 1
+           && std::all_of(decomposition.cbegin() + 1, decomposition.cend(), [](QChar ch) {
+                  return ch.category() == QChar::Mark_NonSpacing;
+              });
+}
+
+const std::vector<char16_t> &foldTable()
+{
+    static const std::vector<char16_t> table = [] { // NOSONAR - Meyers singleton pattern
+        std::vector<char16_t> result(0x10000);
+        for (char32_t c = 1; c < 0x10000; ++c) {
+            if (QChar::isSurrogate(c)) {
+                result[c] = static_cast<char16_t>(c);
+                continue;
+            }
+            if (QChar::category(c) == QChar::Mark_NonSpacing) {
+                result[c] = 0;
+                continue;
+            }
+
+            char32_t base = c;
+            // "й" is a letter of its own in Russian, unlike "ё" which folds to "е".
+            while (base != kShortI && base != kCapitalShortI
+                   && QChar::decompositionTag(base) == QChar::Canonical) {
+                const QString decomposition = QChar::decomposition(base);
+                if (!decomposesToBaseAndMarks(decomposition) || decomposition.at(0).isSurrogate()) {
+                    break;
+                }
+                base = decomposition.at(0).unicode();
+            }
+
+            const char32_t folded = QChar::toCaseFolded(base);
+            result[c] = folded <= 0xFFFF ? static_cast<char16_t>(folded) : static_cast<char16_t>(c);
+        }
+        return result;
+    }();
+    return table;
+}
+
+}
+
+qsizetype FoldedSnapshot::toOriginal(qsizetype folded) const
+{
+    if (foldedStarts.empty()) {
+        return folded;
+    }
+    const auto it = std::upper_bound(foldedStarts.cbegin(), foldedStarts.cend(), folded);
+    const auto block = static_cast<qsizetype>(std::distance(foldedStarts.cbegin(), it)) - 1;
+    const qsizetype local = folded - foldedStarts[static_cast<size_t>(block)];
+    const auto map = maps.constFind(block);
+    if (map == maps.cend()) {
+        return originalStarts[static_cast<size_t>(block)] + local;
+    }
+    const qsizetype foldedLength = map->size() - 1;
+    const qsizetype mapped = local <= foldedLength ? map->at(local) : map->last() + (local - foldedLength);
+    return originalStarts[static_cast<size_t>(block)] + mapped;
+}
+
+qsizetype FoldedSnapshot::toFolded(qsizetype original) const
+{
+    if (originalStarts.empty()) {
+        return original;
+    }
+    const auto it = std::upper_bound(originalStarts.cbegin(), originalStarts.cend(), original);
+    const auto block = static_cast<qsizetype>(std::distance(originalStarts.cbegin(), it)) - 1;
+    const qsizetype local = original - originalStarts[static_cast<size_t>(block)];
+    const auto map = maps.constFind(block);
+    if (map == maps.cend()) {
+        return foldedStarts[static_cast<size_t>(block)] + local;
+    }
+    const auto pos = std::lower_bound(map->cbegin(), map->cend(), static_cast<int>(local));
+    return foldedStarts[static_cast<size_t>(block)] + (pos - map->cbegin());
+}
+
+FoldedShadow::FoldedShadow(QTextDocument *document, QObject *parent)
+    : QObject(parent)
+    , document_(document)
+{
+    connect(document_, &QTextDocument::contentsChange, this, &FoldedShadow::onContentsChange);
+}
+
+QString FoldedShadow::fold(QStringView text, QVector<int> *map)
+{
+    const std::vector<char16_t> &table = foldTable();
+    QString result(text.size(), Qt::Uninitialized);
+    char16_t *out = reinterpret_cast<char16_t *>(result.data());
+    qsizetype length = 0;
+    QVector<int> positions;
+    bool identity = true;
+
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const char16_t c = text[i].unicode();
+        const char16_t folded = table[c];
+        if (folded == 0 && c != 0) {
+            if (identity) {
+                identity = false;
+                positions.resize(length);
+                std::iota(positions.begin(), positions.end(), 0);
+            }
+            continue;
+        }
+        if (!identity) {
+            positions.push_back(static_cast<int>(i));
+        }
+        out[length++] = folded;
+    }
+    result.truncate(length);
+
+    if (map) {
+        map->clear();
+        if (!identity) {
+            positions.push_back(static_cast<int>(text.size()));
+            *map = std::move(positions);
+        }
+    }
+    return result;
+}
+
+std::shared_ptr<const FoldedSnapshot> FoldedShadow::snapshot()
+{
+    if (!attached_ || !snapshot_ || blocks_.size() != static_cast<size_t>(document_->blockCount())) {
+        rebuild();
+    } else if (dirtyFirst_ >= 0) {
+        patch();
+    }
+    dirtyFirst_ = -1;
+    dirtyLast_ = -1;
+    return snapshot_;
+}
+
+const FoldedShadow::BlockShadow &FoldedShadow::blockShadow(const QTextBlock &block, size_t index)
+{
+    BlockShadow &shadow = blocks_[index];
+    if (!shadow.valid) {
+        shadow.folded = fold(block.text(), &shadow.map);
+        shadow.valid = true;
+    }
+    return shadow;
+}
+
+void FoldedShadow::rebuild()
+{
+    const auto blockCount = static_cast<size_t>(document_->blockCount());
+    if (!attached_ || blocks_.size() != blockCount) {
+        blocks_.assign(blockCount, BlockShadow{});
+        attached_ = true;
+    }
+
+    auto snapshot = std::make_shared<FoldedSnapshot>();
+    snapshot->text.reserve(document_->characterCount());
+    snapshot->foldedStarts.reserve(blockCount);
+    snapshot->originalStarts.reserve(blockCount);
+
+    qsizetype index = 0;
+    for (QTextBlock block = document_->begin(); block.isValid(); block = block.next(), ++index) {
+        const BlockShadow &shadow = blockShadow(block, static_cast<size_t>(index));
+        snapshot->foldedStarts.push_back(snapshot->text.size());
+        snapshot->originalStarts.push_back(block.position());
+        if (!shadow.map.isEmpty()) {
+            snapshot->maps.insert(index, shadow.map);
+        }
+        snapshot->text += shadow.folded;
+        snapshot->text += QChar(u'\n');
+    }
+    snapshot_ = std::move(snapshot);
+}
+
+// Splices the blocks changed since the last snapshot into it and shifts the
+// starts of the blocks after them. A snapshot still held by a search is
+// copied first, since it must not change under the worker.
+void FoldedShadow::patch()
+{
+    const auto oldCount = static_cast<int>(snapshot_->foldedStarts.size());
+    const auto newCount = static_cast<int>(blocks_.size());
+    const int first = dirtyFirst_;
+    const int last = qMin(dirtyLast_, newCount - 1);
+    const int oldLast = last - (newCount - oldCount);
+    if (first > last || oldLast < first || oldLast >= oldCount) {
+        rebuild();
+        return;
+    }
+    if (snapshot_.use_count() > 1) {
+        snapshot_ = std::make_shared<FoldedSnapshot>(*snapshot_);
+    }
+    FoldedSnapshot &snapshot = *snapshot_;
+
+    const qsizetype foldedFrom = snapshot.foldedStarts[static_cast<size_t>(first)];
+    const qsizetype foldedTo = oldLast + 1 < oldCount ? snapshot.foldedStarts[static_cast<size_t>(oldLast + 1)]
+                                                      : snapshot.text.size();
+    QString text;
+    std::vector<qsizetype> foldedStarts;
+    std::vector<qsizetype> originalStarts;
+    QHash<qsizetype, QVector<int>> maps;
+    QTextBlock block = document_->findBlockByNumber(first);
+    for (int index = first; index <= last; ++index, block = block.next()) {
+        const BlockShadow &shadow = blockShadow(block, static_cast<size_t>(index));
+        foldedStarts.push_back(foldedFrom + text.size());
+        originalStarts.push_back(block.position());
+        if (!shadow.map.isEmpty()) {
+            maps.insert(index, shadow.map);
+        }
+        text += shadow.folded;
+        text += QChar(u'\n');
+    }
+
+    const qsizetype foldedDelta = text.size() - (foldedTo - foldedFrom);
+    const qsizetype originalDelta = oldLast + 1 < oldCount
+                                        ? block.position() - snapshot.originalStarts[static_cast<size_t>(oldLast + 1)]
+                                        : 0;
+    snapshot.text.replace(foldedFrom, foldedTo - foldedFrom, text);
+
+    auto splice = [first, oldLast](std::vector<qsizetype> &starts, const std::vector<qsizetype> &fresh, qsizetype delta) {
+        starts.erase(starts.begin() + first, starts.begin() + oldLast + 1);
+        starts.insert(starts.begin() + first, fresh.cbegin(), fresh.cend());
+        for (auto it = starts.begin() + first + static_cast<qsizetype>(fresh.size()); it != starts.end(); ++it) {
+            *it += delta;
+        }
+    };
+    splice(snapshot.foldedStarts, foldedStarts, foldedDelta);
+    splice(snapshot.originalStarts, originalStarts, originalDelta);
+
+    for (auto it = snapshot.maps.cbegin(); it != snapshot.maps.cend(); ++it) {
+        if (it.key() < first) {
+            maps.insert(it.key(), it.value());
+        } else if (it.key() > oldLast) {
+            maps.insert(it.key() + (newCount - oldCount), it.value());
+        }
+    }
+    snapshot.maps = std::move(maps);
+}
+
+void FoldedShadow::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved)
+    if (!attached_) {
+        return;
+    }
+
+    const int newCount = document_->blockCount();
+    const int delta = newCount - static_cast<int>(blocks_.size());
+    const QTextBlock firstBlock = document_->findBlock(position);
+    QTextBlock lastBlock = document_->findBlock(position + charsAdded);
+    if (!lastBlock.isValid()) {
+        lastBlock = document_->lastBlock();
+    }
+
+    const int first = firstBlock.blockNumber();
+    const int last = lastBlock.blockNumber();
+    const int oldLast = last - delta;
+    if (first < 0 || oldLast < first || oldLast >= static_cast<int>(blocks_.size())) {
+        blocks_.assign(static_cast<size_t>(newCount), BlockShadow{});
+        snapshot_.reset();
+        return;
+    }
+
+    blocks_.erase(blocks_.begin() + first, blocks_.begin() + oldLast + 1);
+    blocks_.insert(blocks_.begin() + first, static_cast<size_t>(last - first + 1), BlockShadow{});
+
+    if (dirtyFirst_ < 0) {
+        dirtyFirst_ = first;
+        dirtyLast_ = last;
+    } else {
+        dirtyLast_ = dirtyLast_ > oldLast ? dirtyLast_ + delta : last;
+        dirtyFirst_ = std::min(dirtyFirst_, first);
+    }
+}
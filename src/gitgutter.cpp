@@ -0,0 +1,231 @@
+#include "../headers/gitgutter.h"
+#include "../headers/linediff.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QPromise>
+#include <QProcess>
+#include <QFileInfo>
+#include <QTextEdit>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QAbstractTextDocumentLayout>
+#include <QScrollBar>
+#include <QPainter>
+#include <QPaintEvent>
+#include <algorithm>
+
+namespace {
+
+constexpr int kGutterWidth = 6;
+constexpr int kDiffDelayMs = 150;
+constexpr int kDeletedMarkerSize = 4;
+
+// The base text is hashed by the first job after the blob arrives; later
+// jobs reuse the hashes.
+void diffAgainstBase(QPromise<GitGutterDiff> &promise, quint64 generation, const QString &baseText,
+                     QVector<size_t> base, const QVector<size_t> &current)
+{
+    if (base.isEmpty()) {
+        base = LineDiff::hashLines(baseText);
+    }
+    if (promise.isCanceled()) {
+        return;
+    }
+    GitGutterDiff result;
+    result.generation = generation;
+    for (const DiffHunk &hunk : LineDiff::diff(base, current)) {
+        GitLineChange change;
+        change.first = hunk.newStart;
+        change.count = hunk.newCount;
+        change.kind = hunk.oldCount == 0 ? GitLineChange::Added
+            : hunk.newCount == 0 ? GitLineChange::Deleted : GitLineChange::Modified;
+        result.changes.append(change);
+    }
+    result.base = std::move(base);
+    promise.addResult(std::move(result));
+}
+
+}
+
+GitGutter::GitGutter(QTextEdit *textEdit, QWidget *parent)
+    : QWidget(parent)
+    , textEdit_(textEdit)
+{
+    setFixedWidth(kGutterWidth);
+    hide();
+
+    diffTimer_.setSingleShot(true);
+    diffTimer_.setInterval(kDiffDelayMs);
+    connect(&diffTimer_, &QTimer::timeout, this, &GitGutter::startDiff);
+    connect(&diffWatcher_, &QFutureWatcher<GitGutterDiff>::finished, this, &GitGutter::onDiffed);
+    connect(textEdit_->document(), &QTextDocument::contentsChange, this, &GitGutter::onContentsChange);
+    connect(textEdit_->verticalScrollBar(), &QScrollBar::valueChanged, this, qOverload<>(&QWidget::update));
+    connect(textEdit_->document()->documentLayout(), &QAbstractTextDocumentLayout::documentSizeChanged,
+            this, qOverload<>(&QWidget::update));
+}
+
+GitGutter::~GitGutter()
+{
+    diffWatcher_.cancel();
+    diffWatcher_.waitForFinished();
+}
+
+// Files outside a work tree, untracked files and binary blobs leave the
+// gutter hidden.
+void GitGutter::setFile(const QString &filePath)
+{
+    ++generation_;
+    tracked_ = false;
+    diffPending_ = false;
+    diffTimer_.stop();
+    diffWatcher_.cancel();
+    baseText_.clear();
+    base_.clear();
+    current_.clear();
+    changes_.clear();
+    hide();
+    if (filePath.isEmpty()) {
+        return;
+    }
+
+    const QFileInfo info(filePath);
+    auto *process = new QProcess(this);
+    process->setWorkingDirectory(info.absolutePath());
+    process->setStandardErrorFile(QProcess::nullDevice());
+    const quint64 generation = generation_;
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, [this, process, generation](int exitCode, QProcess::ExitStatus exitStatus) {
+        process->deleteLater();
+        if (generation != generation_ || exitStatus != QProcess::NormalExit || exitCode != 0) {
+            return;
+        }
+        const QByteArray blob = process->readAllStandardOutput();
+        if (blob.contains('\0')) {
+            return;
+        }
+        baseText_ = QString::fromUtf8(blob);
+        tracked_ = true;
+        rebuildHashes();
+        show();
+        startDiff();
+    });
+    connect(process, &QProcess::errorOccurred, this, [process](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            process->deleteLater();
+        }
+    });
+    process->start("git", {"show", "HEAD:./" + info.fileName()});
+}
+
+void GitGutter::rebuildHashes()
+{
+    current_.clear();
+    current_.reserve(textEdit_->document()->blockCount());
+    for (QTextBlock block = textEdit_->document()->begin(); block.isValid(); block = block.next()) {
+        current_.append(LineDiff::hashLine(block.text()));
+    }
+}
+
+// Blocks outside the changed range keep their hashes; the count of old
+// blocks the change replaced follows from the change in block count.
+void GitGutter::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    (void)charsRemoved;
+    if (!tracked_) {
+        return;
+    }
+    const QTextDocument *document = textEdit_->document();
+    const QTextBlock first = document->findBlock(position);
+    QTextBlock last = document->findBlock(position + charsAdded);
+    if (!last.isValid()) {
+        last = document->lastBlock();
+    }
+    const int start = first.blockNumber();
+    const int newCount = last.blockNumber() - start + 1;
+    const int oldCount = newCount - (document->blockCount() - static_cast<int>(current_.size()));
+    if (!first.isValid() || oldCount < 1 || start + oldCount > current_.size()) {
+        rebuildHashes();
+    } else {
+        if (newCount > oldCount) {
+            current_.insert(start, newCount - oldCount, 0);
+        } else if (newCount < oldCount) {
+            current_.remove(start, oldCount - newCount);
+        }
+        int number = start;
+        for (QTextBlock block = first; number < start + newCount; block = block.next(), ++number) {
+            current_[number] = LineDiff::hashLine(block.text());
+        }
+    }
+    diffTimer_.start();
+}
+
+void GitGutter::startDiff()
+{
+    if (!tracked_) {
+        return;
+    }
+    if (diffWatcher_.isRunning()) {
+        diffPending_ = true;
+        return;
+    }
+    diffWatcher_.setFuture(QtConcurrent::run(diffAgainstBase, generation_, baseText_, base_, current_));
+}
+
+void GitGutter::onDiffed()
+{
+    if (!diffWatcher_.isCanceled() && diffWatcher_.future().resultCount() > 0) {
+        GitGutterDiff result = diffWatcher_.result();
+        if (result.generation == generation_) {
+            if (base_.isEmpty()) {
+                base_ = std::move(result.base);
+                baseText_.clear();
+            }
+            changes_ = std::move(result.changes);
+            update();
+        }
+    }
+    if (diffPending_) {
+        diffPending_ = false;
+        startDiff();
+    }
+}
+
+int GitGutter::blockTop(int blockNumber) const
+{
+    const QTextDocument *document = textEdit_->document();
+    const QTextBlock block = document->findBlockByNumber(blockNumber);
+    const QRectF rect = document->documentLayout()->blockBoundingRect(block.isValid() ? block : document->lastBlock());
+    const int y = qRound(block.isValid() ? rect.top() : rect.bottom()) - textEdit_->verticalScrollBar()->value();
+    return mapFromGlobal(textEdit_->viewport()->mapToGlobal(QPoint(0, y))).y();
+}
+
+void GitGutter::paintEvent(QPaintEvent *event)
+{
+    QPainter painter(this);
+    painter.fillRect(event->rect(), palette().window());
+    if (changes_.isEmpty()) {
+        return;
+    }
+
+    const int firstVisible = textEdit_->cursorForPosition(QPoint(0, 0)).blockNumber();
+    const int lastVisible = textEdit_->cursorForPosition(QPoint(0, textEdit_->viewport()->height())).blockNumber();
+    auto it = std::partition_point(changes_.cbegin(), changes_.cend(), [firstVisible](const GitLineChange &change) {
+        return change.first + qMax(change.count, 1) <= firstVisible;
+    });
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    for (; it != changes_.cend() && it->first <= lastVisible; ++it) {
+        const int top = blockTop(it->first);
+        if (it->kind == GitLineChange::Deleted) {
+            QPolygon marker;
+            marker << QPoint(0, top - kDeletedMarkerSize) << QPoint(width(), top) << QPoint(0, top + kDeletedMarkerSize);
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(QColor(220, 70, 70));
+            painter.drawPolygon(marker);
+            continue;
+        }
+        const int bottom = blockTop(it->first + it->count);
+        const QColor color = it->kind == GitLineChange::Added ? QColor(90, 170, 90) : QColor(80, 140, 220);
+        painter.fillRect(QRect(1, top, width() - 2, qMax(1, bottom - top)), color);
+    }
+}
@@ -210,6 +210,43 @@ bool LibreOfficeHandler::save(const QString &filePath,
     return true;
 }
 
+bool LibreOfficeHandler::extractText(const QString &filePath,
+                                     QString &text,
+                                     QString &error) const
+{
+    if (!ensureLibreOfficeAvailable(error)) {
+        return false;
+    }
+
+    QTemporaryDir tempDir;
+    if (!tempDir.isValid()) {
+        error = QObject::tr("Не удалось создать временную директорию для извлечения текста");
+        return false;
+    }
+
+    QString textFile;
+    if (!convertToPlainText(filePath, tempDir.path(), textFile, error)) {
+        return false;
+    }
+
+    QFile file(textFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = QObject::tr("Не удалось открыть извлеченный текст '%1'").arg(textFile);
+        return false;
+    }
+
+    QTextStream stream(&file);
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    stream.setEncoding(QStringConverter::Utf8);
+#else
+    stream.setCodec("UTF-8");
+#endif
+
+    text = stream.readAll();
+    return true;
+}
+
 bool LibreOfficeHandler::ensureLibreOfficeAvailable(QString &error) const
 {
     if (!libreOfficeBinary_.isEmpty()) {
@@ -280,6 +317,39 @@ bool LibreOfficeHandler::convertToHtml(const QString &filePath,
     return true;
 }
 
+bool LibreOfficeHandler::convertToPlainText(const QString &filePath,
+                                            const QString &outputDir,
+                                            QString &textFilePath,
+                                            QString &error) const
+{
+    QProcess process;
+    QStringList args;
+    args << QStringLiteral("--headless")
+         << QStringLiteral("--convert-to")
+         << QStringLiteral("txt:Text (encoded):UTF8")
+         << filePath
+         << QStringLiteral("--outdir")
+         << outputDir;
+
+    process.start(libreOfficeBinary_, args);
+    if (!process.waitForFinished(-1)) {
+        error = QObject::tr("LibreOffice завершается слишком долго при извлечении текста");
+        return false;
+    }
+
+    if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0) {
+        error = QObject::tr("LibreOffice не удалось извлечь текст: %1").arg(QString::fromUtf8(process.readAllStandardError()));
+        return false;
+    }
+
+    textFilePath = QDir(outputDir).absoluteFilePath(QFileInfo(filePath).completeBaseName() + QStringLiteral(".txt"));
+    if (!QFile::exists(textFilePath)) {
+        error = QObject::tr("LibreOffice не создал текстовый файл для '%1'").arg(filePath);
+        return false;
+    }
+    return true;
+}
+
 bool LibreOfficeHandler::convertFromHtml(const QString &htmlPath,
                                          const QString &targetFormat,
                                          const QString &destinationPath,
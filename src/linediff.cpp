@@ -0,0 +1,471 @@
+#include "../headers/linediff.h"
+#include "../headers/searchengine.h"
+
+#include <QHash>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+constexpr int kCostLimit = 256;
+constexpr int kMaxChainLength = 64;
+constexpr int kMaxHistogramDepth = 64;
+
+// Forward and backward furthest-reaching paths meet in the middle snake;
+// the ranges on both sides of its start are compared independently.
+class Myers
+{
+public:
+    Myers(const QVector<size_t> &oldLines, const QVector<size_t> &newLines)
+        : removed(oldLines.size(), 0)
+        , added(newLines.size(), 0)
+        , a_(oldLines.constData())
+        , b_(newLines.constData())
+    {
+    }
+
+    void compare(int aLo, int aHi, int bLo, int bHi);
+
+    std::vector<char> removed;
+    std::vector<char> added;
+
+private:
+    bool split(int aLo, int aHi, int bLo, int bHi, int &splitX, int &splitY);
+
+    const size_t *a_;
+    const size_t *b_;
+    std::vector<int> forward_;
+    std::vector<int> backward_;
+};
+
+void Myers::compare(int aLo, int aHi, int bLo, int bHi)
+{
+    for (;;) {
+        while (aLo < aHi && bLo < bHi && a_[aLo] == b_[bLo]) {
+            ++aLo;
+            ++bLo;
+        }
+        while (aLo < aHi && bLo < bHi && a_[aHi - 1] == b_[bHi - 1]) {
+            --aHi;
+            --bHi;
+        }
+        int x = 0;
+        int y = 0;
+        if (aLo == aHi || bLo == bHi || !split(aLo, aHi, bLo, bHi, x, y)) {
+            std::fill(removed.begin() + aLo, removed.begin() + aHi, 1);
+            std::fill(added.begin() + bLo, added.begin() + bHi, 1);
+            return;
+        }
+        // The right half is walked iteratively: greedy splits of a long
+        // unrelated region would otherwise nest one call per split.
+        compare(aLo, aLo + x, bLo, bLo + y);
+        aLo += x;
+        bLo += y;
+    }
+}
+
+bool Myers::split(int aLo, int aHi, int bLo, int bHi, int &splitX, int &splitY)
+{
+    const size_t *a = a_ + aLo;
+    const size_t *b = b_ + bLo;
+    const int n = aHi - aLo;
+    const int m = bHi - bLo;
+    const int maxD = (n + m + 1) / 2;
+    const int lastD = std::min(maxD, kCostLimit);
+    const int offset = lastD + 1;
+    const int length = 2 * offset + 2;
+    forward_.assign(length, -1);
+    backward_.assign(length, -1);
+    forward_[offset + 1] = 0;
+    backward_[offset + 1] = 0;
+
+    const int delta = n - m;
+    const bool front = delta % 2 != 0;
+    int kForwardStart = 0;
+    int kForwardEnd = 0;
+    int kBackwardStart = 0;
+    int kBackwardEnd = 0;
+
+    for (int d = 0; d < lastD; ++d) {
+        for (int k = -d + kForwardStart; k <= d - kForwardEnd; k += 2) {
+            const int index = offset + k;
+            int x = (k == -d || (k != d && forward_[index - 1] < forward_[index + 1]))
+                ? forward_[index + 1] : forward_[index - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[x] == b[y]) {
+                ++x;
+                ++y;
+            }
+            forward_[index] = x;
+            if (x > n) {
+                kForwardEnd += 2;
+            } else if (y > m) {
+                kForwardStart += 2;
+            } else if (front) {
+                const int backwardIndex = offset + delta - k;
+                if (backwardIndex >= 0 && backwardIndex < length && backward_[backwardIndex] != -1
+                    && x >= n - backward_[backwardIndex]) {
+                    splitX = x;
+                    splitY = y;
+                    return true;
+                }
+            }
+        }
+        for (int k = -d + kBackwardStart; k <= d - kBackwardEnd; k += 2) {
+            const int index = offset + k;
+            int x = (k == -d || (k != d && backward_[index - 1] < backward_[index + 1]))
+                ? backward_[index + 1] : backward_[index - 1] + 1;
+            int y = x - k;
+            while (x < n && y < m && a[n - x - 1] == b[m - y - 1]) {
+                ++x;
+                ++y;
+            }
+            backward_[index] = x;
+            if (x > n) {
+                kBackwardEnd += 2;
+            } else if (y > m) {
+                kBackwardStart += 2;
+            } else if (!front) {
+                const int forwardIndex = offset + delta - k;
+                if (forwardIndex >= 0 && forwardIndex < length && forward_[forwardIndex] != -1) {
+                    const int forwardX = forward_[forwardIndex];
+                    if (forwardX >= n - x) {
+                        splitX = forwardX;
+                        splitY = forwardX - (forwardIndex - offset);
+                        return true;
+                    }
+                }
+            }
+        }
+    }
+
+    // Too expensive: split where the forward search got furthest.
+    int bestX = 0;
+    int bestY = 0;
+    for (int k = -lastD; k <= lastD; ++k) {
+        const int x = forward_[offset + k];
+        const int y = x - k;
+        if (x >= 0 && x <= n && y >= 0 && y <= m && x + y > bestX + bestY) {
+            bestX = x;
+            bestY = y;
+        }
+    }
+    if (bestX + bestY == 0 || (bestX == n && bestY == m)) {
+        return false;
+    }
+    splitX = bestX;
+    splitY = bestY;
+    return true;
+}
+
+// Lines of the old range are bucketed by hash; a bucket chains the
+// positions of one line text in order through next_.
+class Histogram
+{
+public:
+    Histogram(Myers &myers, const QVector<size_t> &oldLines, const QVector<size_t> &newLines)
+        : myers_(myers)
+        , a_(oldLines.constData())
+        , b_(newLines.constData())
+    {
+    }
+
+    void compare(int aLo, int aHi, int bLo, int bHi, int depth);
+
+private:
+    struct Bucket
+    {
+        int last = -1;
+        int count = 0;
+    };
+
+    struct Match
+    {
+        int aStart = 0;
+        int aEnd = 0;
+        int bStart = 0;
+        int bEnd = 0;
+    };
+
+    bool findMatch(int aLo, int aHi, int bLo, int bHi, Match &match);
+
+    Myers &myers_;
+    const size_t *a_;
+    const size_t *b_;
+    QHash<size_t, Bucket> buckets_;
+    std::vector<int> next_;
+};
+
+void Histogram::compare(int aLo, int aHi, int bLo, int bHi, int depth)
+{
+    for (;;) {
+        while (aLo < aHi && bLo < bHi && a_[aLo] == b_[bLo]) {
+            ++aLo;
+            ++bLo;
+        }
+        while (aLo < aHi && bLo < bHi && a_[aHi - 1] == b_[bHi - 1]) {
+            --aHi;
+            --bHi;
+        }
+        Match match;
+        if (aLo == aHi || bLo == bHi || depth > kMaxHistogramDepth || !findMatch(aLo, aHi, bLo, bHi, match)) {
+            myers_.compare(aLo, aHi, bLo, bHi);
+            return;
+        }
+        compare(aLo, match.aStart, bLo, match.bStart, depth + 1);
+        aLo = match.aEnd;
+        bLo = match.bEnd;
+    }
+}
+
+// The anchor is the common line with the fewest occurrences in the old
+// range, extended to the longest run of equal lines around it. Lines seen
+// more than kMaxChainLength times are never anchors.
+bool Histogram::findMatch(int aLo, int aHi, int bLo, int bHi, Match &match)
+{
+    buckets_.clear();
+    buckets_.reserve(aHi - aLo);
+    next_.assign(aHi - aLo, -1);
+    for (int i = aHi - 1; i >= aLo; --i) {
+        Bucket &bucket = buckets_[a_[i]];
+        next_[i - aLo] = bucket.last;
+        bucket.last = i;
+        ++bucket.count;
+    }
+
+    int bestCount = kMaxChainLength;
+    int bestLength = 0;
+    for (int bi = bLo; bi < bHi;) {
+        int nextB = bi + 1;
+        const auto it = buckets_.constFind(b_[bi]);
+        if (it != buckets_.cend() && it->count <= bestCount) {
+            for (int ai = it->last; ai >= 0; ai = next_[ai - aLo]) {
+                int aStart = ai;
+                int bStart = bi;
+                int aEnd = ai + 1;
+                int bEnd = bi + 1;
+                while (aStart > aLo && bStart > bLo && a_[aStart - 1] == b_[bStart - 1]) {
+                    --aStart;
+                    --bStart;
+                }
+                while (aEnd < aHi && bEnd < bHi && a_[aEnd] == b_[bEnd]) {
+                    ++aEnd;
+                    ++bEnd;
+                }
+                if (it->count < bestCount || aEnd - aStart > bestLength) {
+                    bestCount = it->count;
+                    bestLength = aEnd - aStart;
+                    match = {aStart, aEnd, bStart, bEnd};
+                }
+                nextB = std::max(nextB, bEnd);
+            }
+        }
+        bi = nextB;
+    }
+    return bestLength > 0;
+}
+
+// Lines without an equal on the other side can never match. They are
+// marked up front and left out of the search, so unrelated regions cost
+// nothing and the result is the same.
+void diffMarks(const QVector<size_t> &oldLines, const QVector<size_t> &newLines,
+               std::vector<char> &removed, std::vector<char> &added)
+{
+    std::vector<size_t> oldSorted(oldLines.cbegin(), oldLines.cend());
+    std::vector<size_t> newSorted(newLines.cbegin(), newLines.cend());
+    std::sort(oldSorted.begin(), oldSorted.end());
+    std::sort(newSorted.begin(), newSorted.end());
+
+    removed.assign(oldLines.size(), 1);
+    added.assign(newLines.size(), 1);
+    QVector<size_t> oldKept;
+    QVector<size_t> newKept;
+    std::vector<int> oldIndex;
+    std::vector<int> newIndex;
+    for (int i = 0; i < oldLines.size(); ++i) {
+        if (std::binary_search(newSorted.cbegin(), newSorted.cend(), oldLines.at(i))) {
+            oldKept.append(oldLines.at(i));
+            oldIndex.push_back(i);
+        }
+    }
+    for (int j = 0; j < newLines.size(); ++j) {
+        if (std::binary_search(oldSorted.cbegin(), oldSorted.cend(), newLines.at(j))) {
+            newKept.append(newLines.at(j));
+            newIndex.push_back(j);
+        }
+    }
+    oldSorted = {};
+    newSorted = {};
+
+    Myers myers(oldKept, newKept);
+    Histogram histogram(myers, oldKept, newKept);
+    histogram.compare(0, static_cast<int>(oldKept.size()), 0, static_cast<int>(newKept.size()), 0);
+    for (size_t i = 0; i < oldIndex.size(); ++i) {
+        removed[oldIndex[i]] = myers.removed[i];
+    }
+    for (size_t j = 0; j < newIndex.size(); ++j) {
+        added[newIndex[j]] = myers.added[j];
+    }
+}
+
+struct Token
+{
+    int line = 0;
+    int start = 0;
+    int length = 0;
+};
+
+bool isWordChar(QChar ch)
+{
+    return ch.isLetterOrNumber() || ch == u'_';
+}
+
+// Line ends are zero-length tokens, so a word never matches across lines.
+void tokenize(const QList<QStringView> &lines, QVector<Token> &tokens, QVector<size_t> &hashes)
+{
+    const size_t lineEnd = qHash(QStringView(u"\n"));
+    for (int line = 0; line < lines.size(); ++line) {
+        const QStringView text = lines.at(line);
+        const qsizetype size = text.size();
+        qsizetype i = 0;
+        while (i < size) {
+            const qsizetype start = i;
+            if (isWordChar(text[i])) {
+                while (i < size && isWordChar(text[i])) {
+                    ++i;
+                }
+            } else if (text[i].isSpace()) {
+                while (i < size && text[i].isSpace()) {
+                    ++i;
+                }
+            } else {
+                i += (text[i].isHighSurrogate() && i + 1 < size) ? 2 : 1;
+            }
+            tokens.append({line, static_cast<int>(start), static_cast<int>(i - start)});
+            hashes.append(qHash(text.sliced(start, i - start)));
+        }
+        tokens.append({line, static_cast<int>(size), 0});
+        hashes.append(lineEnd);
+    }
+}
+
+QVector<WordRange> changedRanges(const QVector<Token> &tokens, const std::vector<char> &changed)
+{
+    QVector<WordRange> ranges;
+    for (qsizetype i = 0; i < tokens.size(); ++i) {
+        const Token &token = tokens.at(i);
+        if (!changed[i] || token.length == 0) {
+            continue;
+        }
+        if (!ranges.isEmpty() && ranges.last().line == token.line
+            && ranges.last().start + ranges.last().length == token.start) {
+            ranges.last().length += token.length;
+        } else {
+            ranges.append({token.line, token.start, token.length});
+        }
+    }
+    return ranges;
+}
+
+}
+
+namespace LineDiff {
+
+size_t hashLine(QStringView line)
+{
+    return qHash(line);
+}
+
+QList<QStringView> splitLines(QStringView text)
+{
+    QList<QStringView> lines;
+    qsizetype start = 0;
+    for (;;) {
+        const qsizetype end = SearchEngine::findChar(text, u'\n', start, text.size());
+        QStringView line = text.sliced(start, (end < 0 ? text.size() : end) - start);
+        if (line.endsWith(u'\r')) {
+            line.chop(1);
+        }
+        lines.append(line);
+        if (end < 0) {
+            return lines;
+        }
+        start = end + 1;
+    }
+}
+
+QVector<size_t> hashLines(QStringView text)
+{
+    return hashLines(splitLines(text));
+}
+
+QVector<size_t> hashLines(const QList<QStringView> &lines)
+{
+    QVector<size_t> hashes;
+    hashes.reserve(lines.size());
+    for (const QStringView line : lines) {
+        hashes.append(hashLine(line));
+    }
+    return hashes;
+}
+
+QVector<DiffHunk> diff(const QVector<size_t> &oldLines, const QVector<size_t> &newLines)
+{
+    std::vector<char> removed;
+    std::vector<char> added;
+    diffMarks(oldLines, newLines, removed, added);
+
+    QVector<DiffHunk> hunks;
+    const int n = static_cast<int>(oldLines.size());
+    const int m = static_cast<int>(newLines.size());
+    int i = 0;
+    int j = 0;
+    while (i < n || j < m) {
+        if (i < n && j < m && !removed[i] && !added[j]) {
+            ++i;
+            ++j;
+            continue;
+        }
+        DiffHunk hunk{i, 0, j, 0};
+        while (i < n && removed[i]) {
+            ++i;
+            ++hunk.oldCount;
+        }
+        while (j < m && added[j]) {
+            ++j;
+            ++hunk.newCount;
+        }
+        if (hunk.oldCount == 0 && hunk.newCount == 0) {
+            break;
+        }
+        if (!hunks.isEmpty() && hunks.last().oldStart + hunks.last().oldCount == hunk.oldStart
+            && hunks.last().newStart + hunks.last().newCount == hunk.newStart) {
+            hunks.last().oldCount += hunk.oldCount;
+            hunks.last().newCount += hunk.newCount;
+        } else {
+            hunks.append(hunk);
+        }
+    }
+    return hunks;
+}
+
+WordDiff refineWords(const QList<QStringView> &oldLines, const QList<QStringView> &newLines)
+{
+    QVector<Token> oldTokens;
+    QVector<Token> newTokens;
+    QVector<size_t> oldHashes;
+    QVector<size_t> newHashes;
+    tokenize(oldLines, oldTokens, oldHashes);
+    tokenize(newLines, newTokens, newHashes);
+
+    std::vector<char> removed;
+    std::vector<char> added;
+    diffMarks(oldHashes, newHashes, removed, added);
+
+    WordDiff words;
+    words.oldRanges = changedRanges(oldTokens, removed);
+    words.newRanges = changedRanges(newTokens, added);
+    return words;
+}
+
+}
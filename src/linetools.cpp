@@ -0,0 +1,397 @@
+#include "../headers/linetools.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <QCollator>
+#include <QLocale>
+#include <QRandomGenerator>
+#include <QVector>
+#include <QPair>
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+constexpr qsizetype kMinChunkLines = 16384;
+// Small enough that cancel is noticed soon even on a multi-million-line sort.
+constexpr qsizetype kSortRunLines = 65536;
+
+using LineViews = std::vector<QStringView>;
+using LineOrder = std::vector<quint32>;
+using ChunkBounds = QVector<QPair<qsizetype, qsizetype>>;
+
+LineViews splitLines(QStringView text)
+{
+    LineViews lines;
+    lines.reserve(static_cast<size_t>(text.count(u'\n')) + 1);
+    qsizetype start = 0;
+    for (;;) {
+        const qsizetype newline = text.indexOf(u'\n', start);
+        if (newline < 0) {
+            lines.push_back(text.sliced(start));
+            break;
+        }
+        lines.push_back(text.sliced(start, newline - start));
+        start = newline + 1;
+    }
+    return lines;
+}
+
+QString joinLines(const LineViews &lines)
+{
+    qsizetype total = lines.empty() ? 0 : static_cast<qsizetype>(lines.size()) - 1;
+    for (const QStringView line : lines) {
+        total += line.size();
+    }
+    QString result;
+    result.reserve(total);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        if (i > 0) {
+            result += QLatin1Char('\n');
+        }
+        result += lines[i];
+    }
+    return result;
+}
+
+ChunkBounds chunkBounds(qsizetype count, const QThreadPool *pool)
+{
+    const auto parts = static_cast<int>(qBound<qsizetype>(1, count / kMinChunkLines, qMax(1, pool->maxThreadCount())));
+    ChunkBounds bounds;
+    bounds.reserve(parts);
+    for (int i = 0; i < parts; ++i) {
+        bounds.append({count * i / parts, count * (i + 1) / parts});
+    }
+    return bounds;
+}
+
+template <typename Function>
+void forEachChunk(qsizetype count, QThreadPool *pool, Function function)
+{
+    ChunkBounds bounds = chunkBounds(count, pool);
+    if (bounds.size() == 1) {
+        function(bounds.first().first, bounds.first().second);
+        return;
+    }
+    QtConcurrent::blockingMap(pool, bounds, [&function](const QPair<qsizetype, qsizetype> &chunk) {
+        function(chunk.first, chunk.second);
+    });
+}
+
+// Sorts runs of at most kSortRunLines on the pool, then merges neighbouring
+// runs pairwise until a single run is left. Cancel is checked between runs
+// and merge passes; progress goes up to 90.
+template <typename Less>
+void parallelSort(LineOrder &order, Less less, EditToolControl &control)
+{
+    const auto count = static_cast<qsizetype>(order.size());
+    const auto runs = static_cast<int>(qMax<qsizetype>(1, (count + kSortRunLines - 1) / kSortRunLines));
+    ChunkBounds bounds;
+    bounds.reserve(runs);
+    for (int i = 0; i < runs; ++i) {
+        bounds.append({count * i / runs, count * (i + 1) / runs});
+    }
+    int passes = 0;
+    for (int width = 1; width < runs; width *= 2) {
+        ++passes;
+    }
+    const int steps = runs + passes;
+    std::atomic<int> done{0};
+    const auto begin = order.begin();
+
+    QtConcurrent::blockingMap(control.pool(), bounds, [&](const QPair<qsizetype, qsizetype> &chunk) {
+        if (control.isCanceled()) {
+            return;
+        }
+        std::stable_sort(begin + chunk.first, begin + chunk.second, less);
+        control.setProgress(++done * 90 / steps);
+    });
+
+    for (int width = 1; width < runs && !control.isCanceled(); width *= 2) {
+        QVector<int> starts;
+        for (int i = 0; i + width < runs; i += 2 * width) {
+            starts.append(i);
+        }
+        QtConcurrent::blockingMap(control.pool(), starts, [&](int first) {
+            const int last = qMin(first + 2 * width, runs) - 1;
+            std::inplace_merge(begin + bounds.at(first).first,
+                               begin + bounds.at(first + width).first,
+                               begin + bounds.at(last).second, less);
+        });
+        control.setProgress(++done * 90 / steps);
+    }
+}
+
+double numericKey(QStringView line)
+{
+    qsizetype end = 0;
+    while (end < line.size() && line.at(end).isSpace()) {
+        ++end;
+    }
+    const qsizetype start = end;
+    if (end < line.size() && (line.at(end) == u'-' || line.at(end) == u'+')) {
+        ++end;
+    }
+    while (end < line.size() && line.at(end).isDigit()) {
+        ++end;
+    }
+    if (end < line.size() && line.at(end) == u'.') {
+        ++end;
+        while (end < line.size() && line.at(end).isDigit()) {
+            ++end;
+        }
+    }
+    bool ok = false;
+    const double value = QLocale::c().toDouble(line.sliced(start, end - start), &ok);
+    return ok ? value : 0.0;
+}
+
+qsizetype digitRunEnd(QStringView text, qsizetype from)
+{
+    while (from < text.size() && text.at(from).isDigit()) {
+        ++from;
+    }
+    return from;
+}
+
+int naturalCompare(QStringView a, QStringView b)
+{
+    qsizetype i = 0;
+    qsizetype j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (a.at(i).isDigit() && b.at(j).isDigit()) {
+            while (i < a.size() - 1 && a.at(i) == u'0' && a.at(i + 1).isDigit()) {
+                ++i;
+            }
+            while (j < b.size() - 1 && b.at(j) == u'0' && b.at(j + 1).isDigit()) {
+                ++j;
+            }
+            const qsizetype endA = digitRunEnd(a, i);
+            const qsizetype endB = digitRunEnd(b, j);
+            if (endA - i != endB - j) {
+                return endA - i < endB - j ? -1 : 1;
+            }
+            if (const int result = a.sliced(i, endA - i).compare(b.sliced(j, endB - j)); result != 0) {
+                return result;
+            }
+            i = endA;
+            j = endB;
+            continue;
+        }
+        const char16_t ca = a.at(i).toCaseFolded().unicode();
+        const char16_t cb = b.at(j).toCaseFolded().unicode();
+        if (ca != cb) {
+            return ca < cb ? -1 : 1;
+        }
+        ++i;
+        ++j;
+    }
+    const qsizetype restA = a.size() - i;
+    const qsizetype restB = b.size() - j;
+    return restA == restB ? 0 : (restA < restB ? -1 : 1);
+}
+
+LineViews sortLines(const LineViews &lines, LineTransform::Operation operation, EditToolControl &control)
+{
+    QThreadPool *pool = control.pool();
+    const auto count = static_cast<qsizetype>(lines.size());
+    LineOrder order(lines.size());
+    std::iota(order.begin(), order.end(), 0u);
+
+    switch (operation) {
+    case LineTransform::Operation::SortNumeric: {
+        std::vector<double> keys(lines.size());
+        forEachChunk(count, pool, [&](qsizetype from, qsizetype to) {
+            for (qsizetype i = from; i < to; ++i) {
+                keys[i] = numericKey(lines[i]);
+            }
+        });
+        parallelSort(order, [&keys](quint32 a, quint32 b) { return keys[a] < keys[b]; }, control);
+        break;
+    }
+    case LineTransform::Operation::SortNatural:
+        parallelSort(order, [&lines](quint32 a, quint32 b) { return naturalCompare(lines[a], lines[b]) < 0; }, control);
+        break;
+    case LineTransform::Operation::SortLocale: {
+        // QCollator is not safe to share between threads, so every chunk
+        // builds its keys with its own instance.
+        std::vector<std::optional<QCollatorSortKey>> keys(lines.size());
+        forEachChunk(count, pool, [&](qsizetype from, qsizetype to) {
+            const QCollator collator;
+            for (qsizetype i = from; i < to; ++i) {
+                keys[i].emplace(collator.sortKey(lines[i].toString()));
+            }
+        });
+        parallelSort(order, [&keys](quint32 a, quint32 b) { return keys[a]->compare(*keys[b]) < 0; }, control);
+        break;
+    }
+    default:
+        parallelSort(order, [&lines](quint32 a, quint32 b) { return lines[a].compare(lines[b]) < 0; }, control);
+        break;
+    }
+
+    if (control.isCanceled()) {
+        return {};
+    }
+    LineViews sorted(lines.size());
+    forEachChunk(count, pool, [&](qsizetype from, qsizetype to) {
+        for (qsizetype i = from; i < to; ++i) {
+            sorted[i] = lines[order[i]];
+        }
+    });
+    return sorted;
+}
+
+LineViews uniqueLines(const LineViews &lines, EditToolControl &control)
+{
+    QThreadPool *pool = control.pool();
+    std::vector<size_t> hashes(lines.size());
+    forEachChunk(static_cast<qsizetype>(lines.size()), pool, [&](qsizetype from, qsizetype to) {
+        for (qsizetype i = from; i < to; ++i) {
+            hashes[i] = qHash(lines[i]);
+        }
+    });
+
+    const auto hash = [&hashes](quint32 index) { return hashes[index]; };
+    const auto equal = [&lines](quint32 a, quint32 b) { return lines[a] == lines[b]; };
+    std::unordered_set<quint32, decltype(hash), decltype(equal)> seen(lines.size(), hash, equal);
+
+    LineViews unique;
+    unique.reserve(lines.size());
+    for (quint32 i = 0; i < lines.size(); ++i) {
+        if ((i & 0xFFFF) == 0) {
+            if (control.isCanceled()) {
+                return {};
+            }
+            control.setProgress(static_cast<int>(i * 90ULL / lines.size()));
+        }
+        if (seen.insert(i).second) {
+            unique.push_back(lines[i]);
+        }
+    }
+    return unique;
+}
+
+}
+
+QString LineTransform::apply(QStringView text, Operation operation, EditToolControl& control)
+{
+    QThreadPool* pool = control.pool();
+    LineViews lines = splitLines(text);
+
+    // A trailing newline stays at the end instead of sorting to the top as
+    // an empty line.
+    const bool trailingNewline = lines.size() > 1 && lines.back().isEmpty();
+    if (trailingNewline) {
+        lines.pop_back();
+    }
+    const auto count = static_cast<qsizetype>(lines.size());
+
+    switch (operation) {
+    case Operation::SortLexical:
+    case Operation::SortNumeric:
+    case Operation::SortNatural:
+    case Operation::SortLocale:
+        lines = sortLines(lines, operation, control);
+        break;
+    case Operation::Unique:
+        lines = uniqueLines(lines, control);
+        break;
+    case Operation::Reverse:
+        std::reverse(lines.begin(), lines.end());
+        break;
+    case Operation::Shuffle: {
+        std::mt19937_64 generator(QRandomGenerator::global()->generate64());
+        std::shuffle(lines.begin(), lines.end(), generator);
+        break;
+    }
+    case Operation::TrimTrailing:
+        forEachChunk(count, pool, [&lines](qsizetype from, qsizetype to) {
+            for (qsizetype i = from; i < to; ++i) {
+                QStringView &line = lines[i];
+                while (!line.isEmpty() && line.back().isSpace()) {
+                    line.chop(1);
+                }
+            }
+        });
+        break;
+    case Operation::RemoveBlank:
+        lines.erase(std::remove_if(lines.begin(), lines.end(),
+                                   [](QStringView line) { return line.trimmed().isEmpty(); }),
+                    lines.end());
+        break;
+    }
+    if (control.isCanceled()) {
+        return {};
+    }
+
+    if (trailingNewline) {
+        lines.push_back(QStringView());
+    }
+    return joinLines(lines);
+}
+
+LineTransformTool::LineTransformTool(const QString& name, LineTransform::Operation operation)
+    : name_(name), operation_(operation) {
+}
+
+bool LineTransformTool::canExecute(IDocument* document, QTextEdit* textEdit) const {
+    (void)textEdit;
+    return document && document->characterCount() > 1;
+}
+
+EditToolInput LineTransformTool::snapshot(IDocument* document) const {
+    EditToolInput input;
+    input.selection = document->hasSelection();
+    const TextRange range = input.selection ? document->selectionRange() : TextRange{0, document->characterCount()};
+
+    int start = -1;
+    int end = -1;
+    input.text.reserve(range.length());
+    for (const TextChunk& chunk : document->blocks(range)) {
+        if (input.selection && start >= 0 && chunk.blockPosition == range.end) {
+            break;
+        }
+        if (start < 0) {
+            start = chunk.blockPosition;
+        } else {
+            input.text += QLatin1Char('\n');
+        }
+        input.text += chunk.blockText;
+        end = chunk.blockPosition + static_cast<int>(chunk.blockText.size());
+    }
+    input.range = TextRange{qMax(0, start), qMax(0, end)};
+    return input;
+}
+
+EditToolInput LineTransformTool::snapshotSource(const ITextSource& source, TextRange selection) const {
+    EditToolInput input;
+    input.selection = !selection.isEmpty();
+    if (input.selection) {
+        const int last = selection.end > selection.start && source.lineRange(selection.end).start == selection.end
+                             ? selection.end - 1
+                             : selection.end;
+        input.range = TextRange{source.lineRange(selection.start).start, source.lineRange(last).end};
+    } else {
+        input.range = TextRange{0, source.length()};
+    }
+    input.text = source.text(input.range);
+    return input;
+}
+
+EditToolResult LineTransformTool::compute(const EditToolInput& input, EditToolControl& control) const {
+    EditToolResult result;
+    const QString text = LineTransform::apply(input.text, operation_, control);
+    if (control.isCanceled() || text == input.text) {
+        return result;
+    }
+    result.edits.append({input.range.start, input.range.length(), text});
+    if (input.selection) {
+        result.selection = TextRange{input.range.start, input.range.start + static_cast<int>(text.size())};
+    }
+    return result;
+}
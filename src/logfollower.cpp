@@ -0,0 +1,237 @@
+#include "../headers/logfollower.h"
+#include "../headers/searchengine.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <QTextEdit>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QScrollBar>
+
+#if defined(Q_OS_UNIX)
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+constexpr int kFrameMs = 16;
+constexpr int kDefaultLinesPerFrame = 1000;
+constexpr qint64 kReadChunk = 1 << 20;
+
+// Tells a rotated log (a new file under the same name) from a truncated one.
+QByteArray fileIdentity(const QString &filePath)
+{
+#if defined(Q_OS_UNIX)
+    struct stat info;
+    if (::stat(QFile::encodeName(filePath).constData(), &info) != 0) {
+        return {};
+    }
+    return QByteArray::number(static_cast<quint64>(info.st_dev)) + ':'
+           + QByteArray::number(static_cast<quint64>(info.st_ino));
+#else
+    const QDateTime birth = QFileInfo(filePath).birthTime();
+    return birth.isValid() ? QByteArray::number(birth.toMSecsSinceEpoch()) : QByteArray();
+#endif
+}
+
+}
+
+LogFollower::LogFollower(QTextEdit *textEdit, QObject *parent)
+    : QObject(parent)
+    , textEdit_(textEdit)
+    , decoder_(QStringDecoder::Utf8)
+    , linesPerFrame_(kDefaultLinesPerFrame)
+{
+    frameTimer_.setInterval(kFrameMs);
+    connect(&frameTimer_, &QTimer::timeout, this, &LogFollower::onFrame);
+    connect(&watcher_, &QFileSystemWatcher::fileChanged, this, &LogFollower::wake);
+    connect(&watcher_, &QFileSystemWatcher::directoryChanged, this, &LogFollower::wake);
+    connect(textEdit_->verticalScrollBar(), &QScrollBar::valueChanged, this, &LogFollower::onScrolled);
+    connect(textEdit_->verticalScrollBar(), &QScrollBar::rangeChanged, this, &LogFollower::onRangeChanged);
+}
+
+// Following starts where the buffer ends, so bytes written since the file
+// was loaded are appended first. The buffer is read-only meanwhile and
+// keeps no undo history, which would otherwise grow with every appended
+// batch.
+bool LogFollower::start(const QString &filePath, qint64 offset, QString &error)
+{
+    stop();
+    file_.setFileName(QFileInfo(filePath).absoluteFilePath());
+    if (!file_.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        error = file_.errorString();
+        return false;
+    }
+    offset_ = offset >= 0 ? offset : file_.size();
+    identity_ = fileIdentity(file_.fileName());
+    decoder_.resetState();
+    pending_.clear();
+    pendingPos_ = 0;
+    watcher_.addPath(file_.fileName());
+    watcher_.addPath(QFileInfo(file_.fileName()).absolutePath());
+
+    QTextDocument *document = textEdit_->document();
+    hadUndo_ = document->isUndoRedoEnabled();
+    document->setUndoRedoEnabled(false);
+    wasReadOnly_ = textEdit_->isReadOnly();
+    textEdit_->setReadOnly(true);
+
+    autoScroll_ = true;
+    QScrollBar *scrollBar = textEdit_->verticalScrollBar();
+    scrollBar->setValue(scrollBar->maximum());
+    emit followingChanged(true);
+    emit statusMessage("Слежение за файлом: " + file_.fileName());
+    wake();
+    return true;
+}
+
+void LogFollower::stop()
+{
+    if (!isFollowing()) {
+        return;
+    }
+    frameTimer_.stop();
+    if (pendingPos_ < pending_.size()) {
+        append(QStringView(pending_).sliced(pendingPos_));
+    }
+    pending_.clear();
+    pendingPos_ = 0;
+    if (!watcher_.files().isEmpty()) {
+        watcher_.removePaths(watcher_.files());
+    }
+    if (!watcher_.directories().isEmpty()) {
+        watcher_.removePaths(watcher_.directories());
+    }
+    file_.close();
+
+    textEdit_->document()->setUndoRedoEnabled(hadUndo_);
+    textEdit_->setReadOnly(wasReadOnly_);
+    emit followingChanged(false);
+}
+
+void LogFollower::setLinesPerFrame(int lines)
+{
+    linesPerFrame_ = qMax(1, lines);
+}
+
+void LogFollower::wake()
+{
+    if (isFollowing() && !frameTimer_.isActive()) {
+        frameTimer_.start();
+    }
+}
+
+// Reads only once the previous chunk has been appended, so a large burst
+// is held at most one chunk at a time.
+void LogFollower::onFrame()
+{
+    checkFile();
+    if (pendingPos_ >= pending_.size()) {
+        pending_.clear();
+        pendingPos_ = 0;
+        readAvailable();
+        if (pending_.isEmpty()) {
+            frameTimer_.stop();
+            return;
+        }
+    }
+
+    qsizetype end = pendingPos_;
+    for (int line = 0; line < linesPerFrame_; ++line) {
+        const qsizetype lineEnd = SearchEngine::findChar(pending_, u'\n', end, pending_.size());
+        if (lineEnd < 0) {
+            end = pending_.size();
+            break;
+        }
+        end = lineEnd + 1;
+    }
+    append(QStringView(pending_).sliced(pendingPos_, end - pendingPos_));
+    pendingPos_ = end;
+}
+
+// A rotated file is drained before the new one is opened; while the name
+// is missing the old file is still read.
+void LogFollower::checkFile()
+{
+    const QString filePath = file_.fileName();
+    if (!QFileInfo::exists(filePath)) {
+        return;
+    }
+    if (fileIdentity(filePath) != identity_) {
+        if (file_.size() <= offset_) {
+            reopen();
+        }
+        return;
+    }
+    if (file_.size() < offset_) {
+        offset_ = 0;
+        decoder_.resetState();
+        pending_.clear();
+        pendingPos_ = 0;
+        QTextCursor cursor(textEdit_->document());
+        cursor.select(QTextCursor::Document);
+        cursor.removeSelectedText();
+        textEdit_->document()->setModified(false);
+        emit statusMessage("Файл усечён, чтение с начала: " + filePath);
+    }
+}
+
+void LogFollower::reopen()
+{
+    const QString filePath = file_.fileName();
+    file_.close();
+    if (!file_.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        emit statusMessage("Не удалось открыть файл после ротации: " + file_.errorString());
+        stop();
+        return;
+    }
+    offset_ = 0;
+    identity_ = fileIdentity(filePath);
+    decoder_.resetState();
+    watcher_.removePath(filePath);
+    watcher_.addPath(filePath);
+    emit statusMessage("Файл заменён (ротация), чтение нового файла: " + filePath);
+}
+
+void LogFollower::readAvailable()
+{
+    const qint64 available = file_.size() - offset_;
+    if (available <= 0 || !file_.seek(offset_)) {
+        return;
+    }
+    const QByteArray bytes = file_.read(qMin(available, kReadChunk));
+    offset_ += bytes.size();
+    QString text = decoder_.decode(bytes);
+    text.remove(u'\r');
+    pending_ += text;
+}
+
+void LogFollower::append(QStringView text)
+{
+    QTextCursor cursor(textEdit_->document());
+    cursor.movePosition(QTextCursor::End);
+    cursor.insertText(text.toString());
+    textEdit_->document()->setModified(false);
+}
+
+// Scrolling away from the bottom pauses auto-scroll; scrolling back to the
+// bottom resumes it.
+void LogFollower::onScrolled(int value)
+{
+    const bool atBottom = value >= textEdit_->verticalScrollBar()->maximum();
+    if (atBottom == autoScroll_) {
+        return;
+    }
+    autoScroll_ = atBottom;
+    if (isFollowing()) {
+        emit statusMessage(atBottom ? QString("Автопрокрутка возобновлена") : QString("Автопрокрутка приостановлена"));
+    }
+}
+
+void LogFollower::onRangeChanged(int minimum, int maximum)
+{
+    (void)minimum;
+    if (isFollowing() && autoScroll_) {
+        textEdit_->verticalScrollBar()->setValue(maximum);
+    }
+}
@@ -0,0 +1,508 @@
+#include "../headers/lspclient.h"
+
+#include <QCoreApplication>
+#include <QStandardPaths>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QJsonDocument>
+#include <QLoggingCategory>
+#include <QFileInfo>
+#include <QUrl>
+#include <utility>
+
+Q_LOGGING_CATEGORY(lcLsp, "texteditor.lsp")
+
+namespace {
+
+constexpr int kChangeDelayMs = 120;
+constexpr int kHoverDelayMs = 250;
+constexpr int kStopTimeoutMs = 1000;
+constexpr int kRequestCancelled = -32800;
+constexpr QByteArrayView kContentLength = "content-length:";
+
+QString plainText(const QTextDocument *document)
+{
+    QString text;
+    text.reserve(document->characterCount());
+    for (QTextBlock block = document->begin(); block.isValid(); block = block.next()) {
+        if (block != document->begin()) {
+            text += u'\n';
+        }
+        text += block.text();
+    }
+    return text;
+}
+
+QString languageId(const QString &filePath)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    return suffix == "c" ? QString("c") : QString("cpp");
+}
+
+QString hoverText(const QJsonValue &contents)
+{
+    if (contents.isString()) {
+        return contents.toString();
+    }
+    if (contents.isObject()) {
+        return contents.toObject().value("value").toString();
+    }
+    QStringList parts;
+    for (const QJsonValue &part : contents.toArray()) {
+        parts << hoverText(part);
+    }
+    return parts.join("\n\n");
+}
+
+}
+
+LspClient::LspClient(QObject *parent)
+    : QObject(parent)
+{
+    changeTimer_.setSingleShot(true);
+    changeTimer_.setInterval(kChangeDelayMs);
+    hoverTimer_.setSingleShot(true);
+    hoverTimer_.setInterval(kHoverDelayMs);
+    connect(&changeTimer_, &QTimer::timeout, this, &LspClient::flushChanges);
+    connect(&hoverTimer_, &QTimer::timeout, this, &LspClient::sendHover);
+}
+
+LspClient::~LspClient()
+{
+    blockSignals(true);
+    stop();
+}
+
+bool LspClient::isAvailable(const QString &program)
+{
+    return !QStandardPaths::findExecutable(program).isEmpty();
+}
+
+bool LspClient::start(const QString &rootPath, const QString &program)
+{
+    stop();
+    const QString executable = QStandardPaths::findExecutable(program);
+    if (executable.isEmpty()) {
+        emit statusMessage(QString("%1 не найден в PATH").arg(program));
+        return false;
+    }
+
+    rootPath_ = rootPath;
+    process_ = new QProcess(this);
+    process_->setWorkingDirectory(rootPath);
+    process_->setStandardErrorFile(QProcess::nullDevice());
+    connect(process_, &QProcess::readyReadStandardOutput, this, &LspClient::readOutput);
+    connect(process_, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, &LspClient::onProcessFinished);
+    connect(process_, &QProcess::errorOccurred, this, [this, program](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            emit statusMessage(QString("Не удалось запустить %1").arg(program));
+        }
+    });
+    process_->start(executable, {"--log=error"});
+
+    QJsonObject capabilities{
+        {"general", QJsonObject{{"positionEncodings", QJsonArray{"utf-16"}}}},
+        {"textDocument", QJsonObject{
+            {"synchronization", QJsonObject{{"didSave", false}, {"willSave", false}}},
+            {"completion", QJsonObject{{"completionItem", QJsonObject{{"snippetSupport", false}}}}},
+            {"hover", QJsonObject{{"contentFormat", QJsonArray{"plaintext"}}}},
+            {"publishDiagnostics", QJsonObject{{"versionSupport", true}}}
+        }}
+    };
+    sendRequest("initialize", QJsonObject{
+        {"processId", QCoreApplication::applicationPid()},
+        {"clientInfo", QJsonObject{{"name", QCoreApplication::applicationName()}}},
+        {"rootUri", QUrl::fromLocalFile(rootPath).toString()},
+        {"capabilities", capabilities}
+    });
+    return true;
+}
+
+void LspClient::stop()
+{
+    if (!process_) {
+        return;
+    }
+    closeDocument();
+    if (initialized_) {
+        sendRequest("shutdown", QJsonObject());
+        sendNotification("exit", QJsonValue());
+    }
+    disconnect(process_, nullptr, this, nullptr);
+    process_->closeWriteChannel();
+    if (!process_->waitForFinished(kStopTimeoutMs)) {
+        process_->kill();
+        process_->waitForFinished(kStopTimeoutMs);
+    }
+    delete process_;
+    process_ = nullptr;
+
+    buffer_.clear();
+    queued_.clear();
+    pending_.clear();
+    initialized_ = false;
+    completionId_ = -1;
+    hoverId_ = -1;
+    rootPath_.clear();
+}
+
+bool LspClient::isRunning() const
+{
+    return process_ && process_->state() != QProcess::NotRunning;
+}
+
+void LspClient::openDocument(const QString &filePath, QTextDocument *document)
+{
+    closeDocument();
+    if (!process_ || !document) {
+        return;
+    }
+    document_ = document;
+    uri_ = QUrl::fromLocalFile(filePath).toString();
+    mirror_ = plainText(document);
+    version_ = 1;
+    sendNotification("textDocument/didOpen", QJsonObject{
+        {"textDocument", QJsonObject{
+            {"uri", uri_}, {"languageId", languageId(filePath)}, {"version", version_}, {"text", mirror_}
+        }}
+    });
+    changeConnection_ = connect(document, &QTextDocument::contentsChange, this, &LspClient::onContentsChange);
+}
+
+void LspClient::closeDocument()
+{
+    if (uri_.isEmpty()) {
+        return;
+    }
+    flushChanges();
+    cancelRequest(completionId_);
+    cancelRequest(hoverId_);
+    hoverTimer_.stop();
+    sendNotification("textDocument/didClose", QJsonObject{{"textDocument", QJsonObject{{"uri", uri_}}}});
+    disconnect(changeConnection_);
+    document_ = nullptr;
+    uri_.clear();
+    mirror_.clear();
+    emit diagnosticsChanged({});
+}
+
+void LspClient::requestCompletion(int position)
+{
+    if (!document_) {
+        return;
+    }
+    flushChanges();
+    cancelRequest(completionId_);
+    completionId_ = sendRequest("textDocument/completion", documentPosition(position), position);
+}
+
+void LspClient::requestHover(int position)
+{
+    if (!document_ || (position == hoverPosition_ && (hoverTimer_.isActive() || hoverId_ >= 0))) {
+        return;
+    }
+    hoverPosition_ = position;
+    hoverTimer_.start();
+}
+
+void LspClient::sendHover()
+{
+    if (!document_) {
+        return;
+    }
+    flushChanges();
+    cancelRequest(hoverId_);
+    hoverId_ = sendRequest("textDocument/hover", documentPosition(hoverPosition_), hoverPosition_);
+}
+
+// contentsChange arrives after the document changed: the start of the range
+// is the same in old and new text, its old end is found in mirror_.
+void LspClient::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (!document_) {
+        return;
+    }
+    if (position < 0 || position + charsRemoved > mirror_.size()
+        || position + charsAdded > document_->characterCount() - 1) {
+        resyncAll();
+        return;
+    }
+
+    QTextCursor cursor(document_);
+    cursor.setPosition(position);
+    cursor.setPosition(position + charsAdded, QTextCursor::KeepAnchor);
+    QString added = cursor.selectedText();
+    added.replace(QChar::ParagraphSeparator, u'\n');
+    const QStringView removed = QStringView(mirror_).sliced(position, charsRemoved);
+    if (removed == added) {
+        return;
+    }
+
+    if (charsRemoved == 0 && position == insertEnd_ && !pendingChanges_.isEmpty()) {
+        QJsonObject last = pendingChanges_.last().toObject();
+        last["text"] = last.value("text").toString() + added;
+        pendingChanges_.last() = last;
+        insertEnd_ += charsAdded;
+    } else {
+        const QJsonObject start = positionAt(position);
+        const int line = start.value("line").toInt();
+        const int character = start.value("character").toInt();
+        const qsizetype newlines = removed.count(u'\n');
+        const int endLine = line + static_cast<int>(newlines);
+        const int endCharacter = newlines == 0 ? character + charsRemoved
+                                               : static_cast<int>(removed.size() - removed.lastIndexOf(u'\n') - 1);
+        pendingChanges_.append(QJsonObject{
+            {"range", QJsonObject{
+                {"start", start},
+                {"end", QJsonObject{{"line", endLine}, {"character", endCharacter}}}
+            }},
+            {"text", added}
+        });
+        insertEnd_ = charsRemoved == 0 ? position + charsAdded : -1;
+    }
+    mirror_.replace(position, charsRemoved, added);
+    changeTimer_.start();
+}
+
+void LspClient::resyncAll()
+{
+    mirror_ = plainText(document_);
+    pendingChanges_ = QJsonArray{QJsonObject{{"text", mirror_}}};
+    insertEnd_ = -1;
+    changeTimer_.start();
+}
+
+// Sends everything typed since the last flush as one didChange. Answers to
+// requests made against the previous version are no longer wanted.
+void LspClient::flushChanges()
+{
+    changeTimer_.stop();
+    if (pendingChanges_.isEmpty() || uri_.isEmpty()) {
+        return;
+    }
+    ++version_;
+    sendNotification("textDocument/didChange", QJsonObject{
+        {"textDocument", QJsonObject{{"uri", uri_}, {"version", version_}}},
+        {"contentChanges", pendingChanges_}
+    });
+    pendingChanges_ = QJsonArray();
+    insertEnd_ = -1;
+    cancelRequest(completionId_);
+    cancelRequest(hoverId_);
+}
+
+QJsonObject LspClient::positionAt(int position) const
+{
+    const QTextBlock block = document_->findBlock(position);
+    return QJsonObject{{"line", block.blockNumber()}, {"character", position - block.position()}};
+}
+
+QJsonObject LspClient::documentPosition(int position) const
+{
+    return QJsonObject{{"textDocument", QJsonObject{{"uri", uri_}}}, {"position", positionAt(position)}};
+}
+
+qint64 LspClient::sendRequest(const QString &method, const QJsonObject &params, int position)
+{
+    const qint64 id = nextId_++;
+    PendingRequest &request = pending_[id];
+    request.method = method;
+    request.position = position;
+    request.version = version_;
+    request.timer.start();
+
+    const QJsonObject message{{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", params}};
+    if (initialized_ || method == "initialize") {
+        sendMessage(message);
+    } else {
+        queued_.append(message);
+    }
+    return id;
+}
+
+void LspClient::sendNotification(const QString &method, const QJsonValue &params)
+{
+    QJsonObject message{{"jsonrpc", "2.0"}, {"method", method}};
+    if (!params.isNull()) {
+        message.insert("params", params);
+    }
+    initialized_ ? sendMessage(message) : queued_.append(message);
+}
+
+void LspClient::cancelRequest(qint64 &id)
+{
+    if (id < 0) {
+        return;
+    }
+    if (pending_.contains(id)) {
+        sendNotification("$/cancelRequest", QJsonObject{{"id", id}});
+    }
+    id = -1;
+}
+
+void LspClient::sendMessage(const QJsonObject &message)
+{
+    if (!process_) {
+        return;
+    }
+    const QByteArray body = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    process_->write("Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n");
+    process_->write(body);
+}
+
+void LspClient::readOutput()
+{
+    buffer_ += process_->readAllStandardOutput();
+    while (true) {
+        const qsizetype headerEnd = buffer_.indexOf("\r\n\r\n");
+        if (headerEnd < 0) {
+            return;
+        }
+        qsizetype length = -1;
+        for (const QByteArray &line : buffer_.left(headerEnd).split('\n')) {
+            const QByteArray trimmed = line.trimmed();
+            if (trimmed.toLower().startsWith(kContentLength)) {
+                length = trimmed.mid(kContentLength.size()).trimmed().toLongLong();
+            }
+        }
+        const qsizetype bodyStart = headerEnd + 4;
+        if (length < 0) {
+            buffer_.remove(0, bodyStart);
+            continue;
+        }
+        if (buffer_.size() < bodyStart + length) {
+            return;
+        }
+        const QJsonDocument json = QJsonDocument::fromJson(buffer_.mid(bodyStart, length));
+        buffer_.remove(0, bodyStart + length);
+        if (json.isObject()) {
+            handleMessage(json.object());
+        }
+    }
+}
+
+void LspClient::handleMessage(const QJsonObject &message)
+{
+    const bool hasId = message.contains("id");
+    const QString method = message.value("method").toString();
+    if (hasId && !method.isEmpty()) {
+        // Server-to-client requests (progress tokens, configuration) only
+        // need an empty answer.
+        sendMessage(QJsonObject{{"jsonrpc", "2.0"}, {"id", message.value("id")}, {"result", QJsonValue()}});
+    } else if (hasId) {
+        handleResponse(message.value("id").toInteger(), message);
+    } else if (!method.isEmpty()) {
+        handleNotification(method, message.value("params").toObject());
+    }
+}
+
+void LspClient::handleResponse(qint64 id, const QJsonObject &message)
+{
+    const auto it = pending_.constFind(id);
+    if (it == pending_.cend()) {
+        return;
+    }
+    const PendingRequest request = *it;
+    pending_.erase(it);
+
+    const qint64 elapsed = request.timer.elapsed();
+    const QJsonObject error = message.value("error").toObject();
+    const bool cancelled = error.value("code").toInt() == kRequestCancelled;
+    qCDebug(lcLsp).noquote() << request.method << "#" << id << elapsed << "ms"
+                             << (cancelled ? "cancelled" : error.isEmpty() ? "" : "failed");
+    if (!cancelled) {
+        emit requestTraced(request.method, elapsed);
+    }
+
+    if (request.method == "initialize") {
+        if (!error.isEmpty()) {
+            emit statusMessage("Ошибка инициализации сервера: " + error.value("message").toString());
+            return;
+        }
+        initialized_ = true;
+        sendMessage(QJsonObject{{"jsonrpc", "2.0"}, {"method", "initialized"}, {"params", QJsonObject()}});
+        const QVector<QJsonObject> queued = std::exchange(queued_, {});
+        for (const QJsonObject &queuedMessage : queued) {
+            sendMessage(queuedMessage);
+        }
+        return;
+    }
+    if (!error.isEmpty() || request.version != version_ || !pendingChanges_.isEmpty()) {
+        return;
+    }
+
+    const QJsonValue result = message.value("result");
+    if (request.method == "textDocument/completion" && id == completionId_) {
+        completionId_ = -1;
+        const QJsonArray items = result.isArray() ? result.toArray() : result.toObject().value("items").toArray();
+        QVector<LspCompletionItem> completions;
+        completions.reserve(items.size());
+        for (const QJsonValue &value : items) {
+            const QJsonObject item = value.toObject();
+            LspCompletionItem completion;
+            completion.label = item.value("label").toString().trimmed();
+            completion.detail = item.value("detail").toString();
+            completion.insertText = item.value("textEdit").toObject().value("newText").toString();
+            if (completion.insertText.isEmpty()) {
+                completion.insertText = item.value("insertText").toString(completion.label);
+            }
+            completions.append(completion);
+        }
+        emit completionReady(request.position, completions);
+    } else if (request.method == "textDocument/hover" && id == hoverId_) {
+        hoverId_ = -1;
+        const QString text = hoverText(result.toObject().value("contents")).trimmed();
+        if (!text.isEmpty()) {
+            emit hoverReady(request.position, text);
+        }
+    }
+}
+
+void LspClient::handleNotification(const QString &method, const QJsonObject &params)
+{
+    if (method == "textDocument/publishDiagnostics") {
+        if (params.value("uri").toString() != uri_) {
+            return;
+        }
+        QVector<LspDiagnostic> diagnostics;
+        for (const QJsonValue &value : params.value("diagnostics").toArray()) {
+            const QJsonObject item = value.toObject();
+            const QJsonObject range = item.value("range").toObject();
+            const QJsonObject start = range.value("start").toObject();
+            const QJsonObject end = range.value("end").toObject();
+            LspDiagnostic diagnostic;
+            diagnostic.startLine = start.value("line").toInt();
+            diagnostic.startCharacter = start.value("character").toInt();
+            diagnostic.endLine = end.value("line").toInt();
+            diagnostic.endCharacter = end.value("character").toInt();
+            diagnostic.severity = item.value("severity").toInt(LspDiagnostic::Error);
+            diagnostic.message = item.value("message").toString();
+            diagnostic.source = item.value("source").toString();
+            diagnostics.append(diagnostic);
+        }
+        emit diagnosticsChanged(diagnostics);
+    } else if (method == "window/showMessage" && params.value("type").toInt() == 1) {
+        emit statusMessage(params.value("message").toString());
+    }
+}
+
+void LspClient::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    (void)exitStatus;
+    emit statusMessage(QString("Языковой сервер завершился (код %1)").arg(exitCode));
+    disconnect(changeConnection_);
+    document_ = nullptr;
+    uri_.clear();
+    mirror_.clear();
+    pendingChanges_ = QJsonArray();
+    queued_.clear();
+    pending_.clear();
+    initialized_ = false;
+    completionId_ = -1;
+    hoverId_ = -1;
+    process_->deleteLater();
+    process_ = nullptr;
+    rootPath_.clear();
+    emit diagnosticsChanged({});
+}
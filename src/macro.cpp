@@ -0,0 +1,775 @@
+#include "../headers/macro.h"
+
+#include <QTextEdit>
+#include <QKeyEvent>
+#include <QKeySequence>
+#include <QInputMethodEvent>
+#include <QApplication>
+#include <QClipboard>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr int kInitialGap = 4096;
+constexpr int kBackwardWindow = 4096;
+
+struct MoveBinding
+{
+    QKeySequence::StandardKey key;
+    QTextCursor::MoveOperation operation;
+    QTextCursor::MoveMode mode;
+};
+
+constexpr MoveBinding kMoveBindings[] = {
+    {QKeySequence::MoveToNextChar, QTextCursor::Right, QTextCursor::MoveAnchor},
+    {QKeySequence::MoveToPreviousChar, QTextCursor::Left, QTextCursor::MoveAnchor},
+    {QKeySequence::MoveToNextWord, QTextCursor::NextWord, QTextCursor::MoveAnchor},
+    {QKeySequence::MoveToPreviousWord, QTextCursor::PreviousWord, QTextCursor::MoveAnchor},
+    {QKeySequence::MoveToNextLine, QTextCursor::Down, QTextCursor::MoveAnchor},
+    {QKeySequence::MoveToPreviousLine, QTextCursor::Up, QTextCursor::MoveAnchor},
+    {QKeySequence::MoveToStartOfLine, QTextCursor::StartOfLine, QTextCursor::MoveAnchor},
+    {QKeySequence::MoveToEndOfLine, QTextCursor::EndOfLine, QTextCursor::MoveAnchor},
+    {QKeySequence::MoveToStartOfBlock, QTextCursor::StartOfBlock, QTextCursor::MoveAnchor},
+    {QKeySequence::MoveToEndOfBlock, QTextCursor::EndOfBlock, QTextCursor::MoveAnchor},
+    {QKeySequence::MoveToStartOfDocument, QTextCursor::Start, QTextCursor::MoveAnchor},
+    {QKeySequence::MoveToEndOfDocument, QTextCursor::End, QTextCursor::MoveAnchor},
+    {QKeySequence::SelectNextChar, QTextCursor::Right, QTextCursor::KeepAnchor},
+    {QKeySequence::SelectPreviousChar, QTextCursor::Left, QTextCursor::KeepAnchor},
+    {QKeySequence::SelectNextWord, QTextCursor::NextWord, QTextCursor::KeepAnchor},
+    {QKeySequence::SelectPreviousWord, QTextCursor::PreviousWord, QTextCursor::KeepAnchor},
+    {QKeySequence::SelectNextLine, QTextCursor::Down, QTextCursor::KeepAnchor},
+    {QKeySequence::SelectPreviousLine, QTextCursor::Up, QTextCursor::KeepAnchor},
+    {QKeySequence::SelectStartOfLine, QTextCursor::StartOfLine, QTextCursor::KeepAnchor},
+    {QKeySequence::SelectEndOfLine, QTextCursor::EndOfLine, QTextCursor::KeepAnchor},
+    {QKeySequence::SelectStartOfBlock, QTextCursor::StartOfBlock, QTextCursor::KeepAnchor},
+    {QKeySequence::SelectEndOfBlock, QTextCursor::EndOfBlock, QTextCursor::KeepAnchor},
+    {QKeySequence::SelectStartOfDocument, QTextCursor::Start, QTextCursor::KeepAnchor},
+    {QKeySequence::SelectEndOfDocument, QTextCursor::End, QTextCursor::KeepAnchor},
+};
+
+bool isWordChar(QChar ch)
+{
+    return ch.isLetterOrNumber() || ch == u'_';
+}
+
+// Gap buffer whose gap follows the replay cursor. Every edit is recorded as
+// a dirty span that remembers which range of the original text it replaced.
+// Spans left of the gap keep absolute positions and spans right of it keep
+// their distance from the end, so an edit at the gap never has to renumber
+// anything but the spans it touches.
+class MacroBuffer : public ITextSource
+{
+public:
+    explicit MacroBuffer(const QString &text)
+        : original_(text)
+    {
+        data_ = text;
+        data_.resize(text.size() + kInitialGap);
+        gapStart_ = static_cast<int>(text.size());
+        gapEnd_ = static_cast<int>(data_.size());
+    }
+
+    int length() const override { return static_cast<int>(data_.size()) - (gapEnd_ - gapStart_); }
+
+    QString text(TextRange range) const override
+    {
+        QString result;
+        result.reserve(range.length());
+        const int split = qBound(range.start, gapStart_, range.end);
+        result.append(QStringView(data_).sliced(range.start, split - range.start));
+        result.append(QStringView(data_).sliced(gapEnd_ + split - gapStart_, range.end - split));
+        return result;
+    }
+
+    TextRange lineRange(int position) const override
+    {
+        int start = position;
+        while (start > 0 && at(start - 1) != u'\n') {
+            --start;
+        }
+        int end = position;
+        const int size = length();
+        while (end < size && at(end) != u'\n') {
+            ++end;
+        }
+        return {start, end};
+    }
+
+    QChar at(int position) const
+    {
+        return data_.at(position < gapStart_ ? position : position + gapEnd_ - gapStart_);
+    }
+
+    // Text on either side of the gap after moveGap(position).
+    QStringView before() const { return QStringView(data_).first(gapStart_); }
+    QStringView after() const { return QStringView(data_).sliced(gapEnd_); }
+
+    void moveGap(int position)
+    {
+        QChar *data = data_.data();
+        if (position < gapStart_) {
+            const int count = gapStart_ - position;
+            std::memmove(data + gapEnd_ - count, data + position, count * sizeof(QChar));
+            gapStart_ -= count;
+            gapEnd_ -= count;
+            const int size = length();
+            while (!left_.isEmpty() && left_.back().position >= position) {
+                Span span = left_.takeLast();
+                leftDelta_ -= span.length - span.originLength;
+                span.position = size - span.position - span.length;
+                right_.append(span);
+            }
+        } else if (position > gapStart_) {
+            const int count = position - gapStart_;
+            std::memmove(data + gapStart_, data + gapEnd_, count * sizeof(QChar));
+            gapStart_ += count;
+            gapEnd_ += count;
+            const int size = length();
+            while (!right_.isEmpty() && size - right_.back().position - right_.back().length < position) {
+                Span span = right_.takeLast();
+                span.position = size - span.position - span.length;
+                leftDelta_ += span.length - span.originLength;
+                left_.append(span);
+            }
+        }
+    }
+
+    void replace(int from, int to, QStringView text)
+    {
+        moveGap(from);
+        const int size = length();
+
+        int start = from;
+        int end = to;
+        int delta = 0;
+        int origin = -1;
+        while (!left_.isEmpty() && left_.back().position + left_.back().length >= from) {
+            const Span span = left_.takeLast();
+            start = span.position;
+            end = qMax(end, span.position + span.length);
+            origin = span.origin;
+            delta += span.length - span.originLength;
+            leftDelta_ -= span.length - span.originLength;
+        }
+        if (origin < 0) {
+            origin = start - leftDelta_;
+        }
+        while (!right_.isEmpty()) {
+            const Span &span = right_.back();
+            const int spanStart = size - span.position - span.length;
+            if (spanStart > end) {
+                break;
+            }
+            end = qMax(end, spanStart + span.length);
+            delta += span.length - span.originLength;
+            right_.removeLast();
+        }
+
+        gapEnd_ += to - from;
+        reserveGap(static_cast<int>(text.size()));
+        std::memcpy(data_.data() + gapStart_, text.data(), text.size() * sizeof(QChar));
+        gapStart_ += static_cast<int>(text.size());
+
+        Span merged;
+        merged.position = start;
+        merged.length = end - start - (to - from) + static_cast<int>(text.size());
+        merged.origin = origin;
+        merged.originLength = end - start - delta;
+        leftDelta_ += merged.length - merged.originLength;
+        left_.append(merged);
+    }
+
+    QVector<EditToolEdit> edits() const
+    {
+        QVector<EditToolEdit> result;
+        result.reserve(left_.size() + right_.size());
+        const int size = length();
+        auto emitSpan = [&](const Span &span, int position) {
+            const QString text = this->text({position, position + span.length});
+            if (QStringView(original_).sliced(span.origin, span.originLength) != text) {
+                result.append({span.origin, span.originLength, text});
+            }
+        };
+        for (const Span &span : left_) {
+            emitSpan(span, span.position);
+        }
+        for (auto it = right_.crbegin(); it != right_.crend(); ++it) {
+            emitSpan(*it, size - it->position - it->length);
+        }
+        return result;
+    }
+
+private:
+    struct Span
+    {
+        int position = 0;
+        int length = 0;
+        int origin = 0;
+        int originLength = 0;
+    };
+
+    void reserveGap(int needed)
+    {
+        if (gapEnd_ - gapStart_ >= needed) {
+            return;
+        }
+        const int tail = static_cast<int>(data_.size()) - gapEnd_;
+        const int grow = qMax(needed, static_cast<int>(data_.size()) / 2 + kInitialGap);
+        data_.resize(data_.size() + grow);
+        QChar *data = data_.data();
+        std::memmove(data + gapEnd_ + grow, data + gapEnd_, tail * sizeof(QChar));
+        gapEnd_ += grow;
+    }
+
+    QString original_;
+    QString data_;
+    int gapStart_ = 0;
+    int gapEnd_ = 0;
+    int leftDelta_ = 0;
+    QVector<Span> left_;
+    QVector<Span> right_;
+};
+
+struct ReplayCursor
+{
+    int anchor = 0;
+    int position = 0;
+    int column = -1;
+
+    int start() const { return qMin(anchor, position); }
+    int end() const { return qMax(anchor, position); }
+    bool hasSelection() const { return anchor != position; }
+};
+
+class ReplayEngine
+{
+public:
+    ReplayEngine(MacroBuffer &buffer, ReplayCursor &cursor, EditToolControl &control)
+        : buffer_(buffer), cursor_(cursor), control_(control)
+    {
+    }
+
+    bool insert(const QString &text)
+    {
+        replace(cursor_.start(), cursor_.end(), text);
+        return true;
+    }
+
+    bool remove(int count, bool backward)
+    {
+        if (cursor_.hasSelection()) {
+            replace(cursor_.start(), cursor_.end(), {});
+            --count;
+        }
+        if (count <= 0) {
+            return true;
+        }
+        const int position = cursor_.position;
+        const int from = backward ? qMax(0, position - count) : position;
+        const int to = backward ? position : qMin(buffer_.length(), position + count);
+        if (from == to) {
+            return false;
+        }
+        replace(from, to, {});
+        return true;
+    }
+
+    bool move(QTextCursor::MoveOperation operation, QTextCursor::MoveMode mode, int count)
+    {
+        const bool vertical = operation == QTextCursor::Up || operation == QTextCursor::Down;
+        if (!vertical) {
+            cursor_.column = -1;
+        }
+        for (int i = 0; i < count; ++i) {
+            if (!moveOnce(operation, mode)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Searching looks only at the text on one side of the gap, so a match is
+    // never found across the cursor and word boundaries there are implied.
+    bool find(const TextSearcher &searcher, bool backward)
+    {
+        SearchMatch match;
+        if (!backward) {
+            buffer_.moveGap(cursor_.end());
+            const QStringView text = buffer_.after();
+            if (!searcher.findNext(text, 0, text.size(), match)) {
+                return false;
+            }
+            if (match.length == 0 && !searcher.findNext(text, 1, text.size(), match)) {
+                return false;
+            }
+            match.start += cursor_.end();
+        } else {
+            buffer_.moveGap(cursor_.start());
+            const QStringView text = buffer_.before();
+            QVector<SearchMatch> matches;
+            for (qsizetype window = kBackwardWindow; matches.isEmpty(); window *= 2) {
+                const qsizetype from = qMax<qsizetype>(0, text.size() - window);
+                searcher.findAll(text, from, text.size(), matches);
+                if (from == 0) {
+                    break;
+                }
+            }
+            if (matches.isEmpty()) {
+                return false;
+            }
+            match = matches.constLast();
+        }
+        cursor_.anchor = static_cast<int>(match.start);
+        cursor_.position = static_cast<int>(match.end());
+        cursor_.column = -1;
+        return true;
+    }
+
+    bool runTool(const IEditTool &tool)
+    {
+        const EditToolInput input = tool.snapshotSource(buffer_, {cursor_.start(), cursor_.end()});
+        const EditToolResult result = tool.compute(input, control_);
+        if (control_.isCanceled()) {
+            return false;
+        }
+        QVector<EditToolEdit> edits = result.edits;
+        std::sort(edits.begin(), edits.end(), [](const EditToolEdit &a, const EditToolEdit &b) {
+            return a.position > b.position;
+        });
+        for (const EditToolEdit &edit : edits) {
+            buffer_.replace(edit.position, edit.position + edit.length, edit.text);
+            shift(cursor_.anchor, edit);
+            shift(cursor_.position, edit);
+        }
+        if (result.placeCursor || !result.selection.isEmpty()) {
+            cursor_.anchor = result.selection.start;
+            cursor_.position = result.selection.end;
+        }
+        cursor_.column = -1;
+        return true;
+    }
+
+private:
+    static void shift(int &position, const EditToolEdit &edit)
+    {
+        const int delta = static_cast<int>(edit.text.size()) - edit.length;
+        if (position >= edit.position + edit.length) {
+            position += delta;
+        } else if (position > edit.position) {
+            position = edit.position + static_cast<int>(edit.text.size());
+        }
+    }
+
+    void replace(int from, int to, QStringView text)
+    {
+        buffer_.replace(from, to, text);
+        cursor_.anchor = cursor_.position = from + static_cast<int>(text.size());
+        cursor_.column = -1;
+    }
+
+    bool moveOnce(QTextCursor::MoveOperation operation, QTextCursor::MoveMode mode)
+    {
+        const int size = buffer_.length();
+        int position = cursor_.position;
+        bool relative = true;
+
+        switch (operation) {
+        case QTextCursor::Left:
+        case QTextCursor::PreviousCharacter:
+            if (mode == QTextCursor::MoveAnchor && cursor_.hasSelection()) {
+                position = cursor_.start();
+            } else if (position > 0) {
+                --position;
+            }
+            break;
+        case QTextCursor::Right:
+        case QTextCursor::NextCharacter:
+            if (mode == QTextCursor::MoveAnchor && cursor_.hasSelection()) {
+                position = cursor_.end();
+            } else if (position < size) {
+                ++position;
+            }
+            break;
+        case QTextCursor::Up:
+        case QTextCursor::Down: {
+            const TextRange line = buffer_.lineRange(position);
+            if (cursor_.column < 0) {
+                cursor_.column = position - line.start;
+            }
+            if (operation == QTextCursor::Up && line.start > 0) {
+                const TextRange target = buffer_.lineRange(line.start - 1);
+                position = qMin(target.start + cursor_.column, target.end);
+            } else if (operation == QTextCursor::Down && line.end < size) {
+                const TextRange target = buffer_.lineRange(line.end + 1);
+                position = qMin(target.start + cursor_.column, target.end);
+            }
+            break;
+        }
+        case QTextCursor::PreviousWord:
+        case QTextCursor::WordLeft:
+        case QTextCursor::StartOfWord:
+            while (position > 0 && !isWordChar(buffer_.at(position - 1))) {
+                --position;
+            }
+            while (position > 0 && isWordChar(buffer_.at(position - 1))) {
+                --position;
+            }
+            break;
+        case QTextCursor::NextWord:
+        case QTextCursor::WordRight:
+            while (position < size && isWordChar(buffer_.at(position))) {
+                ++position;
+            }
+            while (position < size && !isWordChar(buffer_.at(position))) {
+                ++position;
+            }
+            break;
+        case QTextCursor::EndOfWord:
+            while (position < size && isWordChar(buffer_.at(position))) {
+                ++position;
+            }
+            break;
+        case QTextCursor::StartOfLine:
+        case QTextCursor::StartOfBlock:
+            position = buffer_.lineRange(position).start;
+            relative = false;
+            break;
+        case QTextCursor::EndOfLine:
+        case QTextCursor::EndOfBlock:
+            position = buffer_.lineRange(position).end;
+            relative = false;
+            break;
+        case QTextCursor::Start:
+            position = 0;
+            relative = false;
+            break;
+        case QTextCursor::End:
+            position = size;
+            relative = false;
+            break;
+        default:
+            return false;
+        }
+
+        const bool collapsed = mode == QTextCursor::MoveAnchor && cursor_.hasSelection();
+        if (relative && position == cursor_.position && !collapsed) {
+            return false;
+        }
+        cursor_.position = position;
+        if (mode == QTextCursor::MoveAnchor) {
+            cursor_.anchor = position;
+        }
+        return true;
+    }
+
+    MacroBuffer &buffer_;
+    ReplayCursor &cursor_;
+    EditToolControl &control_;
+};
+
+}
+
+MacroRecorder::MacroRecorder(QTextEdit *textEdit, QObject *parent)
+    : QObject(parent), textEdit_(textEdit)
+{
+}
+
+void MacroRecorder::start()
+{
+    if (recording_) {
+        return;
+    }
+    steps_.clear();
+    recording_ = true;
+    textEdit_->installEventFilter(this);
+    emit recordingChanged(true);
+}
+
+void MacroRecorder::stop()
+{
+    if (!recording_) {
+        return;
+    }
+    recording_ = false;
+    textEdit_->removeEventFilter(this);
+    emit recordingChanged(false);
+}
+
+void MacroRecorder::recordTool(const QString &toolName)
+{
+    if (!recording_) {
+        return;
+    }
+    MacroStep step;
+    step.kind = MacroStep::Kind::Tool;
+    step.text = toolName;
+    append(step);
+}
+
+void MacroRecorder::recordFind(const SearchQuery &query, bool backward)
+{
+    if (!recording_ || query.isEmpty()) {
+        return;
+    }
+    MacroStep step;
+    step.kind = MacroStep::Kind::Find;
+    step.query = query;
+    step.backward = backward;
+    append(step);
+}
+
+// The filter only observes: the editor still handles every event itself.
+bool MacroRecorder::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == textEdit_ && !textEdit_->isReadOnly()) {
+        if (event->type() == QEvent::KeyPress) {
+            recordKey(static_cast<QKeyEvent *>(event));
+        } else if (event->type() == QEvent::InputMethod) {
+            const QString text = static_cast<QInputMethodEvent *>(event)->commitString();
+            if (!text.isEmpty()) {
+                MacroStep step;
+                step.text = text;
+                append(step);
+            }
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void MacroRecorder::recordKey(const QKeyEvent *event)
+{
+    for (const MoveBinding &binding : kMoveBindings) {
+        if (event->matches(binding.key)) {
+            recordMove(binding.operation, binding.mode);
+            return;
+        }
+    }
+
+    MacroStep step;
+    if (event->matches(QKeySequence::SelectAll)) {
+        recordMove(QTextCursor::Start, QTextCursor::MoveAnchor);
+        recordMove(QTextCursor::End, QTextCursor::KeepAnchor);
+        return;
+    }
+    if (event->matches(QKeySequence::Paste)) {
+        step.text = QApplication::clipboard()->text();
+        if (!step.text.isEmpty()) {
+            append(step);
+        }
+        return;
+    }
+    if (event->matches(QKeySequence::Cut)) {
+        if (textEdit_->textCursor().hasSelection()) {
+            step.kind = MacroStep::Kind::DeleteBackward;
+            append(step);
+        }
+        return;
+    }
+    if (event->matches(QKeySequence::DeleteStartOfWord)) {
+        if (!textEdit_->textCursor().hasSelection()) {
+            recordMove(QTextCursor::PreviousWord, QTextCursor::KeepAnchor);
+        }
+        step.kind = MacroStep::Kind::DeleteBackward;
+        append(step);
+        return;
+    }
+    if (event->matches(QKeySequence::DeleteEndOfWord)) {
+        if (!textEdit_->textCursor().hasSelection()) {
+            recordMove(QTextCursor::EndOfWord, QTextCursor::KeepAnchor);
+        }
+        step.kind = MacroStep::Kind::DeleteForward;
+        append(step);
+        return;
+    }
+    if (event->matches(QKeySequence::Delete)) {
+        step.kind = MacroStep::Kind::DeleteForward;
+        append(step);
+        return;
+    }
+    if (event->key() == Qt::Key_Backspace && !(event->modifiers() & ~Qt::ShiftModifier)) {
+        step.kind = MacroStep::Kind::DeleteBackward;
+        append(step);
+        return;
+    }
+    if (event->matches(QKeySequence::InsertParagraphSeparator) || event->matches(QKeySequence::InsertLineSeparator)) {
+        step.text = QStringLiteral("\n");
+        append(step);
+        return;
+    }
+
+    const QString text = event->text();
+    const bool command = event->modifiers() & (Qt::ControlModifier | Qt::MetaModifier);
+    if (!command && !text.isEmpty() && (text.at(0).isPrint() || text.at(0) == u'\t')) {
+        step.text = text;
+        append(step);
+    }
+}
+
+void MacroRecorder::recordMove(QTextCursor::MoveOperation operation, QTextCursor::MoveMode mode)
+{
+    MacroStep step;
+    step.kind = MacroStep::Kind::Move;
+    step.operation = operation;
+    step.mode = mode;
+    append(step);
+}
+
+void MacroRecorder::append(const MacroStep &step)
+{
+    if (!steps_.isEmpty()) {
+        MacroStep &last = steps_.last();
+        if (last.kind == step.kind) {
+            switch (step.kind) {
+            case MacroStep::Kind::Insert:
+                last.text += step.text;
+                return;
+            case MacroStep::Kind::DeleteBackward:
+            case MacroStep::Kind::DeleteForward:
+                last.count += step.count;
+                return;
+            case MacroStep::Kind::Move:
+                if (last.operation == step.operation && last.mode == step.mode) {
+                    last.count += step.count;
+                    return;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    steps_.append(step);
+}
+
+MacroReplayTool::MacroReplayTool(const QVector<MacroStep> &macro, const EditToolManager &tools, int iterations)
+    : iterations_(iterations)
+{
+    const std::vector<IEditTool *> available = tools.getAvailableTools();
+    for (const MacroStep &step : macro) {
+        CompiledStep compiled;
+        compiled.step = step;
+        if (step.kind == MacroStep::Kind::Tool) {
+            auto it = std::find_if(available.cbegin(), available.cend(), [&step](const IEditTool *tool) {
+                return tool->getName() == step.text;
+            });
+            if (it == available.cend()) {
+                error_ = QString("Неизвестный инструмент: %1").arg(step.text);
+                return;
+            }
+            compiled.tool = *it;
+        } else if (step.kind == MacroStep::Kind::Find) {
+            auto searcher = std::make_shared<TextSearcher>(step.query);
+            if (!searcher->isValid()) {
+                error_ = searcher->errorString();
+                return;
+            }
+            compiled.searcher = std::move(searcher);
+        }
+        steps_.append(compiled);
+    }
+    if (steps_.isEmpty()) {
+        error_ = "Макрос пуст";
+    }
+}
+
+MacroReplayTool::~MacroReplayTool() = default;
+
+bool MacroReplayTool::canExecute(IDocument *document, QTextEdit *textEdit) const
+{
+    return document && textEdit && !textEdit->isReadOnly() && isValid();
+}
+
+// The selection direction is not part of IDocument, so replay starts with the
+// cursor at the end of the selection.
+EditToolInput MacroReplayTool::snapshot(IDocument *document) const
+{
+    EditToolInput input;
+    input.text = document->getPlainText();
+    input.selection = document->hasSelection();
+    input.range = document->selectionRange();
+    return input;
+}
+
+EditToolResult MacroReplayTool::compute(const EditToolInput &input, EditToolControl &control) const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    MacroBuffer buffer(input.text);
+    ReplayCursor cursor;
+    cursor.anchor = input.range.start;
+    cursor.position = input.range.end;
+    ReplayEngine engine(buffer, cursor, control);
+
+    const bool untilEnd = iterations_ <= 0;
+    int done = 0;
+    int failedStep = -1;
+    int lastPercent = -1;
+    while (failedStep < 0 && (untilEnd || done < iterations_)) {
+        if (control.isCanceled()) {
+            return {};
+        }
+        const int remaining = buffer.length() - cursor.position;
+        for (int i = 0; i < steps_.size() && failedStep < 0; ++i) {
+            const CompiledStep &compiled = steps_.at(i);
+            const MacroStep &step = compiled.step;
+            bool ok = true;
+            switch (step.kind) {
+            case MacroStep::Kind::Insert:
+                ok = engine.insert(step.text);
+                break;
+            case MacroStep::Kind::DeleteBackward:
+                ok = engine.remove(step.count, true);
+                break;
+            case MacroStep::Kind::DeleteForward:
+                ok = engine.remove(step.count, false);
+                break;
+            case MacroStep::Kind::Move:
+                ok = engine.move(step.operation, step.mode, step.count);
+                break;
+            case MacroStep::Kind::Find:
+                ok = engine.find(*compiled.searcher, step.backward);
+                break;
+            case MacroStep::Kind::Tool:
+                ok = engine.runTool(*compiled.tool);
+                break;
+            }
+            if (!ok) {
+                failedStep = i;
+            }
+        }
+        if (control.isCanceled()) {
+            return {};
+        }
+        if (failedStep >= 0) {
+            break;
+        }
+        ++done;
+
+        const int left = buffer.length() - cursor.position;
+        const int percent = untilEnd ? 100 - static_cast<int>(qint64(left) * 100 / qMax(1, buffer.length()))
+                                     : static_cast<int>(qint64(done) * 100 / iterations_);
+        if (percent != lastPercent) {
+            control.setProgress(percent);
+            lastPercent = percent;
+        }
+        if (untilEnd && (left == 0 || left >= remaining)) {
+            break;
+        }
+    }
+
+    EditToolResult result;
+    result.edits = buffer.edits();
+    result.selection = TextRange{cursor.anchor, cursor.position};
+    result.placeCursor = true;
+    result.message = QString("Макрос: повторов %1, правок %2, %3 мс")
+                         .arg(done)
+                         .arg(result.edits.size())
+                         .arg(timer.elapsed());
+    if (failedStep >= 0 && done == 0) {
+        result.message += QString(" (шаг %1 не выполнен)").arg(failedStep + 1);
+    }
+    return result;
+}
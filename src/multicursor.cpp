@@ -0,0 +1,525 @@
+#include "../headers/multicursor.h"
+#include "../headers/selectionlayers.h"
+
+#include <QTextEdit>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QScrollBar>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+class CaretOverlay : public QWidget
+{
+public:
+    CaretOverlay(QWidget *parent, std::function<void(QPainter &)> paint)
+        : QWidget(parent), paint_(std::move(paint))
+    {
+        setAttribute(Qt::WA_TransparentForMouseEvents);
+        setAttribute(Qt::WA_NoSystemBackground);
+    }
+
+protected:
+    void paintEvent(QPaintEvent *event) override
+    {
+        Q_UNUSED(event)
+        QPainter painter(this);
+        paint_(painter);
+    }
+
+private:
+    std::function<void(QPainter &)> paint_;
+};
+
+int clampToBlock(int position, const QTextBlock &block)
+{
+    return qBound(block.position(), position, block.position() + block.length() - 1);
+}
+
+}
+
+MultiCursorController::MultiCursorController(QTextEdit *textEdit, QObject *parent)
+    : QObject(parent)
+    , textEdit_(textEdit)
+{
+    // A sibling of the viewport rather than a child, so viewport scrolling
+    // does not drag the painted carets along with it.
+    overlay_ = new CaretOverlay(textEdit_, [this](QPainter &painter) { paintCarets(painter); });
+    overlay_->setGeometry(textEdit_->viewport()->geometry());
+    overlay_->raise();
+
+    textEdit_->installEventFilter(this);
+    textEdit_->viewport()->installEventFilter(this);
+    connect(textEdit_->document(), &QTextDocument::contentsChange, this, &MultiCursorController::onContentsChange);
+    connect(textEdit_->verticalScrollBar(), &QScrollBar::valueChanged, overlay_, qOverload<>(&QWidget::update));
+    connect(textEdit_->horizontalScrollBar(), &QScrollBar::valueChanged, overlay_, qOverload<>(&QWidget::update));
+}
+
+MultiCursorController::~MultiCursorController() = default;
+
+int MultiCursorController::cursorCount() const
+{
+    return qMax(1, static_cast<int>(carets_.size()));
+}
+
+void MultiCursorController::addCaretAbove()
+{
+    addCaretVertically(QTextCursor::Up);
+}
+
+void MultiCursorController::addCaretBelow()
+{
+    addCaretVertically(QTextCursor::Down);
+}
+
+void MultiCursorController::clear()
+{
+    columnDrag_ = false;
+    if (carets_.isEmpty()) {
+        return;
+    }
+    carets_.clear();
+    SelectionLayers::of(textEdit_)->clearLayer(SelectionLayers::MultiCursorLayer);
+    overlay_->update();
+    emit cursorCountChanged(1);
+}
+
+bool MultiCursorController::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == textEdit_) {
+        switch (event->type()) {
+        case QEvent::ShortcutOverride:
+            if (isActive() && isHandledKey(static_cast<QKeyEvent *>(event))) {
+                event->accept();
+                return true;
+            }
+            break;
+        case QEvent::KeyPress:
+            return handleKey(static_cast<QKeyEvent *>(event));
+        case QEvent::Resize:
+            overlay_->setGeometry(textEdit_->viewport()->geometry());
+            break;
+        default:
+            break;
+        }
+        return false;
+    }
+    if (watched == textEdit_->viewport()) {
+        if (event->type() == QEvent::Resize) {
+            overlay_->setGeometry(textEdit_->viewport()->geometry());
+            return false;
+        }
+        return handleMouse(event);
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+bool MultiCursorController::isHandledKey(const QKeyEvent *event) const
+{
+    switch (event->key()) {
+    case Qt::Key_Escape:
+    case Qt::Key_Backspace:
+    case Qt::Key_Delete:
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+    case Qt::Key_Tab:
+    case Qt::Key_Left:
+    case Qt::Key_Right:
+    case Qt::Key_Up:
+    case Qt::Key_Down:
+    case Qt::Key_Home:
+    case Qt::Key_End:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool MultiCursorController::handleKey(QKeyEvent *event)
+{
+    if (!isActive()) {
+        return false;
+    }
+
+    const Qt::KeyboardModifiers modifiers = event->modifiers() & ~Qt::KeypadModifier;
+    const bool word = modifiers.testFlag(Qt::ControlModifier);
+    const auto mode = modifiers.testFlag(Qt::ShiftModifier) ? QTextCursor::KeepAnchor : QTextCursor::MoveAnchor;
+
+    switch (event->key()) {
+    case Qt::Key_Escape:
+        clear();
+        return true;
+    case Qt::Key_Backspace:
+        edit(EditKind::Backspace, QString());
+        return true;
+    case Qt::Key_Delete:
+        edit(EditKind::Delete, QString());
+        return true;
+    case Qt::Key_Return:
+    case Qt::Key_Enter:
+        edit(EditKind::Insert, QStringLiteral("\n"));
+        return true;
+    case Qt::Key_Tab:
+        edit(EditKind::Insert, QStringLiteral("\t"));
+        return true;
+    case Qt::Key_Left:
+        move(word ? QTextCursor::WordLeft : QTextCursor::Left, mode);
+        return true;
+    case Qt::Key_Right:
+        move(word ? QTextCursor::WordRight : QTextCursor::Right, mode);
+        return true;
+    case Qt::Key_Up:
+        move(QTextCursor::Up, mode);
+        return true;
+    case Qt::Key_Down:
+        move(QTextCursor::Down, mode);
+        return true;
+    case Qt::Key_Home:
+        move(word ? QTextCursor::Start : QTextCursor::StartOfLine, mode);
+        return true;
+    case Qt::Key_End:
+        move(word ? QTextCursor::End : QTextCursor::EndOfLine, mode);
+        return true;
+    case Qt::Key_Shift:
+    case Qt::Key_Control:
+    case Qt::Key_Alt:
+    case Qt::Key_Meta:
+        return false;
+    default:
+        break;
+    }
+
+    const QString text = event->text();
+    if (!text.isEmpty() && text.at(0).isPrint()
+        && !(modifiers & (Qt::ControlModifier | Qt::MetaModifier))) {
+        edit(EditKind::Insert, text);
+        return true;
+    }
+
+    clear();
+    return false;
+}
+
+bool MultiCursorController::handleMouse(QEvent *event)
+{
+    switch (event->type()) {
+    case QEvent::MouseButtonPress: {
+        auto *mouse = static_cast<QMouseEvent *>(event);
+        if (mouse->button() != Qt::LeftButton) {
+            return false;
+        }
+        if (!mouse->modifiers().testFlag(Qt::AltModifier)) {
+            clear();
+            return false;
+        }
+        adoptEditorCursor();
+        columnDrag_ = true;
+        dragMoved_ = false;
+        dragOrigin_ = mouse->position().toPoint();
+        return true;
+    }
+    case QEvent::MouseMove: {
+        if (!columnDrag_) {
+            return false;
+        }
+        const QPoint point = static_cast<QMouseEvent *>(event)->position().toPoint();
+        if (!dragMoved_ && (point - dragOrigin_).manhattanLength() < 4) {
+            return true;
+        }
+        dragMoved_ = true;
+        setColumnSelection(dragOrigin_, point);
+        return true;
+    }
+    case QEvent::MouseButtonRelease: {
+        if (!columnDrag_) {
+            return false;
+        }
+        columnDrag_ = false;
+        if (!dragMoved_) {
+            const int position = textEdit_->cursorForPosition(dragOrigin_).position();
+            addCaret(position, position);
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+// All spans are replaced inside one edit block, back to front so earlier
+// offsets stay valid; QTextDocument then lays out and signals the change
+// once. The new caret offsets come from a single forward pass that
+// accumulates the length delta of the preceding spans.
+void MultiCursorController::edit(EditKind kind, const QString &text)
+{
+    QElapsedTimer timer;
+    timer.start();
+    normalize();
+
+    QTextDocument *document = textEdit_->document();
+    const int limit = document->characterCount() - 1;
+    QVector<QPair<int, int>> spans;
+    spans.reserve(carets_.size());
+    int previousEnd = 0;
+    for (const Caret &caret : std::as_const(carets_)) {
+        int from = caret.start();
+        int to = caret.end();
+        if (!caret.hasSelection()) {
+            if (kind == EditKind::Backspace && from > 0) {
+                --from;
+                if (from > 0 && document->characterAt(from).isLowSurrogate()
+                    && document->characterAt(from - 1).isHighSurrogate()) {
+                    --from;
+                }
+            } else if (kind == EditKind::Delete && to < limit) {
+                ++to;
+                if (to < limit && document->characterAt(to - 1).isHighSurrogate()
+                    && document->characterAt(to).isLowSurrogate()) {
+                    ++to;
+                }
+            }
+        }
+        from = qMax(from, previousEnd);
+        to = qMax(to, from);
+        spans.append({from, to});
+        previousEnd = to;
+    }
+
+    applying_ = true;
+    QTextCursor cursor(document);
+    cursor.beginEditBlock();
+    for (qsizetype i = spans.size() - 1; i >= 0; --i) {
+        const auto [from, to] = spans.at(i);
+        if (from == to && text.isEmpty()) {
+            continue;
+        }
+        cursor.setPosition(from);
+        cursor.setPosition(to, QTextCursor::KeepAnchor);
+        if (text.isEmpty()) {
+            cursor.removeSelectedText();
+        } else {
+            cursor.insertText(text);
+        }
+    }
+    cursor.endEditBlock();
+    applying_ = false;
+
+    const auto inserted = static_cast<int>(text.size());
+    int delta = 0;
+    for (qsizetype i = 0; i < carets_.size(); ++i) {
+        const auto [from, to] = spans.at(i);
+        const int position = from + delta + inserted;
+        carets_[i].anchor = position;
+        carets_[i].position = position;
+        delta += inserted - (to - from);
+    }
+
+    emit editApplied(static_cast<int>(carets_.size()), timer.nsecsElapsed());
+    normalize();
+    syncPrimary();
+    refresh();
+}
+
+void MultiCursorController::move(QTextCursor::MoveOperation operation, QTextCursor::MoveMode mode)
+{
+    QTextCursor cursor(textEdit_->document());
+    for (Caret &caret : carets_) {
+        if (mode == QTextCursor::MoveAnchor && caret.hasSelection()
+            && (operation == QTextCursor::Left || operation == QTextCursor::Right)) {
+            caret.position = operation == QTextCursor::Left ? caret.start() : caret.end();
+            caret.anchor = caret.position;
+            continue;
+        }
+        cursor.setPosition(caret.anchor);
+        cursor.setPosition(caret.position, QTextCursor::KeepAnchor);
+        cursor.movePosition(operation, mode);
+        caret.anchor = cursor.anchor();
+        caret.position = cursor.position();
+    }
+    normalize();
+    syncPrimary();
+    refresh();
+}
+
+void MultiCursorController::addCaret(int anchor, int position)
+{
+    adoptEditorCursor();
+    carets_.append({anchor, position, false});
+    normalize();
+    syncPrimary();
+    refresh();
+}
+
+void MultiCursorController::addCaretVertically(QTextCursor::MoveOperation operation)
+{
+    adoptEditorCursor();
+    const auto extreme = operation == QTextCursor::Up
+                             ? std::min_element(carets_.cbegin(), carets_.cend(), [](const Caret &a, const Caret &b) {
+                                   return a.position < b.position;
+                               })
+                             : std::max_element(carets_.cbegin(), carets_.cend(), [](const Caret &a, const Caret &b) {
+                                   return a.position < b.position;
+                               });
+    QTextCursor cursor(textEdit_->document());
+    cursor.setPosition(extreme->position);
+    if (!cursor.movePosition(operation)) {
+        return;
+    }
+    addCaret(cursor.position(), cursor.position());
+}
+
+void MultiCursorController::setColumnSelection(const QPoint &from, const QPoint &to)
+{
+    const QTextBlock first = textEdit_->cursorForPosition(QPoint(from.x(), qMin(from.y(), to.y()))).block();
+    const QTextBlock last = textEdit_->cursorForPosition(QPoint(from.x(), qMax(from.y(), to.y()))).block();
+    const QTextBlock primaryBlock = textEdit_->cursorForPosition(to).block();
+
+    carets_.clear();
+    for (QTextBlock block = first; block.isValid(); block = block.next()) {
+        const int y = textEdit_->cursorRect(QTextCursor(block)).center().y();
+        const int anchor = clampToBlock(textEdit_->cursorForPosition(QPoint(from.x(), y)).position(), block);
+        const int position = clampToBlock(textEdit_->cursorForPosition(QPoint(to.x(), y)).position(), block);
+        carets_.append({anchor, position, block == primaryBlock});
+        if (block == last) {
+            break;
+        }
+    }
+    if (!carets_.isEmpty() && std::none_of(carets_.cbegin(), carets_.cend(), [](const Caret &c) { return c.primary; })) {
+        carets_.last().primary = true;
+    }
+    normalize();
+    syncPrimary();
+    refresh();
+}
+
+void MultiCursorController::adoptEditorCursor()
+{
+    if (carets_.isEmpty()) {
+        const QTextCursor cursor = textEdit_->textCursor();
+        carets_.append({cursor.anchor(), cursor.position(), true});
+    }
+}
+
+void MultiCursorController::normalize()
+{
+    const int limit = qMax(0, textEdit_->document()->characterCount() - 1);
+    for (Caret &caret : carets_) {
+        caret.anchor = qBound(0, caret.anchor, limit);
+        caret.position = qBound(0, caret.position, limit);
+    }
+    std::sort(carets_.begin(), carets_.end(), [](const Caret &a, const Caret &b) {
+        return a.start() < b.start() || (a.start() == b.start() && a.end() < b.end());
+    });
+
+    QVector<Caret> merged;
+    merged.reserve(carets_.size());
+    for (const Caret &caret : std::as_const(carets_)) {
+        if (!merged.isEmpty()) {
+            Caret &previous = merged.last();
+            const bool overlaps = caret.start() < previous.end()
+                                  || (caret.start() == previous.end() && (!caret.hasSelection() || !previous.hasSelection()));
+            if (overlaps) {
+                const int start = previous.start();
+                const int end = qMax(previous.end(), caret.end());
+                const bool forward = previous.position >= previous.anchor;
+                previous.anchor = forward ? start : end;
+                previous.position = forward ? end : start;
+                previous.primary = previous.primary || caret.primary;
+                continue;
+            }
+        }
+        merged.append(caret);
+    }
+    carets_ = merged;
+}
+
+void MultiCursorController::syncPrimary()
+{
+    const auto primary = std::find_if(carets_.cbegin(), carets_.cend(), [](const Caret &c) { return c.primary; });
+    if (primary == carets_.cend()) {
+        return;
+    }
+    QTextCursor cursor(textEdit_->document());
+    cursor.setPosition(primary->anchor);
+    cursor.setPosition(primary->position, QTextCursor::KeepAnchor);
+    textEdit_->setTextCursor(cursor);
+    textEdit_->ensureCursorVisible();
+}
+
+void MultiCursorController::refresh()
+{
+    if (carets_.size() <= 1) {
+        clear();
+        return;
+    }
+
+    QList<QTextEdit::ExtraSelection> selections;
+    QTextCharFormat format;
+    format.setBackground(textEdit_->palette().highlight());
+    format.setForeground(textEdit_->palette().highlightedText());
+    for (const Caret &caret : std::as_const(carets_)) {
+        if (caret.primary || !caret.hasSelection()) {
+            continue;
+        }
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(textEdit_->document());
+        selection.cursor.setPosition(caret.anchor);
+        selection.cursor.setPosition(caret.position, QTextCursor::KeepAnchor);
+        selection.format = format;
+        selections.append(selection);
+    }
+    SelectionLayers::of(textEdit_)->setLayer(SelectionLayers::MultiCursorLayer, selections);
+    overlay_->update();
+    emit cursorCountChanged(static_cast<int>(carets_.size()));
+}
+
+void MultiCursorController::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    if (applying_ || carets_.isEmpty()) {
+        return;
+    }
+    const auto shift = [position, charsRemoved, charsAdded](int offset) {
+        if (offset >= position + charsRemoved) {
+            return offset + charsAdded - charsRemoved;
+        }
+        return offset > position ? position + charsAdded : offset;
+    };
+    for (Caret &caret : carets_) {
+        caret.anchor = shift(caret.anchor);
+        caret.position = shift(caret.position);
+    }
+    normalize();
+    refresh();
+}
+
+// Only carets inside the viewport are painted; the sorted order lets the
+// first one be found by binary search.
+void MultiCursorController::paintCarets(QPainter &painter) const
+{
+    if (!isActive()) {
+        return;
+    }
+    const QWidget *viewport = textEdit_->viewport();
+    const int first = textEdit_->cursorForPosition(QPoint(0, 0)).position();
+    const int last = textEdit_->cursorForPosition(QPoint(viewport->width(), viewport->height())).position();
+    auto it = std::lower_bound(carets_.cbegin(), carets_.cend(), first, [](const Caret &caret, int offset) {
+        return caret.end() < offset;
+    });
+
+    const QColor color = textEdit_->palette().color(QPalette::Text);
+    const int width = qMax(1, textEdit_->cursorWidth());
+    QTextCursor cursor(textEdit_->document());
+    for (; it != carets_.cend() && it->start() <= last; ++it) {
+        if (it->primary) {
+            continue;
+        }
+        cursor.setPosition(it->position);
+        const QRect rect = textEdit_->cursorRect(cursor);
+        painter.fillRect(QRect(rect.left(), rect.top(), width, rect.height()), color);
+    }
+}
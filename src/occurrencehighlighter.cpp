@@ -0,0 +1,245 @@
+#include "../headers/occurrencehighlighter.h"
+#include "../headers/selectionlayers.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QPromise>
+#include <QTextEdit>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QScrollBar>
+
+namespace {
+
+constexpr int kVisibleDelayMs = 120;
+constexpr int kCountDelayMs = 500;
+constexpr int kMarginBlocks = 100;
+constexpr qsizetype kMaxHighlights = 2000;
+constexpr qsizetype kMaxTermLength = 200;
+constexpr qsizetype kCountChunk = qsizetype(4) << 20;
+
+void findVisible(QPromise<OccurrenceBatch> &promise, const QString &text, qsizetype base,
+                 const SearchQuery &query, quint64 generation)
+{
+    const TextSearcher searcher(query);
+    OccurrenceBatch batch;
+    batch.generation = generation;
+    if (promise.isCanceled() || !searcher.isValid()) {
+        return;
+    }
+    searcher.findAll(text, 0, text.size(), batch.matches, kMaxHighlights);
+    for (SearchMatch &match : batch.matches) {
+        match.start += base;
+    }
+    promise.addResult(std::move(batch));
+}
+
+void countAll(QPromise<OccurrenceCount> &promise, const QString &text, const SearchQuery &query)
+{
+    const TextSearcher searcher(query);
+    if (!searcher.isValid()) {
+        return;
+    }
+
+    OccurrenceCount count;
+    count.total = text.size();
+    QVector<SearchMatch> matches;
+    qsizetype pos = 0;
+    while (pos < text.size()) {
+        if (promise.isCanceled()) {
+            return;
+        }
+        const qsizetype chunkEnd = qMin(text.size(), pos + kCountChunk);
+        matches.clear();
+        count.count += searcher.findAll(text, pos, chunkEnd, matches);
+        pos = matches.isEmpty() ? chunkEnd : qMax(chunkEnd, matches.last().end());
+        count.scanned = pos;
+        promise.addResult(count);
+    }
+}
+
+}
+
+OccurrenceHighlighter::OccurrenceHighlighter(QTextEdit *textEdit, QObject *parent)
+    : QObject(parent)
+    , textEdit_(textEdit)
+{
+    visibleTimer_.setSingleShot(true);
+    visibleTimer_.setInterval(kVisibleDelayMs);
+    countTimer_.setSingleShot(true);
+    countTimer_.setInterval(kCountDelayMs);
+
+    connect(&visibleTimer_, &QTimer::timeout, this, &OccurrenceHighlighter::startVisibleJob);
+    connect(&countTimer_, &QTimer::timeout, this, &OccurrenceHighlighter::startCountJob);
+    connect(&visibleWatcher_, &QFutureWatcher<OccurrenceBatch>::finished, this, &OccurrenceHighlighter::onVisibleReady);
+    connect(&countWatcher_, &QFutureWatcher<OccurrenceCount>::resultReadyAt, this, &OccurrenceHighlighter::onCountProgress);
+    connect(&countWatcher_, &QFutureWatcher<OccurrenceCount>::finished, this, &OccurrenceHighlighter::onCountFinished);
+
+    connect(textEdit_, &QTextEdit::cursorPositionChanged, this, &OccurrenceHighlighter::schedule);
+    connect(textEdit_, &QTextEdit::selectionChanged, this, &OccurrenceHighlighter::schedule);
+    connect(textEdit_->verticalScrollBar(), &QScrollBar::valueChanged, this, &OccurrenceHighlighter::schedule);
+    connect(textEdit_->document(), &QTextDocument::contentsChange, this, &OccurrenceHighlighter::onContentsChange);
+}
+
+OccurrenceHighlighter::~OccurrenceHighlighter()
+{
+    visibleWatcher_.cancel();
+    countWatcher_.cancel();
+    visibleWatcher_.waitForFinished();
+    countWatcher_.waitForFinished();
+}
+
+void OccurrenceHighlighter::setEnabled(bool enabled)
+{
+    enabled_ = enabled;
+    if (enabled_) {
+        schedule();
+    } else {
+        clear();
+    }
+}
+
+void OccurrenceHighlighter::clear()
+{
+    ++generation_;
+    visibleTimer_.stop();
+    countTimer_.stop();
+    visibleWatcher_.cancel();
+    countWatcher_.cancel();
+    term_ = SearchQuery();
+    SelectionLayers::of(textEdit_)->clearLayer(SelectionLayers::OccurrenceLayer);
+    emit countChanged(QString());
+}
+
+void OccurrenceHighlighter::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(position)
+    if (charsRemoved != 0 || charsAdded != 0) {
+        ++contentsRevision_;
+    }
+}
+
+void OccurrenceHighlighter::schedule()
+{
+    if (!enabled_) {
+        return;
+    }
+    ++generation_;
+    visibleWatcher_.cancel();
+    visibleTimer_.start();
+}
+
+SearchQuery OccurrenceHighlighter::termUnderCursor() const
+{
+    SearchQuery query;
+    query.options.caseSensitive = true;
+
+    QTextCursor cursor = textEdit_->textCursor();
+    if (cursor.hasSelection()) {
+        const QString selected = cursor.selectedText();
+        if (selected.size() <= kMaxTermLength && !selected.contains(QChar::ParagraphSeparator)
+            && !selected.trimmed().isEmpty()) {
+            query.pattern = selected;
+        }
+        return query;
+    }
+
+    cursor.select(QTextCursor::WordUnderCursor);
+    const QString word = cursor.selectedText();
+    if (word.size() >= 2 && (word.at(0).isLetterOrNumber() || word.at(0) == u'_')) {
+        query.pattern = word;
+        query.options.wholeWords = true;
+    }
+    return query;
+}
+
+void OccurrenceHighlighter::startVisibleJob()
+{
+    const SearchQuery term = termUnderCursor();
+    if (term.isEmpty()) {
+        clear();
+        return;
+    }
+    if (term.pattern != term_.pattern || !(term.options == term_.options)) {
+        term_ = term;
+        countWatcher_.cancel();
+        countTimer_.start();
+    } else if (countedRevision_ != contentsRevision_ && !countWatcher_.isRunning()) {
+        countTimer_.start();
+    }
+
+    const QRect viewport = textEdit_->viewport()->rect();
+    QTextBlock block = textEdit_->cursorForPosition(viewport.topLeft()).block();
+    const QTextBlock lastVisible = textEdit_->cursorForPosition(viewport.bottomRight()).block();
+    for (int i = 0; i < kMarginBlocks && block.previous().isValid(); ++i) {
+        block = block.previous();
+    }
+    const qsizetype base = block.position();
+    const int lastNumber = lastVisible.blockNumber() + kMarginBlocks;
+
+    QString text;
+    for (; block.isValid() && block.blockNumber() <= lastNumber; block = block.next()) {
+        text += block.text();
+        text += QChar(u'\n');
+    }
+    visibleWatcher_.setFuture(QtConcurrent::run(findVisible, text, base, term_, generation_));
+}
+
+void OccurrenceHighlighter::onVisibleReady()
+{
+    if (visibleWatcher_.isCanceled() || visibleWatcher_.future().resultCount() == 0) {
+        return;
+    }
+    const OccurrenceBatch batch = visibleWatcher_.result();
+    if (batch.generation != generation_) {
+        return;
+    }
+
+    QTextCharFormat format;
+    format.setBackground(QColor(200, 225, 255));
+
+    QList<QTextEdit::ExtraSelection> selections;
+    selections.reserve(batch.matches.size());
+    for (const SearchMatch &match : batch.matches) {
+        QTextEdit::ExtraSelection selection;
+        selection.cursor = QTextCursor(textEdit_->document());
+        selection.cursor.setPosition(static_cast<int>(match.start));
+        selection.cursor.setPosition(static_cast<int>(match.end()), QTextCursor::KeepAnchor);
+        selection.format = format;
+        selections.append(selection);
+    }
+    SelectionLayers::of(textEdit_)->setLayer(SelectionLayers::OccurrenceLayer,
+                                             selections.size() > 1 ? selections : QList<QTextEdit::ExtraSelection>());
+}
+
+void OccurrenceHighlighter::startCountJob()
+{
+    if (term_.isEmpty()) {
+        return;
+    }
+    countWatcher_.cancel();
+    countWatcher_.waitForFinished();
+    countedTerm_ = term_;
+    countedRevision_ = contentsRevision_;
+    countWatcher_.setFuture(QtConcurrent::run(countAll, textEdit_->document()->toPlainText(), term_));
+}
+
+void OccurrenceHighlighter::onCountProgress(int resultIndex)
+{
+    const OccurrenceCount count = countWatcher_.resultAt(resultIndex);
+    if (count.scanned >= count.total || count.scanned == 0) {
+        return;
+    }
+    const auto estimate = static_cast<qsizetype>(double(count.count) * count.total / count.scanned);
+    emit countChanged(QString("Вхождений: ~%1").arg(estimate));
+}
+
+void OccurrenceHighlighter::onCountFinished()
+{
+    const int results = countWatcher_.future().resultCount();
+    if (countWatcher_.isCanceled() || results == 0) {
+        return;
+    }
+    const OccurrenceCount count = countWatcher_.resultAt(results - 1);
+    emit countChanged(QString("Вхождений «%1»: %2").arg(countedTerm_.pattern.left(40)).arg(count.count));
+}
@@ -12,9 +12,12 @@
 #include <QAbstractTextDocumentLayout>
 #include <QDir>
 #include <QDialog>
-#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QShortcut>
+#include <QKeySequence>
 #include <QtPdf/QPdfDocument>
-#include <QtPdfWidgets/QPdfView>
+#include <QtPdf/QPdfSelection>
+#include "pdfsearch.h"
 
 namespace {
 
@@ -114,13 +117,25 @@ bool PdfHandler::load(const QString &filePath,
     auto *pdfDocument = new QPdfDocument(dialog);
     pdfDocument->load(filePath);
     if (pdfDocument->status() != QPdfDocument::Status::Error) {
-        auto *view = new QPdfView(dialog);
+        auto *view = new PdfSearchView(dialog);
         view->setDocument(pdfDocument);
         view->setZoomFactor(1.0);
 
-        auto *layout = new QVBoxLayout(dialog);
+        auto *searchPanel = new PdfSearchPanel(view, dialog);
+        searchPanel->setDocumentFile(filePath);
+        searchPanel->setMinimumWidth(260);
+        searchPanel->hide();
+
+        auto *layout = new QHBoxLayout(dialog);
         layout->setContentsMargins(0, 0, 0, 0);
-        layout->addWidget(view);
+        layout->addWidget(view, 1);
+        layout->addWidget(searchPanel);
+
+        auto *findShortcut = new QShortcut(QKeySequence::Find, dialog);
+        QObject::connect(findShortcut, &QShortcut::activated, searchPanel, [searchPanel]() {
+            searchPanel->show();
+            searchPanel->activate();
+        });
 
         dialog->resize(900, 700);
         dialog->show();
@@ -199,4 +214,22 @@ bool PdfHandler::save(const QString &filePath,
     return true;
 }
 
+bool PdfHandler::extractText(const QString &filePath,
+                             QString &text,
+                             QString &error) const
+{
+    QPdfDocument pdfDocument;
+    pdfDocument.load(filePath);
+    if (pdfDocument.status() != QPdfDocument::Status::Ready) {
+        error = QObject::tr("Не удалось загрузить PDF-файл '%1'").arg(filePath);
+        return false;
+    }
 
+    QStringList pages;
+    pages.reserve(pdfDocument.pageCount());
+    for (int page = 0; page < pdfDocument.pageCount(); ++page) {
+        pages << pdfDocument.getAllText(page).text();
+    }
+    text = pages.join(QLatin1Char('\n'));
+    return true;
+}
@@ -0,0 +1,377 @@
+#include "../headers/pdfsearch.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QPromise>
+#include <QtPdf/QPdfDocument>
+#include <QtPdf/QPdfSelection>
+#include <QtPdf/QPdfPageNavigator>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QScrollBar>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QLineEdit>
+#include <QListWidget>
+#include <QLabel>
+#include <QTimer>
+#include <QVBoxLayout>
+
+namespace {
+
+constexpr int kContextChars = 30;
+constexpr int kMaxCachedQueries = 64;
+constexpr int kMaxListedHits = 5000;
+
+// Hit offsets index the page text, so every code point is folded on its
+// own and kept as is when its folding would need a different number of
+// UTF-16 units.
+QString foldForSearch(const QString &text)
+{
+    QString folded = text;
+    QChar *data = folded.data();
+    const qsizetype size = folded.size();
+    for (qsizetype i = 0; i < size; ++i) {
+        if (data[i].isHighSurrogate() && i + 1 < size && data[i + 1].isLowSurrogate()) {
+            const char32_t code = QChar::surrogateToUcs4(data[i], data[i + 1]);
+            const char32_t fold = QChar::toCaseFolded(code);
+            if (QChar::requiresSurrogates(fold)) {
+                data[i] = QChar(QChar::highSurrogate(fold));
+                data[i + 1] = QChar(QChar::lowSurrogate(fold));
+            }
+            ++i;
+            continue;
+        }
+        const char32_t fold = QChar::toCaseFolded(data[i].unicode());
+        if (!QChar::requiresSurrogates(fold)) {
+            data[i] = QChar(static_cast<char16_t>(fold));
+        }
+    }
+    return folded;
+}
+
+QString makeContext(const QString &pageText, int offset, int length)
+{
+    const int from = qMax(0, offset - kContextChars);
+    const int to = qMin(static_cast<int>(pageText.size()), offset + length + kContextChars);
+    QString context = pageText.mid(from, to - from).simplified();
+    if (from > 0) {
+        context.prepend(QStringLiteral("…"));
+    }
+    if (to < pageText.size()) {
+        context.append(QStringLiteral("…"));
+    }
+    return context;
+}
+
+void extractPages(QPromise<PdfPageText> &promise, const QString &filePath)
+{
+    QPdfDocument document;
+    document.load(filePath);
+    if (document.status() != QPdfDocument::Status::Ready) {
+        return;
+    }
+
+    const int pageCount = document.pageCount();
+    promise.setProgressRange(0, pageCount);
+    for (int page = 0; page < pageCount; ++page) {
+        if (promise.isCanceled()) {
+            return;
+        }
+        promise.addResult(PdfPageText{page, document.getAllText(page).text()});
+        promise.setProgressValue(page + 1);
+    }
+}
+
+}
+
+PdfTextIndex::PdfTextIndex(QObject *parent)
+    : QObject(parent)
+{
+    connect(&watcher_, &QFutureWatcher<PdfPageText>::resultReadyAt, this, &PdfTextIndex::onPageReady);
+    connect(&watcher_, &QFutureWatcher<PdfPageText>::progressRangeChanged, this, [this](int, int maximum) {
+        pageCount_ = maximum;
+    });
+    connect(&watcher_, &QFutureWatcher<PdfPageText>::finished, this, [this]() {
+        pageCount_ = indexedPageCount();
+        emit indexingFinished();
+    });
+}
+
+PdfTextIndex::~PdfTextIndex()
+{
+    cancel();
+}
+
+void PdfTextIndex::build(const QString &filePath)
+{
+    cancel();
+    pages_.clear();
+    foldedPages_.clear();
+    cache_.clear();
+    pageCount_ = -1;
+
+    watcher_.setFuture(QtConcurrent::run(extractPages, filePath));
+}
+
+void PdfTextIndex::cancel()
+{
+    if (watcher_.isRunning()) {
+        watcher_.cancel();
+        watcher_.waitForFinished();
+    }
+}
+
+void PdfTextIndex::onPageReady(int resultIndex)
+{
+    PdfPageText pageText = watcher_.resultAt(resultIndex);
+    if (pageText.page != pages_.size()) {
+        return;
+    }
+    foldedPages_.push_back(foldForSearch(pageText.text));
+    pages_.push_back(std::move(pageText.text));
+    emit pageIndexed(pageText.page);
+}
+
+QVector<PdfSearchHit> PdfTextIndex::search(const QString &query)
+{
+    const QString foldedQuery = foldForSearch(query);
+    if (foldedQuery.isEmpty()) {
+        return {};
+    }
+
+    const int indexed = indexedPageCount();
+    auto it = cache_.find(foldedQuery);
+    if (it == cache_.end()) {
+        if (cache_.size() >= kMaxCachedQueries) {
+            cache_.clear();
+        }
+        it = cache_.insert(foldedQuery, CachedResult{});
+    }
+
+    if (it->coveredPages < indexed) {
+        searchPages(foldedQuery, it->coveredPages, indexed, it->hits);
+        it->coveredPages = indexed;
+    }
+    return it->hits;
+}
+
+void PdfTextIndex::searchPages(const QString &foldedQuery, int fromPage, int toPage, QVector<PdfSearchHit> &hits) const
+{
+    const auto queryLength = static_cast<int>(foldedQuery.size());
+    for (int page = fromPage; page < toPage; ++page) {
+        const QString &folded = foldedPages_.at(page);
+        qsizetype pos = folded.indexOf(foldedQuery);
+        while (pos >= 0) {
+            const auto offset = static_cast<int>(pos);
+            hits.push_back(PdfSearchHit{page, offset, queryLength, makeContext(pages_.at(page), offset, queryLength)});
+            pos = folded.indexOf(foldedQuery, pos + queryLength);
+        }
+    }
+}
+
+PdfSearchView::PdfSearchView(QWidget *parent)
+    : QPdfView(parent)
+{
+}
+
+void PdfSearchView::showHit(const PdfSearchHit &hit)
+{
+    if (!document() || hit.page < 0) {
+        return;
+    }
+
+    const QPdfSelection selection = document()->getSelectionAtIndex(hit.page, hit.offset, hit.length);
+    highlightPage_ = hit.page;
+    highlightBounds_ = selection.bounds();
+
+    QPointF location;
+    if (!highlightBounds_.isEmpty()) {
+        const QRectF rect = highlightBounds_.first().boundingRect();
+        location = QPointF(qMax<qreal>(0, rect.left() - 36), qMax<qreal>(0, rect.top() - 72));
+    }
+    pageNavigator()->jump(hit.page, location, zoomFactor());
+    viewport()->update();
+}
+
+void PdfSearchView::clearHighlight()
+{
+    highlightPage_ = -1;
+    highlightBounds_.clear();
+    viewport()->update();
+}
+
+QRect PdfSearchView::pageGeometry(int page) const
+{
+    if (!document() || page < 0 || page >= document()->pageCount()) {
+        return QRect();
+    }
+
+    const QScreen *screen = QGuiApplication::primaryScreen();
+    const qreal screenResolution = screen ? screen->logicalDotsPerInch() / 72.0 : 1.0;
+    const QMargins margins = documentMargins();
+
+    auto pageSize = [&](int index) {
+        const QSizeF pointSize = document()->pagePointSize(index) * screenResolution;
+        if (zoomMode() == ZoomMode::FitToWidth && pointSize.width() > 0) {
+            const qreal factor = (viewport()->width() - margins.left() - margins.right()) / pointSize.width();
+            return (pointSize * factor).toSize();
+        }
+        if (zoomMode() == ZoomMode::FitInView && pointSize.width() > 0 && pointSize.height() > 0) {
+            const QSizeF available(viewport()->width() - margins.left() - margins.right(),
+                                   viewport()->height() - margins.top() - margins.bottom());
+            const qreal factor = qMin(available.width() / pointSize.width(), available.height() / pointSize.height());
+            return (pointSize * factor).toSize();
+        }
+        return (pointSize * zoomFactor()).toSize();
+    };
+
+    const bool singlePage = pageMode() == PageMode::SinglePage;
+    const int firstPage = singlePage ? pageNavigator()->currentPage() : 0;
+    const int lastPage = singlePage ? firstPage + 1 : document()->pageCount();
+    if (page < firstPage || page >= lastPage) {
+        return QRect();
+    }
+
+    int totalWidth = 0;
+    int pageY = margins.top();
+    QSize targetSize;
+    for (int index = firstPage; index < lastPage; ++index) {
+        const QSize size = pageSize(index);
+        totalWidth = qMax(totalWidth, size.width());
+        if (index < page) {
+            pageY += size.height() + pageSpacing();
+        } else if (index == page) {
+            targetSize = size;
+        }
+    }
+    totalWidth += margins.left() + margins.right();
+
+    const int pageX = (qMax(totalWidth, viewport()->width()) - targetSize.width()) / 2;
+    return QRect(QPoint(pageX, pageY), targetSize);
+}
+
+void PdfSearchView::paintEvent(QPaintEvent *event)
+{
+    QPdfView::paintEvent(event);
+
+    if (highlightPage_ < 0 || highlightBounds_.isEmpty() || !document()) {
+        return;
+    }
+
+    const QRect geometry = pageGeometry(highlightPage_)
+                               .translated(-horizontalScrollBar()->value(), -verticalScrollBar()->value());
+    const QSizeF pointSize = document()->pagePointSize(highlightPage_);
+    if (geometry.isEmpty() || pointSize.isEmpty()) {
+        return;
+    }
+
+    QPainter painter(viewport());
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.translate(geometry.topLeft());
+    painter.scale(geometry.width() / pointSize.width(), geometry.height() / pointSize.height());
+    painter.setPen(Qt::NoPen);
+    painter.setBrush(QColor(255, 200, 0, 110));
+    for (const QPolygonF &polygon : highlightBounds_) {
+        painter.drawPolygon(polygon);
+    }
+}
+
+PdfSearchPanel::PdfSearchPanel(PdfSearchView *view, QWidget *parent)
+    : QWidget(parent)
+    , view_(view)
+{
+    queryEdit_ = new QLineEdit(this);
+    queryEdit_->setPlaceholderText("Поиск в PDF...");
+    queryEdit_->setClearButtonEnabled(true);
+
+    resultsList_ = new QListWidget(this);
+    statusLabel_ = new QLabel(this);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->addWidget(queryEdit_);
+    layout->addWidget(statusLabel_);
+    layout->addWidget(resultsList_, 1);
+
+    searchTimer_ = new QTimer(this);
+    searchTimer_->setSingleShot(true);
+    searchTimer_->setInterval(150);
+
+    connect(queryEdit_, &QLineEdit::textChanged, this, &PdfSearchPanel::scheduleSearch);
+    connect(queryEdit_, &QLineEdit::returnPressed, this, &PdfSearchPanel::runSearch);
+    connect(searchTimer_, &QTimer::timeout, this, &PdfSearchPanel::runSearch);
+    connect(resultsList_, &QListWidget::itemActivated, this, &PdfSearchPanel::onItemActivated);
+    connect(resultsList_, &QListWidget::itemClicked, this, &PdfSearchPanel::onItemActivated);
+    connect(&index_, &PdfTextIndex::pageIndexed, this, &PdfSearchPanel::onPageIndexed);
+    connect(&index_, &PdfTextIndex::indexingFinished, this, &PdfSearchPanel::updateStatus);
+}
+
+void PdfSearchPanel::setDocumentFile(const QString &filePath)
+{
+    hits_.clear();
+    resultsList_->clear();
+    if (view_) {
+        view_->clearHighlight();
+    }
+    index_.build(filePath);
+    updateStatus();
+}
+
+void PdfSearchPanel::activate()
+{
+    queryEdit_->setFocus();
+    queryEdit_->selectAll();
+}
+
+void PdfSearchPanel::scheduleSearch()
+{
+    searchTimer_->start();
+}
+
+void PdfSearchPanel::runSearch()
+{
+    searchTimer_->stop();
+    hits_ = index_.search(queryEdit_->text());
+
+    resultsList_->clear();
+    const auto listed = qMin(static_cast<int>(hits_.size()), kMaxListedHits);
+    for (int i = 0; i < listed; ++i) {
+        const PdfSearchHit &hit = hits_.at(i);
+        resultsList_->addItem(QString("Стр. %1: %2").arg(hit.page + 1).arg(hit.context));
+    }
+    updateStatus();
+}
+
+void PdfSearchPanel::onPageIndexed(int page)
+{
+    Q_UNUSED(page)
+    if (!queryEdit_->text().isEmpty() && !searchTimer_->isActive()) {
+        const QVector<PdfSearchHit> updated = index_.search(queryEdit_->text());
+        const auto listed = qMin(static_cast<int>(updated.size()), kMaxListedHits);
+        for (auto i = static_cast<int>(qMin(hits_.size(), static_cast<qsizetype>(kMaxListedHits))); i < listed; ++i) {
+            const PdfSearchHit &hit = updated.at(i);
+            resultsList_->addItem(QString("Стр. %1: %2").arg(hit.page + 1).arg(hit.context));
+        }
+        hits_ = updated;
+    }
+    updateStatus();
+}
+
+void PdfSearchPanel::onItemActivated(QListWidgetItem *item)
+{
+    const int row = resultsList_->row(item);
+    if (view_ && row >= 0 && row < hits_.size()) {
+        view_->showHit(hits_.at(row));
+    }
+}
+
+void PdfSearchPanel::updateStatus()
+{
+    QString status = QString("Совпадений: %1").arg(hits_.size());
+    if (!index_.isComplete()) {
+        status += QString(" | Индексация: %1 из %2 стр.")
+                      .arg(index_.indexedPageCount())
+                      .arg(index_.pageCount() < 0 ? QStringLiteral("?") : QString::number(index_.pageCount()));
+    }
+    statusLabel_->setText(status);
+}
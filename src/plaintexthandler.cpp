@@ -37,16 +37,11 @@ bool PlainTextHandler::load(const QString &filePath,
                             DocumentContext &context,
                             QString &error)
 {
-    QFile file(filePath);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        error = QObject::tr("Не удалось открыть файл '%1' для чтения").arg(filePath);
+    QString text;
+    if (!readText(filePath, text, context.syncedBytes, error)) {
         return false;
     }
-
-    QTextStream stream(&file);
-    stream.setEncoding(QStringConverter::Utf8); 
-    document->setPlainText(stream.readAll());
-    file.close();
+    document->setPlainText(text);
 
     context.isReadOnly = false;
     context.workingDirectory.clear();
@@ -69,6 +64,8 @@ bool PlainTextHandler::save(const QString &filePath,
     QTextStream stream(&file);
     stream.setEncoding(QStringConverter::Utf8); 
     stream << document->toPlainText();
+    stream.flush();
+    context.syncedBytes = file.pos();
     file.close();
 
     context.isReadOnly = false;
@@ -77,3 +74,29 @@ bool PlainTextHandler::save(const QString &filePath,
 
     return true;
 }
+
+bool PlainTextHandler::extractText(const QString &filePath,
+                                   QString &text,
+                                   QString &error) const
+{
+    qint64 bytesRead = 0;
+    return readText(filePath, text, bytesRead, error);
+}
+
+bool PlainTextHandler::readText(const QString &filePath,
+                                QString &text,
+                                qint64 &bytesRead,
+                                QString &error)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        error = QObject::tr("Не удалось открыть файл '%1' для чтения").arg(filePath);
+        return false;
+    }
+
+    QTextStream stream(&file);
+    stream.setEncoding(QStringConverter::Utf8);
+    text = stream.readAll();
+    bytesRead = file.pos();
+    return true;
+}
@@ -0,0 +1,99 @@
+#include "../headers/replacepreviewdialog.h"
+
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QLabel>
+#include <QDialogButtonBox>
+#include <QPushButton>
+#include <QVBoxLayout>
+#include <QDir>
+#include <QBrush>
+#include <QColor>
+
+namespace {
+
+constexpr int kPlanIndexRole = Qt::UserRole;
+
+}
+
+ReplacePreviewDialog::ReplacePreviewDialog(const QVector<FileReplacePlan> &plans, QWidget *parent)
+    : QDialog(parent)
+    , plans_(plans)
+{
+    setWindowTitle("Замена в файлах");
+    resize(900, 600);
+
+    tree_ = new QTreeWidget(this);
+    tree_->setHeaderHidden(true);
+    tree_->setUniformRowHeights(true);
+
+    const QBrush removed(QColor(255, 220, 220));
+    const QBrush added(QColor(220, 255, 220));
+    for (qsizetype i = 0; i < plans_.size(); ++i) {
+        const FileReplacePlan &plan = plans_.at(i);
+        auto *fileItem = new QTreeWidgetItem(tree_);
+        fileItem->setText(0, QString("%1 (%2)").arg(QDir::toNativeSeparators(plan.filePath)).arg(plan.matchCount));
+        fileItem->setData(0, kPlanIndexRole, static_cast<int>(i));
+        fileItem->setCheckState(0, Qt::Checked);
+
+        for (const ReplacePreviewLine &line : plan.preview) {
+            auto *before = new QTreeWidgetItem(fileItem);
+            before->setText(0, QString("- %1: %2").arg(line.line).arg(line.before));
+            before->setBackground(0, removed);
+            auto *after = new QTreeWidgetItem(fileItem);
+            after->setText(0, QString("+ %1: %2").arg(line.line).arg(line.after));
+            after->setBackground(0, added);
+        }
+        if (plan.preview.size() < plan.matchCount) {
+            auto *more = new QTreeWidgetItem(fileItem);
+            more->setText(0, "…");
+        }
+    }
+    if (tree_->topLevelItemCount() <= 20) {
+        tree_->expandAll();
+    }
+
+    summaryLabel_ = new QLabel(this);
+
+    auto *buttons = new QDialogButtonBox(QDialogButtonBox::Cancel, this);
+    buttons->addButton("Заменить", QDialogButtonBox::AcceptRole);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(tree_, 1);
+    layout->addWidget(summaryLabel_);
+    layout->addWidget(buttons);
+
+    connect(buttons, &QDialogButtonBox::accepted, this, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::reject);
+    connect(tree_, &QTreeWidget::itemChanged, this, &ReplacePreviewDialog::updateSummary);
+    updateSummary();
+}
+
+QVector<FileReplacePlan> ReplacePreviewDialog::selectedPlans() const
+{
+    QVector<FileReplacePlan> selected;
+    for (int i = 0; i < tree_->topLevelItemCount(); ++i) {
+        const QTreeWidgetItem *item = tree_->topLevelItem(i);
+        if (item->checkState(0) == Qt::Checked) {
+            selected.push_back(plans_.at(item->data(0, kPlanIndexRole).toInt()));
+        }
+    }
+    return selected;
+}
+
+void ReplacePreviewDialog::updateSummary()
+{
+    qsizetype files = 0;
+    qsizetype matches = 0;
+    for (int i = 0; i < tree_->topLevelItemCount(); ++i) {
+        const QTreeWidgetItem *item = tree_->topLevelItem(i);
+        if (item->checkState(0) == Qt::Checked) {
+            ++files;
+            matches += plans_.at(item->data(0, kPlanIndexRole).toInt()).matchCount;
+        }
+    }
+    summaryLabel_->setText(QString("Будет заменено %1 совпадений в %2 файлах. "
+                                   "Файлы записываются целиком или не изменяются вовсе.")
+                               .arg(matches)
+                               .arg(files));
+}
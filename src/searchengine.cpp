@@ -0,0 +1,424 @@
+#include "../headers/searchengine.h"
+
+#include <QMutexLocker>
+#include <QtAlgorithms>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TEXTEDITOR_SEARCH_SSE2 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define TEXTEDITOR_SEARCH_NEON 1
+#endif
+
+namespace {
+
+constexpr qsizetype kHorspoolMinLength = 4;
+// Text after the end of a regex search range that a match may still read.
+constexpr qsizetype kRegexSlack = 4096;
+
+}
+
+RegexCache &RegexCache::instance()
+{
+    static RegexCache cache; // NOSONAR - Meyers singleton pattern
+    return cache;
+}
+
+QRegularExpression RegexCache::get(const QString &pattern, QRegularExpression::PatternOptions options)
+{
+    const QString key = QString::number(options.toInt()) + QLatin1Char(':') + pattern;
+
+    QMutexLocker locker(&mutex_);
+    if (const auto it = entries_.constFind(key); it != entries_.constEnd()) {
+        order_.removeOne(key);
+        order_.append(key);
+        return *it;
+    }
+
+    QRegularExpression regex(pattern, options);
+    regex.optimize();
+    entries_.insert(key, regex);
+    order_.append(key);
+    if (order_.size() > kCapacity) {
+        entries_.remove(order_.takeFirst());
+    }
+    return regex;
+}
+
+namespace SearchEngine {
+
+bool isWordChar(char32_t ch)
+{
+    return QChar::isLetterOrNumber(ch) || ch == U'_';
+}
+
+qsizetype findChar(QStringView text, char16_t ch, qsizetype from, qsizetype to)
+{
+    const auto *data = reinterpret_cast<const char16_t *>(text.utf16());
+    qsizetype i = qMax<qsizetype>(0, from);
+    to = qMin(to, text.size());
+
+#if defined(TEXTEDITOR_SEARCH_SSE2)
+    const __m128i needle = _mm_set1_epi16(static_cast<short>(ch));
+    for (; i + 8 <= to; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        if (const int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(chunk, needle)); mask != 0) {
+            return i + (qCountTrailingZeroBits(static_cast<quint32>(mask)) >> 1);
+        }
+    }
+#elif defined(TEXTEDITOR_SEARCH_NEON)
+    const uint16x8_t needle = vdupq_n_u16(ch);
+    for (; i + 8 <= to; i += 8) {
+        const uint16x8_t eq = vceqq_u16(vld1q_u16(reinterpret_cast<const uint16_t *>(data + i)), needle);
+        if (vmaxvq_u16(eq) != 0) {
+            break;
+        }
+    }
+#endif
+
+    for (; i < to; ++i) {
+        if (data[i] == ch) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+qsizetype findEitherChar(QStringView text, char16_t first, char16_t second, qsizetype from, qsizetype to)
+{
+    if (first == second) {
+        return findChar(text, first, from, to);
+    }
+
+    const auto *data = reinterpret_cast<const char16_t *>(text.utf16());
+    qsizetype i = qMax<qsizetype>(0, from);
+    to = qMin(to, text.size());
+
+#if defined(TEXTEDITOR_SEARCH_SSE2)
+    const __m128i needleA = _mm_set1_epi16(static_cast<short>(first));
+    const __m128i needleB = _mm_set1_epi16(static_cast<short>(second));
+    for (; i + 8 <= to; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i eq = _mm_or_si128(_mm_cmpeq_epi16(chunk, needleA), _mm_cmpeq_epi16(chunk, needleB));
+        if (const int mask = _mm_movemask_epi8(eq); mask != 0) {
+            return i + (qCountTrailingZeroBits(static_cast<quint32>(mask)) >> 1);
+        }
+    }
+#elif defined(TEXTEDITOR_SEARCH_NEON)
+    const uint16x8_t needleA = vdupq_n_u16(first);
+    const uint16x8_t needleB = vdupq_n_u16(second);
+    for (; i + 8 <= to; i += 8) {
+        const uint16x8_t chunk = vld1q_u16(reinterpret_cast<const uint16_t *>(data + i));
+        if (vmaxvq_u16(vorrq_u16(vceqq_u16(chunk, needleA), vceqq_u16(chunk, needleB))) != 0) {
+            break;
+        }
+    }
+#endif
+
+    for (; i < to; ++i) {
+        if (data[i] == first || data[i] == second) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+}
+
+TextSearcher::TextSearcher(const SearchQuery &query)
+    : query_(query)
+{
+    if (query_.pattern.isEmpty()) {
+        valid_ = false;
+        return;
+    }
+
+    if (query_.options.regex) {
+        QRegularExpression::PatternOptions options = QRegularExpression::UseUnicodePropertiesOption;
+        if (!query_.options.caseSensitive) {
+            options |= QRegularExpression::CaseInsensitiveOption;
+        }
+        const QString pattern = query_.options.wholeWords
+                                    ? QStringLiteral("\\b(?:%1)\\b").arg(query_.pattern)
+                                    : query_.pattern;
+        regex_ = RegexCache::instance().get(pattern, options);
+        valid_ = regex_.isValid();
+        error_ = regex_.errorString();
+        return;
+    }
+
+    const QChar first = query_.pattern.front();
+    if (query_.options.caseSensitive || first.isSurrogate()) {
+        firstLower_ = first.unicode();
+        firstUpper_ = first.unicode();
+    } else {
+        firstLower_ = first.toLower().unicode();
+        firstUpper_ = first.toUpper().unicode();
+    }
+
+    const qsizetype m = query_.pattern.size();
+    useHorspool_ = query_.options.caseSensitive && m >= kHorspoolMinLength;
+    if (useHorspool_) {
+        shift_.fill(m);
+        const char16_t *pattern = reinterpret_cast<const char16_t *>(query_.pattern.utf16());
+        for (qsizetype i = 0; i < m - 1; ++i) {
+            shift_[pattern[i] & 0xFF] = m - 1 - i;
+        }
+    }
+}
+
+qsizetype TextSearcher::horspool(QStringView text, qsizetype from, qsizetype to) const
+{
+    const char16_t *data = reinterpret_cast<const char16_t *>(text.utf16());
+    const char16_t *pattern = reinterpret_cast<const char16_t *>(query_.pattern.utf16());
+    const qsizetype m = query_.pattern.size();
+    const qsizetype n = text.size();
+    const char16_t last = pattern[m - 1];
+
+    qsizetype pos = from;
+    while (pos < to && pos + m <= n) {
+        const char16_t tail = data[pos + m - 1];
+        if (tail == last && data[pos] == pattern[0]
+            && std::equal(pattern + 1, pattern + m - 1, data + pos + 1)) {
+            return pos;
+        }
+        pos += shift_[tail & 0xFF];
+    }
+    return -1;
+}
+
+qsizetype TextSearcher::firstCharScan(QStringView text, qsizetype from, qsizetype to) const
+{
+    const qsizetype m = query_.pattern.size();
+    const Qt::CaseSensitivity cs = query_.options.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    const qsizetype lastStart = qMin(to, text.size() - m + 1);
+
+    qsizetype pos = from;
+    while (pos < lastStart) {
+        pos = SearchEngine::findEitherChar(text, firstLower_, firstUpper_, pos, lastStart);
+        if (pos < 0) {
+            return -1;
+        }
+        if (text.sliced(pos, m).compare(query_.pattern, cs) == 0) {
+            return pos;
+        }
+        ++pos;
+    }
+    return -1;
+}
+
+bool TextSearcher::isWordBoundaryMatch(QStringView text, qsizetype start, qsizetype length) const
+{
+    if (start > 0) {
+        char32_t before = text.at(start - 1).unicode();
+        if (QChar::isLowSurrogate(before) && start > 1 && text.at(start - 2).isHighSurrogate()) {
+            before = QChar::surrogateToUcs4(text.at(start - 2), text.at(start - 1));
+        }
+        if (SearchEngine::isWordChar(before)) {
+            return false;
+        }
+    }
+    const qsizetype end = start + length;
+    if (end >= text.size()) {
+        return true;
+    }
+    char32_t after = text.at(end).unicode();
+    if (QChar::isHighSurrogate(after) && end + 1 < text.size() && text.at(end + 1).isLowSurrogate()) {
+        after = QChar::surrogateToUcs4(text.at(end), text.at(end + 1));
+    }
+    return !SearchEngine::isWordChar(after);
+}
+
+bool TextSearcher::findLiteral(QStringView text, qsizetype from, qsizetype to, SearchMatch &match) const
+{
+    const qsizetype m = query_.pattern.size();
+    qsizetype pos = from;
+    while (pos < to) {
+        pos = useHorspool_ ? horspool(text, pos, to) : firstCharScan(text, pos, to);
+        if (pos < 0) {
+            return false;
+        }
+        if (!query_.options.wholeWords || isWordBoundaryMatch(text, pos, m)) {
+            match = SearchMatch{pos, m};
+            return true;
+        }
+        ++pos;
+    }
+    return false;
+}
+
+// The subject ends a little after `to`, so a search split into chunks does
+// not scan the rest of the document for every chunk. An attempt that runs
+// into that end comes back as a partial match and is repeated on the
+// whole text.
+bool TextSearcher::findRegex(QStringView text, qsizetype from, qsizetype to, SearchMatch &match) const
+{
+    const qsizetype limit = qMin(text.size(), to + kRegexSlack);
+    const bool bounded = limit < text.size();
+    qsizetype pos = from;
+    while (pos < to && pos <= text.size()) {
+        QRegularExpressionMatch result = bounded
+            ? regex_.matchView(text.first(limit), pos, QRegularExpression::PartialPreferFirstMatch)
+            : regex_.matchView(text, pos);
+        if (result.hasPartialMatch()) {
+            if (result.capturedStart() >= to) {
+                return false;
+            }
+            result = regex_.matchView(text, pos);
+        }
+        if (!result.hasMatch() || result.capturedStart() >= to) {
+            return false;
+        }
+        if (result.capturedLength() > 0) {
+            match = SearchMatch{result.capturedStart(), result.capturedLength()};
+            return true;
+        }
+        pos = result.capturedStart() + 1;
+    }
+    return false;
+}
+
+bool TextSearcher::findNext(QStringView text, qsizetype from, qsizetype to, SearchMatch &match) const
+{
+    if (!valid_) {
+        return false;
+    }
+    from = qMax<qsizetype>(0, from);
+    to = qMin(to, text.size());
+    return query_.options.regex ? findRegex(text, from, to, match) : findLiteral(text, from, to, match);
+}
+
+qsizetype TextSearcher::findAll(QStringView text, qsizetype from, qsizetype to,
+                                QVector<SearchMatch> &matches, qsizetype limit) const
+{
+    qsizetype found = 0;
+    SearchMatch match;
+    qsizetype pos = from;
+    while ((limit < 0 || found < limit) && findNext(text, pos, to, match)) {
+        matches.push_back(match);
+        ++found;
+        pos = match.end();
+    }
+    return found;
+}
+
+bool TextSearcher::matchesAt(QStringView text, qsizetype position, qsizetype length) const
+{
+    if (!valid_ || position < 0 || position + length > text.size()) {
+        return false;
+    }
+    if (query_.options.regex) {
+        const QRegularExpressionMatch result = regex_.matchView(text, position,
+                                                                QRegularExpression::NormalMatch,
+                                                                QRegularExpression::AnchorAtOffsetMatchOption);
+        return result.hasMatch() && result.capturedLength() == length;
+    }
+    if (length != query_.pattern.size()) {
+        return false;
+    }
+    const Qt::CaseSensitivity cs = query_.options.caseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
+    return text.sliced(position, length).compare(query_.pattern, cs) == 0
+           && (!query_.options.wholeWords || isWordBoundaryMatch(text, position, length));
+}
+
+QString TextSearcher::expandReplacement(QStringView replacement, const QRegularExpressionMatch &match)
+{
+    QString result;
+    result.reserve(replacement.size());
+    const qsizetype n = replacement.size();
+    for (qsizetype i = 0; i < n; ++i) {
+        const QChar ch = replacement.at(i);
+        const QChar next = i + 1 < n ? replacement.at(i + 1) : QChar();
+
+        if (ch == QLatin1Char('\\') && !next.isNull()) {
+            ++i;
+            if (next.isDigit()) {
+                result += match.captured(next.digitValue());
+            } else if (next == QLatin1Char('n')) {
+                result += QLatin1Char('\n');
+            } else if (next == QLatin1Char('t')) {
+                result += QLatin1Char('\t');
+            } else {
+                result += next;
+            }
+        } else if (ch == QLatin1Char('$') && next == QLatin1Char('$')) {
+            result += QLatin1Char('$');
+            ++i;
+        } else if (ch == QLatin1Char('$') && next == QLatin1Char('{')) {
+            const qsizetype close = replacement.indexOf(QLatin1Char('}'), i + 2);
+            if (close < 0) {
+                result += ch;
+                continue;
+            }
+            const QStringView name = replacement.sliced(i + 2, close - i - 2);
+            bool isNumber = false;
+            const int group = name.toInt(&isNumber);
+            result += isNumber ? match.captured(group) : match.captured(name);
+            i = close;
+        } else if (ch == QLatin1Char('$') && next.isDigit()) {
+            int group = next.digitValue();
+            ++i;
+            if (i + 1 < n && replacement.at(i + 1).isDigit()
+                && group * 10 + replacement.at(i + 1).digitValue() <= match.lastCapturedIndex()) {
+                group = group * 10 + replacement.at(i + 1).digitValue();
+                ++i;
+            }
+            result += match.captured(group);
+        } else {
+            result += ch;
+        }
+    }
+    return result;
+}
+
+QString TextSearcher::replacementAt(QStringView text, const SearchMatch &match, const QString &replacement) const
+{
+    if (!query_.options.regex) {
+        return replacement;
+    }
+    const QRegularExpressionMatch result = regex_.matchView(text, match.start,
+                                                            QRegularExpression::NormalMatch,
+                                                            QRegularExpression::AnchorAtOffsetMatchOption);
+    return result.hasMatch() ? expandReplacement(replacement, result) : replacement;
+}
+
+bool TextSearcher::buildReplacePlan(QStringView text, const QString &replacement, ReplacePlan &plan,
+                                    const std::function<bool()> &isCanceled) const
+{
+    plan.edits.clear();
+    if (!valid_) {
+        return false;
+    }
+
+    qsizetype pos = 0;
+    SearchMatch match;
+    QRegularExpressionMatch regexMatch;
+    while (pos <= text.size()) {
+        if ((plan.edits.size() & 0x3FF) == 0 && isCanceled && isCanceled()) {
+            return false;
+        }
+
+        QString substitute;
+        if (query_.options.regex) {
+            regexMatch = regex_.matchView(text, pos);
+            while (regexMatch.hasMatch() && regexMatch.capturedLength() == 0) {
+                regexMatch = regex_.matchView(text, regexMatch.capturedStart() + 1);
+            }
+            if (!regexMatch.hasMatch()) {
+                break;
+            }
+            match = SearchMatch{regexMatch.capturedStart(), regexMatch.capturedLength()};
+            substitute = expandReplacement(replacement, regexMatch);
+        } else {
+            if (!findLiteral(text, pos, text.size(), match)) {
+                break;
+            }
+            substitute = replacement;
+        }
+
+        plan.edits.append(ReplaceEdit{match.start, match.length, std::move(substitute)});
+        pos = match.end();
+    }
+    return true;
+}
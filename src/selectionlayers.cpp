@@ -0,0 +1,39 @@
+#include "../headers/selectionlayers.h"
+
+SelectionLayers::SelectionLayers(QTextEdit *textEdit)
+    : QObject(textEdit)
+    , textEdit_(textEdit)
+{
+}
+
+SelectionLayers *SelectionLayers::of(QTextEdit *textEdit)
+{
+    auto *layers = textEdit->findChild<SelectionLayers *>(QString(), Qt::FindDirectChildrenOnly);
+    return layers ? layers : new SelectionLayers(textEdit);
+}
+
+void SelectionLayers::setLayer(int layer, const QList<QTextEdit::ExtraSelection> &selections)
+{
+    if (selections.isEmpty()) {
+        clearLayer(layer);
+        return;
+    }
+    layers_.insert(layer, selections);
+    apply();
+}
+
+void SelectionLayers::clearLayer(int layer)
+{
+    if (layers_.remove(layer) > 0) {
+        apply();
+    }
+}
+
+void SelectionLayers::apply()
+{
+    QList<QTextEdit::ExtraSelection> combined;
+    for (const QList<QTextEdit::ExtraSelection> &selections : std::as_const(layers_)) {
+        combined += selections;
+    }
+    textEdit_->setExtraSelections(combined);
+}
@@ -36,9 +36,17 @@ void SpeechManager::speakFromDocument(const IDocument *document)
         return;
     }
 
-    QString text = document->getSelectedText();
-    if (text.isEmpty()) {
-        text = document->getAllText();
+    const DocumentBlocks blocks = document->hasSelection()
+                                      ? document->blocks(document->selectionRange())
+                                      : document->blocks();
+    QString text;
+    bool first = true;
+    for (const TextChunk &chunk : blocks) {
+        if (!first) {
+            text += QLatin1Char('\n');
+        }
+        text += chunk.text;
+        first = false;
     }
 
     speakText(text);
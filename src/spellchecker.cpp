@@ -0,0 +1,285 @@
+#include "../headers/spellchecker.h"
+#include "../headers/selectionlayers.h"
+
+#include <QtConcurrent/QtConcurrent>
+#include <QPromise>
+#include <QTextEdit>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QScrollBar>
+
+namespace {
+
+constexpr int kEditCheckDelayMs = 250;
+constexpr int kScrollCheckDelayMs = 40;
+constexpr int kRenderDelayMs = 30;
+constexpr int kMarginBlocks = 20;
+constexpr int kMaxEditedBlocks = 500;
+constexpr qsizetype kMaxCachedBlocks = 20000;
+
+bool isWordPart(QChar ch)
+{
+    return ch.isLetter() || ch.category() == QChar::Mark_NonSpacing;
+}
+
+bool isApostrophe(QChar ch)
+{
+    return ch == u'\'' || ch == u'’';
+}
+
+// Words glued to digits, underscores or path characters are identifiers,
+// file names or addresses rather than prose.
+bool isCodeNeighbour(QChar ch)
+{
+    return ch.isDigit() || ch == u'_' || ch == u'@' || ch == u'/' || ch == u'\\' || ch == u'#' || ch == u'$';
+}
+
+bool shouldSkip(QStringView word)
+{
+    if (word.size() < 2) {
+        return true;
+    }
+    const QChar::Script script = word.front().script();
+    for (qsizetype i = 0; i < word.size(); ++i) {
+        const QChar ch = word[i];
+        if ((i > 0 && ch.isUpper()) || (ch.isLetter() && ch.script() != script)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QVector<SpellRange> checkText(const SpellDictionaries &dictionaries, const QString &text)
+{
+    QVector<SpellRange> ranges;
+    const qsizetype size = text.size();
+    qsizetype i = 0;
+    while (i < size) {
+        if (!isWordPart(text[i])) {
+            ++i;
+            continue;
+        }
+        const qsizetype start = i;
+        while (i < size && (isWordPart(text[i]) || (isApostrophe(text[i]) && i + 1 < size && isWordPart(text[i + 1])))) {
+            ++i;
+        }
+        if ((start > 0 && isCodeNeighbour(text[start - 1])) || (i < size && isCodeNeighbour(text[i]))) {
+            continue;
+        }
+        const QStringView word = QStringView(text).sliced(start, i - start);
+        const SpellDictionary *dictionary = dictionaries.forWord(word);
+        if (!dictionary || shouldSkip(word)) {
+            continue;
+        }
+        const QString normalized = SpellDictionary::normalize(word);
+        if (dictionary->contains(normalized)
+            || (normalized.endsWith(u"'s") && dictionary->contains(QStringView(normalized).chopped(2)))) {
+            continue;
+        }
+        ranges.append({static_cast<int>(start), static_cast<int>(i - start)});
+    }
+    return ranges;
+}
+
+void checkBatch(QPromise<SpellBatch> &promise, const std::shared_ptr<const SpellDictionaries> &dictionaries,
+                const QStringList &texts)
+{
+    SpellBatch batch;
+    batch.texts = texts;
+    batch.misspellings.reserve(texts.size());
+    for (const QString &text : texts) {
+        if (promise.isCanceled()) {
+            return;
+        }
+        batch.misspellings.append(checkText(*dictionaries, text));
+    }
+    promise.addResult(std::move(batch));
+}
+
+std::shared_ptr<const SpellDictionaries> loadDictionaries()
+{
+    return SpellDictionaries::shared();
+}
+
+}
+
+SpellChecker::SpellChecker(QTextEdit *textEdit, QObject *parent)
+    : QObject(parent)
+    , textEdit_(textEdit)
+{
+    checkTimer_.setSingleShot(true);
+    renderTimer_.setSingleShot(true);
+    renderTimer_.setInterval(kRenderDelayMs);
+
+    connect(&checkTimer_, &QTimer::timeout, this, &SpellChecker::startCheck);
+    connect(&renderTimer_, &QTimer::timeout, this, &SpellChecker::render);
+    connect(&loadWatcher_, &QFutureWatcher<std::shared_ptr<const SpellDictionaries>>::finished,
+            this, &SpellChecker::onDictionariesLoaded);
+    connect(&checkWatcher_, &QFutureWatcher<SpellBatch>::finished, this, &SpellChecker::onChecked);
+    connect(textEdit_->document(), &QTextDocument::contentsChange, this, &SpellChecker::onContentsChange);
+    connect(textEdit_, &QTextEdit::cursorPositionChanged, this, &SpellChecker::scheduleRender);
+    connect(textEdit_->verticalScrollBar(), &QScrollBar::valueChanged, this, &SpellChecker::scheduleRender);
+}
+
+SpellChecker::~SpellChecker()
+{
+    checkWatcher_.cancel();
+    checkWatcher_.waitForFinished();
+    loadWatcher_.waitForFinished();
+}
+
+void SpellChecker::setEnabled(bool enabled)
+{
+    if (enabled_ == enabled) {
+        return;
+    }
+    enabled_ = enabled;
+    if (!enabled_) {
+        checkTimer_.stop();
+        renderTimer_.stop();
+        checkWatcher_.cancel();
+        editedBlocks_.clear();
+        SelectionLayers::of(textEdit_)->clearLayer(SelectionLayers::SpellLayer);
+        return;
+    }
+    if (!dictionaries_ && !loadWatcher_.isRunning()) {
+        loadWatcher_.setFuture(QtConcurrent::run(loadDictionaries));
+        return;
+    }
+    render();
+}
+
+void SpellChecker::onDictionariesLoaded()
+{
+    dictionaries_ = loadWatcher_.result();
+    emit statusMessage(dictionaries_->description());
+    if (enabled_) {
+        startCheck();
+    }
+}
+
+void SpellChecker::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    (void)charsRemoved;
+    if (!enabled_ || !dictionaries_) {
+        return;
+    }
+    const QTextDocument *document = textEdit_->document();
+    const int first = document->findBlock(position).blockNumber();
+    const int last = document->findBlock(position + charsAdded).blockNumber();
+    for (int number = first; number <= last && editedBlocks_.size() < kMaxEditedBlocks; ++number) {
+        editedBlocks_.insert(number);
+    }
+    checkTimer_.start(kEditCheckDelayMs);
+}
+
+void SpellChecker::scheduleRender()
+{
+    if (enabled_ && dictionaries_) {
+        renderTimer_.start();
+    }
+}
+
+QVector<int> SpellChecker::visibleBlocks() const
+{
+    const QRect viewport = textEdit_->viewport()->rect();
+    const int first = textEdit_->cursorForPosition(viewport.topLeft()).blockNumber();
+    const int last = textEdit_->cursorForPosition(viewport.bottomRight()).blockNumber();
+    const int count = textEdit_->document()->blockCount();
+    QVector<int> blocks;
+    for (int number = qMax(0, first - kMarginBlocks); number <= qMin(count - 1, last + kMarginBlocks); ++number) {
+        blocks.append(number);
+    }
+    return blocks;
+}
+
+// Only texts missing from the cache go to the worker. A job is never
+// restarted while one is running; onChecked() picks up what is left.
+void SpellChecker::startCheck()
+{
+    if (!enabled_ || !dictionaries_ || dictionaries_->isEmpty() || checkWatcher_.isRunning()) {
+        return;
+    }
+    QVector<int> numbers = visibleBlocks();
+    for (const int number : std::as_const(editedBlocks_)) {
+        numbers.append(number);
+    }
+    editedBlocks_.clear();
+
+    const QTextDocument *document = textEdit_->document();
+    QStringList texts;
+    QSet<QString> queued;
+    for (const int number : std::as_const(numbers)) {
+        const QString text = document->findBlockByNumber(number).text();
+        if (!text.isEmpty() && !cache_.contains(text) && !queued.contains(text)) {
+            queued.insert(text);
+            texts << text;
+        }
+    }
+    if (texts.isEmpty()) {
+        render();
+        return;
+    }
+    checkWatcher_.setFuture(QtConcurrent::run(checkBatch, dictionaries_, texts));
+}
+
+void SpellChecker::onChecked()
+{
+    if (checkWatcher_.isCanceled() || checkWatcher_.future().resultCount() == 0) {
+        return;
+    }
+    const SpellBatch batch = checkWatcher_.result();
+    if (cache_.size() + batch.texts.size() > kMaxCachedBlocks) {
+        cache_.clear();
+    }
+    for (qsizetype i = 0; i < batch.texts.size(); ++i) {
+        cache_.insert(batch.texts.at(i), batch.misspellings.at(i));
+    }
+    render();
+    if (!editedBlocks_.isEmpty() && !checkTimer_.isActive()) {
+        checkTimer_.start(kEditCheckDelayMs);
+    }
+}
+
+// The word the caret is in is left alone while it is still being typed.
+void SpellChecker::render()
+{
+    if (!enabled_ || !dictionaries_ || dictionaries_->isEmpty()) {
+        return;
+    }
+    const QTextDocument *document = textEdit_->document();
+    const int caret = textEdit_->hasFocus() ? textEdit_->textCursor().position() : -1;
+
+    QTextCharFormat format;
+    format.setUnderlineStyle(QTextCharFormat::SpellCheckUnderline);
+    format.setUnderlineColor(QColor(220, 40, 40));
+
+    QList<QTextEdit::ExtraSelection> selections;
+    bool missing = false;
+    for (const int number : visibleBlocks()) {
+        const QTextBlock block = document->findBlockByNumber(number);
+        const auto it = cache_.constFind(block.text());
+        if (it == cache_.cend()) {
+            missing = missing || !block.text().isEmpty();
+            continue;
+        }
+        for (const SpellRange &range : *it) {
+            const int start = block.position() + range.start;
+            if (caret >= start && caret <= start + range.length) {
+                continue;
+            }
+            QTextEdit::ExtraSelection selection;
+            selection.cursor = QTextCursor(textEdit_->document());
+            selection.cursor.setPosition(start);
+            selection.cursor.setPosition(start + range.length, QTextCursor::KeepAnchor);
+            selection.format = format;
+            selections.append(selection);
+        }
+    }
+    SelectionLayers::of(textEdit_)->setLayer(SelectionLayers::SpellLayer, selections);
+
+    if (missing && !checkWatcher_.isRunning() && !checkTimer_.isActive()) {
+        checkTimer_.start(kScrollCheckDelayMs);
+    }
+}
@@ -0,0 +1,738 @@
+#include "../headers/spelldictionary.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QStringDecoder>
+#include <QMutex>
+#include <QHash>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+struct DawgEdge
+{
+    quint32 target;
+    quint8 label;
+    quint8 flags;
+    quint16 reserved;
+};
+
+namespace {
+
+constexpr quint32 kDawgMagic = 0x54445747;
+constexpr quint32 kDawgVersion = 1;
+constexpr quint8 kLastEdge = 0x01;
+constexpr quint8 kFinalEdge = 0x02;
+
+struct DawgHeader
+{
+    quint32 magic;
+    quint32 version;
+    quint32 edgeCount;
+    quint32 root;
+    quint32 wordCount;
+    quint32 reserved;
+};
+
+static_assert(sizeof(DawgEdge) == 8);
+static_assert(sizeof(DawgHeader) % 8 == 0);
+
+// Lower-case half of KOI8-R (0xC0..0xDF); 0xE0..0xFF are the same letters
+// in upper case. Older Russian Hunspell dictionaries use this encoding.
+constexpr char16_t kKoi8Letters[] = u"юабцдефгхийклмнопярстужвьызшэщчъ";
+
+// Incremental construction of a minimal automaton from sorted words
+// (Daciuk et al.): once a word diverges from the previous one, the states
+// below the divergence point are final and get merged with an equivalent
+// registered state if there is one.
+class DawgBuilder
+{
+public:
+    DawgBuilder()
+        : nodes_(1), path_{0}
+    {
+    }
+
+    void add(QByteArrayView word)
+    {
+        qsizetype common = 0;
+        const qsizetype limit = qMin(word.size(), previous_.size());
+        while (common < limit && word[common] == previous_[common]) {
+            ++common;
+        }
+        minimize(common);
+        path_.resize(common + 1);
+        for (qsizetype i = common; i < word.size(); ++i) {
+            const quint32 id = newNode();
+            nodes_[path_.back()].edges.emplace_back(static_cast<quint8>(word[i]), id);
+            path_.push_back(id);
+        }
+        nodes_[path_.back()].final = true;
+        previous_ = word.toByteArray();
+    }
+
+    bool write(const QString &path, quint32 wordCount, QString &error)
+    {
+        minimize(0);
+
+        std::vector<quint32> offsets(nodes_.size(), 0);
+        std::vector<quint32> order;
+        quint32 next = 1;
+        if (!nodes_[0].edges.empty()) {
+            offsets[0] = next;
+            next += static_cast<quint32>(nodes_[0].edges.size());
+            order.push_back(0);
+        }
+        for (size_t i = 0; i < order.size(); ++i) {
+            for (const auto &[label, child] : nodes_[order[i]].edges) {
+                (void)label;
+                if (offsets[child] == 0 && !nodes_[child].edges.empty()) {
+                    offsets[child] = next;
+                    next += static_cast<quint32>(nodes_[child].edges.size());
+                    order.push_back(child);
+                }
+            }
+        }
+
+        std::vector<DawgEdge> edges(next, DawgEdge{0, 0, kLastEdge, 0});
+        for (const quint32 id : order) {
+            const auto &nodeEdges = nodes_[id].edges;
+            for (size_t k = 0; k < nodeEdges.size(); ++k) {
+                const Node &child = nodes_[nodeEdges[k].second];
+                DawgEdge &edge = edges[offsets[id] + k];
+                edge.target = child.edges.empty() ? 0 : offsets[nodeEdges[k].second];
+                edge.label = nodeEdges[k].first;
+                edge.flags = (k + 1 == nodeEdges.size() ? kLastEdge : 0) | (child.final ? kFinalEdge : 0);
+                edge.reserved = 0;
+            }
+        }
+
+        const DawgHeader header{kDawgMagic, kDawgVersion, next, offsets[0], wordCount, 0};
+        QSaveFile file(path);
+        if (!file.open(QIODevice::WriteOnly)) {
+            error = file.errorString();
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char *>(edges.data()), static_cast<qint64>(edges.size() * sizeof(DawgEdge)));
+        if (!file.commit()) {
+            error = file.errorString();
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Node
+    {
+        std::vector<std::pair<quint8, quint32>> edges;
+        bool final = false;
+    };
+
+    quint32 newNode()
+    {
+        if (!free_.empty()) {
+            const quint32 id = free_.back();
+            free_.pop_back();
+            return id;
+        }
+        nodes_.emplace_back();
+        return static_cast<quint32>(nodes_.size() - 1);
+    }
+
+    QByteArray signature(const Node &node) const
+    {
+        QByteArray key;
+        key.reserve(1 + static_cast<qsizetype>(node.edges.size()) * 5);
+        key.append(node.final ? '\1' : '\0');
+        for (const auto &[label, child] : node.edges) {
+            key.append(static_cast<char>(label));
+            key.append(reinterpret_cast<const char *>(&child), sizeof(child));
+        }
+        return key;
+    }
+
+    void minimize(qsizetype downTo)
+    {
+        for (qsizetype depth = static_cast<qsizetype>(path_.size()) - 1; depth > downTo; --depth) {
+            const quint32 id = path_[depth];
+            const QByteArray key = signature(nodes_[id]);
+            if (const auto it = register_.constFind(key); it != register_.cend()) {
+                nodes_[path_[depth - 1]].edges.back().second = *it;
+                nodes_[id] = Node();
+                free_.push_back(id);
+            } else {
+                register_.insert(key, id);
+            }
+        }
+        path_.resize(downTo + 1);
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<quint32> free_;
+    std::vector<quint32> path_;
+    QByteArray previous_;
+    QHash<QByteArray, quint32> register_;
+};
+
+struct ConditionPart
+{
+    QString chars;
+    bool negate = false;
+    bool any = false;
+};
+
+struct AffixRule
+{
+    QString strip;
+    QString add;
+    QVector<ConditionPart> condition;
+};
+
+struct AffixClass
+{
+    bool prefix = false;
+    bool cross = false;
+    QVector<AffixRule> rules;
+};
+
+enum class FlagMode { Char, Long, Number, Utf8 };
+
+struct AffixData
+{
+    QHash<QString, AffixClass> classes;
+    FlagMode flagMode = FlagMode::Char;
+    QString needAffix;
+    QString forbidden;
+    QString onlyInCompound;
+};
+
+QString decode(const QByteArray &bytes, const QString &encoding, QString &error)
+{
+    const QString name = encoding.trimmed().toUpper();
+    if (name == "KOI8-R") {
+        QString text;
+        text.reserve(bytes.size());
+        for (const char byte : bytes) {
+            const auto code = static_cast<uchar>(byte);
+            if (code < 0x80) {
+                text += QChar(code);
+            } else if (code >= 0xC0) {
+                const QChar letter(kKoi8Letters[code & 0x1F]);
+                text += code >= 0xE0 ? letter.toUpper() : letter;
+            } else {
+                text += code == 0xA3 ? QChar(u'ё') : code == 0xB3 ? QChar(u'Ё') : QChar(QChar::ReplacementCharacter);
+            }
+        }
+        return text;
+    }
+    QStringDecoder decoder(name.isEmpty() ? "UTF-8" : name.toLatin1().constData());
+    if (!decoder.isValid()) {
+        error = QString("неподдерживаемая кодировка словаря: %1").arg(encoding);
+        return QString();
+    }
+    return decoder(bytes);
+}
+
+QStringList parseFlags(QStringView flags, FlagMode mode)
+{
+    QStringList result;
+    switch (mode) {
+    case FlagMode::Long:
+        for (qsizetype i = 0; i + 1 < flags.size(); i += 2) {
+            result << flags.sliced(i, 2).toString();
+        }
+        break;
+    case FlagMode::Number:
+        for (const QStringView flag : flags.split(u',', Qt::SkipEmptyParts)) {
+            result << flag.trimmed().toString();
+        }
+        break;
+    case FlagMode::Char:
+    case FlagMode::Utf8:
+        for (const QChar ch : flags) {
+            result << QString(ch);
+        }
+        break;
+    }
+    return result;
+}
+
+QVector<ConditionPart> parseCondition(QStringView condition)
+{
+    QVector<ConditionPart> parts;
+    if (condition == u".") {
+        return parts;
+    }
+    for (qsizetype i = 0; i < condition.size(); ++i) {
+        ConditionPart part;
+        if (condition[i] == u'.') {
+            part.any = true;
+        } else if (condition[i] == u'[') {
+            const qsizetype close = condition.indexOf(u']', i + 1);
+            const qsizetype end = close < 0 ? condition.size() : close;
+            QStringView set = condition.sliced(i + 1, end - i - 1);
+            if (set.startsWith(u'^')) {
+                part.negate = true;
+                set = set.sliced(1);
+            }
+            part.chars = set.toString();
+            i = end;
+        } else {
+            part.chars = condition[i];
+        }
+        parts.append(part);
+    }
+    return parts;
+}
+
+bool matchesAt(const QVector<ConditionPart> &condition, const QString &word, qsizetype from)
+{
+    for (qsizetype i = 0; i < condition.size(); ++i) {
+        const ConditionPart &part = condition.at(i);
+        if (part.any) {
+            continue;
+        }
+        if (part.chars.contains(word.at(from + i)) == part.negate) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool appliesAsSuffix(const AffixRule &rule, const QString &word)
+{
+    return word.size() > rule.strip.size() && word.size() >= rule.condition.size() && word.endsWith(rule.strip)
+           && matchesAt(rule.condition, word, word.size() - rule.condition.size());
+}
+
+bool appliesAsPrefix(const AffixRule &rule, const QString &word)
+{
+    return word.size() > rule.strip.size() && word.size() >= rule.condition.size() && word.startsWith(rule.strip)
+           && matchesAt(rule.condition, word, 0);
+}
+
+QList<QStringView> splitFields(QStringView line)
+{
+    QList<QStringView> fields;
+    qsizetype i = 0;
+    while (i < line.size()) {
+        while (i < line.size() && line[i].isSpace()) {
+            ++i;
+        }
+        const qsizetype start = i;
+        while (i < line.size() && !line[i].isSpace()) {
+            ++i;
+        }
+        if (i > start) {
+            fields << line.sliced(start, i - start);
+        }
+    }
+    return fields;
+}
+
+bool readAffixes(const QString &affPath, AffixData &data, QString &encoding, QString &error)
+{
+    QFile file(affPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("%1: %2").arg(affPath, file.errorString());
+        return false;
+    }
+    const QByteArray bytes = file.readAll();
+    for (const QByteArray &line : bytes.split('\n')) {
+        if (line.startsWith("SET ")) {
+            encoding = QString::fromLatin1(line.mid(4)).trimmed();
+        }
+    }
+    const QString text = decode(bytes, encoding, error);
+    if (!error.isEmpty()) {
+        return false;
+    }
+
+    for (const QStringView line : QStringView(text).split(u'\n')) {
+        const QList<QStringView> tokens = splitFields(line);
+        if (tokens.size() < 2 || tokens.first().startsWith(u'#')) {
+            continue;
+        }
+        const QStringView key = tokens.first();
+        if (key == u"FLAG") {
+            data.flagMode = tokens[1] == u"long"  ? FlagMode::Long
+                            : tokens[1] == u"num" ? FlagMode::Number
+                                                  : FlagMode::Utf8;
+        } else if (key == u"NEEDAFFIX") {
+            data.needAffix = tokens[1].toString();
+        } else if (key == u"FORBIDDENWORD") {
+            data.forbidden = tokens[1].toString();
+        } else if (key == u"ONLYINCOMPOUND") {
+            data.onlyInCompound = tokens[1].toString();
+        } else if ((key == u"PFX" || key == u"SFX") && tokens.size() >= 4) {
+            const QString flag = tokens[1].toString();
+            AffixClass &affix = data.classes[flag];
+            if (tokens.size() == 4 && (tokens[2] == u"Y" || tokens[2] == u"N")) {
+                affix.prefix = key == u"PFX";
+                affix.cross = tokens[2] == u"Y";
+                continue;
+            }
+            AffixRule rule;
+            rule.strip = tokens[2] == u"0" ? QString() : tokens[2].toString();
+            const QStringView add = tokens[3].left(tokens[3].indexOf(u'/') < 0 ? tokens[3].size() : tokens[3].indexOf(u'/'));
+            rule.add = add == u"0" ? QString() : add.toString();
+            rule.condition = parseCondition(tokens.size() > 4 ? tokens[4] : QStringView(u"."));
+            affix.rules.append(rule);
+        }
+    }
+    return true;
+}
+
+void addForm(const QString &form, WordList &words)
+{
+    if (!form.isEmpty()) {
+        words.append(SpellDictionary::normalize(form).toUtf8());
+    }
+}
+
+void expandEntry(const QString &word, const QStringList &flags, const AffixData &data, WordList &words)
+{
+    if (!data.forbidden.isEmpty() && flags.contains(data.forbidden)) {
+        return;
+    }
+    if ((data.needAffix.isEmpty() || !flags.contains(data.needAffix))
+        && (data.onlyInCompound.isEmpty() || !flags.contains(data.onlyInCompound))) {
+        addForm(word, words);
+    }
+
+    QStringList crossForms;
+    for (const QString &flag : flags) {
+        const auto it = data.classes.constFind(flag);
+        if (it == data.classes.cend() || it->prefix) {
+            continue;
+        }
+        for (const AffixRule &rule : it->rules) {
+            if (appliesAsSuffix(rule, word)) {
+                const QString form = word.chopped(rule.strip.size()) + rule.add;
+                addForm(form, words);
+                if (it->cross) {
+                    crossForms << form;
+                }
+            }
+        }
+    }
+    for (const QString &flag : flags) {
+        const auto it = data.classes.constFind(flag);
+        if (it == data.classes.cend() || !it->prefix) {
+            continue;
+        }
+        for (const AffixRule &rule : it->rules) {
+            if (!appliesAsPrefix(rule, word)) {
+                continue;
+            }
+            addForm(rule.add + word.mid(rule.strip.size()), words);
+            if (!it->cross) {
+                continue;
+            }
+            for (const QString &form : std::as_const(crossForms)) {
+                if (form.startsWith(rule.strip)) {
+                    addForm(rule.add + form.mid(rule.strip.size()), words);
+                }
+            }
+        }
+    }
+}
+
+bool readWordList(const QString &path, WordList &words, QString &error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("%1: %2").arg(path, file.errorString());
+        return false;
+    }
+    const QString text = QString::fromUtf8(file.readAll());
+    for (const QStringView line : QStringView(text).split(u'\n', Qt::SkipEmptyParts)) {
+        addForm(line.trimmed().toString(), words);
+    }
+    return true;
+}
+
+struct LanguageSource
+{
+    QString name;
+    QStringList hunspellNames;
+    QStringList wordLists;
+};
+
+QStringList dictionaryDirectories()
+{
+    return {
+        QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/dictionaries",
+        "/usr/share/hunspell",
+        "/usr/share/myspell",
+        "/usr/share/myspell/dicts",
+        "/usr/local/share/hunspell"
+    };
+}
+
+QFileInfo findSource(const LanguageSource &language)
+{
+    for (const QString &dir : dictionaryDirectories()) {
+        for (const QString &name : language.hunspellNames) {
+            const QFileInfo dic(dir + '/' + name + ".dic");
+            if (dic.isFile() && QFileInfo::exists(dir + '/' + name + ".aff")) {
+                return dic;
+            }
+        }
+    }
+    for (const QString &path : language.wordLists) {
+        const QFileInfo list(QDir::isAbsolutePath(path) ? path : dictionaryDirectories().first() + '/' + path);
+        if (list.isFile()) {
+            return list;
+        }
+    }
+    return QFileInfo();
+}
+
+std::shared_ptr<const SpellDictionary> loadLanguage(const LanguageSource &language, QString &errors)
+{
+    const QString cacheDir = dictionaryDirectories().first();
+    QDir().mkpath(cacheDir);
+    const QFileInfo compiled(cacheDir + '/' + language.name + ".dawg");
+    const QFileInfo source = findSource(language);
+
+    QString error;
+    if (compiled.isFile() && (!source.exists() || compiled.lastModified() >= source.lastModified())) {
+        if (auto dictionary = SpellDictionary::map(compiled.filePath(), error)) {
+            return dictionary;
+        }
+    }
+    if (!source.exists()) {
+        return nullptr;
+    }
+
+    WordList words;
+    const bool read = source.suffix() == "dic" ? HunspellReader::readWords(source.filePath(), words, error)
+                                               : readWordList(source.filePath(), words, error);
+    words.sortUnique();
+    if (!read || !SpellDictionary::compile(words, compiled.filePath(), error)) {
+        errors += QString("%1: %2\n").arg(language.name, error);
+        return nullptr;
+    }
+    auto dictionary = SpellDictionary::map(compiled.filePath(), error);
+    if (!dictionary) {
+        errors += QString("%1: %2\n").arg(language.name, error);
+    }
+    return dictionary;
+}
+
+}
+
+void WordList::append(QByteArrayView word)
+{
+    if (word.isEmpty()) {
+        return;
+    }
+    offsets_.append(static_cast<quint32>(data_.size()));
+    data_.append(word);
+    data_.append('\0');
+}
+
+QByteArrayView WordList::at(qsizetype i) const
+{
+    const char *word = data_.constData() + offsets_.at(i);
+    return QByteArrayView(word, qstrlen(word));
+}
+
+void WordList::sortUnique()
+{
+    const char *base = data_.constData();
+    const auto less = [base](quint32 a, quint32 b) { return std::strcmp(base + a, base + b) < 0; };
+    const auto same = [base](quint32 a, quint32 b) { return std::strcmp(base + a, base + b) == 0; };
+    std::sort(offsets_.begin(), offsets_.end(), less);
+    offsets_.erase(std::unique(offsets_.begin(), offsets_.end(), same), offsets_.end());
+}
+
+SpellDictionary::~SpellDictionary() = default;
+
+std::shared_ptr<const SpellDictionary> SpellDictionary::map(const QString &path, QString &error)
+{
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly)) {
+        error = file->errorString();
+        return nullptr;
+    }
+    const qint64 size = file->size();
+    const uchar *data = size >= qint64(sizeof(DawgHeader)) ? file->map(0, size) : nullptr;
+    if (!data) {
+        error = QString("не удалось отобразить %1 в память").arg(path);
+        return nullptr;
+    }
+
+    DawgHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != kDawgMagic || header.version != kDawgVersion
+        || size != qint64(sizeof(DawgHeader)) + qint64(header.edgeCount) * qint64(sizeof(DawgEdge))
+        || header.root >= qMax<quint32>(header.edgeCount, 1)) {
+        error = QString("повреждённый словарь %1").arg(path);
+        return nullptr;
+    }
+
+    std::shared_ptr<SpellDictionary> dictionary(new SpellDictionary());
+    dictionary->edges_ = reinterpret_cast<const DawgEdge *>(data + sizeof(DawgHeader));
+    dictionary->edgeCount_ = header.edgeCount;
+    dictionary->root_ = header.root;
+    dictionary->wordCount_ = header.wordCount;
+    dictionary->file_ = std::move(file);
+    return dictionary;
+}
+
+bool SpellDictionary::compile(WordList &words, const QString &path, QString &error)
+{
+    DawgBuilder builder;
+    for (qsizetype i = 0; i < words.size(); ++i) {
+        builder.add(words.at(i));
+    }
+    return builder.write(path, static_cast<quint32>(words.size()), error);
+}
+
+QString SpellDictionary::normalize(QStringView word)
+{
+    QString result;
+    result.reserve(word.size());
+    for (QChar ch : word) {
+        if (ch.category() == QChar::Mark_NonSpacing) {
+            continue;
+        }
+        if (ch == u'’') {
+            ch = u'\'';
+        }
+        ch = ch.toLower();
+        result += ch == u'ё' ? QChar(u'е') : ch;
+    }
+    return result;
+}
+
+bool SpellDictionary::contains(QStringView normalizedWord) const
+{
+    const QByteArray bytes = normalizedWord.toUtf8();
+    if (bytes.isEmpty()) {
+        return false;
+    }
+    quint32 index = root_;
+    for (qsizetype i = 0; i < bytes.size(); ++i) {
+        if (index == 0 || index >= edgeCount_) {
+            return false;
+        }
+        const auto label = static_cast<quint8>(bytes[i]);
+        const DawgEdge *found = nullptr;
+        for (quint32 e = index; e < edgeCount_; ++e) {
+            const DawgEdge &edge = edges_[e];
+            if (edge.label == label) {
+                found = &edge;
+                break;
+            }
+            if (edge.label > label || (edge.flags & kLastEdge)) {
+                break;
+            }
+        }
+        if (!found) {
+            return false;
+        }
+        if (i + 1 == bytes.size()) {
+            return found->flags & kFinalEdge;
+        }
+        index = found->target;
+    }
+    return false;
+}
+
+bool HunspellReader::readWords(const QString &dicPath, WordList &words, QString &error)
+{
+    AffixData data;
+    QString encoding;
+    if (!readAffixes(dicPath.chopped(4) + ".aff", data, encoding, error)) {
+        return false;
+    }
+
+    QFile file(dicPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = QString("%1: %2").arg(dicPath, file.errorString());
+        return false;
+    }
+    const QString text = decode(file.readAll(), encoding, error);
+    if (!error.isEmpty()) {
+        return false;
+    }
+
+    bool first = true;
+    for (QStringView line : QStringView(text).split(u'\n', Qt::SkipEmptyParts)) {
+        line = line.trimmed();
+        if (std::exchange(first, false) && !line.isEmpty() && line.front().isDigit()) {
+            continue;
+        }
+        const qsizetype space = std::find_if(line.cbegin(), line.cend(), [](QChar ch) { return ch.isSpace(); })
+                                - line.cbegin();
+        line = line.left(space);
+
+        qsizetype slash = -1;
+        for (qsizetype i = 0; i < line.size(); ++i) {
+            if (line[i] == u'/' && (i == 0 || line[i - 1] != u'\\')) {
+                slash = i;
+                break;
+            }
+        }
+        QString word = (slash < 0 ? line : line.left(slash)).toString();
+        word.replace("\\/", "/");
+        const QStringList flags = slash < 0 ? QStringList() : parseFlags(line.sliced(slash + 1), data.flagMode);
+        expandEntry(word, flags, data, words);
+    }
+    return true;
+}
+
+std::shared_ptr<const SpellDictionaries> SpellDictionaries::shared()
+{
+    static QMutex mutex;
+    static std::weak_ptr<const SpellDictionaries> cache;
+
+    QMutexLocker locker(&mutex);
+    if (auto existing = cache.lock()) {
+        return existing;
+    }
+    auto dictionaries = std::make_shared<SpellDictionaries>();
+    dictionaries->russian_ = loadLanguage({"ru", {"ru_RU", "ru"}, {"ru.txt"}}, dictionaries->errors_);
+    dictionaries->english_ = loadLanguage({"en", {"en_US", "en_GB", "en"}, {"en.txt", "/usr/share/dict/words"}},
+                                          dictionaries->errors_);
+    cache = dictionaries;
+    return dictionaries;
+}
+
+const SpellDictionary *SpellDictionaries::forWord(QStringView word) const
+{
+    if (word.isEmpty()) {
+        return nullptr;
+    }
+    switch (word.front().script()) {
+    case QChar::Script_Cyrillic: return russian_.get();
+    case QChar::Script_Latin: return english_.get();
+    default: return nullptr;
+    }
+}
+
+QString SpellDictionaries::description() const
+{
+    QStringList parts;
+    if (russian_) {
+        parts << QString("русский (%1 форм)").arg(russian_->wordCount());
+    }
+    if (english_) {
+        parts << QString("английский (%1 форм)").arg(english_->wordCount());
+    }
+    QString text = parts.isEmpty() ? QString("Словари орфографии не найдены")
+                                   : "Орфография: " + parts.join(", ");
+    if (!errors_.isEmpty()) {
+        text += " | " + errors_.trimmed().replace('\n', "; ");
+    }
+    return text;
+}
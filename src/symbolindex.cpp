@@ -0,0 +1,934 @@
+#include "../headers/symbolindex.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QSet>
+#include <QtConcurrent/QtConcurrent>
+#include <QThread>
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+constexpr quint32 kIndexMagic = 0x5453594d;
+constexpr quint32 kIndexVersion = 2;
+constexpr qint64 kMaxSourceSize = 8LL * 1024 * 1024;
+constexpr qsizetype kMaxSourceFiles = 50000;
+constexpr qsizetype kParseBatch = 256;
+constexpr int kMaxRootDepth = 12;
+constexpr int kMaxTrailingTokens = 64;
+
+const QStringList kSourceExtensions = {
+    "c", "cc", "cpp", "cxx", "h", "hh", "hpp", "hxx", "inl", "ipp"
+};
+
+const QStringList kSkippedDirectories = {
+    "node_modules", "build", "cmake-build-debug", "cmake-build-release", "out"
+};
+
+const QStringList kProjectMarkers = {
+    "CMakeLists.txt", "compile_commands.json", "meson.build", "Makefile", "configure.ac"
+};
+
+constexpr QStringView kNotFunctions[] = {
+    u"__attribute__", u"__declspec", u"alignas", u"alignof", u"case", u"catch", u"co_await", u"co_return",
+    u"co_yield", u"decltype", u"defined", u"delete", u"do", u"else", u"for", u"if", u"new", u"noexcept",
+    u"requires", u"return", u"sizeof", u"static_assert", u"switch", u"throw", u"typedef", u"typeid",
+    u"using", u"while"
+};
+
+constexpr QStringView kExpressionKeywords[] = {
+    u"case", u"co_await", u"co_return", u"co_yield", u"delete", u"else", u"new", u"return", u"throw"
+};
+
+template<size_t N>
+bool contains(const QStringView (&words)[N], QStringView word)
+{
+    return std::binary_search(std::begin(words), std::end(words), word);
+}
+
+bool isIdentifierStart(QChar ch)
+{
+    return ch.isLetter() || ch == u'_';
+}
+
+bool isIdentifierChar(QChar ch)
+{
+    return ch.isLetterOrNumber() || ch == u'_';
+}
+
+bool isMacroName(QStringView name)
+{
+    bool letter = false;
+    for (const QChar ch : name) {
+        if (ch.isLower()) {
+            return false;
+        }
+        letter = letter || ch.isLetter();
+    }
+    return letter && name.size() > 1;
+}
+
+struct Token
+{
+    QStringView text;
+    int line = 0;
+    int column = 0;
+};
+
+// Replaces comments, literals and preprocessor lines with spaces, keeping
+// newlines so token positions still match the source. Macro names are
+// collected on the way.
+QString blankNonCode(QStringView source, QVector<SymbolInfo> &macros)
+{
+    QString text = source.toString();
+    QChar *out = text.data();
+    const qsizetype size = text.size();
+    auto blank = [out](qsizetype from, qsizetype to) {
+        for (qsizetype k = from; k < to; ++k) {
+            if (out[k] != u'\n') {
+                out[k] = u' ';
+            }
+        }
+    };
+    auto lineEnd = [&source, size](qsizetype from) {
+        const qsizetype end = source.indexOf(u'\n', from);
+        return end < 0 ? size : end;
+    };
+
+    int line = 1;
+    qsizetype lineStart = 0;
+    bool atLineStart = true;
+    qsizetype i = 0;
+    while (i < size) {
+        const QChar ch = source[i];
+        const QChar next = i + 1 < size ? source[i + 1] : QChar();
+        if (ch == u'\n') {
+            ++line;
+            lineStart = i + 1;
+            atLineStart = true;
+            ++i;
+            continue;
+        }
+        if (ch.isSpace()) {
+            ++i;
+            continue;
+        }
+
+        if (ch == u'#' && atLineStart) {
+            qsizetype end = lineEnd(i);
+            while (end < size && end > i && source[end - 1] == u'\\') {
+                end = lineEnd(end + 1);
+            }
+            qsizetype k = i + 1;
+            while (k < end && source[k].isSpace()) {
+                ++k;
+            }
+            if (source.sliced(k).startsWith(u"define")) {
+                k += 6;
+                while (k < end && source[k].isSpace()) {
+                    ++k;
+                }
+                const qsizetype nameStart = k;
+                while (k < end && isIdentifierChar(source[k])) {
+                    ++k;
+                }
+                if (k > nameStart) {
+                    SymbolInfo macro;
+                    macro.name = source.sliced(nameStart, k - nameStart).toString();
+                    macro.kind = SymbolInfo::Kind::Macro;
+                    macro.line = line;
+                    macro.column = static_cast<int>(nameStart - lineStart);
+                    macro.definition = true;
+                    macros.append(macro);
+                }
+            }
+            for (qsizetype k2 = i; k2 < end; ++k2) {
+                if (source[k2] == u'\n') {
+                    ++line;
+                    lineStart = k2 + 1;
+                }
+            }
+            blank(i, end);
+            i = end;
+            continue;
+        }
+        atLineStart = false;
+
+        qsizetype end = -1;
+        if (ch == u'/' && next == u'/') {
+            end = lineEnd(i);
+        } else if (ch == u'/' && next == u'*') {
+            const qsizetype close = source.indexOf(u"*/", i + 2);
+            end = close < 0 ? size : close + 2;
+        } else if (ch == u'"') {
+            if (i > 0 && source[i - 1] == u'R') {
+                const qsizetype paren = source.indexOf(u'(', i + 1);
+                if (paren > 0) {
+                    const QString terminator = ")" + source.sliced(i + 1, paren - i - 1).toString() + "\"";
+                    const qsizetype close = source.indexOf(terminator, paren + 1);
+                    end = close < 0 ? size : close + terminator.size();
+                }
+            }
+            if (end < 0) {
+                qsizetype k = i + 1;
+                while (k < size && source[k] != u'"' && source[k] != u'\n') {
+                    k += source[k] == u'\\' ? 2 : 1;
+                }
+                end = qMin(size, k + 1);
+            }
+        } else if (ch == u'\'' && !(i > 0 && source[i - 1].isLetterOrNumber())) {
+            qsizetype k = i + 1;
+            while (k < size && source[k] != u'\'' && source[k] != u'\n') {
+                k += source[k] == u'\\' ? 2 : 1;
+            }
+            end = qMin(size, k + 1);
+        }
+
+        if (end < 0) {
+            ++i;
+            continue;
+        }
+        for (qsizetype k = i; k < end; ++k) {
+            if (source[k] == u'\n') {
+                ++line;
+                lineStart = k + 1;
+            }
+        }
+        blank(i, end);
+        i = end;
+    }
+    return text;
+}
+
+QVector<Token> tokenize(QStringView text)
+{
+    QVector<Token> tokens;
+    int line = 1;
+    qsizetype lineStart = 0;
+    qsizetype i = 0;
+    const qsizetype size = text.size();
+    while (i < size) {
+        const QChar ch = text[i];
+        if (ch == u'\n') {
+            ++line;
+            lineStart = ++i;
+            continue;
+        }
+        if (ch.isSpace()) {
+            ++i;
+            continue;
+        }
+        const qsizetype start = i;
+        if (isIdentifierChar(ch)) {
+            while (i < size && isIdentifierChar(text[i])) {
+                ++i;
+            }
+        } else {
+            const QStringView pair = text.sliced(i, qMin<qsizetype>(2, size - i));
+            i += pair == u"::" || pair == u"->" || pair == u"&&" ? 2 : 1;
+        }
+        tokens.append({text.sliced(start, i - start), line, static_cast<int>(start - lineStart)});
+    }
+    return tokens;
+}
+
+class Parser
+{
+public:
+    explicit Parser(const QVector<Token> &tokens)
+        : tokens_(tokens), size_(tokens.size())
+    {
+    }
+
+    QVector<SymbolInfo> run()
+    {
+        scopes_ = {{ScopeType::Namespace, QString()}};
+        qsizetype i = 0;
+        while (i < size_) {
+            const QStringView t = tokens_[i].text;
+            if (t == u"{") {
+                scopes_.append({ScopeType::Block, QString()});
+                ++i;
+            } else if (t == u"}") {
+                if (scopes_.size() > 1) {
+                    scopes_.removeLast();
+                }
+                ++i;
+            } else if (scopes_.back().type == ScopeType::Block) {
+                ++i;
+            } else if (t == u"namespace") {
+                i = parseNamespace(i);
+            } else if (t == u"extern" && is(i + 1, u"{")) {
+                scopes_.append({ScopeType::Transparent, QString()});
+                i += 2;
+            } else if (t == u"template" && is(i + 1, u"<")) {
+                i = skipAngles(i + 1);
+            } else if (t == u"class" || t == u"struct" || t == u"union" || t == u"enum") {
+                i = parseRecord(i);
+            } else if (t == u"typedef" || t == u"using") {
+                i = skipStatement(i);
+            } else if (t == u"operator") {
+                i = parseOperator(i);
+            } else if (isIdentifier(i) && is(i + 1, u"(")) {
+                const qsizetype next = parseFunction(i, t.toString(), i + 1);
+                i = next < 0 ? i + 1 : next;
+            } else {
+                ++i;
+            }
+        }
+        return std::move(symbols_);
+    }
+
+private:
+    enum class ScopeType { Namespace, Class, Block, Transparent };
+
+    struct Scope
+    {
+        ScopeType type;
+        QString name;
+    };
+
+    bool is(qsizetype i, QStringView text) const { return i >= 0 && i < size_ && tokens_[i].text == text; }
+    bool isIdentifier(qsizetype i) const
+    {
+        return i >= 0 && i < size_ && isIdentifierStart(tokens_[i].text.front());
+    }
+
+    qsizetype skipBalanced(qsizetype i, QStringView open, QStringView close) const
+    {
+        int depth = 0;
+        for (; i < size_; ++i) {
+            if (tokens_[i].text == open) {
+                ++depth;
+            } else if (tokens_[i].text == close && --depth == 0) {
+                return i + 1;
+            }
+        }
+        return size_;
+    }
+
+    // Template argument lists stop at a brace or semicolon so that a stray
+    // comparison cannot swallow the rest of the file.
+    qsizetype skipAngles(qsizetype i) const
+    {
+        int depth = 0;
+        for (; i < size_; ++i) {
+            const QStringView t = tokens_[i].text;
+            if (t == u"<") {
+                ++depth;
+            } else if (t == u">" && --depth == 0) {
+                return i + 1;
+            } else if (t == u"(") {
+                i = skipBalanced(i, u"(", u")") - 1;
+            } else if (t == u"{" || t == u"}" || t == u";") {
+                return i;
+            }
+        }
+        return size_;
+    }
+
+    qsizetype skipStatement(qsizetype i) const
+    {
+        for (; i < size_; ++i) {
+            const QStringView t = tokens_[i].text;
+            if (t == u";") {
+                return i + 1;
+            }
+            if (t == u"{") {
+                i = skipBalanced(i, u"{", u"}") - 1;
+            } else if (t == u"}") {
+                return i;
+            }
+        }
+        return size_;
+    }
+
+    QString currentScope() const
+    {
+        QStringList parts;
+        for (const Scope &scope : scopes_) {
+            if (!scope.name.isEmpty() && (scope.type == ScopeType::Namespace || scope.type == ScopeType::Class)) {
+                parts << scope.name;
+            }
+        }
+        return parts.join("::");
+    }
+
+    void record(const QString &name, const QString &scope, SymbolInfo::Kind kind, const Token &at, bool definition)
+    {
+        SymbolInfo symbol;
+        symbol.name = name;
+        symbol.scope = scope;
+        symbol.kind = kind;
+        symbol.line = at.line;
+        symbol.column = at.column;
+        symbol.definition = definition;
+        symbols_.append(symbol);
+    }
+
+    qsizetype parseNamespace(qsizetype i)
+    {
+        qsizetype j = i + 1;
+        QStringList names;
+        while (isIdentifier(j) || is(j, u"::")) {
+            if (isIdentifier(j) && !is(j, u"inline")) {
+                names << tokens_[j].text.toString();
+            }
+            ++j;
+        }
+        if (is(j, u"{")) {
+            scopes_.append({ScopeType::Namespace, names.join("::")});
+            return j + 1;
+        }
+        return is(j, u"=") ? skipStatement(j) : j;
+    }
+
+    qsizetype parseRecord(qsizetype i)
+    {
+        const QStringView keyword = tokens_[i].text;
+        SymbolInfo::Kind kind = keyword == u"class"    ? SymbolInfo::Kind::Class
+                                : keyword == u"struct" ? SymbolInfo::Kind::Struct
+                                : keyword == u"union"  ? SymbolInfo::Kind::Union
+                                                       : SymbolInfo::Kind::Enum;
+        qsizetype j = i + 1;
+        if (kind == SymbolInfo::Kind::Enum && (is(j, u"class") || is(j, u"struct"))) {
+            ++j;
+        }
+
+        qsizetype nameIndex = -1;
+        while (j < size_) {
+            if (isIdentifier(j)) {
+                if (is(j + 1, u"(")) {
+                    j = skipBalanced(j + 1, u"(", u")");
+                    continue;
+                }
+                if (!is(j, u"final")) {
+                    nameIndex = j;
+                }
+                ++j;
+            } else if (is(j, u"::")) {
+                ++j;
+            } else if (is(j, u"<")) {
+                j = skipAngles(j);
+            } else if (is(j, u"[")) {
+                j = skipBalanced(j, u"[", u"]");
+            } else {
+                break;
+            }
+        }
+
+        if (is(j, u":")) {
+            while (j < size_ && !is(j, u"{") && !is(j, u";")) {
+                j = is(j, u"(") ? skipBalanced(j, u"(", u")") : is(j, u"<") ? skipAngles(j) : j + 1;
+            }
+        }
+        if (!is(j, u"{")) {
+            return i + 1;
+        }
+
+        if (nameIndex >= 0) {
+            const QString name = tokens_[nameIndex].text.toString();
+            record(name, currentScope(), kind, tokens_[nameIndex], true);
+            scopes_.append({kind == SymbolInfo::Kind::Enum ? ScopeType::Block : ScopeType::Class, name});
+        } else {
+            scopes_.append({kind == SymbolInfo::Kind::Enum ? ScopeType::Block : ScopeType::Transparent, QString()});
+        }
+        return j + 1;
+    }
+
+    qsizetype parseOperator(qsizetype i)
+    {
+        QString name = "operator";
+        qsizetype j = i + 1;
+        if (is(j, u"(") && is(j + 1, u")")) {
+            name += "()";
+            j += 2;
+        }
+        for (int guard = 0; j < size_ && !is(j, u"(") && guard < 4; ++j, ++guard) {
+            if (isIdentifier(j) && isIdentifier(j - 1)) {
+                name += u' ';
+            }
+            name += tokens_[j].text;
+        }
+        if (!is(j, u"(")) {
+            return i + 1;
+        }
+        const qsizetype next = parseFunction(i, name, j);
+        return next < 0 ? i + 1 : next;
+    }
+
+    // nameIndex is the first token of the unqualified name, paren the '(' that
+    // opens the parameter list. Returns -1 when this is not a function.
+    qsizetype parseFunction(qsizetype nameIndex, QString name, qsizetype paren)
+    {
+        if (contains(kNotFunctions, QStringView(name)) || isMacroName(name)) {
+            return -1;
+        }
+
+        qsizetype k = nameIndex;
+        if (is(k - 1, u"~")) {
+            name.prepend(u'~');
+            --k;
+        }
+        QStringList qualifiers;
+        while (is(k - 1, u"::")) {
+            qsizetype j = k - 2;
+            if (is(j, u">")) {
+                int depth = 0;
+                for (; j >= 0; --j) {
+                    if (is(j, u">")) {
+                        ++depth;
+                    } else if (is(j, u"<") && --depth == 0) {
+                        break;
+                    }
+                }
+                --j;
+            }
+            if (!isIdentifier(j)) {
+                break;
+            }
+            qualifiers.prepend(tokens_[j].text.toString());
+            k = j;
+        }
+
+        const QString &enclosing = scopes_.back().name;
+        const QString bare = name.startsWith(u'~') ? name.mid(1) : name;
+        const bool constructorLike = (!qualifiers.isEmpty() && qualifiers.last() == bare)
+                                     || (scopes_.back().type == ScopeType::Class && enclosing == bare);
+        const qsizetype prev = k - 1;
+        const bool typed = isIdentifier(prev) ? !contains(kExpressionKeywords, tokens_[prev].text)
+                                              : (is(prev, u"*") || is(prev, u"&") || is(prev, u"&&") || is(prev, u">"));
+        if (!typed && !constructorLike) {
+            return -1;
+        }
+
+        qsizetype j = skipBalanced(paren, u"(", u")");
+        qsizetype body = -1;
+        qsizetype end = -1;
+        for (int steps = 0; j < size_ && steps < kMaxTrailingTokens && body < 0 && end < 0; ++steps) {
+            const QStringView t = tokens_[j].text;
+            if (t == u"{") {
+                body = j;
+            } else if (t == u";") {
+                end = j + 1;
+            } else if (t == u"=") {
+                end = skipStatement(j);
+            } else if (t == u"(") {
+                j = skipBalanced(j, u"(", u")");
+            } else if (t == u":") {
+                ++j;
+                while (j < size_ && body < 0) {
+                    if (is(j, u"(")) {
+                        j = skipBalanced(j, u"(", u")");
+                    } else if (is(j, u"{")) {
+                        if (isIdentifier(j - 1) || is(j - 1, u">")) {
+                            j = skipBalanced(j, u"{", u"}");
+                        } else {
+                            body = j;
+                        }
+                    } else if (is(j, u";")) {
+                        return -1;
+                    } else {
+                        ++j;
+                    }
+                }
+            } else if (isIdentifier(j) || t == u"->" || t == u"*" || t == u"&" || t == u"&&"
+                       || t == u"<" || t == u">" || t == u"::" || t == u"[" || t == u"]") {
+                ++j;
+            } else {
+                return -1;
+            }
+        }
+        if (body < 0 && end < 0) {
+            return -1;
+        }
+
+        const bool classScope = scopes_.back().type == ScopeType::Class;
+        if (body >= 0 || classScope) {
+            QString scope = currentScope();
+            if (!qualifiers.isEmpty()) {
+                scope += (scope.isEmpty() ? QString() : QString("::")) + qualifiers.join("::");
+            }
+            const SymbolInfo::Kind kind = classScope || !qualifiers.isEmpty() ? SymbolInfo::Kind::Method
+                                                                              : SymbolInfo::Kind::Function;
+            record(name, scope, kind, tokens_[nameIndex], body >= 0);
+        }
+        if (body >= 0) {
+            scopes_.append({ScopeType::Block, QString()});
+            return body + 1;
+        }
+        return end;
+    }
+
+    const QVector<Token> &tokens_;
+    const qsizetype size_;
+    QVector<Scope> scopes_;
+    QVector<SymbolInfo> symbols_;
+};
+
+FileSymbols parseFile(const QString &path)
+{
+    FileSymbols result;
+    const QFileInfo info(path);
+    result.modified = info.lastModified().toMSecsSinceEpoch();
+    result.size = info.size();
+    if (result.size > kMaxSourceSize) {
+        return result;
+    }
+    QFile file(path);
+    if (file.open(QIODevice::ReadOnly)) {
+        result.symbols = SymbolParser::parse(QString::fromUtf8(file.readAll()));
+    }
+    return result;
+}
+
+QStringList collectSources(const QString &rootPath, const QPromise<SymbolSnapshot> &promise)
+{
+    QStringList files;
+    QStringList pending{rootPath};
+    while (!pending.isEmpty() && files.size() < kMaxSourceFiles && !promise.isCanceled()) {
+        const QDir dir(pending.takeLast());
+        for (const QFileInfo &info : dir.entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot | QDir::Readable)) {
+            const QString name = info.fileName();
+            if (info.isDir()) {
+                if (!name.startsWith(u'.') && !kSkippedDirectories.contains(name) && !info.isSymLink()) {
+                    pending << info.absoluteFilePath();
+                }
+            } else if (SymbolParser::isSourceFile(name)) {
+                files << info.absoluteFilePath();
+            }
+        }
+    }
+    return files;
+}
+
+bool readIndex(const QString &indexPath, const QString &rootPath, QHash<QString, FileSymbols> &files)
+{
+    QFile file(indexPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_0);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString root;
+    quint32 count = 0;
+    in >> magic >> version >> root >> count;
+    if (magic != kIndexMagic || version != kIndexVersion || root != rootPath) {
+        return false;
+    }
+    files.reserve(count);
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString path;
+        FileSymbols entry;
+        quint32 symbolCount = 0;
+        in >> path >> entry.modified >> entry.size >> symbolCount;
+        entry.symbols.resize(symbolCount);
+        for (SymbolInfo &symbol : entry.symbols) {
+            quint8 kind = 0;
+            qint32 line = 0;
+            qint32 column = 0;
+            in >> symbol.name >> symbol.scope >> kind >> line >> column >> symbol.definition;
+            symbol.kind = static_cast<SymbolInfo::Kind>(kind);
+            symbol.line = line;
+            symbol.column = column;
+        }
+        files.insert(path, entry);
+    }
+    if (in.status() != QDataStream::Ok) {
+        files.clear();
+        return false;
+    }
+    return true;
+}
+
+bool writeIndex(const QString &indexPath, const QString &rootPath, const QHash<QString, FileSymbols> &files)
+{
+    QSaveFile file(indexPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << kIndexMagic << kIndexVersion << rootPath << static_cast<quint32>(files.size());
+    for (auto it = files.cbegin(); it != files.cend(); ++it) {
+        out << it.key() << it->modified << it->size << static_cast<quint32>(it->symbols.size());
+        for (const SymbolInfo &symbol : it->symbols) {
+            out << symbol.name << symbol.scope << static_cast<quint8>(symbol.kind)
+                << static_cast<qint32>(symbol.line) << static_cast<qint32>(symbol.column) << symbol.definition;
+        }
+    }
+    return out.status() == QDataStream::Ok && file.commit();
+}
+
+// Loads the on-disk index if asked, re-parses files whose mtime or size
+// changed, drops deleted ones and writes the index back when anything moved.
+void updateIndex(QPromise<SymbolSnapshot> &promise, QThreadPool *pool, const QString &rootPath,
+                 const QString &indexPath, QHash<QString, FileSymbols> files, bool load)
+{
+    SymbolSnapshot snapshot;
+    bool dirty = false;
+    if (load && !readIndex(indexPath, rootPath, files)) {
+        dirty = true;
+    }
+
+    // A canceled walk returns a partial list; pruning against it would
+    // write a truncated index.
+    const QStringList sources = collectSources(rootPath, promise);
+    if (promise.isCanceled()) {
+        return;
+    }
+    QStringList changed;
+    QSet<QString> seen;
+    seen.reserve(sources.size());
+    for (const QString &path : sources) {
+        seen.insert(path);
+        const QFileInfo info(path);
+        const auto it = files.constFind(path);
+        if (it == files.cend() || it->modified != info.lastModified().toMSecsSinceEpoch() || it->size != info.size()) {
+            changed << path;
+        }
+    }
+    for (auto it = files.begin(); it != files.end();) {
+        if (!seen.contains(it.key())) {
+            it = files.erase(it);
+            ++snapshot.removed;
+        } else {
+            ++it;
+        }
+    }
+
+    promise.setProgressRange(0, static_cast<int>(changed.size()));
+    for (qsizetype start = 0; start < changed.size(); start += kParseBatch) {
+        if (promise.isCanceled()) {
+            return;
+        }
+        const QStringList batch = changed.mid(start, kParseBatch);
+        const QVector<FileSymbols> parsed = QtConcurrent::blockingMapped<QVector<FileSymbols>>(pool, batch, &parseFile);
+        for (qsizetype i = 0; i < batch.size(); ++i) {
+            files.insert(batch.at(i), parsed.at(i));
+        }
+        promise.setProgressValue(static_cast<int>(start + batch.size()));
+    }
+    snapshot.changed = changed.size();
+
+    if (dirty || snapshot.changed > 0 || snapshot.removed > 0) {
+        snapshot.saved = writeIndex(indexPath, rootPath, files);
+    }
+
+    for (auto it = files.cbegin(); it != files.cend(); ++it) {
+        for (const SymbolInfo &symbol : it->symbols) {
+            snapshot.byName[symbol.name].append(snapshot.all.size());
+            snapshot.all.append({it.key(), symbol});
+        }
+    }
+    snapshot.files = std::move(files);
+    promise.addResult(std::move(snapshot));
+}
+
+int matchScore(QStringView candidate, QStringView query)
+{
+    if (candidate.startsWith(query, Qt::CaseInsensitive)) {
+        return candidate.size() == query.size() ? 4 : 3;
+    }
+    if (candidate.contains(query, Qt::CaseInsensitive)) {
+        return 2;
+    }
+    qsizetype q = 0;
+    for (qsizetype i = 0; i < candidate.size() && q < query.size(); ++i) {
+        if (candidate[i].toLower() == query[q].toLower()) {
+            ++q;
+        }
+    }
+    return q == query.size() ? 1 : 0;
+}
+
+}
+
+QVector<SymbolInfo> SymbolParser::parse(QStringView text)
+{
+    QVector<SymbolInfo> macros;
+    const QString code = blankNonCode(text, macros);
+    QVector<SymbolInfo> symbols = Parser(tokenize(code)).run();
+    symbols += macros;
+    std::sort(symbols.begin(), symbols.end(), [](const SymbolInfo &a, const SymbolInfo &b) {
+        return a.line != b.line ? a.line < b.line : a.column < b.column;
+    });
+    return symbols;
+}
+
+bool SymbolParser::isSourceFile(const QString &path)
+{
+    return kSourceExtensions.contains(QFileInfo(path).suffix().toLower());
+}
+
+QString SymbolParser::kindName(SymbolInfo::Kind kind)
+{
+    switch (kind) {
+    case SymbolInfo::Kind::Class: return "класс";
+    case SymbolInfo::Kind::Struct: return "структура";
+    case SymbolInfo::Kind::Union: return "объединение";
+    case SymbolInfo::Kind::Enum: return "перечисление";
+    case SymbolInfo::Kind::Function: return "функция";
+    case SymbolInfo::Kind::Method: return "метод";
+    case SymbolInfo::Kind::Macro: return "макрос";
+    }
+    return QString();
+}
+
+SymbolIndex::SymbolIndex(QObject *parent)
+    : QObject(parent)
+{
+    pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    connect(&watcher_, &QFutureWatcher<SymbolSnapshot>::finished, this, &SymbolIndex::onUpdateFinished);
+}
+
+SymbolIndex::~SymbolIndex()
+{
+    close();
+}
+
+// The project is the nearest enclosing git checkout, else the nearest
+// directory with a build file, else the file's own directory.
+QString SymbolIndex::projectRoot(const QString &filePath)
+{
+    QDir dir = QFileInfo(filePath).absoluteDir();
+    const QString fallback = dir.canonicalPath();
+    QString buildRoot;
+    for (int depth = 0; depth < kMaxRootDepth; ++depth) {
+        if (dir.exists(".git")) {
+            return dir.canonicalPath();
+        }
+        if (buildRoot.isEmpty()) {
+            const bool marked = std::any_of(kProjectMarkers.cbegin(), kProjectMarkers.cend(),
+                                            [&dir](const QString &marker) { return dir.exists(marker); });
+            if (marked || !dir.entryList({"*.pro"}, QDir::Files).isEmpty()) {
+                buildRoot = dir.canonicalPath();
+            }
+        }
+        if (!dir.cdUp()) {
+            break;
+        }
+    }
+    return buildRoot.isEmpty() ? fallback : buildRoot;
+}
+
+void SymbolIndex::openForFile(const QString &filePath)
+{
+    const QString root = projectRoot(filePath);
+    if (root.isEmpty()) {
+        return;
+    }
+    if (root == rootPath_) {
+        refresh();
+        return;
+    }
+
+    close();
+    rootPath_ = root;
+    const QString baseDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/symbols";
+    QDir().mkpath(baseDir);
+    const QString key = QString::fromLatin1(QCryptographicHash::hash(root.toUtf8(), QCryptographicHash::Sha1).toHex());
+    indexPath_ = baseDir + '/' + key + ".sym";
+    watcher_.setFuture(QtConcurrent::run(&updateIndex, &pool_, rootPath_, indexPath_, QHash<QString, FileSymbols>(), true));
+}
+
+void SymbolIndex::refresh()
+{
+    if (rootPath_.isEmpty()) {
+        return;
+    }
+    if (watcher_.isRunning()) {
+        pending_ = true;
+        return;
+    }
+    watcher_.setFuture(QtConcurrent::run(&updateIndex, &pool_, rootPath_, indexPath_, snapshot_.files, false));
+}
+
+void SymbolIndex::close()
+{
+    watcher_.cancel();
+    watcher_.waitForFinished();
+    pending_ = false;
+    snapshot_ = SymbolSnapshot();
+    rootPath_.clear();
+    indexPath_.clear();
+}
+
+void SymbolIndex::onUpdateFinished()
+{
+    if (!watcher_.isCanceled() && watcher_.future().resultCount() > 0) {
+        snapshot_ = watcher_.result();
+        if (!snapshot_.saved) {
+            emit failed(tr("Не удалось сохранить индекс символов: %1").arg(indexPath_));
+        }
+        emit updated(snapshot_.files.size(), snapshot_.all.size());
+    }
+    if (pending_) {
+        pending_ = false;
+        refresh();
+    }
+}
+
+QVector<SymbolLocation> SymbolIndex::definitions(const QString &name) const
+{
+    QVector<SymbolLocation> result;
+    for (const qsizetype id : snapshot_.byName.value(name)) {
+        result.append(snapshot_.all.at(id));
+    }
+    std::stable_sort(result.begin(), result.end(), [](const SymbolLocation &a, const SymbolLocation &b) {
+        return a.symbol.definition > b.symbol.definition;
+    });
+    return result;
+}
+
+QVector<SymbolLocation> SymbolIndex::match(const QString &query, int limit) const
+{
+    const QString needle = query.trimmed();
+    if (needle.isEmpty()) {
+        return {};
+    }
+    const bool qualified = needle.contains("::");
+
+    struct Scored
+    {
+        int score;
+        qsizetype id;
+    };
+    std::vector<Scored> scored;
+    for (qsizetype id = 0; id < snapshot_.all.size(); ++id) {
+        const SymbolInfo &symbol = snapshot_.all.at(id).symbol;
+        const int score = qualified ? matchScore(symbol.qualifiedName(), needle) : matchScore(symbol.name, needle);
+        if (score > 0) {
+            scored.push_back({score, id});
+        }
+    }
+
+    const auto better = [this](const Scored &a, const Scored &b) {
+        if (a.score != b.score) {
+            return a.score > b.score;
+        }
+        const SymbolInfo &left = snapshot_.all.at(a.id).symbol;
+        const SymbolInfo &right = snapshot_.all.at(b.id).symbol;
+        if (left.definition != right.definition) {
+            return left.definition;
+        }
+        return left.name.size() != right.name.size() ? left.name.size() < right.name.size() : a.id < b.id;
+    };
+    const auto middle = scored.begin() + qMin<qsizetype>(limit, static_cast<qsizetype>(scored.size()));
+    std::partial_sort(scored.begin(), middle, scored.end(), better);
+
+    QVector<SymbolLocation> result;
+    for (auto it = scored.begin(); it != middle; ++it) {
+        result.append(snapshot_.all.at(it->id));
+    }
+    return result;
+}
@@ -0,0 +1,267 @@
+#include "../headers/symbolpanel.h"
+
+#include <QLineEdit>
+#include <QLabel>
+#include <QListWidget>
+#include <QTreeWidget>
+#include <QTextDocument>
+#include <QVBoxLayout>
+#include <QKeyEvent>
+#include <QFileInfo>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QtConcurrent/QtConcurrent>
+
+namespace {
+
+constexpr int kReparseDelayMs = 400;
+constexpr int kQuickOpenLimit = 200;
+
+enum ItemRole {
+    PathRole = Qt::UserRole,
+    LineRole,
+    ColumnRole
+};
+
+QVector<SymbolInfo> parseText(const QString &text)
+{
+    return SymbolParser::parse(text);
+}
+
+bool isCallable(SymbolInfo::Kind kind)
+{
+    return kind == SymbolInfo::Kind::Function || kind == SymbolInfo::Kind::Method;
+}
+
+QString displayName(const SymbolInfo &symbol)
+{
+    return isCallable(symbol.kind) ? symbol.name + "()" : symbol.name;
+}
+
+}
+
+OutlinePanel::OutlinePanel(QWidget *parent)
+    : QWidget(parent)
+{
+    filterEdit_ = new QLineEdit(this);
+    filterEdit_->setPlaceholderText("Фильтр");
+    filterEdit_->setClearButtonEnabled(true);
+
+    tree_ = new QTreeWidget(this);
+    tree_->setHeaderHidden(true);
+    tree_->setUniformRowHeights(true);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->addWidget(filterEdit_);
+    layout->addWidget(tree_, 1);
+
+    reparseTimer_.setSingleShot(true);
+    reparseTimer_.setInterval(kReparseDelayMs);
+
+    connect(&reparseTimer_, &QTimer::timeout, this, &OutlinePanel::reparse);
+    connect(&watcher_, &QFutureWatcher<QVector<SymbolInfo>>::finished, this, &OutlinePanel::onParsed);
+    connect(filterEdit_, &QLineEdit::textChanged, this, &OutlinePanel::applyFilter);
+    connect(tree_, &QTreeWidget::itemActivated, this, &OutlinePanel::onItemActivated);
+}
+
+OutlinePanel::~OutlinePanel()
+{
+    watcher_.waitForFinished();
+}
+
+void OutlinePanel::setDocument(QTextDocument *document)
+{
+    if (document_ == document) {
+        return;
+    }
+    disconnect(changeConnection_);
+    document_ = document;
+    if (document_) {
+        changeConnection_ = connect(document_, &QTextDocument::contentsChanged, &reparseTimer_,
+                                    qOverload<>(&QTimer::start));
+    }
+    reparseTimer_.start();
+}
+
+// While the panel is inactive (not a C/C++ file) edits are not parsed at all.
+void OutlinePanel::setActive(bool active)
+{
+    active_ = active;
+    if (!active_) {
+        reparseTimer_.stop();
+        tree_->clear();
+        return;
+    }
+    reparseTimer_.start(0);
+}
+
+void OutlinePanel::reparse()
+{
+    if (!active_ || !document_) {
+        return;
+    }
+    if (watcher_.isRunning()) {
+        stale_ = true;
+        return;
+    }
+    stale_ = false;
+    watcher_.setFuture(QtConcurrent::run(parseText, document_->toPlainText()));
+}
+
+void OutlinePanel::onParsed()
+{
+    if (stale_) {
+        reparse();
+        return;
+    }
+    if (!active_ || watcher_.future().resultCount() == 0) {
+        return;
+    }
+
+    const QVector<SymbolInfo> symbols = watcher_.result();
+    tree_->setUpdatesEnabled(false);
+    tree_->clear();
+    QHash<QString, QTreeWidgetItem *> records;
+    for (const SymbolInfo &symbol : symbols) {
+        QTreeWidgetItem *parent = records.value(symbol.scope);
+        auto *item = parent ? new QTreeWidgetItem(parent) : new QTreeWidgetItem(tree_);
+        item->setText(0, parent || symbol.scope.isEmpty() ? displayName(symbol)
+                                                          : symbol.scope + "::" + displayName(symbol));
+        item->setToolTip(0, QString("%1, строка %2").arg(SymbolParser::kindName(symbol.kind)).arg(symbol.line));
+        item->setData(0, LineRole, symbol.line);
+        item->setData(0, ColumnRole, symbol.column);
+        if (!symbol.definition) {
+            item->setForeground(0, palette().brush(QPalette::Disabled, QPalette::Text));
+        }
+        if (!isCallable(symbol.kind) && symbol.kind != SymbolInfo::Kind::Macro) {
+            records.insert(symbol.qualifiedName(), item);
+        }
+    }
+    tree_->expandAll();
+    applyFilter();
+    tree_->setUpdatesEnabled(true);
+}
+
+void OutlinePanel::applyFilter()
+{
+    const QString filter = filterEdit_->text().trimmed();
+    for (int i = 0; i < tree_->topLevelItemCount(); ++i) {
+        QTreeWidgetItem *top = tree_->topLevelItem(i);
+        bool anyChild = false;
+        for (int j = 0; j < top->childCount(); ++j) {
+            QTreeWidgetItem *child = top->child(j);
+            const bool visible = child->text(0).contains(filter, Qt::CaseInsensitive);
+            child->setHidden(!visible);
+            anyChild = anyChild || visible;
+        }
+        top->setHidden(!anyChild && !top->text(0).contains(filter, Qt::CaseInsensitive));
+    }
+}
+
+void OutlinePanel::onItemActivated(QTreeWidgetItem *item, int column)
+{
+    (void)column;
+    emit activated(item->data(0, LineRole).toInt(), item->data(0, ColumnRole).toInt());
+}
+
+SymbolQuickOpen::SymbolQuickOpen(const SymbolIndex *index, QWidget *parent)
+    : QDialog(parent), index_(index)
+{
+    setWindowTitle("Найти символ");
+    resize(640, 420);
+
+    queryEdit_ = new QLineEdit(this);
+    queryEdit_->setPlaceholderText("Имя класса, функции или макроса (можно Класс::метод)");
+    queryEdit_->setClearButtonEnabled(true);
+    queryEdit_->installEventFilter(this);
+
+    list_ = new QListWidget(this);
+    list_->setUniformItemSizes(true);
+
+    statusLabel_ = new QLabel(this);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(queryEdit_);
+    layout->addWidget(list_, 1);
+    layout->addWidget(statusLabel_);
+
+    connect(queryEdit_, &QLineEdit::textChanged, this, &SymbolQuickOpen::search);
+    connect(queryEdit_, &QLineEdit::returnPressed, this, &SymbolQuickOpen::openCurrent);
+    connect(list_, &QListWidget::itemActivated, this, &SymbolQuickOpen::onItemActivated);
+}
+
+void SymbolQuickOpen::activate(const QString &initialQuery)
+{
+    queryEdit_->setText(initialQuery);
+    search();
+    show();
+    raise();
+    activateWindow();
+    queryEdit_->setFocus();
+    queryEdit_->selectAll();
+}
+
+void SymbolQuickOpen::search()
+{
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<SymbolLocation> matches = index_->match(queryEdit_->text(), kQuickOpenLimit);
+    const qint64 micros = timer.nsecsElapsed() / 1000;
+
+    const QDir root(index_->rootPath());
+    list_->clear();
+    for (const SymbolLocation &location : matches) {
+        const SymbolInfo &symbol = location.symbol;
+        auto *item = new QListWidgetItem(QString("%1  —  %2  %3:%4")
+                                             .arg(symbol.scope.isEmpty() ? displayName(symbol)
+                                                                         : symbol.scope + "::" + displayName(symbol),
+                                                  SymbolParser::kindName(symbol.kind),
+                                                  QDir::toNativeSeparators(root.relativeFilePath(location.path)))
+                                             .arg(symbol.line),
+                                         list_);
+        item->setData(PathRole, location.path);
+        item->setData(LineRole, symbol.line);
+        item->setData(ColumnRole, symbol.column);
+    }
+    if (list_->count() > 0) {
+        list_->setCurrentRow(0);
+    }
+
+    if (index_->rootPath().isEmpty()) {
+        statusLabel_->setText("Откройте C/C++ файл проекта, чтобы построить индекс");
+    } else {
+        statusLabel_->setText(QString("Символов в индексе: %1%2 | найдено %3 за %4 мкс")
+                                  .arg(index_->symbolCount())
+                                  .arg(index_->isBusy() ? QString(" (обновляется)") : QString())
+                                  .arg(matches.size())
+                                  .arg(micros));
+    }
+}
+
+void SymbolQuickOpen::openCurrent()
+{
+    if (QListWidgetItem *item = list_->currentItem()) {
+        onItemActivated(item);
+    }
+}
+
+void SymbolQuickOpen::onItemActivated(QListWidgetItem *item)
+{
+    hide();
+    emit openRequested(item->data(PathRole).toString(), item->data(LineRole).toInt(),
+                       item->data(ColumnRole).toInt());
+}
+
+// Up/Down in the query field move through the results without leaving it.
+bool SymbolQuickOpen::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == queryEdit_ && event->type() == QEvent::KeyPress) {
+        const int key = static_cast<QKeyEvent *>(event)->key();
+        if (key == Qt::Key_Down || key == Qt::Key_Up || key == Qt::Key_PageDown || key == Qt::Key_PageUp) {
+            QCoreApplication::sendEvent(list_, event);
+            return true;
+        }
+    }
+    return QDialog::eventFilter(watched, event);
+}
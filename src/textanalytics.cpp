@@ -0,0 +1,384 @@
+#include "../headers/textanalytics.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr qsizetype kProgressStride = qsizetype(1) << 22;
+
+using TextAnalytics::CharClass;
+
+char16_t foldUnit(char16_t c)
+{
+    if (c < 0x80) {
+        return (c >= u'A' && c <= u'Z') ? static_cast<char16_t>(c + 0x20) : c;
+    }
+    return static_cast<char16_t>(QChar::toCaseFolded(static_cast<char32_t>(c)));
+}
+
+// Keys are views into the analysed snapshot; hashing and equality both
+// ignore case so "Error" and "error" count as one word.
+template <int N>
+struct Gram
+{
+    std::array<QStringView, N> words;
+};
+
+template <int N>
+struct GramHash
+{
+    size_t operator()(const Gram<N> &gram) const
+    {
+        size_t hash = 14695981039346656037ull;
+        for (const QStringView word : gram.words) {
+            for (const QChar ch : word) {
+                hash = (hash ^ foldUnit(ch.unicode())) * 1099511628211ull;
+            }
+            hash = (hash ^ 0x20) * 1099511628211ull;
+        }
+        return hash;
+    }
+};
+
+template <int N>
+struct GramEqual
+{
+    bool operator()(const Gram<N> &a, const Gram<N> &b) const
+    {
+        for (int i = 0; i < N; ++i) {
+            if (a.words[i].size() != b.words[i].size()
+                || a.words[i].compare(b.words[i], Qt::CaseInsensitive) != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+template <int N>
+using GramMap = std::unordered_map<Gram<N>, qint64, GramHash<N>, GramEqual<N>>;
+
+struct ChunkStats
+{
+    GramMap<1> words;
+    GramMap<2> bigrams;
+    GramMap<3> trigrams;
+    std::array<qint64, TextAnalytics::kLineLengthBuckets> lineLengths{};
+    std::array<qint64, TextAnalytics::CharClassCount> charClasses{};
+    qint64 totalWords = 0;
+    qint64 totalBigrams = 0;
+    qint64 totalTrigrams = 0;
+    qint64 lines = 0;
+};
+
+struct Chunk
+{
+    qsizetype from = 0;
+    qsizetype to = 0;
+    bool last = false;
+};
+
+CharClass classify(char32_t c)
+{
+    switch (QChar::category(c)) {
+    case QChar::Letter_Uppercase:
+    case QChar::Letter_Lowercase:
+    case QChar::Letter_Titlecase:
+    case QChar::Letter_Modifier:
+    case QChar::Letter_Other:
+        return TextAnalytics::Letter;
+    case QChar::Number_DecimalDigit:
+    case QChar::Number_Letter:
+    case QChar::Number_Other:
+        return TextAnalytics::Digit;
+    case QChar::Separator_Space:
+    case QChar::Separator_Line:
+    case QChar::Separator_Paragraph:
+        return TextAnalytics::Space;
+    case QChar::Punctuation_Connector:
+    case QChar::Punctuation_Dash:
+    case QChar::Punctuation_Open:
+    case QChar::Punctuation_Close:
+    case QChar::Punctuation_InitialQuote:
+    case QChar::Punctuation_FinalQuote:
+    case QChar::Punctuation_Other:
+        return TextAnalytics::Punctuation;
+    case QChar::Symbol_Math:
+    case QChar::Symbol_Currency:
+    case QChar::Symbol_Modifier:
+    case QChar::Symbol_Other:
+        return TextAnalytics::Symbol;
+    default:
+        return QChar::isSpace(c) ? TextAnalytics::Space : TextAnalytics::Other;
+    }
+}
+
+const std::array<quint8, 128> &asciiClasses()
+{
+    static const std::array<quint8, 128> table = [] { // NOSONAR - Meyers singleton pattern
+        std::array<quint8, 128> result{};
+        for (char32_t c = 0; c < 128; ++c) {
+            result[c] = static_cast<quint8>(classify(c));
+        }
+        return result;
+    }();
+    return table;
+}
+
+bool isWordChar(char32_t c, CharClass charClass)
+{
+    return charClass == TextAnalytics::Letter || charClass == TextAnalytics::Digit || c == U'_'
+           || QChar::category(c) == QChar::Mark_NonSpacing;
+}
+
+int lineBucket(qsizetype length)
+{
+    if (length <= 0) {
+        return 0;
+    }
+    return qMin(static_cast<int>(std::bit_width(static_cast<quint64>(length))), TextAnalytics::kLineLengthBuckets - 1);
+}
+
+// Chunks end right after a newline so that lines and n-grams never
+// straddle two workers.
+QVector<Chunk> splitChunks(QStringView text, int parts)
+{
+    QVector<Chunk> chunks;
+    qsizetype from = 0;
+    for (int i = 1; i <= parts && from < text.size(); ++i) {
+        qsizetype to = text.size() * i / parts;
+        if (i < parts) {
+            const qsizetype newline = text.indexOf(u'\n', qMax(from, to - 1));
+            to = newline < 0 ? text.size() : newline + 1;
+        } else {
+            to = text.size();
+        }
+        chunks.append({from, to, to == text.size()});
+        from = to;
+    }
+    if (chunks.isEmpty()) {
+        chunks.append({0, 0, true});
+    }
+    return chunks;
+}
+
+ChunkStats scanChunk(QStringView text, const Chunk &chunk, QPromise<TextAnalyticsReport> &promise,
+                     std::atomic<qint64> &processed)
+{
+    ChunkStats stats;
+    const std::array<quint8, 128> &ascii = asciiClasses();
+    std::array<QStringView, 3> recent;
+    int recentCount = 0;
+    qsizetype wordStart = -1;
+    qsizetype lineStart = chunk.from;
+    qsizetype reported = chunk.from;
+
+    const auto finishWord = [&](qsizetype end) {
+        const QStringView word = text.sliced(wordStart, end - wordStart);
+        wordStart = -1;
+        ++stats.totalWords;
+        ++stats.words[Gram<1>{{word}}];
+        recent[0] = recent[1];
+        recent[1] = recent[2];
+        recent[2] = word;
+        recentCount = qMin(recentCount + 1, 3);
+        if (recentCount >= 2) {
+            ++stats.totalBigrams;
+            ++stats.bigrams[Gram<2>{{recent[1], recent[2]}}];
+        }
+        if (recentCount == 3) {
+            ++stats.totalTrigrams;
+            ++stats.trigrams[Gram<3>{{recent[0], recent[1], recent[2]}}];
+        }
+    };
+
+    qsizetype i = chunk.from;
+    while (i < chunk.to) {
+        if (i - reported >= kProgressStride) {
+            if (promise.isCanceled()) {
+                return stats;
+            }
+            const qint64 done = processed.fetch_add(i - reported) + (i - reported);
+            promise.setProgressValue(static_cast<int>(done * 100 / text.size()));
+            reported = i;
+        }
+
+        const char16_t unit = text.at(i).unicode();
+        if (unit == u'\n') {
+            if (wordStart >= 0) {
+                finishWord(i);
+            }
+            ++stats.charClasses[TextAnalytics::Space];
+            ++stats.lineLengths[lineBucket(i - lineStart)];
+            ++stats.lines;
+            lineStart = i + 1;
+            recentCount = 0;
+            ++i;
+            continue;
+        }
+
+        char32_t codePoint = unit;
+        qsizetype width = 1;
+        if (QChar::isHighSurrogate(unit) && i + 1 < chunk.to && QChar::isLowSurrogate(text.at(i + 1).unicode())) {
+            codePoint = QChar::surrogateToUcs4(unit, text.at(i + 1).unicode());
+            width = 2;
+        }
+        const CharClass charClass = codePoint < 128 ? static_cast<CharClass>(ascii[codePoint]) : classify(codePoint);
+        ++stats.charClasses[charClass];
+
+        const bool word = codePoint < 128 ? (charClass == TextAnalytics::Letter || charClass == TextAnalytics::Digit
+                                             || codePoint == U'_')
+                                          : isWordChar(codePoint, charClass);
+        if (word && wordStart < 0) {
+            wordStart = i;
+        } else if (!word && wordStart >= 0) {
+            finishWord(i);
+        }
+        i += width;
+    }
+
+    if (wordStart >= 0) {
+        finishWord(chunk.to);
+    }
+    if (chunk.last) {
+        ++stats.lineLengths[lineBucket(chunk.to - lineStart)];
+        ++stats.lines;
+    }
+    processed.fetch_add(chunk.to - reported);
+    return stats;
+}
+
+template <int N>
+void mergeInto(GramMap<N> &target, GramMap<N> &source)
+{
+    if (source.size() > target.size()) {
+        target.swap(source);
+    }
+    for (const auto &[gram, count] : source) {
+        target[gram] += count;
+    }
+    GramMap<N>().swap(source);
+}
+
+void mergeStats(ChunkStats &target, ChunkStats &source)
+{
+    mergeInto(target.words, source.words);
+    mergeInto(target.bigrams, source.bigrams);
+    mergeInto(target.trigrams, source.trigrams);
+    for (int i = 0; i < TextAnalytics::kLineLengthBuckets; ++i) {
+        target.lineLengths[i] += source.lineLengths[i];
+    }
+    for (int i = 0; i < TextAnalytics::CharClassCount; ++i) {
+        target.charClasses[i] += source.charClasses[i];
+    }
+    target.totalWords += source.totalWords;
+    target.totalBigrams += source.totalBigrams;
+    target.totalTrigrams += source.totalTrigrams;
+    target.lines += source.lines;
+}
+
+template <int N>
+QVector<FrequencyEntry> topEntries(const GramMap<N> &map, int topN)
+{
+    using Entry = typename GramMap<N>::const_pointer;
+    std::vector<Entry> entries;
+    entries.reserve(map.size());
+    for (const auto &entry : map) {
+        entries.push_back(&entry);
+    }
+    const auto count = static_cast<size_t>(qMin<qsizetype>(topN, static_cast<qsizetype>(entries.size())));
+    std::partial_sort(entries.begin(), entries.begin() + count, entries.end(), [](Entry a, Entry b) {
+        return a->second > b->second;
+    });
+
+    QVector<FrequencyEntry> result;
+    result.reserve(static_cast<qsizetype>(count));
+    for (size_t i = 0; i < count; ++i) {
+        QStringList words;
+        for (const QStringView word : entries[i]->first.words) {
+            words << word.toString().toLower();
+        }
+        result.append({words.join(QLatin1Char(' ')), entries[i]->second});
+    }
+    return result;
+}
+
+}
+
+QString TextAnalytics::bucketLabel(int bucket)
+{
+    if (bucket <= 0) {
+        return QStringLiteral("0");
+    }
+    const qint64 low = qint64(1) << (bucket - 1);
+    if (bucket == kLineLengthBuckets - 1) {
+        return QString("%1+").arg(low);
+    }
+    const qint64 high = (qint64(1) << bucket) - 1;
+    return low == high ? QString::number(low) : QString("%1–%2").arg(low).arg(high);
+}
+
+QString TextAnalytics::charClassName(CharClass charClass)
+{
+    switch (charClass) {
+    case Letter: return QStringLiteral("Буквы");
+    case Digit: return QStringLiteral("Цифры");
+    case Space: return QStringLiteral("Пробельные");
+    case Punctuation: return QStringLiteral("Пунктуация");
+    case Symbol: return QStringLiteral("Символы");
+    default: return QStringLiteral("Прочие");
+    }
+}
+
+void TextAnalytics::analyze(QPromise<TextAnalyticsReport> &promise, QThreadPool *pool, const QString &text, int topN)
+{
+    QElapsedTimer timer;
+    timer.start();
+    promise.setProgressRange(0, 100);
+
+    const QStringView view(text);
+    QVector<Chunk> chunks = splitChunks(view, qMax(1, pool->maxThreadCount()));
+    std::atomic<qint64> processed{0};
+    QVector<ChunkStats> stats = QtConcurrent::blockingMapped<QVector<ChunkStats>>(
+        pool, chunks, [&](const Chunk &chunk) { return scanChunk(view, chunk, promise, processed); });
+    if (promise.isCanceled()) {
+        return;
+    }
+
+    const auto count = static_cast<int>(stats.size());
+    ChunkStats *data = stats.data();
+    for (int width = 1; width < count; width *= 2) {
+        QVector<int> starts;
+        for (int i = 0; i + width < count; i += 2 * width) {
+            starts.append(i);
+        }
+        QtConcurrent::blockingMap(pool, starts, [data, width](int first) {
+            mergeStats(data[first], data[first + width]);
+        });
+    }
+
+    const ChunkStats &total = stats.first();
+    TextAnalyticsReport report;
+    report.words = topEntries(total.words, topN);
+    report.bigrams = topEntries(total.bigrams, topN);
+    report.trigrams = topEntries(total.trigrams, topN);
+    report.lineLengths = total.lineLengths;
+    report.charClasses = total.charClasses;
+    report.totalWords = total.totalWords;
+    report.totalBigrams = total.totalBigrams;
+    report.totalTrigrams = total.totalTrigrams;
+    report.uniqueWords = static_cast<qint64>(total.words.size());
+    report.lines = total.lines;
+    report.characters = text.size();
+    report.elapsedMs = timer.elapsed();
+    promise.setProgressValue(100);
+    promise.addResult(std::move(report));
+}
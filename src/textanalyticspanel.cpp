@@ -0,0 +1,218 @@
+#include "../headers/textanalyticspanel.h"
+#include "../headers/idocument.h"
+
+#include <QtConcurrent/QtConcurrentRun>
+#include <QSpinBox>
+#include <QPushButton>
+#include <QLabel>
+#include <QProgressBar>
+#include <QTabWidget>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QThread>
+
+namespace {
+
+constexpr int kDefaultTopN = 50;
+
+QTreeWidget *createTree(const QStringList &headers, QWidget *parent)
+{
+    auto *tree = new QTreeWidget(parent);
+    tree->setRootIsDecorated(false);
+    tree->setUniformRowHeights(true);
+    tree->setHeaderLabels(headers);
+    tree->header()->setSectionResizeMode(0, QHeaderView::Stretch);
+    tree->header()->setStretchLastSection(false);
+    return tree;
+}
+
+QString percent(qint64 part, qint64 total)
+{
+    return total > 0 ? QString::number(100.0 * static_cast<double>(part) / static_cast<double>(total), 'f', 2) + " %"
+                     : QString();
+}
+
+QString snapshotText(const IDocument *document, bool selection)
+{
+    if (!selection) {
+        return document->getPlainText();
+    }
+    const TextRange range = document->selectionRange();
+    QString text;
+    text.reserve(range.length());
+    bool first = true;
+    for (const TextChunk &chunk : document->blocks(range)) {
+        if (!first) {
+            text += QLatin1Char('\n');
+        }
+        text += chunk.text;
+        first = false;
+    }
+    return text;
+}
+
+}
+
+TextAnalyticsPanel::TextAnalyticsPanel(QWidget *parent)
+    : QWidget(parent)
+{
+    pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+
+    topSpin_ = new QSpinBox(this);
+    topSpin_->setRange(10, 10000);
+    topSpin_->setValue(kDefaultTopN);
+    topSpin_->setPrefix("Топ ");
+
+    analyzeButton_ = new QPushButton("Анализировать", this);
+    stopButton_ = new QPushButton("Стоп", this);
+    stopButton_->setEnabled(false);
+
+    progressBar_ = new QProgressBar(this);
+    progressBar_->setRange(0, 100);
+    progressBar_->setVisible(false);
+
+    summaryLabel_ = new QLabel(this);
+    summaryLabel_->setWordWrap(true);
+
+    wordsTree_ = createTree({"Слово", "Количество", "Доля"}, this);
+    bigramsTree_ = createTree({"Биграмма", "Количество", "Доля"}, this);
+    trigramsTree_ = createTree({"Триграмма", "Количество", "Доля"}, this);
+    linesTree_ = createTree({"Длина строки", "Строк", "Доля"}, this);
+    classesTree_ = createTree({"Класс символов", "Количество", "Доля"}, this);
+
+    auto *tabs = new QTabWidget(this);
+    tabs->addTab(wordsTree_, "Слова");
+    tabs->addTab(bigramsTree_, "Биграммы");
+    tabs->addTab(trigramsTree_, "Триграммы");
+    tabs->addTab(linesTree_, "Длины строк");
+    tabs->addTab(classesTree_, "Символы");
+
+    auto *controls = new QHBoxLayout();
+    controls->addWidget(topSpin_);
+    controls->addStretch(1);
+    controls->addWidget(progressBar_);
+    controls->addWidget(analyzeButton_);
+    controls->addWidget(stopButton_);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->addLayout(controls);
+    layout->addWidget(summaryLabel_);
+    layout->addWidget(tabs, 1);
+
+    connect(analyzeButton_, &QPushButton::clicked, this, &TextAnalyticsPanel::analyze);
+    connect(stopButton_, &QPushButton::clicked, this, &TextAnalyticsPanel::stop);
+    connect(&watcher_, &QFutureWatcher<TextAnalyticsReport>::progressValueChanged,
+            progressBar_, &QProgressBar::setValue);
+    connect(&watcher_, &QFutureWatcher<TextAnalyticsReport>::finished, this, &TextAnalyticsPanel::onFinished);
+}
+
+TextAnalyticsPanel::~TextAnalyticsPanel()
+{
+    watcher_.cancel();
+    watcher_.waitForFinished();
+}
+
+void TextAnalyticsPanel::setDocument(const IDocument *document)
+{
+    document_ = document;
+}
+
+void TextAnalyticsPanel::analyze()
+{
+    if (!document_) {
+        return;
+    }
+    stop();
+    watcher_.waitForFinished();
+
+    selectionOnly_ = document_->hasSelection();
+    const QString text = snapshotText(document_, selectionOnly_);
+
+    progressBar_->setValue(0);
+    progressBar_->setVisible(true);
+    analyzeButton_->setEnabled(false);
+    stopButton_->setEnabled(true);
+    summaryLabel_->setText(QString("Анализ %1 символов…").arg(text.size()));
+    watcher_.setFuture(QtConcurrent::run(TextAnalytics::analyze, &pool_, text, topSpin_->value()));
+}
+
+void TextAnalyticsPanel::stop()
+{
+    watcher_.cancel();
+}
+
+void TextAnalyticsPanel::onFinished()
+{
+    progressBar_->setVisible(false);
+    analyzeButton_->setEnabled(true);
+    stopButton_->setEnabled(false);
+
+    const QFuture<TextAnalyticsReport> future = watcher_.future();
+    if (future.isCanceled() || future.resultCount() == 0) {
+        summaryLabel_->setText("Анализ остановлен");
+        return;
+    }
+    showReport(future.result());
+}
+
+void TextAnalyticsPanel::showReport(const TextAnalyticsReport &report)
+{
+    const double seconds = qMax<qint64>(report.elapsedMs, 1) / 1000.0;
+    summaryLabel_->setText(QString("%1Слов: %2 (уникальных: %3) | Строк: %4 | Символов: %5 | %6 мс, %7 МБ/с")
+                               .arg(selectionOnly_ ? QString("Выделение — ") : QString())
+                               .arg(report.totalWords)
+                               .arg(report.uniqueWords)
+                               .arg(report.lines)
+                               .arg(report.characters)
+                               .arg(report.elapsedMs)
+                               .arg(static_cast<double>(report.characters) * 2 / (1024.0 * 1024.0) / seconds, 0, 'f', 1));
+
+    fillFrequencies(wordsTree_, report.words, report.totalWords);
+    fillFrequencies(bigramsTree_, report.bigrams, report.totalBigrams);
+    fillFrequencies(trigramsTree_, report.trigrams, report.totalTrigrams);
+
+    linesTree_->clear();
+    for (int bucket = 0; bucket < TextAnalytics::kLineLengthBuckets; ++bucket) {
+        const qint64 count = report.lineLengths[bucket];
+        if (count == 0) {
+            continue;
+        }
+        auto *item = new QTreeWidgetItem(linesTree_);
+        item->setText(0, TextAnalytics::bucketLabel(bucket));
+        item->setText(1, QString::number(count));
+        item->setText(2, percent(count, report.lines));
+        item->setTextAlignment(1, Qt::AlignRight);
+        item->setTextAlignment(2, Qt::AlignRight);
+    }
+
+    classesTree_->clear();
+    for (int charClass = 0; charClass < TextAnalytics::CharClassCount; ++charClass) {
+        const qint64 count = report.charClasses[charClass];
+        auto *item = new QTreeWidgetItem(classesTree_);
+        item->setText(0, TextAnalytics::charClassName(static_cast<TextAnalytics::CharClass>(charClass)));
+        item->setText(1, QString::number(count));
+        item->setText(2, percent(count, report.characters));
+        item->setTextAlignment(1, Qt::AlignRight);
+        item->setTextAlignment(2, Qt::AlignRight);
+    }
+}
+
+void TextAnalyticsPanel::fillFrequencies(QTreeWidget *tree, const QVector<FrequencyEntry> &entries, qint64 total)
+{
+    tree->clear();
+    QList<QTreeWidgetItem *> items;
+    items.reserve(entries.size());
+    for (const FrequencyEntry &entry : entries) {
+        auto *item = new QTreeWidgetItem();
+        item->setText(0, entry.text);
+        item->setText(1, QString::number(entry.count));
+        item->setText(2, percent(entry.count, total));
+        item->setTextAlignment(1, Qt::AlignRight);
+        item->setTextAlignment(2, Qt::AlignRight);
+        items.append(item);
+    }
+    tree->addTopLevelItems(items);
+}
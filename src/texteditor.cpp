@@ -8,8 +8,35 @@
 #include <QActionGroup>
 #include <QToolButton>
 #include <stdexcept>
+#include <algorithm>
 #include <QtPdf/QPdfDocument>
-#include <QtPdfWidgets/QPdfView>
+#include <QDockWidget>
+#include "../headers/pdfsearch.h"
+#include "../headers/findbar.h"
+#include "../headers/findinfilespanel.h"
+#include "../headers/occurrencehighlighter.h"
+#include "../headers/edittoolexecutor.h"
+#include "../headers/textanalyticspanel.h"
+#include "../headers/multicursor.h"
+#include "../headers/macro.h"
+#include "../headers/externalfilter.h"
+#include "../headers/cpphighlighter.h"
+#include "../headers/symbolindex.h"
+#include "../headers/symbolpanel.h"
+#include "../headers/lspclient.h"
+#include "../headers/diagnostichighlighter.h"
+#include "../headers/completionpopup.h"
+#include "../headers/spellchecker.h"
+#include "../headers/wordindex.h"
+#include "../headers/gitgutter.h"
+#include "../headers/compareview.h"
+#include "../headers/filechangemonitor.h"
+#include "../headers/logfollower.h"
+#include <QDir>
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QMenu>
+#include <QTextBlock>
 #include "../headers/myvector.h"
 
 TextEditor::TextEditor(QWidget *parent)
@@ -22,6 +49,19 @@ TextEditor::TextEditor(QWidget *parent)
     textEdit = new QTextEdit(this);
     document_ = new Document(this);
     textEdit->setDocument(document_->qtDocument());
+    document_->attachEditor(textEdit);
+    multiCursor = new MultiCursorController(textEdit, this);
+    macroRecorder = new MacroRecorder(textEdit, this);
+    filterRunner = new ExternalFilterRunner(this);
+    cppHighlighter = new CppHighlighter(textEdit, this);
+    symbolIndex = new SymbolIndex(this);
+    lspClient_ = new LspClient(this);
+    diagnosticHighlighter = new DiagnosticHighlighter(textEdit, this);
+    completionPopup = new CompletionPopup(textEdit, this);
+    spellChecker = new SpellChecker(textEdit, this);
+    wordCompleter = new WordCompleter(textEdit, completionPopup, this);
+    fileMonitor = new FileChangeMonitor(textEdit, this);
+    logFollower = new LogFollower(textEdit, this);
     ui_ = std::make_unique<TextEditorUi>(this);
 
     formatController_ = std::make_unique<TextFormatController>(textEdit, this);
@@ -44,7 +84,21 @@ TextEditor::TextEditor(QWidget *parent)
     pdfView = nullptr;
     pdfDocument = nullptr;
 
-    centralStack->addWidget(textEdit);
+    editorPage = new QWidget(this);
+    findBar = new FindBar(textEdit, editorPage);
+    findBar->hide();
+    gitGutter = new GitGutter(textEdit, editorPage);
+    auto *editorRow = new QHBoxLayout();
+    editorRow->setSpacing(0);
+    editorRow->addWidget(gitGutter);
+    editorRow->addWidget(textEdit, 1);
+    auto *editorLayout = new QVBoxLayout(editorPage);
+    editorLayout->setContentsMargins(0, 0, 0, 0);
+    editorLayout->setSpacing(0);
+    editorLayout->addLayout(editorRow, 1);
+    editorLayout->addWidget(findBar);
+
+    centralStack->addWidget(editorPage);
     setCentralWidget(centralStack);
 
     QFont defaultFont("Times New Roman", 12);
@@ -64,11 +118,102 @@ TextEditor::TextEditor(QWidget *parent)
     connect(ui_->themeComboBox(), &QComboBox::currentTextChanged, this, &TextEditor::changeTheme);
     connect(ui_->toolsComboBox(), &QComboBox::activated, this, &TextEditor::executeEditTool);
     connect(speechManager, &SpeechManager::errorOccurred, this, &TextEditor::onSpeechError);
+    connect(findBar, &FindBar::statusMessage, ui_->statusLabel(), &QLabel::setText);
+    connect(findBar, &FindBar::navigated, macroRecorder, &MacroRecorder::recordFind);
+    connect(macroRecorder, &MacroRecorder::recordingChanged, this, [this](bool recording) {
+        ui_->statusLabel()->setText(recording ? QString("Запись макроса…")
+                                              : QString("Макрос записан, шагов: %1").arg(macroRecorder->macro().size()));
+    });
+
+    editToolExecutor_ = std::make_unique<EditToolExecutor>();
+    connect(editToolExecutor_.get(), &EditToolExecutor::started, this, &TextEditor::onToolStarted);
+    connect(editToolExecutor_.get(), &EditToolExecutor::progress, ui_->toolProgress(), &QProgressBar::setValue);
+    connect(editToolExecutor_.get(), &EditToolExecutor::finished, this, &TextEditor::onToolFinished);
+    connect(ui_->toolCancelButton(), &QToolButton::clicked, editToolExecutor_.get(), &EditToolExecutor::cancel);
+
+    connect(filterRunner, &ExternalFilterRunner::started, this, &TextEditor::onToolStarted);
+    connect(filterRunner, &ExternalFilterRunner::progress, ui_->toolProgress(), &QProgressBar::setValue);
+    connect(filterRunner, &ExternalFilterRunner::finished, this, &TextEditor::onToolFinished);
+    connect(ui_->toolCancelButton(), &QToolButton::clicked, filterRunner, &ExternalFilterRunner::cancel);
+
+    connect(multiCursor, &MultiCursorController::editApplied, this, [this](int cursors, qint64 nanoseconds) {
+        ui_->statusLabel()->setText(QString("Курсоров: %1 | правка за %2 мкс").arg(cursors).arg(nanoseconds / 1000));
+    });
+
+    connect(symbolIndex, &SymbolIndex::updated, this, [this](qsizetype files, qsizetype symbols) {
+        ui_->statusLabel()->setText(QString("Индекс символов: %1 файлов, %2 символов").arg(files).arg(symbols));
+    });
+    connect(symbolIndex, &SymbolIndex::failed, ui_->statusLabel(), &QLabel::setText);
+
+    connect(spellChecker, &SpellChecker::statusMessage, ui_->statusLabel(), &QLabel::setText);
+    spellChecker->setEnabled(spellCheckEnabled);
+
+    connect(wordCompleter, &WordCompleter::completed, this, [this](int candidates, qint64 microseconds) {
+        ui_->statusLabel()->setText(QString("Слов в индексе: %1 | вариантов: %2 за %3 мкс")
+                                        .arg(wordCompleter->wordCount()).arg(candidates).arg(microseconds));
+    });
+
+    connect(fileMonitor, &FileChangeMonitor::changedOnDisk, this, &TextEditor::onChangedOnDisk);
+    connect(fileMonitor, &FileChangeMonitor::removedOnDisk, this, [this](const QString &filePath) {
+        ui_->statusLabel()->setText("Файл удалён с диска: " + filePath);
+    });
+    connect(fileMonitor, &FileChangeMonitor::reloaded, this, [this](int hunks, qint64 milliseconds) {
+        ui_->statusLabel()->setText(QString("Файл обновлён с диска: фрагментов %1 за %2 мс").arg(hunks).arg(milliseconds));
+    });
+    connect(fileMonitor, &FileChangeMonitor::failed, ui_->statusLabel(), &QLabel::setText);
+
+    // The follower appends to the buffer itself, so change detection pauses.
+    connect(logFollower, &LogFollower::followingChanged, this, [this](bool following) {
+        const QSignalBlocker blocker(ui_->followLogAct);
+        ui_->followLogAct->setChecked(following);
+        if (following) {
+            fileMonitor->watch(QString());
+        } else {
+            watchCurrentFile(logFollower->offset());
+        }
+    });
+    connect(logFollower, &LogFollower::statusMessage, ui_->statusLabel(), &QLabel::setText);
+
+    connect(lspClient_, &LspClient::statusMessage, ui_->statusLabel(), &QLabel::setText);
+    connect(lspClient_, &LspClient::diagnosticsChanged, this, [this](const QVector<LspDiagnostic> &diagnostics) {
+        diagnosticHighlighter->setDiagnostics(diagnostics);
+        if (lspClient_->hasDocument()) {
+            ui_->statusLabel()->setText(QString("Диагностика: ошибок %1, предупреждений %2")
+                                            .arg(diagnosticHighlighter->errorCount())
+                                            .arg(diagnosticHighlighter->warningCount()));
+        }
+    });
+    connect(diagnosticHighlighter, &DiagnosticHighlighter::hoverRequested, lspClient_, &LspClient::requestHover);
+    connect(lspClient_, &LspClient::hoverReady, diagnosticHighlighter, &DiagnosticHighlighter::showHover);
+    connect(lspClient_, &LspClient::completionReady, this, [this](int position, const QVector<LspCompletionItem> &items) {
+        const QTextBlock block = textEdit->document()->findBlock(position);
+        const QString line = block.text();
+        int start = position - block.position();
+        while (start > 0 && (line.at(start - 1).isLetterOrNumber() || line.at(start - 1) == u'_')) {
+            --start;
+        }
+        QVector<CompletionPopup::Entry> entries;
+        entries.reserve(items.size());
+        for (const LspCompletionItem &item : items) {
+            entries.append({item.insertText, item.detail.isEmpty() ? item.label : item.label + " — " + item.detail});
+        }
+        completionPopup->show(block.position() + start, entries);
+    });
+    connect(lspClient_, &LspClient::requestTraced, this, [this](const QString &method, qint64 milliseconds) {
+        if (method == "textDocument/completion") {
+            ui_->statusLabel()->setText(QString("Автодополнение: ответ сервера за %1 мс").arg(milliseconds));
+        }
+    });
+
+    occurrenceHighlighter = new OccurrenceHighlighter(textEdit, this);
+    connect(occurrenceHighlighter, &OccurrenceHighlighter::countChanged, ui_->occurrenceLabel(), &QLabel::setText);
 
     autoSaveTimer = new QTimer(this);
     autoSaveTimer->setSingleShot(true);
     connect(autoSaveTimer, &QTimer::timeout, this, [this]() {
-        if (autoSaveEnabled && !currentFile.isEmpty() && textEdit->document()->isModified()) {
+        // Never autosave over a change on disk the user has not seen yet.
+        if (autoSaveEnabled && !currentFile.isEmpty() && textEdit->document()->isModified()
+            && !reloadPromptOpen && !fileMonitor->isReloading() && !fileMonitor->isChangedOnDisk()) {
             fileController_->saveFile();
         }
     });
@@ -101,6 +246,417 @@ void TextEditor::onSpeechError(const QString &error)
     ui_->statusLabel()->setText("Ошибка: " + error);
 }
 
+void TextEditor::find()
+{
+    if (pdfView && centralStack->currentWidget() == pdfView) {
+        if (pdfSearchDock && pdfSearchPanel) {
+            pdfSearchDock->show();
+            pdfSearchDock->raise();
+            pdfSearchPanel->activate();
+        }
+        return;
+    }
+    findBar->activate();
+}
+
+void TextEditor::findNext()
+{
+    if (centralStack->currentWidget() == editorPage) {
+        findBar->isVisible() ? findBar->findNext() : findBar->activate();
+    }
+}
+
+void TextEditor::replace()
+{
+    if (centralStack->currentWidget() == editorPage) {
+        findBar->activateReplace();
+    }
+}
+
+void TextEditor::findInFiles()
+{
+    if (!findInFilesDock) {
+        findInFilesPanel = new FindInFilesPanel();
+        findInFilesDock = new QDockWidget("Поиск в файлах", this);
+        findInFilesDock->setWidget(findInFilesPanel);
+        addDockWidget(Qt::BottomDockWidgetArea, findInFilesDock);
+        findInFilesPanel->setRootPath(currentFile.isEmpty() ? QDir::currentPath()
+                                                            : QFileInfo(currentFile).absolutePath());
+        connect(findInFilesPanel, &FindInFilesPanel::openRequested,
+                fileController_.get(), &TextFileController::openFileAt);
+        connect(findInFilesPanel, &FindInFilesPanel::filesRewritten, this, [this](const QStringList &files) {
+            const bool touchesCurrent = std::any_of(files.cbegin(), files.cend(), [this](const QString &file) {
+                return QFileInfo(file) == QFileInfo(currentFile);
+            });
+            if (!touchesCurrent) {
+                return;
+            }
+            // Plain text goes through the monitor: it asks about unsaved
+            // edits and reloads as one undo step.
+            autoSaveTimer->stop();
+            if (documentManager_.isPlainText(currentFile)) {
+                fileMonitor->checkNow();
+                return;
+            }
+            if (textEdit->document()->isModified()
+                && QMessageBox::question(this, "Файл изменён",
+                                         "Файл изменён заменой в файлах:\n" + currentFile
+                                             + "\n\nЗагрузить новую версию? Несохранённые правки будут потеряны.")
+                       != QMessageBox::Yes) {
+                scheduleAutoSave();
+                return;
+            }
+            fileController_->openPath(currentFile);
+        });
+    }
+
+    QString initialPattern;
+    if (const QTextCursor cursor = textEdit->textCursor(); cursor.hasSelection()) {
+        initialPattern = cursor.selectedText();
+        if (initialPattern.contains(QChar::ParagraphSeparator)) {
+            initialPattern.clear();
+        }
+    }
+    findInFilesDock->show();
+    findInFilesDock->raise();
+    findInFilesPanel->activate(initialPattern);
+}
+
+void TextEditor::textAnalytics()
+{
+    if (!analyticsDock) {
+        analyticsPanel = new TextAnalyticsPanel();
+        analyticsPanel->setDocument(document_);
+        analyticsDock = new QDockWidget("Анализ текста", this);
+        analyticsDock->setWidget(analyticsPanel);
+        addDockWidget(Qt::RightDockWidgetArea, analyticsDock);
+    }
+    analyticsDock->show();
+    analyticsDock->raise();
+    analyticsPanel->analyze();
+}
+
+void TextEditor::setMacroRecording(bool recording)
+{
+    recording ? macroRecorder->start() : macroRecorder->stop();
+}
+
+void TextEditor::replayMacro()
+{
+    startMacroReplay(1);
+}
+
+void TextEditor::replayMacroTimes()
+{
+    bool ok = false;
+    const int iterations = QInputDialog::getInt(this, "Воспроизведение макроса",
+                                                "Количество повторов (0 — до конца файла):",
+                                                0, 0, 10000000, 1, &ok);
+    if (ok) {
+        startMacroReplay(iterations);
+    }
+}
+
+void TextEditor::startMacroReplay(int iterations)
+{
+    macroRecorder->stop();
+    if (macroRecorder->macro().isEmpty()) {
+        ui_->statusLabel()->setText("Макрос не записан");
+        return;
+    }
+    if (editToolExecutor_->isRunning()) {
+        ui_->statusLabel()->setText("Дождитесь завершения текущей операции");
+        return;
+    }
+
+    macroReplay_ = std::make_unique<MacroReplayTool>(macroRecorder->macro(), *editToolManager_, iterations);
+    if (!macroReplay_->canExecute(document_, textEdit)) {
+        ui_->statusLabel()->setText(macroReplay_->isValid() ? QString("Макрос нельзя применить к документу")
+                                                            : macroReplay_->errorString());
+        return;
+    }
+    editToolExecutor_->start(macroReplay_.get(), document_, textEdit);
+}
+
+void TextEditor::filterThroughCommand()
+{
+    if (centralStack->currentWidget() != editorPage || textEdit->isReadOnly()) {
+        return;
+    }
+    if (filterRunner->isRunning() || editToolExecutor_->isRunning()) {
+        ui_->statusLabel()->setText("Дождитесь завершения текущей операции");
+        return;
+    }
+    bool ok = false;
+    const QString command = QInputDialog::getText(this, "Фильтр через команду",
+                                                  document_->hasSelection() ? "Команда для выделения:"
+                                                                            : "Команда для всего документа:",
+                                                  QLineEdit::Normal, lastFilterCommand, &ok);
+    if (ok && !command.trimmed().isEmpty()) {
+        lastFilterCommand = command;
+        filterRunner->start(command, document_, textEdit);
+    }
+}
+
+void TextEditor::compareWithSaved()
+{
+    if (centralStack->currentWidget() != editorPage) {
+        return;
+    }
+    if (currentFile.isEmpty()) {
+        ui_->statusLabel()->setText("Документ ещё не сохранён");
+        return;
+    }
+    auto *dialog = new CompareDialog(this);
+    dialog->compare(currentFile, "Редактор", textEdit->toPlainText());
+    dialog->show();
+}
+
+void TextEditor::compareWithFile()
+{
+    if (centralStack->currentWidget() != editorPage) {
+        return;
+    }
+    const QString dir = currentFile.isEmpty() ? QDir::homePath() : QFileInfo(currentFile).absolutePath();
+    const QString filePath = QFileDialog::getOpenFileName(this, "Сравнить с файлом", dir,
+                                                          documentManager_.filterForOpenDialog());
+    if (filePath.isEmpty()) {
+        return;
+    }
+    auto *dialog = new CompareDialog(this);
+    dialog->compare(filePath, currentFile.isEmpty() ? QString("Редактор") : QFileInfo(currentFile).fileName(),
+                    textEdit->toPlainText());
+    dialog->show();
+}
+
+void TextEditor::setLogFollowing(bool enabled)
+{
+    if (!enabled) {
+        logFollower->stop();
+        return;
+    }
+    QString error;
+    if (centralStack->currentWidget() != editorPage || currentFile.isEmpty() || !documentManager_.isPlainText(currentFile)) {
+        error = "Слежение доступно только для сохранённых текстовых файлов";
+    } else if (fileMonitor->finishReload(); textEdit->document()->isModified()) {
+        error = "Сохраните документ перед слежением за файлом";
+    } else if (logFollower->start(currentFile, fileMonitor->syncedBytes(), error)) {
+        return;
+    }
+    const QSignalBlocker blocker(ui_->followLogAct);
+    ui_->followLogAct->setChecked(false);
+    ui_->statusLabel()->setText(error);
+}
+
+void TextEditor::setLogFollowRate()
+{
+    bool ok = false;
+    const int lines = QInputDialog::getInt(this, "Слежение за файлом", "Строк за кадр:",
+                                           logFollower->linesPerFrame(), 1, 1000000, 100, &ok);
+    if (ok) {
+        logFollower->setLinesPerFrame(lines);
+    }
+}
+
+void TextEditor::onToolStarted(const QString &toolName)
+{
+    ui_->toolProgress()->setValue(0);
+    ui_->toolProgress()->setVisible(true);
+    ui_->toolCancelButton()->setVisible(true);
+    ui_->statusLabel()->setText(toolName + "…");
+}
+
+void TextEditor::onToolFinished(const QString &message)
+{
+    ui_->toolProgress()->setVisible(false);
+    ui_->toolCancelButton()->setVisible(false);
+    ui_->statusLabel()->setText(message);
+}
+
+// Highlighting, the outline and the project symbol index only run for
+// C/C++ sources.
+void TextEditor::updateSourceFeatures()
+{
+    const bool source = CppHighlighter::handlesFile(currentFile);
+    cppHighlighter->setEnabled(source);
+    if (source) {
+        symbolIndex->openForFile(currentFile);
+    }
+    if (outlinePanel) {
+        outlinePanel->setActive(source);
+    }
+    spellChecker->setEnabled(spellCheckEnabled && !source);
+
+    if (source && LspClient::isAvailable()) {
+        const QString root = SymbolIndex::projectRoot(currentFile);
+        if (!lspClient_->isRunning() || lspClient_->rootPath() != root) {
+            lspClient_->start(root);
+        }
+        lspClient_->openDocument(currentFile, textEdit->document());
+    } else {
+        lspClient_->closeDocument();
+    }
+    wordCompleter->setAutoComplete(wordAutoCompleteEnabled && !lspClient_->hasDocument());
+    logFollower->stop();
+    watchCurrentFile(documentManager_.context().syncedBytes);
+}
+
+// Rich text loaded from HTML or RTF never matches its source lines, so the
+// gutter and the change monitor only follow plain-text files.
+void TextEditor::watchCurrentFile(qint64 syncedBytes)
+{
+    const QString plainFile = documentManager_.isPlainText(currentFile) ? currentFile : QString();
+    gitGutter->setFile(plainFile);
+    fileMonitor->watch(plainFile, syncedBytes);
+}
+
+// An unmodified buffer follows the file silently; otherwise the user
+// decides. Either way the reload is a single undo step.
+void TextEditor::onChangedOnDisk(const QString &filePath)
+{
+    if (reloadPromptOpen) {
+        return;
+    }
+    autoSaveTimer->stop();
+    if (textEdit->document()->isModified()) {
+        reloadPromptOpen = true;
+        const auto reply = QMessageBox::question(
+            this, "Файл изменён",
+            "Файл изменён другой программой:\n" + filePath
+                + "\n\nЗагрузить новую версию? Несохранённые правки можно будет вернуть отменой.");
+        reloadPromptOpen = false;
+        if (reply != QMessageBox::Yes) {
+            scheduleAutoSave();
+            return;
+        }
+    }
+    fileMonitor->reload();
+}
+
+void TextEditor::setSpellChecking(bool enabled)
+{
+    spellCheckEnabled = enabled;
+    spellChecker->setEnabled(enabled && !CppHighlighter::handlesFile(currentFile));
+}
+
+void TextEditor::setWordAutoComplete(bool enabled)
+{
+    wordAutoCompleteEnabled = enabled;
+    wordCompleter->setAutoComplete(enabled && !lspClient_->hasDocument());
+}
+
+// Sources open in clangd are completed by the server, everything else from
+// the words of the document.
+void TextEditor::triggerCompletion()
+{
+    if (centralStack->currentWidget() != editorPage) {
+        return;
+    }
+    if (!lspClient_->hasDocument()) {
+        wordCompleter->complete();
+        return;
+    }
+    lspClient_->requestCompletion(textEdit->textCursor().position());
+}
+
+void TextEditor::goToDefinition()
+{
+    if (centralStack->currentWidget() != editorPage) {
+        return;
+    }
+
+    QTextCursor cursor = textEdit->textCursor();
+    QString name = cursor.selectedText().trimmed();
+    if (name.isEmpty()) {
+        const QString line = cursor.block().text();
+        auto isWordChar = [](QChar ch) { return ch.isLetterOrNumber() || ch == u'_'; };
+        int start = cursor.positionInBlock();
+        int end = start;
+        while (start > 0 && isWordChar(line.at(start - 1))) {
+            --start;
+        }
+        while (end < line.size() && isWordChar(line.at(end))) {
+            ++end;
+        }
+        name = line.mid(start, end - start);
+    }
+    if (name.isEmpty()) {
+        return;
+    }
+    if (symbolIndex->rootPath().isEmpty()) {
+        ui_->statusLabel()->setText("Индекс символов не построен: откройте C/C++ файл проекта");
+        return;
+    }
+
+    QVector<SymbolLocation> locations = symbolIndex->definitions(name);
+    const auto firstDeclaration = std::find_if(locations.cbegin(), locations.cend(), [](const SymbolLocation &location) {
+        return !location.symbol.definition;
+    });
+    if (firstDeclaration != locations.cbegin()) {
+        locations.erase(firstDeclaration, locations.cend());
+    }
+    if (locations.isEmpty()) {
+        ui_->statusLabel()->setText(QString("Определение «%1» не найдено%2")
+                                        .arg(name, symbolIndex->isBusy() ? QString(" (индекс обновляется)") : QString()));
+        return;
+    }
+    if (locations.size() == 1) {
+        fileController_->openFileAt(locations.first().path, locations.first().symbol.line, locations.first().symbol.column);
+        return;
+    }
+
+    QMenu menu(this);
+    const QDir root(symbolIndex->rootPath());
+    for (const SymbolLocation &location : locations) {
+        QAction *act = menu.addAction(QString("%1  —  %2:%3")
+                                          .arg(location.symbol.qualifiedName(),
+                                               QDir::toNativeSeparators(root.relativeFilePath(location.path)))
+                                          .arg(location.symbol.line));
+        connect(act, &QAction::triggered, this, [this, location]() {
+            fileController_->openFileAt(location.path, location.symbol.line, location.symbol.column);
+        });
+    }
+    menu.exec(textEdit->viewport()->mapToGlobal(textEdit->cursorRect().bottomLeft()));
+}
+
+void TextEditor::findSymbol()
+{
+    if (!symbolQuickOpen) {
+        symbolQuickOpen = new SymbolQuickOpen(symbolIndex, this);
+        connect(symbolQuickOpen, &SymbolQuickOpen::openRequested, fileController_.get(), &TextFileController::openFileAt);
+    }
+    symbolQuickOpen->activate(textEdit->textCursor().selectedText().trimmed());
+}
+
+void TextEditor::showOutline()
+{
+    if (!outlineDock) {
+        outlinePanel = new OutlinePanel();
+        outlinePanel->setDocument(textEdit->document());
+        outlineDock = new QDockWidget("Структура файла", this);
+        outlineDock->setWidget(outlinePanel);
+        addDockWidget(Qt::LeftDockWidgetArea, outlineDock);
+        connect(outlinePanel, &OutlinePanel::activated, this, [this](int line, int column) {
+            fileController_->openFileAt(currentFile, line, column);
+        });
+    }
+    outlinePanel->setActive(CppHighlighter::handlesFile(currentFile));
+    outlineDock->show();
+    outlineDock->raise();
+}
+
+void TextEditor::setHighlightOccurrences(bool enabled)
+{
+    occurrenceHighlighter->setEnabled(enabled);
+}
+
+void TextEditor::findPrevious()
+{
+    if (centralStack->currentWidget() == editorPage) {
+        findBar->isVisible() ? findBar->findPrevious() : findBar->activate();
+    }
+}
+
 void TextEditor::setupEditTools()
 {
     auto tools = editToolManager_->getAvailableTools();
@@ -131,6 +687,7 @@ void TextEditor::applyTheme()
     try {
         const ITheme* theme = themeManager_->getCurrentTheme();
         setStyleSheet(theme->getStylesheet());
+        cppHighlighter->setDarkPalette(theme->getBackgroundColor().lightness() < 128);
         updateStatusBar();
     } catch (const ThemeException& e) {
         QMessageBox::warning(this, "Ошибка темы", e.what());
@@ -153,7 +710,10 @@ void TextEditor::executeEditTool()
 {
     QString toolName = ui_->toolsComboBox()->currentText();
     if (toolName != "Инструменты...") {
-        editToolManager_->executeTool(toolName, document_, textEdit);
+        if (const IEditTool *tool = editToolManager_->findTool(toolName, document_, textEdit)) {
+            macroRecorder->recordTool(toolName);
+            editToolExecutor_->start(tool, document_, textEdit);
+        }
         ui_->toolsComboBox()->setCurrentIndex(0);
     }
 }
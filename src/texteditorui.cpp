@@ -1,6 +1,9 @@
 #include "../headers/texteditorui.h"
 #include "../headers/texteditor.h"
 #include "../headers/textformatcontroller.h"
+#include "../headers/multicursor.h"
+#include "../headers/macro.h"
+#include "../headers/wordindex.h"
 #include <QMenuBar>
 #include <QToolButton>
 #include <QColorDialog>
@@ -57,6 +60,53 @@ void TextEditorUi::createActions()
     edit_.pasteAct->setShortcut(QKeySequence::Paste);
     QObject::connect(edit_.pasteAct, &QAction::triggered, owner_->textEdit, &QTextEdit::paste);
 
+    edit_.findAct = new QAction("🔍 Найти", owner_);
+    edit_.findAct->setShortcut(QKeySequence::Find);
+    QObject::connect(edit_.findAct, &QAction::triggered, owner_, &TextEditor::find);
+
+    edit_.findNextAct = new QAction("Найти далее", owner_);
+    edit_.findNextAct->setShortcut(QKeySequence::FindNext);
+    QObject::connect(edit_.findNextAct, &QAction::triggered, owner_, &TextEditor::findNext);
+
+    edit_.findPreviousAct = new QAction("Найти ранее", owner_);
+    edit_.findPreviousAct->setShortcut(QKeySequence::FindPrevious);
+    QObject::connect(edit_.findPreviousAct, &QAction::triggered, owner_, &TextEditor::findPrevious);
+
+    edit_.replaceAct = new QAction("Заменить...", owner_);
+    edit_.replaceAct->setShortcut(QKeySequence::Replace);
+    QObject::connect(edit_.replaceAct, &QAction::triggered, owner_, &TextEditor::replace);
+
+    edit_.findInFilesAct = new QAction("Найти в файлах...", owner_);
+    edit_.findInFilesAct->setShortcut(QKeySequence("Ctrl+Shift+F"));
+    QObject::connect(edit_.findInFilesAct, &QAction::triggered, owner_, &TextEditor::findInFiles);
+
+    edit_.highlightOccurrencesAct = new QAction("Подсвечивать вхождения", owner_);
+    edit_.highlightOccurrencesAct->setCheckable(true);
+    edit_.highlightOccurrencesAct->setChecked(true);
+    QObject::connect(edit_.highlightOccurrencesAct, &QAction::toggled, owner_, &TextEditor::setHighlightOccurrences);
+
+    edit_.addCaretAboveAct = new QAction("Добавить курсор выше", owner_);
+    edit_.addCaretAboveAct->setShortcut(QKeySequence("Ctrl+Alt+Up"));
+    QObject::connect(edit_.addCaretAboveAct, &QAction::triggered, owner_->multiCursor, &MultiCursorController::addCaretAbove);
+
+    edit_.addCaretBelowAct = new QAction("Добавить курсор ниже", owner_);
+    edit_.addCaretBelowAct->setShortcut(QKeySequence("Ctrl+Alt+Down"));
+    QObject::connect(edit_.addCaretBelowAct, &QAction::triggered, owner_->multiCursor, &MultiCursorController::addCaretBelow);
+
+    edit_.completeAct = new QAction("Автодополнение", owner_);
+    edit_.completeAct->setShortcut(QKeySequence("Ctrl+Space"));
+    QObject::connect(edit_.completeAct, &QAction::triggered, owner_, &TextEditor::triggerCompletion);
+
+    edit_.wordAutoCompleteAct = new QAction("Подсказывать слова при вводе", owner_);
+    edit_.wordAutoCompleteAct->setCheckable(true);
+    edit_.wordAutoCompleteAct->setChecked(owner_->wordAutoCompleteEnabled);
+    QObject::connect(edit_.wordAutoCompleteAct, &QAction::toggled, owner_, &TextEditor::setWordAutoComplete);
+
+    edit_.wordsFromAllDocumentsAct = new QAction("Слова из всех открытых документов", owner_);
+    edit_.wordsFromAllDocumentsAct->setCheckable(true);
+    edit_.wordsFromAllDocumentsAct->setChecked(owner_->wordCompleter->allDocuments());
+    QObject::connect(edit_.wordsFromAllDocumentsAct, &QAction::toggled, owner_->wordCompleter, &WordCompleter::setAllDocuments);
+
     const auto shortcutContext = Qt::WidgetWithChildrenShortcut;
     for (QAction *act : { edit_.undoAct, edit_.redoAct, edit_.cutAct, edit_.copyAct, edit_.pasteAct }) {
         act->setShortcutContext(shortcutContext);
@@ -105,6 +155,58 @@ void TextEditorUi::createActions()
     speech_.stopSpeechAct = new QAction("⏹ Остановить озвучивание", owner_);
     QObject::connect(speech_.stopSpeechAct, &QAction::triggered, owner_, &TextEditor::stopSpeaking);
 
+    textAnalyticsAct = new QAction("📊 Анализ текста", owner_);
+    textAnalyticsAct->setShortcut(QKeySequence("Ctrl+Shift+A"));
+    QObject::connect(textAnalyticsAct, &QAction::triggered, owner_, &TextEditor::textAnalytics);
+
+    recordMacroAct = new QAction("⏺ Запись макроса", owner_);
+    recordMacroAct->setShortcut(QKeySequence("Ctrl+Shift+R"));
+    recordMacroAct->setCheckable(true);
+    QObject::connect(recordMacroAct, &QAction::toggled, owner_, &TextEditor::setMacroRecording);
+    QObject::connect(owner_->macroRecorder, &MacroRecorder::recordingChanged, recordMacroAct, &QAction::setChecked);
+
+    replayMacroAct = new QAction("▶ Воспроизвести макрос", owner_);
+    replayMacroAct->setShortcut(QKeySequence("Ctrl+Shift+P"));
+    QObject::connect(replayMacroAct, &QAction::triggered, owner_, &TextEditor::replayMacro);
+
+    replayMacroTimesAct = new QAction("⏩ Воспроизвести макрос N раз…", owner_);
+    QObject::connect(replayMacroTimesAct, &QAction::triggered, owner_, &TextEditor::replayMacroTimes);
+
+    filterCommandAct = new QAction("⚙ Фильтр через команду…", owner_);
+    filterCommandAct->setShortcut(QKeySequence("Ctrl+Shift+X"));
+    QObject::connect(filterCommandAct, &QAction::triggered, owner_, &TextEditor::filterThroughCommand);
+
+    compareWithSavedAct = new QAction("Сравнить с сохранённым", owner_);
+    QObject::connect(compareWithSavedAct, &QAction::triggered, owner_, &TextEditor::compareWithSaved);
+
+    compareWithFileAct = new QAction("Сравнить с файлом…", owner_);
+    QObject::connect(compareWithFileAct, &QAction::triggered, owner_, &TextEditor::compareWithFile);
+
+    followLogAct = new QAction("Следить за файлом (tail -f)", owner_);
+    followLogAct->setCheckable(true);
+    QObject::connect(followLogAct, &QAction::toggled, owner_, &TextEditor::setLogFollowing);
+
+    followRateAct = new QAction("Строк за кадр при слежении…", owner_);
+    QObject::connect(followRateAct, &QAction::triggered, owner_, &TextEditor::setLogFollowRate);
+
+    goToDefinitionAct = new QAction("Перейти к определению", owner_);
+    goToDefinitionAct->setShortcut(QKeySequence(Qt::Key_F12));
+    QObject::connect(goToDefinitionAct, &QAction::triggered, owner_, &TextEditor::goToDefinition);
+
+    findSymbolAct = new QAction("Найти символ…", owner_);
+    findSymbolAct->setShortcut(QKeySequence("Ctrl+T"));
+    QObject::connect(findSymbolAct, &QAction::triggered, owner_, &TextEditor::findSymbol);
+
+    outlineAct = new QAction("Структура файла", owner_);
+    outlineAct->setShortcut(QKeySequence("Ctrl+Shift+O"));
+    QObject::connect(outlineAct, &QAction::triggered, owner_, &TextEditor::showOutline);
+
+    spellCheckAct = new QAction("Проверка орфографии", owner_);
+    spellCheckAct->setShortcut(QKeySequence(Qt::Key_F7));
+    spellCheckAct->setCheckable(true);
+    spellCheckAct->setChecked(owner_->spellCheckEnabled);
+    QObject::connect(spellCheckAct, &QAction::toggled, owner_, &TextEditor::setSpellChecking);
+
     speech_.aboutAct = new QAction("ℹ О программе", owner_);
     QObject::connect(speech_.aboutAct, &QAction::triggered, owner_, &TextEditor::about);
 }
@@ -128,6 +230,20 @@ void TextEditorUi::createMenus()
     edit_.editMenu->addAction(edit_.cutAct);
     edit_.editMenu->addAction(edit_.copyAct);
     edit_.editMenu->addAction(edit_.pasteAct);
+    edit_.editMenu->addSeparator();
+    edit_.editMenu->addAction(edit_.findAct);
+    edit_.editMenu->addAction(edit_.findNextAct);
+    edit_.editMenu->addAction(edit_.findPreviousAct);
+    edit_.editMenu->addAction(edit_.replaceAct);
+    edit_.editMenu->addAction(edit_.findInFilesAct);
+    edit_.editMenu->addAction(edit_.highlightOccurrencesAct);
+    edit_.editMenu->addSeparator();
+    edit_.editMenu->addAction(edit_.addCaretAboveAct);
+    edit_.editMenu->addAction(edit_.addCaretBelowAct);
+    edit_.editMenu->addSeparator();
+    edit_.editMenu->addAction(edit_.completeAct);
+    edit_.editMenu->addAction(edit_.wordAutoCompleteAct);
+    edit_.editMenu->addAction(edit_.wordsFromAllDocumentsAct);
 
     format_.formatMenu = mb->addMenu("🎨 Формат");
     format_.formatMenu->addAction(format_.boldAct);
@@ -146,6 +262,26 @@ void TextEditorUi::createMenus()
     speech_.speechMenu->addSeparator();
     speech_.speechMenu->addAction(speech_.stopSpeechAct);
 
+    toolsMenu = mb->addMenu("🛠 Инструменты");
+    toolsMenu->addAction(textAnalyticsAct);
+    toolsMenu->addAction(spellCheckAct);
+    toolsMenu->addSeparator();
+    toolsMenu->addAction(recordMacroAct);
+    toolsMenu->addAction(replayMacroAct);
+    toolsMenu->addAction(replayMacroTimesAct);
+    toolsMenu->addSeparator();
+    toolsMenu->addAction(filterCommandAct);
+    toolsMenu->addSeparator();
+    toolsMenu->addAction(compareWithSavedAct);
+    toolsMenu->addAction(compareWithFileAct);
+    toolsMenu->addSeparator();
+    toolsMenu->addAction(followLogAct);
+    toolsMenu->addAction(followRateAct);
+    toolsMenu->addSeparator();
+    toolsMenu->addAction(goToDefinitionAct);
+    toolsMenu->addAction(findSymbolAct);
+    toolsMenu->addAction(outlineAct);
+
     helpMenu = mb->addMenu("ℹ Справка");
     helpMenu->addAction(speech_.aboutAct);
 }
@@ -266,6 +402,9 @@ void TextEditorUi::createStatusBar()
     statusBar_.statusLabel = new QLabel("Готов");
     owner_->statusBar()->addWidget(statusBar_.statusLabel, 1);
 
+    statusBar_.occurrenceLabel = new QLabel();
+    owner_->statusBar()->addWidget(statusBar_.occurrenceLabel);
+
     statusBar_.themeLabel = new QLabel("Тема:");
     owner_->statusBar()->addWidget(statusBar_.themeLabel);
 
@@ -275,4 +414,15 @@ void TextEditorUi::createStatusBar()
     statusBar_.toolsComboBox = new QComboBox();
     statusBar_.toolsComboBox->addItem("Инструменты...");
     owner_->statusBar()->addWidget(statusBar_.toolsComboBox);
+
+    statusBar_.toolProgress = new QProgressBar();
+    statusBar_.toolProgress->setRange(0, 100);
+    statusBar_.toolProgress->setMaximumWidth(160);
+    statusBar_.toolProgress->setVisible(false);
+    owner_->statusBar()->addWidget(statusBar_.toolProgress);
+
+    statusBar_.toolCancelButton = new QToolButton();
+    statusBar_.toolCancelButton->setText("Отменить");
+    statusBar_.toolCancelButton->setVisible(false);
+    owner_->statusBar()->addWidget(statusBar_.toolCancelButton);
 }
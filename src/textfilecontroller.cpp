@@ -4,8 +4,16 @@
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QDockWidget>
 #include <QtPdf/QPdfDocument>
-#include <QtPdfWidgets/QPdfView>
+#include "../headers/pdfsearch.h"
+#include "../headers/cpphighlighter.h"
+#include "../headers/symbolindex.h"
+#include "../headers/lspclient.h"
+#include "../headers/filechangemonitor.h"
+#include "../headers/logfollower.h"
 
 TextFileController::TextFileController(TextEditor *editor, QObject *parent)
     : QObject(parent)
@@ -16,7 +24,7 @@ TextFileController::TextFileController(TextEditor *editor, QObject *parent)
 void TextFileController::newFile()
 {
     editor_->handleFileOperation([this]() {
-        editor_->centralStack->setCurrentWidget(editor_->textEdit);
+        editor_->centralStack->setCurrentWidget(editor_->editorPage);
         if (editor_->textEdit->document()->isModified()) {
             QMessageBox::StandardButton reply;
             reply = QMessageBox::question(editor_, "Создать новый файл",
@@ -29,8 +37,10 @@ void TextFileController::newFile()
             }
         }
 
+        editor_->logFollower->stop();
         editor_->textEdit->clear();
         editor_->currentFile = "";
+        editor_->updateSourceFeatures();
         editor_->setWindowTitle("Текстовый редактор - Новый файл");
         editor_->ui_->statusLabel()->setText("Новый файл создан");
         stopAutoSave();
@@ -40,32 +50,68 @@ void TextFileController::newFile()
 
 void TextFileController::openFile()
 {
-    editor_->handleFileOperation([this]() { openFileImpl(); }, "Ошибка при открытии файла");
+    const QString fileName = QFileDialog::getOpenFileName(editor_,
+                                                          "Открыть файл",
+                                                          QString(),
+                                                          editor_->documentManager_.filterForOpenDialog());
+
+    if (fileName.isEmpty()) {
+        return;
+    }
+    openPath(fileName);
 }
 
-void TextFileController::openFileImpl()
+bool TextFileController::openPath(const QString &fileName)
 {
-    QString fileName = QFileDialog::getOpenFileName(editor_,
-                                                    "Открыть файл",
-                                                    QString(),
-                                                    editor_->documentManager_.filterForOpenDialog());
+    bool opened = false;
+    editor_->handleFileOperation([this, &fileName, &opened]() {
+        openFileImpl(fileName);
+        opened = true;
+    }, "Ошибка при открытии файла");
+    return opened;
+}
 
-    if (fileName.isEmpty()) {
+void TextFileController::openFileAt(const QString &fileName, int line, int column)
+{
+    const bool alreadyOpen = QFileInfo(editor_->currentFile) == QFileInfo(fileName)
+                             && editor_->centralStack->currentWidget() == editor_->editorPage;
+    if (!alreadyOpen && !openPath(fileName)) {
         return;
     }
 
+    QTextBlock block = editor_->textEdit->document()->findBlockByNumber(qMax(0, line - 1));
+    if (!block.isValid()) {
+        return;
+    }
+    QTextCursor cursor(block);
+    cursor.setPosition(block.position() + qBound(0, column, block.length() - 1));
+    editor_->textEdit->setTextCursor(cursor);
+    editor_->textEdit->ensureCursorVisible();
+    editor_->textEdit->setFocus();
+}
+
+void TextFileController::openFileImpl(const QString &fileName)
+{
     const QFileInfo info(fileName);
+    editor_->logFollower->stop();
 
     if (const QString ext = info.suffix().toLower(); ext == "pdf") {
         if (!editor_->pdfDocument) {
             editor_->pdfDocument = new QPdfDocument(editor_);
         }
         if (!editor_->pdfView) {
-            editor_->pdfView = new QPdfView(editor_);
+            editor_->pdfView = new PdfSearchView(editor_);
             editor_->pdfView->setDocument(editor_->pdfDocument);
             editor_->pdfView->setPageMode(QPdfView::PageMode::MultiPage);
             editor_->centralStack->addWidget(editor_->pdfView);
         }
+        if (!editor_->pdfSearchDock) {
+            editor_->pdfSearchPanel = new PdfSearchPanel(editor_->pdfView);
+            editor_->pdfSearchDock = new QDockWidget("Поиск в PDF", editor_);
+            editor_->pdfSearchDock->setWidget(editor_->pdfSearchPanel);
+            editor_->addDockWidget(Qt::RightDockWidgetArea, editor_->pdfSearchDock);
+            editor_->pdfSearchDock->hide();
+        }
 
         editor_->pdfDocument->load(fileName);
         if (editor_->pdfDocument->status() == QPdfDocument::Status::Error) {
@@ -74,20 +120,27 @@ void TextFileController::openFileImpl()
             return;
         }
 
+        editor_->pdfSearchPanel->setDocumentFile(fileName);
         editor_->centralStack->setCurrentWidget(editor_->pdfView);
         editor_->currentFile = fileName;
+        editor_->fileMonitor->watch(QString());
         editor_->setWindowTitle("Текстовый редактор - " + info.fileName());
         editor_->ui_->statusLabel()->setText("PDF открыт: " + fileName);
         stopAutoSave();
         return;
     }
 
+    editor_->lspClient_->closeDocument();
     if (QString error; !editor_->documentManager_.loadDocument(fileName, editor_->textEdit->document(), error)) {
         throw DocumentOperationException(error.toStdString());
     }
 
-    editor_->centralStack->setCurrentWidget(editor_->textEdit);
+    if (editor_->pdfSearchDock) {
+        editor_->pdfSearchDock->hide();
+    }
+    editor_->centralStack->setCurrentWidget(editor_->editorPage);
     editor_->currentFile = fileName;
+    editor_->updateSourceFeatures();
     editor_->setWindowTitle("Текстовый редактор - " + info.fileName());
     editor_->ui_->statusLabel()->setText("Файл открыт: " + fileName);
     editor_->textEdit->document()->setModified(false);
@@ -97,15 +150,27 @@ void TextFileController::openFileImpl()
 void TextFileController::saveFile()
 {
     editor_->handleFileOperation([this]() {
-        if (editor_->currentFile.isEmpty()) {
+        if (editor_->logFollower->isFollowing()) {
+            editor_->ui_->statusLabel()->setText("Во время слежения файл не сохраняется");
+        } else if (editor_->currentFile.isEmpty()) {
             saveAsFile();
         } else {
+            if (editor_->fileMonitor->isChangedOnDisk()
+                && QMessageBox::question(editor_, "Файл изменён",
+                                         "Файл изменён на диске другой программой:\n" + editor_->currentFile
+                                             + "\n\nПерезаписать его?") != QMessageBox::Yes) {
+                return;
+            }
             if (QString error; !editor_->documentManager_.saveDocument(editor_->currentFile, editor_->textEdit->document(), error)) {
                 throw DocumentOperationException(error.toStdString());
             }
 
+            editor_->fileMonitor->noteSaved();
             editor_->textEdit->document()->setModified(false);
             editor_->ui_->statusLabel()->setText("Файл сохранен: " + editor_->currentFile);
+            if (CppHighlighter::handlesFile(editor_->currentFile)) {
+                editor_->symbolIndex->refresh();
+            }
         }
     }, "Ошибка при сохранении файла");
 }
@@ -124,6 +189,7 @@ void TextFileController::saveAsFile()
             }
 
             editor_->currentFile = fileName;
+            editor_->updateSourceFeatures();
             editor_->textEdit->document()->setModified(false);
             editor_->setWindowTitle("Текстовый редактор - " + QFileInfo(fileName).fileName());
             editor_->ui_->statusLabel()->setText("Файл сохранен: " + editor_->currentFile);
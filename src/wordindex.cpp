@@ -0,0 +1,358 @@
+#include "../headers/wordindex.h"
+#include "../headers/completionpopup.h"
+
+#include <QTextEdit>
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QElapsedTimer>
+#include <QHash>
+#include <algorithm>
+#include <map>
+
+struct WordIndex::Store
+{
+    struct Probe
+    {
+        QStringView text;
+    };
+
+    // Case-insensitive order first, so "Word" and "word" sit next to each
+    // other; a Probe compares case-insensitively only and finds the start
+    // of the prefix range.
+    struct Less
+    {
+        using is_transparent = void;
+
+        bool operator()(const QString &a, const QString &b) const
+        {
+            const int order = QStringView(a).compare(b, Qt::CaseInsensitive);
+            return order != 0 ? order < 0 : a < b;
+        }
+        bool operator()(const QString &a, Probe b) const
+        {
+            return QStringView(a).compare(b.text, Qt::CaseInsensitive) < 0;
+        }
+        bool operator()(Probe a, const QString &b) const
+        {
+            return a.text.compare(b, Qt::CaseInsensitive) < 0;
+        }
+    };
+
+    std::map<QString, int, Less> counts;
+};
+
+namespace {
+
+constexpr int kMinWordLength = 3;
+constexpr int kMaxWordLength = 64;
+constexpr int kAutoTriggerChars = 3;
+constexpr int kMaxCandidates = 50;
+constexpr qsizetype kMaxScanned = 20000;
+constexpr int kSyncBlocks = 200;
+constexpr int kSweepSliceMs = 8;
+
+bool isWordChar(QChar ch)
+{
+    return ch.isLetterOrNumber() || ch == u'_';
+}
+
+QStringList wordsOf(const QString &text)
+{
+    QStringList words;
+    const qsizetype size = text.size();
+    qsizetype i = 0;
+    while (i < size) {
+        if (!isWordChar(text[i])) {
+            ++i;
+            continue;
+        }
+        const qsizetype start = i;
+        while (i < size && isWordChar(text[i])) {
+            ++i;
+        }
+        const qsizetype length = i - start;
+        if (!text[start].isDigit() && length >= kMinWordLength && length <= kMaxWordLength) {
+            words << text.mid(start, length);
+        }
+    }
+    return words;
+}
+
+void addWords(WordIndex::Store &store, const QStringList &words)
+{
+    for (const QString &word : words) {
+        ++store.counts[word];
+    }
+}
+
+void removeWords(WordIndex::Store &store, const QStringList &words)
+{
+    for (const QString &word : words) {
+        const auto it = store.counts.find(word);
+        if (it != store.counts.end() && --it->second <= 0) {
+            store.counts.erase(it);
+        }
+    }
+}
+
+void collect(const WordIndex::Store &store, QStringView prefix, const QString &exclude,
+             QVector<WordCandidate> &candidates)
+{
+    for (auto it = store.counts.lower_bound(WordIndex::Store::Probe{prefix});
+         it != store.counts.end() && candidates.size() < kMaxScanned; ++it) {
+        if (!QStringView(it->first).startsWith(prefix, Qt::CaseInsensitive)) {
+            break;
+        }
+        if (it->first != exclude) {
+            candidates.append({it->first, it->second});
+        }
+    }
+}
+
+// Words matching the typed case come first, then the frequent ones, then
+// the short ones.
+void rank(QVector<WordCandidate> &candidates, QStringView prefix, int limit)
+{
+    const auto better = [prefix](const WordCandidate &a, const WordCandidate &b) {
+        const bool aExact = a.word.startsWith(prefix);
+        const bool bExact = b.word.startsWith(prefix);
+        if (aExact != bExact) {
+            return aExact;
+        }
+        if (a.count != b.count) {
+            return a.count > b.count;
+        }
+        if (a.word.size() != b.word.size()) {
+            return a.word.size() < b.word.size();
+        }
+        return a.word < b.word;
+    };
+    const qsizetype kept = qMin<qsizetype>(limit, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + kept, candidates.end(), better);
+    candidates.resize(kept);
+}
+
+QList<const WordIndex *> &openIndexes()
+{
+    static QList<const WordIndex *> indexes;
+    return indexes;
+}
+
+// The words a block contributed. Qt deletes the data together with the
+// block, which takes the words out of the index.
+class WordBlockData : public QTextBlockUserData
+{
+public:
+    explicit WordBlockData(std::weak_ptr<WordIndex::Store> store)
+        : store_(std::move(store))
+    {
+    }
+
+    ~WordBlockData() override
+    {
+        if (const auto store = store_.lock()) {
+            removeWords(*store, words);
+        }
+    }
+
+    QStringList words;
+    int revision = -1;
+
+private:
+    std::weak_ptr<WordIndex::Store> store_;
+};
+
+}
+
+WordIndex::WordIndex()
+    : store_(std::make_shared<Store>())
+{
+    openIndexes().append(this);
+}
+
+WordIndex::~WordIndex()
+{
+    openIndexes().removeOne(this);
+}
+
+void WordIndex::add(const QStringList &words)
+{
+    addWords(*store_, words);
+}
+
+void WordIndex::remove(const QStringList &words)
+{
+    removeWords(*store_, words);
+}
+
+qsizetype WordIndex::size() const
+{
+    return static_cast<qsizetype>(store_->counts.size());
+}
+
+QVector<WordCandidate> WordIndex::complete(QStringView prefix, int limit, const QString &exclude) const
+{
+    QVector<WordCandidate> candidates;
+    collect(*store_, prefix, exclude, candidates);
+    rank(candidates, prefix, limit);
+    return candidates;
+}
+
+QVector<WordCandidate> WordIndex::completeEverywhere(QStringView prefix, int limit, const QString &exclude)
+{
+    QVector<WordCandidate> candidates;
+    QHash<QString, qsizetype> seen;
+    for (const WordIndex *index : std::as_const(openIndexes())) {
+        QVector<WordCandidate> found;
+        collect(*index->store_, prefix, exclude, found);
+        for (const WordCandidate &candidate : std::as_const(found)) {
+            const auto it = seen.constFind(candidate.word);
+            if (it != seen.cend()) {
+                candidates[*it].count += candidate.count;
+            } else {
+                seen.insert(candidate.word, candidates.size());
+                candidates.append(candidate);
+            }
+        }
+    }
+    rank(candidates, prefix, limit);
+    return candidates;
+}
+
+WordCompleter::WordCompleter(QTextEdit *textEdit, CompletionPopup *popup, QObject *parent)
+    : QObject(parent)
+    , textEdit_(textEdit)
+    , popup_(popup)
+{
+    sweepTimer_.setSingleShot(true);
+    sweepTimer_.setInterval(0);
+    autoTimer_.setSingleShot(true);
+    autoTimer_.setInterval(0);
+
+    connect(&sweepTimer_, &QTimer::timeout, this, &WordCompleter::sweep);
+    connect(&autoTimer_, &QTimer::timeout, this, &WordCompleter::autoComplete);
+    connect(textEdit_->document(), &QTextDocument::contentsChange, this, &WordCompleter::onContentsChange);
+    scheduleSweep(0);
+}
+
+// A block is re-read when forced (it was just edited) or when its revision
+// no longer matches the one its words were taken from.
+void WordCompleter::indexBlock(QTextBlock &block, bool force)
+{
+    auto *data = dynamic_cast<WordBlockData *>(block.userData());
+    if (data && !force && data->revision == block.revision()) {
+        return;
+    }
+    if (!data) {
+        data = new WordBlockData(index_.store());
+        block.setUserData(data);
+    }
+    QStringList words = wordsOf(block.text());
+    if (words != data->words) {
+        index_.remove(data->words);
+        index_.add(words);
+        data->words = std::move(words);
+    }
+    data->revision = block.revision();
+}
+
+// Typing touches one or two blocks and is indexed right away; loading or
+// replacing a large text is finished in time slices by sweep().
+void WordCompleter::onContentsChange(int position, int charsRemoved, int charsAdded)
+{
+    QTextDocument *document = textEdit_->document();
+    QTextBlock block = document->findBlock(position);
+    const QTextBlock last = document->findBlock(position + charsAdded);
+    for (int indexed = 0; block.isValid(); ++indexed) {
+        if (indexed == kSyncBlocks) {
+            scheduleSweep(block.blockNumber());
+            break;
+        }
+        indexBlock(block, true);
+        if (block == last) {
+            break;
+        }
+        block = block.next();
+    }
+
+    if (autoComplete_ && charsRemoved == 0 && charsAdded == 1 && textEdit_->hasFocus()) {
+        autoTimer_.start();
+    }
+}
+
+void WordCompleter::scheduleSweep(int fromBlock)
+{
+    sweepFrom_ = sweepFrom_ < 0 ? fromBlock : qMin(sweepFrom_, fromBlock);
+    sweepTimer_.start();
+}
+
+void WordCompleter::sweep()
+{
+    QElapsedTimer timer;
+    timer.start();
+    QTextBlock block = textEdit_->document()->findBlockByNumber(qMax(0, sweepFrom_));
+    while (block.isValid()) {
+        indexBlock(block, false);
+        block = block.next();
+        if (block.isValid() && timer.elapsed() >= kSweepSliceMs) {
+            sweepFrom_ = block.blockNumber();
+            sweepTimer_.start();
+            return;
+        }
+    }
+    sweepFrom_ = -1;
+}
+
+void WordCompleter::complete()
+{
+    if (!showCandidates(true)) {
+        popup_->hide();
+    }
+}
+
+void WordCompleter::autoComplete()
+{
+    showCandidates(false);
+}
+
+bool WordCompleter::showCandidates(bool explicitRequest)
+{
+    const QTextCursor cursor = textEdit_->textCursor();
+    if (cursor.hasSelection()) {
+        return false;
+    }
+    const QTextBlock block = cursor.block();
+    const QString line = block.text();
+    const int column = cursor.positionInBlock();
+    if (column < line.size() && isWordChar(line.at(column))) {
+        return false;
+    }
+    int start = column;
+    while (start > 0 && isWordChar(line.at(start - 1))) {
+        --start;
+    }
+    const QString prefix = line.mid(start, column - start);
+    if (prefix.isEmpty() || prefix.front().isDigit()
+        || (!explicitRequest && prefix.size() < kAutoTriggerChars)) {
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    const QVector<WordCandidate> candidates = allDocuments_
+        ? WordIndex::completeEverywhere(prefix, kMaxCandidates, prefix)
+        : index_.complete(prefix, kMaxCandidates, prefix);
+    const qint64 microseconds = timer.nsecsElapsed() / 1000;
+
+    QVector<CompletionPopup::Entry> entries;
+    entries.reserve(candidates.size());
+    for (const WordCandidate &candidate : candidates) {
+        entries.append({candidate.word, QString("Вхождений: %1").arg(candidate.count)});
+    }
+    popup_->show(block.position() + start, entries);
+    if (explicitRequest) {
+        emit completed(static_cast<int>(candidates.size()), microseconds);
+    }
+    return !candidates.isEmpty();
+}
@@ -0,0 +1,955 @@
+#include "../headers/workspaceindex.h"
+#include "../headers/documentmanager.h"
+#include "../headers/filesearcher.h"
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QtConcurrent/QtConcurrent>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+constexpr char kIndexMagic[4] = {'T', 'T', 'R', 'I'};
+constexpr quint32 kIndexVersion = 1;
+constexpr quint32 kByteOrderTag = 0x01020304;
+constexpr qint64 kMaxIndexedFileSize = 64LL * 1024 * 1024;
+constexpr qsizetype kBuildBatch = 256;
+constexpr qsizetype kCompactThreshold = 4096;
+constexpr qsizetype kMaxWatchedPaths = 8192;
+constexpr int kChangeDelayMs = 500;
+constexpr qint64 kRefreshIntervalMs = 60 * 1000;
+constexpr quint32 kTrigramSpace = 1u << 24;
+
+struct IndexHeader
+{
+    char magic[4];
+    quint32 version;
+    quint32 byteOrder;
+    quint32 fileCount;
+    quint32 trigramCount;
+    quint32 reserved;
+    quint64 filesOffset;
+    quint64 trigramsOffset;
+    quint64 postingsOffset;
+    quint64 stringsOffset;
+};
+
+struct FileRecord
+{
+    quint64 pathOffset;
+    quint32 pathBytes;
+    quint32 flags;
+    qint64 modified;
+    qint64 size;
+};
+
+struct TrigramRecord
+{
+    quint32 trigram;
+    quint32 count;
+    quint64 postingsOffset;
+};
+
+static_assert(sizeof(IndexHeader) % 8 == 0);
+static_assert(sizeof(FileRecord) % 8 == 0);
+static_assert(sizeof(TrigramRecord) % 8 == 0);
+
+void appendVarint(QByteArray &out, quint32 value)
+{
+    while (value >= 0x80) {
+        out.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.append(static_cast<char>(value));
+}
+
+bool isDocumentPath(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "docx" || suffix == "odt" || suffix == "pdf";
+}
+
+QByteArray foldBytes(const char *data, qint64 size)
+{
+    const bool ascii = std::none_of(data, data + size, [](char c) { return static_cast<unsigned char>(c) >= 0x80; });
+    if (!ascii) {
+        return QString::fromUtf8(data, size).toCaseFolded().toUtf8();
+    }
+    QByteArray folded(data, size);
+    char *out = folded.data();
+    for (qint64 i = 0; i < size; ++i) {
+        if (out[i] >= 'A' && out[i] <= 'Z') {
+            out[i] = static_cast<char>(out[i] + ('a' - 'A'));
+        }
+    }
+    return folded;
+}
+
+std::vector<quint32> collectTrigrams(const QByteArray &folded)
+{
+    std::vector<quint32> trigrams;
+    if (folded.size() < 3) {
+        return trigrams;
+    }
+
+    thread_local std::vector<quint64> seen(kTrigramSpace / 64);
+    const auto *bytes = reinterpret_cast<const uchar *>(folded.constData());
+    quint32 window = (quint32(bytes[0]) << 8) | bytes[1];
+    for (qsizetype i = 2; i < folded.size(); ++i) {
+        window = ((window << 8) | bytes[i]) & (kTrigramSpace - 1);
+        quint64 &word = seen[window >> 6];
+        const quint64 bit = quint64(1) << (window & 63);
+        if (!(word & bit)) {
+            word |= bit;
+            trigrams.push_back(window);
+        }
+    }
+    for (const quint32 trigram : trigrams) {
+        seen[trigram >> 6] &= ~(quint64(1) << (trigram & 63));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    return trigrams;
+}
+
+void appendTrigrams(std::vector<quint32> &out, const QString &literal)
+{
+    const QByteArray folded = literal.toCaseFolded().toUtf8();
+    const std::vector<quint32> trigrams = collectTrigrams(folded);
+    out.insert(out.end(), trigrams.begin(), trigrams.end());
+}
+
+QStringList regexLiterals(const QString &pattern, bool *ok)
+{
+    QStringList literals;
+    QString current;
+    int depth = 0;
+    *ok = true;
+
+    auto flush = [&]() {
+        if (depth == 0 && current.size() >= 3) {
+            literals << current;
+        }
+        current.clear();
+    };
+
+    for (qsizetype i = 0; i < pattern.size(); ++i) {
+        const QChar ch = pattern.at(i);
+        switch (ch.unicode()) {
+        case '\\':
+            if (i + 1 < pattern.size() && !pattern.at(i + 1).isLetterOrNumber()) {
+                current += pattern.at(++i);
+            } else {
+                ++i;
+                flush();
+            }
+            break;
+        case '|':
+            *ok = false;
+            return {};
+        case '(':
+            flush();
+            ++depth;
+            break;
+        case ')':
+            flush();
+            depth = qMax(0, depth - 1);
+            break;
+        case '[':
+            flush();
+            while (i + 1 < pattern.size() && pattern.at(i + 1) != ']') {
+                i += pattern.at(i + 1) == '\\' ? 2 : 1;
+            }
+            ++i;
+            break;
+        case '?':
+        case '*':
+        case '{':
+            current.chop(1);
+            flush();
+            if (ch == '{') {
+                while (i + 1 < pattern.size() && pattern.at(i + 1) != '}') {
+                    ++i;
+                }
+                ++i;
+            }
+            break;
+        case '.':
+        case '^':
+        case '$':
+        case '+':
+            flush();
+            break;
+        default:
+            current += ch;
+            break;
+        }
+    }
+    flush();
+    return literals;
+}
+
+QString textCachePath(const QString &textCacheDir, const QString &filePath)
+{
+    const QByteArray hash = QCryptographicHash::hash(filePath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return textCacheDir + '/' + QString::fromLatin1(hash) + ".txt";
+}
+
+bool extractDocumentText(const QString &filePath, const QString &cachePath, QString &text)
+{
+    // LibreOffice refuses to run concurrently against one user profile.
+    static QMutex mutex;
+    QMutexLocker locker(&mutex);
+    static const DocumentManager documents; // NOSONAR - Meyers singleton pattern
+
+    QString error;
+    if (!documents.extractText(filePath, text, error)) {
+        return false;
+    }
+
+    QSaveFile cache(cachePath);
+    if (!cache.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    cache.write(text.toUtf8());
+    return cache.commit();
+}
+
+IndexEntry indexFile(const QString &filePath, const QString &textCacheDir)
+{
+    IndexEntry entry;
+    const QFileInfo info(filePath);
+    entry.file.path = filePath;
+    entry.file.modified = info.lastModified().toMSecsSinceEpoch();
+    entry.file.size = info.size();
+
+    if (isDocumentPath(filePath)) {
+        entry.file.flags |= IndexedDocument;
+        QString text;
+        if (extractDocumentText(filePath, textCachePath(textCacheDir, filePath), text)) {
+            entry.trigrams = collectTrigrams(text.toCaseFolded().toUtf8());
+        } else {
+            entry.file.flags |= IndexedBinary;
+        }
+        return entry;
+    }
+
+    if (entry.file.size > kMaxIndexedFileSize) {
+        entry.file.flags |= IndexedUnindexed;
+        return entry;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        entry.file.flags |= IndexedUnindexed;
+        return entry;
+    }
+    const qint64 size = file.size();
+    if (size == 0) {
+        return entry;
+    }
+
+    QByteArray fallback;
+    const auto *data = reinterpret_cast<const char *>(file.map(0, size));
+    if (!data) {
+        fallback = file.readAll();
+        data = fallback.constData();
+    }
+    if (FileScanner::isBinaryContent(data, size)) {
+        entry.file.flags |= IndexedBinary;
+        return entry;
+    }
+    entry.trigrams = collectTrigrams(foldBytes(data, size));
+    return entry;
+}
+
+QVector<IndexEntry> indexFiles(QThreadPool *pool, const QStringList &paths, const QString &textCacheDir)
+{
+    return QtConcurrent::blockingMapped<QVector<IndexEntry>>(pool, paths, [textCacheDir](const QString &path) {
+        return indexFile(path, textCacheDir);
+    });
+}
+
+void buildIndex(QPromise<IndexBuildResult> &promise, QThreadPool *pool,
+                const QString &rootPath, const QString &indexPath, const QString &textCacheDir)
+{
+    QStringList paths;
+    QDirIterator it(rootPath, QDir::Files | QDir::Readable | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        if (promise.isCanceled()) {
+            return;
+        }
+        paths << it.next();
+    }
+    promise.setProgressRange(0, static_cast<int>(paths.size()));
+
+    QVector<IndexedFile> files;
+    files.reserve(paths.size());
+    TrigramIndexFile::PostingMap postings;
+    for (qsizetype start = 0; start < paths.size(); start += kBuildBatch) {
+        if (promise.isCanceled()) {
+            return;
+        }
+        const QVector<IndexEntry> batch = indexFiles(pool, paths.mid(start, kBuildBatch), textCacheDir);
+        for (const IndexEntry &entry : batch) {
+            const auto id = static_cast<quint32>(files.size());
+            files.push_back(entry.file);
+            for (const quint32 trigram : entry.trigrams) {
+                postings[trigram].push_back(id);
+            }
+        }
+        promise.setProgressValue(static_cast<int>(start + batch.size()));
+    }
+
+    IndexBuildResult result;
+    result.ok = TrigramIndexFile::write(indexPath, files, postings, result.error);
+    promise.addResult(result);
+}
+
+void scanForUpdates(QPromise<IndexUpdate> &promise, QThreadPool *pool,
+                    const QString &rootPath, const QStringList &directories, const QStringList &files, bool full,
+                    const QHash<QString, qint64> &knownModified, const QSet<QString> &knownDirectories,
+                    const QString &textCacheDir)
+{
+    IndexUpdate update;
+    update.full = full;
+    QStringList changed;
+    QSet<QString> seen;
+
+    auto consider = [&](const QFileInfo &info) {
+        const QString path = info.absoluteFilePath();
+        seen.insert(path);
+        const auto it = knownModified.constFind(path);
+        if (it == knownModified.cend() || *it != info.lastModified().toMSecsSinceEpoch()) {
+            changed << path;
+        }
+    };
+    auto walkTree = [&](const QString &dir) {
+        update.directories << dir;
+        QDirIterator dirs(dir, QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (dirs.hasNext() && !promise.isCanceled()) {
+            update.directories << dirs.next();
+        }
+        QDirIterator it(dir, QDir::Files | QDir::Readable | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (it.hasNext() && !promise.isCanceled()) {
+            it.next();
+            consider(it.fileInfo());
+        }
+    };
+
+    if (full) {
+        walkTree(rootPath);
+        for (auto it = knownModified.cbegin(); it != knownModified.cend(); ++it) {
+            if (!seen.contains(it.key())) {
+                update.removed << it.key();
+            }
+        }
+    }
+
+    for (const QString &dir : directories) {
+        const QDir directory(dir);
+        const QString prefix = dir + '/';
+        if (directory.exists()) {
+            for (const QFileInfo &info : directory.entryInfoList(QDir::Files | QDir::Readable | QDir::NoDotAndDotDot)) {
+                consider(info);
+            }
+            for (const QFileInfo &info : directory.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+                if (!knownDirectories.contains(info.absoluteFilePath())) {
+                    walkTree(info.absoluteFilePath());
+                }
+            }
+        }
+        for (auto it = knownModified.cbegin(); it != knownModified.cend(); ++it) {
+            if (!it.key().startsWith(prefix) || seen.contains(it.key())) {
+                continue;
+            }
+            const qsizetype slash = it.key().indexOf('/', prefix.size());
+            if (slash < 0 || !QFileInfo::exists(it.key().left(slash))) {
+                update.removed << it.key();
+            }
+        }
+    }
+
+    for (const QString &path : files) {
+        const QFileInfo info(path);
+        if (info.exists()) {
+            consider(info);
+        } else if (knownModified.contains(path)) {
+            update.removed << path;
+        }
+    }
+
+    if (promise.isCanceled()) {
+        return;
+    }
+    changed.removeDuplicates();
+    update.entries = indexFiles(pool, changed, textCacheDir);
+    promise.addResult(update);
+}
+
+}
+
+TrigramIndexFile::~TrigramIndexFile()
+{
+    close();
+}
+
+bool TrigramIndexFile::open(const QString &path)
+{
+    close();
+    file_.setFileName(path);
+    if (!file_.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    size_ = file_.size();
+    if (size_ < static_cast<qint64>(sizeof(IndexHeader))) {
+        close();
+        return false;
+    }
+    data_ = file_.map(0, size_);
+    if (!data_) {
+        close();
+        return false;
+    }
+
+    const auto *header = reinterpret_cast<const IndexHeader *>(data_);
+    const auto fits = [this](quint64 offset, quint64 bytes) {
+        return offset <= static_cast<quint64>(size_) && bytes <= static_cast<quint64>(size_) - offset;
+    };
+    if (std::memcmp(header->magic, kIndexMagic, sizeof(kIndexMagic)) != 0
+        || header->version != kIndexVersion
+        || header->byteOrder != kByteOrderTag
+        || !fits(header->filesOffset, quint64(header->fileCount) * sizeof(FileRecord))
+        || !fits(header->trigramsOffset, quint64(header->trigramCount) * sizeof(TrigramRecord))
+        || !fits(header->postingsOffset, header->stringsOffset - header->postingsOffset)
+        || !fits(header->stringsOffset, 0)) {
+        close();
+        return false;
+    }
+
+    fileCount_ = header->fileCount;
+    trigramCount_ = header->trigramCount;
+    filesOffset_ = header->filesOffset;
+    trigramsOffset_ = header->trigramsOffset;
+    postingsOffset_ = header->postingsOffset;
+    stringsOffset_ = header->stringsOffset;
+    return true;
+}
+
+void TrigramIndexFile::close()
+{
+    if (data_) {
+        file_.unmap(const_cast<uchar *>(data_));
+        data_ = nullptr;
+    }
+    file_.close();
+    size_ = 0;
+    fileCount_ = 0;
+    trigramCount_ = 0;
+}
+
+IndexedFile TrigramIndexFile::file(quint32 id) const
+{
+    IndexedFile result;
+    if (id >= fileCount_) {
+        return result;
+    }
+    const auto *record = reinterpret_cast<const FileRecord *>(data_ + filesOffset_) + id;
+    const quint64 end = stringsOffset_ + record->pathOffset + record->pathBytes;
+    if (end <= static_cast<quint64>(size_)) {
+        result.path = QString::fromUtf8(reinterpret_cast<const char *>(data_ + stringsOffset_ + record->pathOffset),
+                                        record->pathBytes);
+    }
+    result.modified = record->modified;
+    result.size = record->size;
+    result.flags = record->flags;
+    return result;
+}
+
+const void *TrigramIndexFile::findTrigram(quint32 trigram) const
+{
+    const auto *begin = reinterpret_cast<const TrigramRecord *>(data_ + trigramsOffset_);
+    const auto *end = begin + trigramCount_;
+    const auto *it = std::lower_bound(begin, end, trigram, [](const TrigramRecord &record, quint32 value) {
+        return record.trigram < value;
+    });
+    return (it != end && it->trigram == trigram) ? it : nullptr;
+}
+
+std::vector<quint32> TrigramIndexFile::decodePostings(const void *record) const
+{
+    const auto *trigram = static_cast<const TrigramRecord *>(record);
+    std::vector<quint32> ids;
+    ids.reserve(trigram->count);
+
+    const uchar *p = data_ + postingsOffset_ + trigram->postingsOffset;
+    const uchar *end = data_ + stringsOffset_;
+    quint32 previous = 0;
+    for (quint32 i = 0; i < trigram->count && p < end; ++i) {
+        quint32 delta = 0;
+        int shift = 0;
+        while (p < end && (*p & 0x80) && shift < 28) {
+            delta |= quint32(*p++ & 0x7F) << shift;
+            shift += 7;
+        }
+        if (p >= end) {
+            break;
+        }
+        delta |= quint32(*p++) << shift;
+        previous += delta;
+        ids.push_back(previous);
+    }
+    return ids;
+}
+
+std::vector<quint32> TrigramIndexFile::intersect(const std::vector<quint32> &trigrams) const
+{
+    std::vector<const TrigramRecord *> records;
+    records.reserve(trigrams.size());
+    for (const quint32 trigram : trigrams) {
+        const auto *record = static_cast<const TrigramRecord *>(findTrigram(trigram));
+        if (!record) {
+            return {};
+        }
+        records.push_back(record);
+    }
+    if (records.empty()) {
+        return {};
+    }
+
+    std::sort(records.begin(), records.end(), [](const TrigramRecord *a, const TrigramRecord *b) {
+        return a->count < b->count;
+    });
+
+    std::vector<quint32> result = decodePostings(records.front());
+    std::vector<quint32> scratch;
+    for (size_t i = 1; i < records.size() && !result.empty(); ++i) {
+        const std::vector<quint32> next = decodePostings(records[i]);
+        scratch.clear();
+        std::set_intersection(result.begin(), result.end(), next.begin(), next.end(), std::back_inserter(scratch));
+        result.swap(scratch);
+    }
+    return result;
+}
+
+bool TrigramIndexFile::write(const QString &path,
+                             const QVector<IndexedFile> &files,
+                             const PostingMap &postings,
+                             QString &error)
+{
+    QByteArray strings;
+    QVector<FileRecord> fileRecords;
+    fileRecords.reserve(files.size());
+    for (const IndexedFile &file : files) {
+        const QByteArray bytes = file.path.toUtf8();
+        FileRecord record{};
+        record.pathOffset = static_cast<quint64>(strings.size());
+        record.pathBytes = static_cast<quint32>(bytes.size());
+        record.flags = file.flags;
+        record.modified = file.modified;
+        record.size = file.size;
+        fileRecords.push_back(record);
+        strings += bytes;
+    }
+
+    std::vector<quint32> keys(postings.keyBegin(), postings.keyEnd());
+    std::sort(keys.begin(), keys.end());
+
+    QByteArray postingBytes;
+    QVector<TrigramRecord> trigramRecords;
+    trigramRecords.reserve(static_cast<qsizetype>(keys.size()));
+    for (const quint32 key : keys) {
+        const std::vector<quint32> &ids = postings.value(key);
+        TrigramRecord record{};
+        record.trigram = key;
+        record.count = static_cast<quint32>(ids.size());
+        record.postingsOffset = static_cast<quint64>(postingBytes.size());
+        quint32 previous = 0;
+        for (const quint32 id : ids) {
+            appendVarint(postingBytes, id - previous);
+            previous = id;
+        }
+        trigramRecords.push_back(record);
+    }
+
+    IndexHeader header{};
+    std::memcpy(header.magic, kIndexMagic, sizeof(kIndexMagic));
+    header.version = kIndexVersion;
+    header.byteOrder = kByteOrderTag;
+    header.fileCount = static_cast<quint32>(fileRecords.size());
+    header.trigramCount = static_cast<quint32>(trigramRecords.size());
+    header.filesOffset = sizeof(IndexHeader);
+    header.trigramsOffset = header.filesOffset + quint64(fileRecords.size()) * sizeof(FileRecord);
+    header.postingsOffset = header.trigramsOffset + quint64(trigramRecords.size()) * sizeof(TrigramRecord);
+    header.stringsOffset = header.postingsOffset + static_cast<quint64>(postingBytes.size());
+
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        error = QObject::tr("Не удалось записать индекс '%1'").arg(path);
+        return false;
+    }
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char *>(fileRecords.constData()), fileRecords.size() * qsizetype(sizeof(FileRecord)));
+    out.write(reinterpret_cast<const char *>(trigramRecords.constData()), trigramRecords.size() * qsizetype(sizeof(TrigramRecord)));
+    out.write(postingBytes);
+    out.write(strings);
+    if (!out.commit()) {
+        error = QObject::tr("Не удалось сохранить индекс '%1'").arg(path);
+        return false;
+    }
+    return true;
+}
+
+WorkspaceIndex::WorkspaceIndex(QObject *parent)
+    : QObject(parent)
+{
+    pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+    changeTimer_.setSingleShot(true);
+    changeTimer_.setInterval(kChangeDelayMs);
+
+    connect(&buildWatcher_, &QFutureWatcher<IndexBuildResult>::finished, this, &WorkspaceIndex::onBuildFinished);
+    connect(&buildWatcher_, &QFutureWatcher<IndexBuildResult>::progressValueChanged, this, [this](int value) {
+        emit progress(value, buildWatcher_.progressMaximum());
+    });
+    connect(&updateWatcher_, &QFutureWatcher<IndexUpdate>::finished, this, &WorkspaceIndex::onUpdateFinished);
+    connect(&watcher_, &QFileSystemWatcher::directoryChanged, this, &WorkspaceIndex::onPathChanged);
+    connect(&watcher_, &QFileSystemWatcher::fileChanged, this, &WorkspaceIndex::onPathChanged);
+    connect(&changeTimer_, &QTimer::timeout, this, &WorkspaceIndex::flushPendingChanges);
+}
+
+WorkspaceIndex::~WorkspaceIndex()
+{
+    close();
+}
+
+bool WorkspaceIndex::isBusy() const
+{
+    return buildWatcher_.isRunning() || updateWatcher_.isRunning();
+}
+
+void WorkspaceIndex::open(const QString &rootPath)
+{
+    const QString root = QDir(rootPath).canonicalPath();
+    if (root.isEmpty()) {
+        emit failed(tr("Папка не найдена: %1").arg(rootPath));
+        return;
+    }
+    if (root == rootPath_ && (isReady() || isBusy())) {
+        return;
+    }
+
+    close();
+    rootPath_ = root;
+
+    const QString baseDir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/index";
+    const QString key = QString::fromLatin1(QCryptographicHash::hash(root.toUtf8(), QCryptographicHash::Sha1).toHex());
+    indexPath_ = baseDir + '/' + key + ".tri";
+    textCacheDir_ = baseDir + '/' + key + ".text";
+    QDir().mkpath(textCacheDir_);
+
+    if (loadBase()) {
+        startUpdate({}, {}, true);
+        emit ready();
+    } else {
+        rebuild();
+    }
+}
+
+void WorkspaceIndex::rebuild()
+{
+    if (rootPath_.isEmpty() || buildWatcher_.isRunning()) {
+        return;
+    }
+    buildWatcher_.setFuture(QtConcurrent::run(&buildIndex, &pool_, rootPath_, indexPath_ + ".new", textCacheDir_));
+}
+
+void WorkspaceIndex::close()
+{
+    buildWatcher_.cancel();
+    updateWatcher_.cancel();
+    buildWatcher_.waitForFinished();
+    updateWatcher_.waitForFinished();
+    changeTimer_.stop();
+
+    if (const QStringList watched = watcher_.directories() + watcher_.files(); !watched.isEmpty()) {
+        watcher_.removePaths(watched);
+    }
+    base_.close();
+    baseIds_.clear();
+    staleBase_.clear();
+    unindexedBase_.clear();
+    overlay_.clear();
+    stamps_.clear();
+    directories_.clear();
+    pendingDirectories_.clear();
+    pendingFiles_.clear();
+    pendingFull_ = false;
+    rootPath_.clear();
+}
+
+void WorkspaceIndex::refreshIfStale()
+{
+    if (isReady() && !isBusy() && sinceRefresh_.isValid() && sinceRefresh_.elapsed() > kRefreshIntervalMs) {
+        startUpdate({}, {}, true);
+    }
+}
+
+bool WorkspaceIndex::loadBase()
+{
+    if (!base_.open(indexPath_)) {
+        return false;
+    }
+
+    baseIds_.clear();
+    stamps_.clear();
+    overlay_.clear();
+    unindexedBase_.clear();
+    staleBase_.assign(base_.fileCount(), false);
+    baseIds_.reserve(base_.fileCount());
+    stamps_.reserve(base_.fileCount());
+    for (quint32 id = 0; id < base_.fileCount(); ++id) {
+        const IndexedFile file = base_.file(id);
+        baseIds_.insert(file.path, id);
+        stamps_.insert(file.path, FileStamp{file.modified, file.size});
+        if (file.flags & IndexedUnindexed) {
+            unindexedBase_.push_back(id);
+        }
+    }
+    return true;
+}
+
+void WorkspaceIndex::onBuildFinished()
+{
+    if (buildWatcher_.isCanceled() || buildWatcher_.future().resultCount() == 0) {
+        return;
+    }
+    const IndexBuildResult result = buildWatcher_.result();
+    if (!result.ok) {
+        emit failed(result.error);
+        return;
+    }
+
+    base_.close();
+    QFile::remove(indexPath_);
+    if (!QFile::rename(indexPath_ + ".new", indexPath_) || !loadBase()) {
+        emit failed(tr("Не удалось открыть индекс '%1'").arg(indexPath_));
+        return;
+    }
+    startUpdate({}, {}, true);
+    emit ready();
+}
+
+void WorkspaceIndex::startUpdate(const QStringList &directories, const QStringList &files, bool full)
+{
+    if (updateWatcher_.isRunning()) {
+        for (const QString &dir : directories) {
+            pendingDirectories_.insert(dir);
+        }
+        for (const QString &file : files) {
+            pendingFiles_.insert(file);
+        }
+        pendingFull_ = pendingFull_ || full;
+        return;
+    }
+
+    QHash<QString, qint64> knownModified;
+    knownModified.reserve(stamps_.size());
+    for (auto it = stamps_.cbegin(); it != stamps_.cend(); ++it) {
+        knownModified.insert(it.key(), it->modified);
+    }
+    if (full) {
+        sinceRefresh_.start();
+    }
+    updateWatcher_.setFuture(QtConcurrent::run(&scanForUpdates, &pool_, rootPath_, directories, files, full,
+                                               knownModified, directories_, textCacheDir_));
+}
+
+void WorkspaceIndex::onUpdateFinished()
+{
+    if (!updateWatcher_.isCanceled() && updateWatcher_.future().resultCount() > 0) {
+        applyUpdate(updateWatcher_.result());
+    }
+    if (pendingFull_ || !pendingDirectories_.isEmpty() || !pendingFiles_.isEmpty()) {
+        changeTimer_.start();
+    }
+}
+
+void WorkspaceIndex::applyUpdate(const IndexUpdate &update)
+{
+    for (const QString &path : update.removed) {
+        markBaseStale(path);
+        overlay_.remove(path);
+        stamps_.remove(path);
+    }
+
+    QStringList newFiles;
+    for (const IndexEntry &entry : update.entries) {
+        const QString &path = entry.file.path;
+        markBaseStale(path);
+        if (!stamps_.contains(path)) {
+            newFiles << path;
+        }
+        stamps_.insert(path, FileStamp{entry.file.modified, entry.file.size});
+        overlay_.insert(path, entry);
+    }
+
+    QStringList newDirectories;
+    for (const QString &dir : update.directories) {
+        if (!directories_.contains(dir)) {
+            directories_.insert(dir);
+            newDirectories << dir;
+        }
+    }
+    if (update.full) {
+        newFiles = stamps_.keys();
+    }
+    watchPaths(newDirectories, newFiles);
+
+    if (overlay_.size() > kCompactThreshold) {
+        rebuild();
+    }
+}
+
+void WorkspaceIndex::markBaseStale(const QString &path)
+{
+    const auto it = baseIds_.constFind(path);
+    if (it != baseIds_.cend() && *it < staleBase_.size()) {
+        staleBase_[*it] = true;
+    }
+}
+
+void WorkspaceIndex::watchPaths(const QStringList &directories, const QStringList &files)
+{
+    const QStringList watchedDirs = watcher_.directories();
+    const QStringList watchedFiles = watcher_.files();
+    qsizetype budget = kMaxWatchedPaths - watchedDirs.size() - watchedFiles.size();
+    const QSet<QString> watched(watchedFiles.cbegin(), watchedFiles.cend());
+
+    QStringList paths;
+    for (const QString &dir : directories) {
+        if (budget-- <= 0) {
+            break;
+        }
+        paths << dir;
+    }
+    for (const QString &file : files) {
+        if (budget <= 0) {
+            break;
+        }
+        if (!watched.contains(file)) {
+            paths << file;
+            --budget;
+        }
+    }
+    if (!paths.isEmpty()) {
+        watcher_.addPaths(paths);
+    }
+}
+
+void WorkspaceIndex::onPathChanged(const QString &path)
+{
+    if (directories_.contains(path)) {
+        pendingDirectories_.insert(path);
+    } else {
+        pendingFiles_.insert(path);
+    }
+    changeTimer_.start();
+}
+
+void WorkspaceIndex::flushPendingChanges()
+{
+    if (!isReady() || updateWatcher_.isRunning()) {
+        return;
+    }
+
+    const bool full = pendingFull_;
+    const QStringList dirs(pendingDirectories_.cbegin(), pendingDirectories_.cend());
+    const QStringList files(pendingFiles_.cbegin(), pendingFiles_.cend());
+    pendingFull_ = false;
+    pendingDirectories_.clear();
+    pendingFiles_.clear();
+    startUpdate(full ? QStringList() : dirs, full ? QStringList() : files, full);
+}
+
+QString WorkspaceIndex::textSourcePath(const QString &filePath) const
+{
+    return textCachePath(textCacheDir_, filePath);
+}
+
+std::vector<quint32> WorkspaceIndex::queryTrigrams(const SearchQuery &query, bool *narrowable)
+{
+    std::vector<quint32> trigrams;
+    if (query.options.regex) {
+        bool ok = false;
+        for (const QString &literal : regexLiterals(query.pattern, &ok)) {
+            appendTrigrams(trigrams, literal);
+        }
+    } else {
+        appendTrigrams(trigrams, query.pattern);
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    *narrowable = !trigrams.empty();
+    return trigrams;
+}
+
+IndexCandidates WorkspaceIndex::candidates(const SearchQuery &query, const QStringList &nameFilters) const
+{
+    IndexCandidates result;
+    result.totalFiles = stamps_.size();
+    if (!isReady()) {
+        return result;
+    }
+
+    bool narrowable = false;
+    const std::vector<quint32> trigrams = queryTrigrams(query, &narrowable);
+    result.narrowed = narrowable;
+
+    auto add = [&](const QString &path, quint32 flags) {
+        if (flags & IndexedBinary) {
+            return;
+        }
+        if (!nameFilters.isEmpty() && !QDir::match(nameFilters, QFileInfo(path).fileName())) {
+            return;
+        }
+        result.files << path;
+        if (flags & IndexedDocument) {
+            result.textSources.insert(path, textSourcePath(path));
+        }
+    };
+
+    std::vector<quint32> ids;
+    if (narrowable) {
+        ids = base_.intersect(trigrams);
+        ids.insert(ids.end(), unindexedBase_.begin(), unindexedBase_.end());
+    } else {
+        ids.resize(base_.fileCount());
+        std::iota(ids.begin(), ids.end(), 0u);
+    }
+    for (const quint32 id : ids) {
+        if (id < staleBase_.size() && !staleBase_[id]) {
+            const IndexedFile file = base_.file(id);
+            add(file.path, file.flags);
+        }
+    }
+
+    for (const IndexEntry &entry : overlay_) {
+        const bool matches = !narrowable
+                             || (entry.file.flags & IndexedUnindexed)
+                             || std::includes(entry.trigrams.begin(), entry.trigrams.end(),
+                                              trigrams.begin(), trigrams.end());
+        if (matches) {
+            add(entry.file.path, entry.file.flags);
+        }
+    }
+    result.files.removeDuplicates();
+    return result;
+}
@@ -0,0 +1,472 @@
+#include "../headers/workspacereplace.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QTemporaryFile>
+#include <QElapsedTimer>
+#include <QStringDecoder>
+#include <QStringEncoder>
+#include <QtConcurrent/QtConcurrent>
+
+#if defined(Q_OS_UNIX)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <sys/xattr.h>
+#include <cerrno>
+#endif
+
+namespace {
+
+constexpr qint64 kReadChunk = 1 << 20;
+constexpr qsizetype kMaxPendingChars = 8 * 1024 * 1024;
+constexpr qsizetype kPlanBatch = 256;
+constexpr int kPreviewLines = 50;
+
+struct StagedFile
+{
+    QString path;
+    QString target;
+    QString temp;
+    QString backup;
+    qint64 bytes = 0;
+    QString error;
+    QString unsafe;
+};
+
+qint64 modifiedMs(const QFileInfo &info)
+{
+    return info.lastModified().toMSecsSinceEpoch();
+}
+
+QString backupPathFor(const QString &target)
+{
+    QString backup = target + ".replace-backup";
+    for (int i = 1; QFileInfo::exists(backup); ++i) {
+        backup = QString("%1.replace-backup%2").arg(target).arg(i);
+    }
+    return backup;
+}
+
+// The staged copy replaces the file by rename, so it has to carry what the
+// new inode would otherwise lose: owner, group and the access ACL.
+bool copyOwnership(const QString &source, int fd)
+{
+#if defined(Q_OS_UNIX)
+    struct stat original;
+    struct stat staged;
+    if (::stat(QFile::encodeName(source).constData(), &original) != 0 || ::fstat(fd, &staged) != 0) {
+        return false;
+    }
+    if ((original.st_uid != staged.st_uid || original.st_gid != staged.st_gid)
+        && ::fchown(fd, original.st_uid, original.st_gid) != 0) {
+        return false;
+    }
+#endif
+#if defined(Q_OS_LINUX)
+    const char *aclName = "system.posix_acl_access";
+    const QByteArray path = QFile::encodeName(source);
+    const ssize_t size = ::getxattr(path.constData(), aclName, nullptr, 0);
+    if (size < 0) {
+        return errno == ENODATA || errno == ENOTSUP;
+    }
+    QByteArray acl(static_cast<qsizetype>(size), Qt::Uninitialized);
+    if (::getxattr(path.constData(), aclName, acl.data(), static_cast<size_t>(size)) != size
+        || ::fsetxattr(fd, aclName, acl.constData(), static_cast<size_t>(size), 0) != 0) {
+        return false;
+    }
+#else
+    (void)source;
+    (void)fd;
+#endif
+    return true;
+}
+
+bool hasHardLinks(const QString &filePath)
+{
+#if defined(Q_OS_UNIX)
+    struct stat status;
+    return ::stat(QFile::encodeName(filePath).constData(), &status) == 0 && status.st_nlink > 1;
+#else
+    (void)filePath;
+    return false;
+#endif
+}
+
+// Symlinks are resolved first, so the link stays and its target is
+// rewritten. A file with several hard links cannot be replaced: a rename
+// would detach this name from the others.
+StagedFile stageFile(const StreamingReplacer &replacer, const FileReplacePlan &plan)
+{
+    StagedFile staged;
+    staged.path = plan.filePath;
+    staged.target = QFileInfo(plan.filePath).canonicalFilePath();
+    if (staged.target.isEmpty()) {
+        staged.error = QObject::tr("Файл '%1' не найден").arg(plan.filePath);
+        return staged;
+    }
+
+    const QFileInfo info(staged.target);
+    if (modifiedMs(info) != plan.modified || info.size() != plan.size) {
+        staged.error = QObject::tr("Файл '%1' изменился после предпросмотра").arg(plan.filePath);
+        return staged;
+    }
+    if (hasHardLinks(staged.target)) {
+        staged.unsafe = QObject::tr("'%1': несколько жёстких ссылок").arg(plan.filePath);
+        return staged;
+    }
+
+    QFile input(staged.target);
+    if (!input.open(QIODevice::ReadOnly)) {
+        staged.error = QObject::tr("Не удалось открыть файл '%1' для чтения").arg(plan.filePath);
+        return staged;
+    }
+
+    QTemporaryFile output(info.absolutePath() + "/." + info.fileName() + ".XXXXXX");
+    output.setAutoRemove(false);
+    if (!output.open()) {
+        staged.error = QObject::tr("Не удалось создать временный файл рядом с '%1'").arg(plan.filePath);
+        return staged;
+    }
+    staged.temp = output.fileName();
+
+    if (!replacer.rewrite(input, output, &staged.bytes, staged.error) || !output.flush()) {
+        if (staged.error.isEmpty()) {
+            staged.error = QObject::tr("Не удалось записать временный файл для '%1'").arg(plan.filePath);
+        }
+        return staged;
+    }
+    if (!copyOwnership(staged.target, output.handle())) {
+        output.close();
+        QFile::remove(staged.temp);
+        staged.temp.clear();
+        staged.unsafe = QObject::tr("'%1': не удалось сохранить владельца или ACL").arg(plan.filePath);
+        return staged;
+    }
+    output.setPermissions(info.permissions());
+    output.close();
+    return staged;
+}
+
+void discardStaged(const QVector<StagedFile> &staged, qsizetype from)
+{
+    for (qsizetype i = from; i < staged.size(); ++i) {
+        if (!staged.at(i).temp.isEmpty()) {
+            QFile::remove(staged.at(i).temp);
+        }
+    }
+}
+
+void planFiles(QPromise<FileReplacePlan> &promise, QThreadPool *pool,
+               const FileSearchRequest &request, const QString &replacement)
+{
+    QStringList files = request.files;
+    if (files.isEmpty()) {
+        QDirIterator it(request.rootPath, request.nameFilters,
+                        QDir::Files | QDir::Readable | QDir::Writable | QDir::NoDotAndDotDot,
+                        QDirIterator::Subdirectories);
+        while (it.hasNext() && !promise.isCanceled()) {
+            files << it.next();
+        }
+    }
+    files.removeIf([&request](const QString &path) { return request.textSources.contains(path); });
+    promise.setProgressRange(0, static_cast<int>(files.size()));
+
+    const StreamingReplacer replacer(request.query, replacement);
+    for (qsizetype start = 0; start < files.size(); start += kPlanBatch) {
+        if (promise.isCanceled()) {
+            return;
+        }
+        const QVector<FileReplacePlan> plans = QtConcurrent::blockingMapped<QVector<FileReplacePlan>>(
+            pool, files.mid(start, kPlanBatch), [&replacer](const QString &path) {
+                return replacer.plan(path, kPreviewLines);
+            });
+        for (const FileReplacePlan &plan : plans) {
+            if (plan.matchCount > 0) {
+                promise.addResult(plan);
+            }
+        }
+        promise.setProgressValue(static_cast<int>(start + plans.size()));
+    }
+}
+
+void commitPlans(QPromise<ReplaceCommitResult> &promise, QThreadPool *pool,
+                 const SearchQuery &query, const QString &replacement, const QVector<FileReplacePlan> &plans)
+{
+    QElapsedTimer timer;
+    timer.start();
+    ReplaceCommitResult result;
+    const StreamingReplacer replacer(query, replacement);
+
+    QVector<StagedFile> staged = QtConcurrent::blockingMapped<QVector<StagedFile>>(
+        pool, plans, [&replacer](const FileReplacePlan &plan) { return stageFile(replacer, plan); });
+
+    // A file that cannot be swapped safely cancels the whole commit, so the
+    // tree is never left partly replaced.
+    QStringList unsafe;
+    for (const StagedFile &file : staged) {
+        if (!file.error.isEmpty()) {
+            result.error = file.error;
+            break;
+        }
+        if (!file.unsafe.isEmpty()) {
+            unsafe << file.unsafe;
+        }
+    }
+    if (result.error.isEmpty() && !unsafe.isEmpty()) {
+        result.error = QObject::tr("нельзя заменить файлов: %1, снимите их отметку (%2)")
+                           .arg(unsafe.size())
+                           .arg(unsafe.first());
+    }
+    if (!result.error.isEmpty() || promise.isCanceled()) {
+        discardStaged(staged, 0);
+        promise.addResult(result);
+        return;
+    }
+
+    qsizetype swapped = 0;
+    for (; swapped < staged.size(); ++swapped) {
+        StagedFile &file = staged[swapped];
+        file.backup = backupPathFor(file.target);
+        if (!QFile::rename(file.target, file.backup)) {
+            result.error = QObject::tr("Не удалось переименовать '%1'").arg(file.target);
+            break;
+        }
+        if (!QFile::rename(file.temp, file.target)) {
+            QFile::rename(file.backup, file.target);
+            result.error = QObject::tr("Не удалось заменить '%1'").arg(file.target);
+            break;
+        }
+    }
+
+    if (swapped < staged.size()) {
+        for (qsizetype i = swapped - 1; i >= 0; --i) {
+            QFile::remove(staged.at(i).target);
+            QFile::rename(staged.at(i).backup, staged.at(i).target);
+        }
+        discardStaged(staged, swapped);
+        promise.addResult(result);
+        return;
+    }
+
+    for (const StagedFile &file : staged) {
+        QFile::remove(file.backup);
+        result.files << file.path;
+        result.bytesWritten += file.bytes;
+    }
+    result.ok = true;
+    result.elapsedMs = timer.elapsed();
+    promise.addResult(result);
+}
+
+}
+
+StreamingReplacer::StreamingReplacer(const SearchQuery &query, const QString &replacement)
+    : searcher_(query)
+    , replacement_(replacement)
+{
+}
+
+FileReplacePlan StreamingReplacer::plan(const QString &filePath, int previewLimit) const
+{
+    FileReplacePlan plan;
+    plan.filePath = filePath;
+
+    const QFileInfo info(filePath);
+    plan.modified = modifiedMs(info);
+    plan.size = info.size();
+
+    QFile input(filePath);
+    if (!input.open(QIODevice::ReadOnly)) {
+        return plan;
+    }
+    QString error;
+    plan.matchCount = qMax<qsizetype>(0, process(input, nullptr, &plan.preview, previewLimit, nullptr, error));
+    return plan;
+}
+
+bool StreamingReplacer::rewrite(QIODevice &input, QIODevice &output, qint64 *bytesWritten, QString &error) const
+{
+    return process(input, &output, nullptr, 0, bytesWritten, error) >= 0;
+}
+
+qsizetype StreamingReplacer::process(QIODevice &input, QIODevice *output, QVector<ReplacePreviewLine> *preview,
+                                     int previewLimit, qint64 *bytesWritten, QString &error) const
+{
+    if (!searcher_.isValid()) {
+        error = searcher_.errorString();
+        return -1;
+    }
+
+    QStringDecoder decoder(QStringConverter::Utf8, QStringConverter::Flag::ConvertInitialBom);
+    QStringEncoder encoder(QStringConverter::Utf8);
+    QString pending;
+    qsizetype matches = 0;
+    int line = 1;
+
+    auto flushBlock = [&](qsizetype cut) {
+        const QStringView block = QStringView(pending).first(cut);
+        ReplacePlan replacePlan;
+        searcher_.buildReplacePlan(block, replacement_, replacePlan);
+        matches += replacePlan.edits.size();
+
+        if (preview && !replacePlan.edits.isEmpty() && preview->size() < previewLimit) {
+            collectPreview(block, line, *preview, previewLimit);
+        }
+        if (preview) {
+            line += static_cast<int>(block.count(u'\n'));
+        }
+
+        if (output) {
+            QByteArray encoded;
+            qsizetype copied = 0;
+            for (const ReplaceEdit &edit : replacePlan.edits) {
+                encoded += encoder.encode(block.sliced(copied, edit.start - copied));
+                encoded += encoder.encode(edit.text);
+                copied = edit.start + edit.length;
+            }
+            encoded += encoder.encode(block.sliced(copied));
+            if (output->write(encoded) != encoded.size()) {
+                error = QObject::tr("Ошибка записи: %1").arg(output->errorString());
+                return false;
+            }
+            if (bytesWritten) {
+                *bytesWritten += encoded.size();
+            }
+        }
+        pending.remove(0, cut);
+        return true;
+    };
+
+    bool firstChunk = true;
+    while (!input.atEnd()) {
+        const QByteArray chunk = input.read(kReadChunk);
+        if (chunk.isEmpty()) {
+            error = QObject::tr("Ошибка чтения: %1").arg(input.errorString());
+            return -1;
+        }
+        if (firstChunk && FileScanner::isBinaryContent(chunk.constData(), chunk.size())) {
+            error = QObject::tr("Двоичный файл пропущен");
+            return -1;
+        }
+        firstChunk = false;
+
+        pending += decoder.decode(chunk);
+        qsizetype cut = pending.lastIndexOf(u'\n') + 1;
+        if (cut == 0 && pending.size() >= kMaxPendingChars) {
+            cut = pending.size();
+        }
+        if (cut > 0 && !flushBlock(cut)) {
+            return -1;
+        }
+    }
+    if (!pending.isEmpty() && !flushBlock(pending.size())) {
+        return -1;
+    }
+    if (decoder.hasError()) {
+        error = QObject::tr("Файл не в кодировке UTF-8");
+        return -1;
+    }
+    return matches;
+}
+
+void StreamingReplacer::collectPreview(QStringView block, int firstLine,
+                                       QVector<ReplacePreviewLine> &preview, int previewLimit) const
+{
+    QVector<SearchMatch> matches;
+    searcher_.findAll(block, 0, block.size(), matches, qsizetype(previewLimit) * 16);
+
+    int line = firstLine;
+    qsizetype counted = 0;
+    qsizetype i = 0;
+    while (i < matches.size() && preview.size() < previewLimit) {
+        const qsizetype lineStart = block.first(matches.at(i).start).lastIndexOf(u'\n') + 1;
+        qsizetype lineEnd = block.indexOf(u'\n', matches.at(i).start);
+        if (lineEnd < 0) {
+            lineEnd = block.size();
+        }
+        line += static_cast<int>(block.sliced(counted, lineStart - counted).count(u'\n'));
+        counted = lineStart;
+
+        QString after;
+        qsizetype copied = lineStart;
+        for (; i < matches.size() && matches.at(i).start < lineEnd; ++i) {
+            const SearchMatch &match = matches.at(i);
+            after += block.sliced(copied, match.start - copied);
+            after += searcher_.replacementAt(block, match, replacement_);
+            copied = match.end();
+        }
+        after += block.sliced(copied, qMax(copied, lineEnd) - copied);
+
+        ReplacePreviewLine entry;
+        entry.line = line;
+        entry.before = block.sliced(lineStart, lineEnd - lineStart).toString();
+        entry.after = after;
+        if (entry.before.endsWith(u'\r')) {
+            entry.before.chop(1);
+        }
+        if (entry.after.endsWith(u'\r')) {
+            entry.after.chop(1);
+        }
+        preview.push_back(std::move(entry));
+    }
+}
+
+WorkspaceReplacer::WorkspaceReplacer(QObject *parent)
+    : QObject(parent)
+{
+    pool_.setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+
+    connect(&planWatcher_, &QFutureWatcher<FileReplacePlan>::progressValueChanged, this, [this](int value) {
+        emit planProgress(value, planWatcher_.progressMaximum());
+    });
+    connect(&planWatcher_, &QFutureWatcher<FileReplacePlan>::finished, this, [this]() {
+        if (!planWatcher_.isCanceled()) {
+            emit planReady(planWatcher_.future().results());
+        }
+    });
+    connect(&commitWatcher_, &QFutureWatcher<ReplaceCommitResult>::finished, this, [this]() {
+        if (commitWatcher_.future().resultCount() > 0) {
+            emit committed(commitWatcher_.result());
+        }
+    });
+}
+
+WorkspaceReplacer::~WorkspaceReplacer()
+{
+    planWatcher_.cancel();
+    planWatcher_.waitForFinished();
+    commitWatcher_.waitForFinished();
+}
+
+bool WorkspaceReplacer::isRunning() const
+{
+    return planWatcher_.isRunning() || commitWatcher_.isRunning();
+}
+
+void WorkspaceReplacer::plan(const FileSearchRequest &request, const QString &replacement)
+{
+    if (isRunning()) {
+        return;
+    }
+    query_ = request.query;
+    replacement_ = replacement;
+    planWatcher_.setFuture(QtConcurrent::run(&planFiles, &pool_, request, replacement));
+}
+
+void WorkspaceReplacer::commit(const QVector<FileReplacePlan> &plans)
+{
+    if (isRunning()) {
+        return;
+    }
+    commitWatcher_.setFuture(QtConcurrent::run(&commitPlans, &pool_, query_, replacement_, plans));
+}
+
+void WorkspaceReplacer::cancel()
+{
+    planWatcher_.cancel();
+}